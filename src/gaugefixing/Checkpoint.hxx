@@ -0,0 +1,320 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Checkpointing of long gauge copy searches.
+ *
+ * The state (file index, first copy of the batch, phase, SA sweep and temperature, best functional,
+ * global Philox counter) and the fields (pristine, best copy and, within SA, the working fields of all
+ * slots) are written to a single binary file in native byte order and native precision.
+ * The fields have to be copied to the page-locked buffers of this class first (prepare() waits until the
+ * previous checkpoint is on disk). writeAsync() then writes the file in a separate thread such that the
+ * gauge fixing continues immediately. The file is written to <filename>.tmp and renamed when it is
+ * complete, a crash while writing leaves the previous checkpoint intact.
+ *
+ * Since all kernels are deterministic for a given Philox counter, continuing from a checkpoint gives
+ * bit-identical results to an uninterrupted run. The state also counts the lines of the functional
+ * output (CSV) of the current file: on restart the file is truncated to these lines, the copies that
+ * are redone do not appear twice. A completed run removes the checkpoint (remove()).
+ */
+
+#ifndef CHECKPOINT_HXX_
+#define CHECKPOINT_HXX_
+
+#include "GlobalConstants.h"
+#include "../lattice/datatype/datatypes.h"
+#include "../lattice/rng/PhiloxWrapper.hxx"
+
+#include <cuda_runtime.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+#include <fstream>
+
+enum CheckpointPhase { CHECKPOINT_BATCH = 0, CHECKPOINT_SA = 1 };
+
+struct CheckpointState
+{
+	int fileIndex;
+	int firstCopy;
+	int phase;
+	int sweep; // the next SA sweep
+	float temperature; // temperature of the next SA sweep
+	double bestGff;
+	unsigned int philoxCounter;
+	int hasBest;
+	int functionalLines; // "copy,functional" lines written for this file before the checkpoint
+};
+
+class Checkpoint
+{
+public:
+	Checkpoint( std::string filename, int slots, int arraySize );
+	~Checkpoint();
+
+	bool isEnabled() const;
+	void prepare();
+	Real* getPristine();
+	Real* getBest();
+	Real* getWorking( int slot );
+	void writeAsync( const CheckpointState& state );
+	bool read( CheckpointState& state );
+	void remove();
+	static bool truncateLines( std::string filename, int lines );
+
+	template<class Batch> void store( Batch& batch, CheckpointState state );
+	template<class Batch> void restore( Batch& batch, const CheckpointState& state );
+
+private:
+	static const int VERSION = 2;
+
+	std::string filename;
+	int slots;
+	int arraySize;
+	Real* buffer; // pristine, best, working[0], ..., working[slots-1]
+	CheckpointState state;
+	pthread_t thread;
+	bool writing;
+
+	static void* writer( void* checkpoint );
+	void write();
+};
+
+inline Checkpoint::Checkpoint( std::string filename, int slots, int arraySize ) : filename(filename), slots(slots), arraySize(arraySize), buffer(0), writing(false)
+{
+	if( isEnabled() )
+	{
+		cudaMallocHost( &buffer, (size_t)(slots+2)*arraySize*sizeof(Real) );
+	}
+}
+
+inline Checkpoint::~Checkpoint()
+{
+	prepare();
+	if( buffer ) cudaFreeHost( buffer );
+}
+
+inline bool Checkpoint::isEnabled() const
+{
+	return !filename.empty();
+}
+
+/**
+ * Waits for the previous checkpoint to be written. Afterwards the buffers may be filled.
+ */
+inline void Checkpoint::prepare()
+{
+	if( writing )
+	{
+		pthread_join( thread, NULL );
+		writing = false;
+	}
+}
+
+inline Real* Checkpoint::getPristine()
+{
+	return buffer;
+}
+
+inline Real* Checkpoint::getBest()
+{
+	return &buffer[arraySize];
+}
+
+inline Real* Checkpoint::getWorking( int slot )
+{
+	return &buffer[(size_t)(slot+2)*arraySize];
+}
+
+inline void Checkpoint::writeAsync( const CheckpointState& state )
+{
+	prepare();
+	this->state = state;
+	writing = true;
+	if( pthread_create( &thread, NULL, writer, this ) != 0 )
+	{
+		// no thread available: write synchronously
+		write();
+		writing = false;
+	}
+}
+
+inline void* Checkpoint::writer( void* checkpoint )
+{
+	((Checkpoint*)checkpoint)->write();
+	return NULL;
+}
+
+inline void Checkpoint::write()
+{
+	std::string tmpname = filename + ".tmp";
+	FILE* file = fopen( tmpname.c_str(), "wb" );
+	if( file == NULL )
+	{
+		std::cout << "Can not open checkpoint file " << tmpname << std::endl;
+		return;
+	}
+
+	const char magic[8] = { 'c','u','L','G','T','C','K','P' };
+	int header[8] = { VERSION, (int)sizeof(Real), HOST_CONSTANTS::SIZE[0], HOST_CONSTANTS::SIZE[1], HOST_CONSTANTS::SIZE[2], HOST_CONSTANTS::SIZE[3], slots, arraySize };
+
+	bool ok = ( fwrite( magic, sizeof(char), 8, file ) == 8 );
+	ok = ok && ( fwrite( header, sizeof(int), 8, file ) == 8 );
+	ok = ok && ( fwrite( &state, sizeof(CheckpointState), 1, file ) == 1 );
+
+	ok = ok && ( fwrite( getPristine(), sizeof(Real), arraySize, file ) == (size_t)arraySize );
+	if( state.hasBest ) ok = ok && ( fwrite( getBest(), sizeof(Real), arraySize, file ) == (size_t)arraySize );
+	if( state.phase == CHECKPOINT_SA )
+	{
+		for( int k = 0; k < slots; k++ )
+		{
+			ok = ok && ( fwrite( getWorking(k), sizeof(Real), arraySize, file ) == (size_t)arraySize );
+		}
+	}
+	fclose( file );
+
+	if( ok ) rename( tmpname.c_str(), filename.c_str() );
+	else std::cout << "Error while writing checkpoint " << tmpname << std::endl;
+}
+
+/**
+ * Reads the checkpoint into the buffers. Returns false if there is no (compatible) checkpoint.
+ */
+inline bool Checkpoint::read( CheckpointState& state )
+{
+	if( !isEnabled() ) return false;
+	prepare();
+
+	FILE* file = fopen( filename.c_str(), "rb" );
+	if( file == NULL )
+	{
+		std::cout << "Can not open checkpoint file " << filename << std::endl;
+		return false;
+	}
+
+	char magic[8];
+	int header[8];
+	int expected[8] = { VERSION, (int)sizeof(Real), HOST_CONSTANTS::SIZE[0], HOST_CONSTANTS::SIZE[1], HOST_CONSTANTS::SIZE[2], HOST_CONSTANTS::SIZE[3], slots, arraySize };
+
+	bool ok = ( fread( magic, sizeof(char), 8, file ) == 8 ) && ( strncmp( magic, "cuLGTCKP", 8 ) == 0 );
+	ok = ok && ( fread( header, sizeof(int), 8, file ) == 8 ) && ( memcmp( header, expected, sizeof(expected) ) == 0 );
+	if( !ok )
+	{
+		std::cout << "Checkpoint " << filename << " does not match this run (lattice size, precision or number of slots)." << std::endl;
+		fclose( file );
+		return false;
+	}
+
+	ok = ( fread( &this->state, sizeof(CheckpointState), 1, file ) == 1 );
+	ok = ok && ( fread( getPristine(), sizeof(Real), arraySize, file ) == (size_t)arraySize );
+	if( ok && this->state.hasBest ) ok = ( fread( getBest(), sizeof(Real), arraySize, file ) == (size_t)arraySize );
+	if( ok && this->state.phase == CHECKPOINT_SA )
+	{
+		for( int k = 0; k < slots; k++ )
+		{
+			ok = ok && ( fread( getWorking(k), sizeof(Real), arraySize, file ) == (size_t)arraySize );
+		}
+	}
+	fclose( file );
+
+	if( !ok )
+	{
+		std::cout << "Checkpoint " << filename << " is incomplete." << std::endl;
+		return false;
+	}
+	state = this->state;
+	return true;
+}
+
+/**
+ * Deletes the checkpoint after the run is complete (a later --restart can not continue a stale state).
+ */
+inline void Checkpoint::remove()
+{
+	if( !isEnabled() ) return;
+	prepare();
+	::remove( filename.c_str() );
+	::remove( (filename + ".tmp").c_str() );
+}
+
+/**
+ * Keeps the first <lines> lines of a text file, e.g. the functional output of the checkpointed copies.
+ */
+inline bool Checkpoint::truncateLines( std::string filename, int lines )
+{
+	std::ifstream in( filename.c_str() );
+	if( !in.good() ) return false;
+
+	std::string content;
+	std::string line;
+	for( int i = 0; i < lines && std::getline( in, line ); i++ )
+	{
+		content += line + "\n";
+	}
+	in.close();
+
+	std::ofstream out( filename.c_str(), std::ios::trunc );
+	out << content;
+	return out.good();
+}
+
+/**
+ * Copies the fields of the GaugeCopyBatch to the buffers, completes the state (best copy, Philox counter)
+ * and starts writing.
+ */
+template<class Batch> void Checkpoint::store( Batch& batch, CheckpointState state )
+{
+	batch.synchronize();
+	prepare();
+
+	batch.getFieldBuffers().storePristine( getPristine() );
+	state.hasBest = batch.getFieldBuffers().storeBest( getBest() );
+	if( state.phase == CHECKPOINT_SA )
+	{
+		for( int k = 0; k < slots; k++ )
+		{
+			batch.getFieldBuffers().storeWorking( k, getWorking(k) );
+		}
+	}
+	state.philoxCounter = PhiloxWrapper::getCurrentCounter();
+
+	writeAsync( state );
+}
+
+/**
+ * Restores the fields of a checkpoint that was read before and the Philox counter.
+ */
+template<class Batch> void Checkpoint::restore( Batch& batch, const CheckpointState& state )
+{
+	batch.getFieldBuffers().load( getPristine() );
+	if( state.hasBest ) batch.getFieldBuffers().loadBest( getBest() );
+	if( state.phase == CHECKPOINT_SA )
+	{
+		for( int k = 0; k < slots; k++ )
+		{
+			batch.getFieldBuffers().loadWorking( k, getWorking(k) );
+		}
+	}
+	PhiloxWrapper::setCounter( state.philoxCounter );
+}
+
+#endif /* CHECKPOINT_HXX_ */
@@ -33,8 +33,10 @@ namespace COMKSU3
 {
 static const int Ndim = 4; // TODO why here?
 static const int Nc = 3;
-__global__ void projectSU3( Real *U, lat_coord_t* ptrToDeviceSize );
-__global__ void setHot( Real *U, lat_coord_t* ptrToDeviceSize, int rngSeed, int rngCounter );
+template<class T_Real> __global__ void projectSU3( T_Real *U, lat_coord_t* ptrToDeviceSize );
+template<class T_Real> __global__ void projectSU3Batch( T_Real *U, lat_array_index_t configStride, lat_coord_t* ptrToDeviceSize, const int* active );
+template<class T_Real> __global__ void setHot( T_Real *U, lat_coord_t* ptrToDeviceSize, int rngSeed, int rngCounter );
+template<class T_Src, class T_Dst> __global__ void convertAndProject( T_Src *USrc, T_Dst *UDst, lat_coord_t* ptrToDeviceSize );
 }
 
 class CommonKernelsSU3
@@ -43,19 +45,41 @@ public:
 //	__global__ static void heatbathStep( Real* UtDw, Real* Ut, Real* UtUp, lat_index_t* nnt, float beta, bool parity, int counter );
 
 	// TODO remove static and make the init in constructor
-	static void initCacheConfig()
+	template<class T_Real = Real> static void initCacheConfig()
 	{
-		cudaFuncSetCacheConfig( COMKSU3::projectSU3, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( COMKSU3::projectSU3<T_Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( COMKSU3::projectSU3Batch<T_Real>, cudaFuncCachePreferL1 );
 	}
 
-	static void projectSU3( int a, int b, Real *U, lat_coord_t* ptrToDeviceSize )
+	template<class T_Real> static void projectSU3( int a, int b, T_Real *U, lat_coord_t* ptrToDeviceSize )
 	{
-		COMKSU3::projectSU3<<<a,b>>>( U, ptrToDeviceSize );
+		COMKSU3::projectSU3<T_Real><<<a,b>>>( U, ptrToDeviceSize );
+	};
+	template<class T_Real> static void projectSU3( int a, int b, cudaStream_t stream, T_Real *U, lat_coord_t* ptrToDeviceSize )
+	{
+		COMKSU3::projectSU3<T_Real><<<a,b,0,stream>>>( U, ptrToDeviceSize );
+	};
+
+	// all configurations of a batch (configuration blockIdx.y starts at U+blockIdx.y*configStride) in one launch,
+	// configurations with active[c] == 0 are skipped (active == NULL: all)
+	template<class T_Real> static void projectSU3Batch( int a, int b, int configs, T_Real *U, lat_array_index_t configStride, lat_coord_t* ptrToDeviceSize, const int* active = NULL )
+	{
+		COMKSU3::projectSU3Batch<T_Real><<<dim3(a,configs),b>>>( U, configStride, ptrToDeviceSize, active );
+	};
+
+	template<class T_Real> static void setHot( int a, int b, T_Real *U, lat_coord_t* ptrToDeviceSize, int rngSeed, int rngCounter )
+	{
+		COMKSU3::setHot<T_Real><<<a,b>>>( U, ptrToDeviceSize, rngSeed, rngCounter );
 	};
 
-	static void setHot( int a, int b, Real *U, lat_coord_t* ptrToDeviceSize, int rngSeed, int rngCounter )
+	/**
+	 * Copies the field USrc to UDst, converting the precision on the fly, and reprojects each link to SU(3).
+	 * Only the first two lines of the source are read, the third line of the destination is rebuilt in the
+	 * target precision. Used to promote a single precision field to double precision.
+	 */
+	template<class T_Src, class T_Dst> static void convertAndProject( int a, int b, T_Src *USrc, T_Dst *UDst, lat_coord_t* ptrToDeviceSize )
 	{
-		COMKSU3::setHot<<<a,b>>>( U, ptrToDeviceSize, rngSeed, rngCounter );
+		COMKSU3::convertAndProject<T_Src,T_Dst><<<a,b>>>( USrc, UDst, ptrToDeviceSize );
 	};
 
 private:
@@ -68,14 +92,13 @@ private:
 namespace COMKSU3
 {
 
-__global__ void projectSU3( Real *U, lat_coord_t* ptrToDeviceSize )
+template<class T_Real> __device__ inline void projectSite( T_Real *U, lat_coord_t* ptrToDeviceSize, int site )
 {
 	typedef GpuPattern< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuTimeslice;
-	typedef Link<GpuTimeslice,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLink;
+	typedef Link<GpuTimeslice,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc,T_Real> TLink;
 
 //	const lat_coord_t size[Ndim] = {1,Nx,Ny,Nz};
 	SiteIndex<4,FULL_SPLIT> s(ptrToDeviceSize );
-	int site = blockIdx.x * blockDim.x + threadIdx.x;
 
 	s.setLatticeIndex( site );
 
@@ -83,16 +106,27 @@ __global__ void projectSU3( Real *U, lat_coord_t* ptrToDeviceSize )
 	for( int mu = 0; mu < 4; mu++ )
 	{
 		TLink linkUp( U, s, mu );
-		SU3<TLink> globUp( linkUp );
+		SU3<TLink,T_Real> globUp( linkUp );
 
 		globUp.projectSU3(); // IMPORTANT: Currently this kernel is used for reconstructing third line in the end. Be aware of this when changing something.
 	}
 }
 
-__global__ void setHot( Real *U, lat_coord_t* ptrToDeviceSize, int rngSeed, int rngCounter )
+template<class T_Real> __global__ void projectSU3( T_Real *U, lat_coord_t* ptrToDeviceSize )
+{
+	projectSite( U, ptrToDeviceSize, blockIdx.x * blockDim.x + threadIdx.x );
+}
+
+template<class T_Real> __global__ void projectSU3Batch( T_Real *U, lat_array_index_t configStride, lat_coord_t* ptrToDeviceSize, const int* active )
+{
+	if( active != NULL && !active[blockIdx.y] ) return;
+	projectSite( &U[(size_t)blockIdx.y*configStride], ptrToDeviceSize, blockIdx.x * blockDim.x + threadIdx.x );
+}
+
+template<class T_Real> __global__ void setHot( T_Real *U, lat_coord_t* ptrToDeviceSize, int rngSeed, int rngCounter )
 {
 	typedef GpuPattern< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuTimeslice;
-	typedef Link<GpuTimeslice,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLink;
+	typedef Link<GpuTimeslice,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc,T_Real> TLink;
 
 //	const lat_coord_t size[Ndim] = {1,Nx,Ny,Nz};
 	SiteIndex<4,FULL_SPLIT> s(ptrToDeviceSize );
@@ -102,25 +136,25 @@ __global__ void setHot( Real *U, lat_coord_t* ptrToDeviceSize, int rngSeed, int
 
 	PhiloxWrapper rng( site, rngSeed, rngCounter );
 
-	Quaternion<Real> q;
+	Quaternion<T_Real> q;
 
 	for( int mu = 0; mu < 4; mu++ )
 	{
 		TLink linkUp( U, s, mu );
-		SU3<TLink> globUp( linkUp );
+		SU3<TLink,T_Real> globUp( linkUp );
 
-		Matrix<Complex<Real>,Nc> locMat;
-		SU3<Matrix<Complex<Real>,Nc> > locU(locMat);
+		Matrix<Complex<T_Real>,Nc> locMat;
+		SU3<Matrix<Complex<T_Real>,Nc>,T_Real> locU(locMat);
 
 		locU.identity();
 
 		for( int i=0; i<2; i++ )
 			for( int j=i+1; j<3; j++ )
 			{
-				q[0] = rng.rand()*2.0-1.0;
-				q[1] = rng.rand()*2.0-1.0;
-				q[2] = rng.rand()*2.0-1.0;
-				q[3] = rng.rand()*2.0-1.0;
+				q[0] = rng.rand<T_Real>()*2.0-1.0;
+				q[1] = rng.rand<T_Real>()*2.0-1.0;
+				q[2] = rng.rand<T_Real>()*2.0-1.0;
+				q[3] = rng.rand<T_Real>()*2.0-1.0;
 
 				q.projectSU2();
 				locU.rightSubgroupMult( i, j, &q );
@@ -129,6 +163,35 @@ __global__ void setHot( Real *U, lat_coord_t* ptrToDeviceSize, int rngSeed, int
 	}
 }
 
+template<class T_Src, class T_Dst> __global__ void convertAndProject( T_Src *USrc, T_Dst *UDst, lat_coord_t* ptrToDeviceSize )
+{
+	typedef GpuPattern< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuTimeslice;
+	typedef Link<GpuTimeslice,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc,T_Src> TLinkSrc;
+	typedef Link<GpuTimeslice,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc,T_Dst> TLinkDst;
+
+	SiteIndex<4,FULL_SPLIT> s(ptrToDeviceSize );
+	int site = blockIdx.x * blockDim.x + threadIdx.x;
+
+	s.setLatticeIndex( site );
+
+	for( int mu = 0; mu < 4; mu++ )
+	{
+		TLinkSrc linkSrc( USrc, s, mu );
+		SU3<TLinkSrc,T_Src> globSrc( linkSrc );
+
+		TLinkDst linkDst( UDst, s, mu );
+		SU3<TLinkDst,T_Dst> globDst( linkDst );
+
+		Matrix<Complex<T_Dst>,Nc> locMat;
+		SU3<Matrix<Complex<T_Dst>,Nc>,T_Dst> locU(locMat);
+
+		locU.assignWithoutThirdLine( globSrc );
+		locU.projectSU3();
+
+		globDst = locU;
+	}
+}
+
 }
 
 
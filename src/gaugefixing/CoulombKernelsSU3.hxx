@@ -44,10 +44,10 @@ static const int Ndim = 4; // TODO why here?
 static const int Nc = 3;
 __global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA );
 __global__ void restoreThirdLine( Real* U, lat_index_t* nnt );
-__global__ void randomTrafo( Real* UtUp, Real* UtDw,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter );
-__global__ void orStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float orParameter );
-__global__ void microStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity );
-__global__ void saStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
+template<class T_Real> __global__ void randomTrafo( T_Real* UtUp, T_Real* UtDw,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter );
+template<class T_Real> __global__ void orStep( T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity, float orParameter );
+template<class T_Real> __global__ void microStep( T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity );
+template<class T_Real> __global__ void saStep( T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
 }
 
 class CoulombKernelsSU3
@@ -58,16 +58,20 @@ public:
 	{
 		cudaFuncSetCacheConfig( CKSU3::generateGaugeQualityPerSite, cudaFuncCachePreferL1 );
 		cudaFuncSetCacheConfig( CKSU3::restoreThirdLine, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( CKSU3::randomTrafo, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( CKSU3::orStep, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( CKSU3::microStep, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( CKSU3::saStep, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( CKSU3::randomTrafo<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( CKSU3::orStep<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( CKSU3::microStep<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( CKSU3::saStep<Real>, cudaFuncCachePreferL1 );
 	}
 
 	static void generateGaugeQualityPerSite( int a, int b, Real *U, double *dGff, double *dA )
 	{
 		CKSU3::generateGaugeQualityPerSite<<<a,b>>>(U,dGff, dA);
 	};
+	static void generateGaugeQualityPerSite( int a, int b, cudaStream_t stream, Real *U, double *dGff, double *dA )
+	{
+		CKSU3::generateGaugeQualityPerSite<<<a,b,0,stream>>>(U,dGff, dA);
+	};
 	static double getGaugeQualityPrefactorA()
 	{
 		return 1./(double)CKSU3::Nc;
@@ -81,21 +85,21 @@ public:
 	{
 		CKSU3::restoreThirdLine<<<a,b>>>(U,nnt);
 	};
-	static void randomTrafo( int a, int b, Real* UtUp, Real* UtDw,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+	template<class T_Real> static void randomTrafo( int a, int b, T_Real* UtUp, T_Real* UtDw,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
 	{
-		CKSU3::randomTrafo<<<a,b>>>( UtUp, UtDw, nnt, parity, rngSeed, rngCounter );
+		CKSU3::randomTrafo<T_Real><<<a,b>>>( UtUp, UtDw, nnt, parity, rngSeed, rngCounter );
 	};
-	static void orStep( int a, int b,  Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float orParameter )
+	template<class T_Real> static void orStep( int a, int b,  T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity, float orParameter )
 	{
-		CKSU3::orStep<<<a,b>>>( UtUp, UtDw, nnt, parity, orParameter );
+		CKSU3::orStep<T_Real><<<a,b>>>( UtUp, UtDw, nnt, parity, orParameter );
 	};
-	static void microStep( int a, int b, Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity )
+	template<class T_Real> static void microStep( int a, int b, T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity )
 	{
-		CKSU3::microStep<<<a,b>>>( UtUp, UtDw, nnt, parity );
+		CKSU3::microStep<T_Real><<<a,b>>>( UtUp, UtDw, nnt, parity );
 	};
-	static void saStep( int a, int b, Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+	template<class T_Real> static void saStep( int a, int b, T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
 	{
-		CKSU3::saStep<<<a,b>>>( UtUp, UtDw, nnt, parity, temperature, rngSeed, rngCounter);
+		CKSU3::saStep<T_Real><<<a,b>>>( UtUp, UtDw, nnt, parity, temperature, rngSeed, rngCounter);
 	};
 private:
 };
@@ -205,10 +209,10 @@ __global__ void restoreThirdLine( Real* U, lat_index_t* nnt )
 
 
 
-template<class Algorithm> inline __device__ void apply( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, Algorithm algorithm  )
+template<class T_Real, class Algorithm> inline __device__ void apply( T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity, Algorithm algorithm  )
 {
 	typedef GpuPattern< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuTimeslice_2;
-	typedef Link<GpuTimeslice_2,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLink3_2;
+	typedef Link<GpuTimeslice_2,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc,T_Real> TLink3_2;
 
 	lat_coord_t size[4] = {1,Nx,Ny,Nz};
 	SiteIndex<4,FULL_SPLIT> s( size ); // If i give DEVICE_CONSTANTS::SIZE_TIMESLICE instead, register spilling is much higher! Why?
@@ -228,28 +232,28 @@ template<class Algorithm> inline __device__ void apply( Real* UtUp, Real* UtDw,
 		s.setNeighbour(mu,false);
 	}
 
-	Matrix<Complex<Real>,Nc> locMat;
-	SU3<Matrix<Complex<Real>,Nc> > locU(locMat);
+	Matrix<Complex<T_Real>,Nc> locMat;
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real> locU(locMat);
 
 	TLink3_2 link( ((mu==0)&&(updown==true))?(UtDw):(UtUp), s, mu );
 
-	SU3<TLink3_2> globU( link );
+	SU3<TLink3_2,T_Real> globU( link );
 
 	// make link local
 	locU.assignWithoutThirdLine(globU);
 	locU.reconstructThirdLine();
 
 	// define the update algorithm
-	GaugeFixingSubgroupStep<SU3<Matrix<Complex<Real>,Nc> >, Algorithm, COULOMB> subgroupStep( &locU, algorithm, id, mu, updown );
+	GaugeFixingSubgroupStep<SU3<Matrix<Complex<T_Real>,Nc>,T_Real>, Algorithm, COULOMB> subgroupStep( &locU, algorithm, id, mu, updown );
 
 	// do the subgroup iteration
-	SU3<Matrix<Complex<Real>,Nc> >::perSubgroup( subgroupStep );
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real>::perSubgroup( subgroupStep );
 
 	// copy link back
 	globU.assignWithoutThirdLine(locU);
 }
 
-__global__ void __launch_bounds__(8*NSB,OR_MINBLOCKS) orStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float orParameter )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::OR_MINBLOCKS) orStep( T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity, float orParameter )
 {
 	OrUpdate overrelax( orParameter );
 	apply( UtUp, UtDw, nnt, parity, overrelax );
@@ -257,21 +261,21 @@ __global__ void __launch_bounds__(8*NSB,OR_MINBLOCKS) orStep( Real* UtUp, Real*
 
 
 
-__global__ void __launch_bounds__(8*NSB,MS_MINBLOCKS) microStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::MS_MINBLOCKS) microStep( T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity )
 {
 	MicroUpdate micro;
 	apply( UtUp, UtDw, nnt, parity, micro );
 }
 
 
-__global__ void __launch_bounds__(8*NSB,SA_MINBLOCKS) saStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::SA_MINBLOCKS) saStep( T_Real* UtUp, T_Real* UtDw, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	SaUpdate sa( temperature, &rng );
 	apply( UtUp, UtDw, nnt, parity, sa );
 }
 
-__global__ void randomTrafo( Real* UtUp, Real* UtDw,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+template<class T_Real> __global__ void randomTrafo( T_Real* UtUp, T_Real* UtDw,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	RandomUpdate random( &rng );
@@ -0,0 +1,141 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Decides whether a gauge copy can still become the best copy.
+ *
+ * The functional is sampled every checkprecision iterations of the final (OR) stage. Once the
+ * functional converges geometrically, g_n = g_inf - c*r^n, the limit is predicted from the last
+ * three samples with Aitken's delta^2 process:
+ * 	g_inf = g2 + (g2-g1)*r/(1-r),  r = (g2-g1)/(g1-g0).
+ * As long as the trajectory is not in the geometric regime (r >= 1 or the functional decreases)
+ * we make no prediction and the copy is never abandoned. A copy counts as converged (prediction:
+ * the last sample) only if both differences are below the tolerance; noisy, non-monotone samples
+ * give no prediction.
+ *
+ * A copy is hopeless if prediction + margin < best functional so far.
+ * The policy keeps one history per slot of the GaugeCopyBatch.
+ */
+
+#ifndef EARLYSTOPPOLICY_HXX_
+#define EARLYSTOPPOLICY_HXX_
+
+#include <math.h>
+
+class EarlyStopPolicy
+{
+public:
+	EarlyStopPolicy( int slots, double margin, double tolerance = 1E-10 );
+	~EarlyStopPolicy();
+
+	void reset();
+	void addSample( int slot, double gff );
+	bool hasPrediction( int slot ) const;
+	double getPrediction( int slot ) const;
+	bool isHopeless( int slot, double bestGff ) const;
+
+	void countEarlyStop();
+	long getEarlyStops() const;
+
+private:
+	int slots;
+	double margin;
+	double tolerance;
+	// last three samples per slot (g[3*slot+2] is the most recent one)
+	double* g;
+	int* samples;
+	long earlyStops;
+};
+
+inline EarlyStopPolicy::EarlyStopPolicy( int slots, double margin, double tolerance ) : slots(slots), margin(margin), tolerance(tolerance), earlyStops(0)
+{
+	g = new double[3*slots];
+	samples = new int[slots];
+	reset();
+}
+
+inline EarlyStopPolicy::~EarlyStopPolicy()
+{
+	delete[] g;
+	delete[] samples;
+}
+
+/**
+ * Forget the trajectories, call this for each new batch of copies.
+ */
+inline void EarlyStopPolicy::reset()
+{
+	for( int k = 0; k < slots; k++ )
+	{
+		samples[k] = 0;
+	}
+}
+
+inline void EarlyStopPolicy::addSample( int slot, double gff )
+{
+	g[3*slot]   = g[3*slot+1];
+	g[3*slot+1] = g[3*slot+2];
+	g[3*slot+2] = gff;
+	samples[slot]++;
+}
+
+inline bool EarlyStopPolicy::hasPrediction( int slot ) const
+{
+	if( samples[slot] < 3 ) return false;
+
+	double d1 = g[3*slot+1] - g[3*slot];
+	double d2 = g[3*slot+2] - g[3*slot+1];
+
+	if( fabs( d1 ) < tolerance && fabs( d2 ) < tolerance ) return true; // converged up to rounding errors
+	if( d1 <= 0. || d2 <= 0. ) return false; // not monotone
+	return ( d2 < d1 );
+}
+
+/**
+ * Upper bound for the functional of this copy (only meaningful if hasPrediction()).
+ */
+inline double EarlyStopPolicy::getPrediction( int slot ) const
+{
+	double d1 = g[3*slot+1] - g[3*slot];
+	double d2 = g[3*slot+2] - g[3*slot+1];
+
+	if( fabs( d1 ) < tolerance && fabs( d2 ) < tolerance ) return g[3*slot+2];
+
+	double r = d2/d1;
+	return g[3*slot+2] + d2*r/(1.-r);
+}
+
+inline bool EarlyStopPolicy::isHopeless( int slot, double bestGff ) const
+{
+	if( !hasPrediction( slot ) ) return false;
+	return ( getPrediction( slot ) + margin < bestGff );
+}
+
+inline void EarlyStopPolicy::countEarlyStop()
+{
+	earlyStops++;
+}
+
+inline long EarlyStopPolicy::getEarlyStops() const
+{
+	return earlyStops;
+}
+
+#endif /* EARLYSTOPPOLICY_HXX_ */
@@ -0,0 +1,179 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Keeps the gauge field buffers of a gauge copy search:
+ * 	- pristine: the configuration as loaded, never modified by a gauge fixing run,
+ * 	- working:  one buffer per concurrently processed copy (slot),
+ * 	- best:     the best copy so far.
+ * A copy starts with a copy pristine -> working within the memory space of the backend.
+ * A better copy is promoted by swapping the pointers of its working buffer and the best buffer,
+ * i.e. no data is moved. The configuration is transferred to the host only once (store()).
+ *
+ * The Memory template parameter is HostMemory or DeviceMemory (see memory/).
+ * After promote() the working buffer of the slot changed: users that keep the pointer
+ * (like GaugeFixingStats) have to be updated.
+ */
+
+#ifndef FIELDBUFFERS_HXX_
+#define FIELDBUFFERS_HXX_
+
+#include "../lattice/datatype/datatypes.h"
+
+template<class Memory> class FieldBuffers
+{
+public:
+	FieldBuffers( int slots, int arraySize );
+	~FieldBuffers();
+
+	Real* getPristine();
+	Real* getWorking( int slot );
+	Real* getBest();
+	bool hasBest() const;
+
+	void load( const Real* U );
+	void reset( int slot, typename Memory::Stream stream = 0 );
+	void promote( int slot );
+	void store( Real* U );
+
+	void storePristine( Real* U );
+	void storeWorking( int slot, Real* U );
+	void loadWorking( int slot, const Real* U );
+	bool storeBest( Real* U );
+	void loadBest( const Real* U );
+
+private:
+	int slots;
+	int arraySize;
+	Real* pristine;
+	Real** working;
+	Real* best;
+	bool bestSet;
+};
+
+template<class Memory> FieldBuffers<Memory>::FieldBuffers( int slots, int arraySize ) : slots(slots), arraySize(arraySize), bestSet(false)
+{
+	pristine = Memory::allocate( arraySize );
+	best = Memory::allocate( arraySize );
+	working = new Real*[slots];
+	for( int k = 0; k < slots; k++ )
+	{
+		working[k] = Memory::allocate( arraySize );
+	}
+}
+
+template<class Memory> FieldBuffers<Memory>::~FieldBuffers()
+{
+	for( int k = 0; k < slots; k++ )
+	{
+		Memory::release( working[k] );
+	}
+	delete[] working;
+	Memory::release( best );
+	Memory::release( pristine );
+}
+
+template<class Memory> Real* FieldBuffers<Memory>::getPristine()
+{
+	return pristine;
+}
+
+template<class Memory> Real* FieldBuffers<Memory>::getWorking( int slot )
+{
+	return working[slot];
+}
+
+template<class Memory> Real* FieldBuffers<Memory>::getBest()
+{
+	return best;
+}
+
+template<class Memory> bool FieldBuffers<Memory>::hasBest() const
+{
+	return bestSet;
+}
+
+/**
+ * Transfers a new configuration from the host to the pristine buffer and forgets the best copy.
+ */
+template<class Memory> void FieldBuffers<Memory>::load( const Real* U )
+{
+	Memory::fromHost( pristine, U, arraySize );
+	bestSet = false;
+}
+
+/**
+ * Restarts the slot from the pristine configuration.
+ */
+template<class Memory> void FieldBuffers<Memory>::reset( int slot, typename Memory::Stream stream )
+{
+	Memory::copy( working[slot], pristine, arraySize, stream );
+}
+
+template<class Memory> void FieldBuffers<Memory>::promote( int slot )
+{
+	Real* temp = best;
+	best = working[slot];
+	working[slot] = temp;
+	bestSet = true;
+}
+
+/**
+ * Transfers the best copy (or the pristine configuration if no copy was promoted) to the host.
+ */
+template<class Memory> void FieldBuffers<Memory>::store( Real* U )
+{
+	Memory::toHost( U, (bestSet)?(best):(pristine), arraySize );
+}
+
+/*
+ * Direct access to the single buffers (host <-> backend), used for checkpointing.
+ */
+template<class Memory> void FieldBuffers<Memory>::storePristine( Real* U )
+{
+	Memory::toHost( U, pristine, arraySize );
+}
+
+template<class Memory> void FieldBuffers<Memory>::storeWorking( int slot, Real* U )
+{
+	Memory::toHost( U, working[slot], arraySize );
+}
+
+template<class Memory> void FieldBuffers<Memory>::loadWorking( int slot, const Real* U )
+{
+	Memory::fromHost( working[slot], U, arraySize );
+}
+
+/**
+ * Returns false (and does not touch U) if no copy was promoted yet.
+ */
+template<class Memory> bool FieldBuffers<Memory>::storeBest( Real* U )
+{
+	if( bestSet ) Memory::toHost( U, best, arraySize );
+	return bestSet;
+}
+
+template<class Memory> void FieldBuffers<Memory>::loadBest( const Real* U )
+{
+	Memory::fromHost( best, U, arraySize );
+	bestSet = true;
+}
+
+#endif /* FIELDBUFFERS_HXX_ */
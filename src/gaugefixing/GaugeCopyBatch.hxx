@@ -0,0 +1,355 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Runs K gauge copies concurrently on one device.
+ *
+ * Each slot owns a working field, a CUDA stream and a GaugeFixingStats object. The application
+ * enqueues the kernels of all active slots in turn (round robin), such that the kernels of
+ * different copies can overlap on the device. This pays off for small lattices where a single
+ * kernel does not fill the device.
+ *
+ * Every copy gets its own Philox key (getSeed()), derived from the user seed and the copy index.
+ * Together with the global counter (PhiloxWrapper::getNextCounter()) that is drawn for each launch
+ * no two copies share random numbers, independent of how many slots are used.
+ *
+ * In replica mode (setReplicaMode()) all slots hold replicas of the same gauge copy, see ReplicaExchange.hxx.
+ * Replicas that are not finished are removed from the competition for the best copy with dismiss().
+ *
+ * The best copy of a batch is chosen with getBestSlot() and kept on the device with promote().
+ * The fields are managed by FieldBuffers: copies start from the pristine configuration on the device
+ * and only the best copy is transferred to the host (store()).
+ */
+
+#ifndef GAUGECOPYBATCH_HXX_
+#define GAUGECOPYBATCH_HXX_
+
+#include "GlobalConstants.h"
+#include "GaugeFixingStats.hxx"
+#include "FieldBuffers.hxx"
+#include "memory/DeviceMemory.hxx"
+#include "../lattice/datatype/datatypes.h"
+#include "../lattice/datatype/lattice_typedefs.h"
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> class GaugeCopyBatch
+{
+public:
+	GaugeCopyBatch( int slots, int arraySize, const lat_coord_t *size );
+	~GaugeCopyBatch();
+
+	int getSlots() const;
+	int getUsedSlots() const;
+	void setReplicaMode( bool replicaMode );
+	int getCopiesPerBatch() const;
+	int begin( int firstCopy, int totalCopies );
+	void load( const Real* U );
+	void reset();
+	void promote( int slot );
+	void store( Real* U );
+	void synchronize();
+	FieldBuffers<DeviceMemory>& getFieldBuffers();
+
+	Real* getField( int slot );
+	Real* getPristine();
+	cudaStream_t getStream( int slot );
+	GaugeFixingStats<Ndim,Nc,GType,ma>& getStats( int slot );
+	int getCopy( int slot ) const;
+	int getSeed( int slot, long seed ) const;
+
+	bool isActive( int slot ) const;
+	void deactivate( int slot );
+	void dismiss( int slot );
+	bool isCandidate( int slot ) const;
+	void activateAll();
+	bool anyActive() const;
+
+	void setTiming( bool timing );
+	void generateGaugeQuality();
+	int getBestSlot( double bestGff );
+
+private:
+	int slots;
+	int usedSlots;
+	int firstCopy;
+	bool replicaMode;
+
+	FieldBuffers<DeviceMemory> fields;
+	cudaStream_t* streams;
+	GaugeFixingStats<Ndim,Nc,GType,ma>** stats;
+	bool* active;
+	bool* candidate;
+};
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeCopyBatch<Ndim,Nc,GType,ma>::GaugeCopyBatch( int slots, int arraySize, const lat_coord_t *size ) : slots(slots), usedSlots(0), firstCopy(0), replicaMode(false), fields( slots, arraySize )
+{
+	streams = new cudaStream_t[slots];
+	stats = new GaugeFixingStats<Ndim,Nc,GType,ma>*[slots];
+	active = new bool[slots];
+	candidate = new bool[slots];
+
+	for( int k = 0; k < slots; k++ )
+	{
+		cudaStreamCreate( &streams[k] );
+		stats[k] = new GaugeFixingStats<Ndim,Nc,GType,ma>( fields.getWorking(k), size );
+		stats[k]->setStream( streams[k] );
+		active[k] = false;
+		candidate[k] = false;
+	}
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeCopyBatch<Ndim,Nc,GType,ma>::~GaugeCopyBatch()
+{
+	for( int k = 0; k < slots; k++ )
+	{
+		delete stats[k];
+		cudaStreamDestroy( streams[k] );
+	}
+	delete[] stats;
+	delete[] streams;
+	delete[] active;
+	delete[] candidate;
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> int GaugeCopyBatch<Ndim,Nc,GType,ma>::getSlots() const
+{
+	return slots;
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> int GaugeCopyBatch<Ndim,Nc,GType,ma>::getUsedSlots() const
+{
+	return usedSlots;
+}
+
+/**
+ * In replica mode a batch is a single gauge copy and all slots are replicas of it.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::setReplicaMode( bool replicaMode )
+{
+	this->replicaMode = replicaMode;
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> int GaugeCopyBatch<Ndim,Nc,GType,ma>::getCopiesPerBatch() const
+{
+	return (replicaMode)?(1):(slots);
+}
+
+/**
+ * Assigns the copies firstCopy, firstCopy+1, ... to the slots and activates them.
+ * Returns the number of slots in use (less than getSlots() for the last batch).
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> int GaugeCopyBatch<Ndim,Nc,GType,ma>::begin( int firstCopy, int totalCopies )
+{
+	this->firstCopy = firstCopy;
+	if( replicaMode )
+	{
+		usedSlots = slots;
+	}
+	else
+	{
+		usedSlots = totalCopies - firstCopy;
+		if( usedSlots > slots ) usedSlots = slots;
+	}
+
+	for( int k = 0; k < slots; k++ )
+	{
+		active[k] = ( k < usedSlots );
+		candidate[k] = active[k];
+	}
+	return usedSlots;
+}
+
+/**
+ * Transfers a new configuration to the pristine device buffer (once per configuration).
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::load( const Real* U )
+{
+	fields.load( U );
+}
+
+/**
+ * Enqueues the device-to-device copy of the pristine configuration to all used slots.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::reset()
+{
+	for( int k = 0; k < usedSlots; k++ )
+	{
+		fields.reset( k, streams[k] );
+	}
+}
+
+/**
+ * Keeps the copy of this slot as best copy. The slot gets the buffer of the previous best copy.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::promote( int slot )
+{
+	cudaStreamSynchronize( streams[slot] );
+	fields.promote( slot );
+	stats[slot]->setPointer( fields.getWorking( slot ) );
+}
+
+/**
+ * Transfers the best copy to the host.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::store( Real* U )
+{
+	synchronize();
+	fields.store( U );
+}
+
+/**
+ * Access to the buffers for checkpointing. Call synchronize() before reading the working buffers.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> FieldBuffers<DeviceMemory>& GaugeCopyBatch<Ndim,Nc,GType,ma>::getFieldBuffers()
+{
+	return fields;
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::synchronize()
+{
+	for( int k = 0; k < usedSlots; k++ )
+	{
+		cudaStreamSynchronize( streams[k] );
+	}
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> Real* GaugeCopyBatch<Ndim,Nc,GType,ma>::getField( int slot )
+{
+	return fields.getWorking( slot );
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> Real* GaugeCopyBatch<Ndim,Nc,GType,ma>::getPristine()
+{
+	return fields.getPristine();
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> cudaStream_t GaugeCopyBatch<Ndim,Nc,GType,ma>::getStream( int slot )
+{
+	return streams[slot];
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeFixingStats<Ndim,Nc,GType,ma>& GaugeCopyBatch<Ndim,Nc,GType,ma>::getStats( int slot )
+{
+	return *stats[slot];
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> int GaugeCopyBatch<Ndim,Nc,GType,ma>::getCopy( int slot ) const
+{
+	return (replicaMode)?(firstCopy):(firstCopy+slot);
+}
+
+/**
+ * Philox key for the copy (or replica) in this slot. Copy 0 uses the user seed, such that a single copy
+ * run is not changed by the batching.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> int GaugeCopyBatch<Ndim,Nc,GType,ma>::getSeed( int slot, long seed ) const
+{
+	unsigned long keyIndex = (replicaMode)?(firstCopy*slots+slot):(firstCopy+slot);
+	return (int)( seed ^ ( keyIndex * 0x9E3779B9ul ) );
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> bool GaugeCopyBatch<Ndim,Nc,GType,ma>::isActive( int slot ) const
+{
+	return active[slot];
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::deactivate( int slot )
+{
+	active[slot] = false;
+}
+
+/**
+ * Deactivates the slot for the rest of the batch and excludes it from getBestSlot().
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::dismiss( int slot )
+{
+	active[slot] = false;
+	candidate[slot] = false;
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> bool GaugeCopyBatch<Ndim,Nc,GType,ma>::isCandidate( int slot ) const
+{
+	return candidate[slot];
+}
+
+/**
+ * Reactivates all used slots (except the dismissed ones), e.g. to start the next algorithm after the slots stopped one by one.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::activateAll()
+{
+	for( int k = 0; k < usedSlots; k++ )
+	{
+		active[k] = candidate[k];
+	}
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> bool GaugeCopyBatch<Ndim,Nc,GType,ma>::anyActive() const
+{
+	for( int k = 0; k < usedSlots; k++ )
+	{
+		if( active[k] ) return true;
+	}
+	return false;
+}
+
+/**
+ * Times the gauge quality measurements of all slots with events in their streams (GaugeFixingStats::setTiming()).
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::setTiming( bool timing )
+{
+	for( int k = 0; k < slots; k++ )
+	{
+		stats[k]->setTiming( timing );
+	}
+}
+
+/**
+ * Measures the gauge quality of all active slots: first all measurements are enqueued, then we wait for them.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeCopyBatch<Ndim,Nc,GType,ma>::generateGaugeQuality()
+{
+	for( int k = 0; k < usedSlots; k++ )
+	{
+		if( active[k] ) stats[k]->generateGaugeQualityAsync();
+	}
+	for( int k = 0; k < usedSlots; k++ )
+	{
+		if( active[k] ) stats[k]->synchronize();
+	}
+}
+
+/**
+ * Returns the slot with the largest functional that is larger than bestGff, or -1 if no slot did better.
+ * Ties are resolved in favour of the lower copy index (as in the sequential loop).
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> int GaugeCopyBatch<Ndim,Nc,GType,ma>::getBestSlot( double bestGff )
+{
+	int best = -1;
+	for( int k = 0; k < usedSlots; k++ )
+	{
+		if( candidate[k] && stats[k]->getCurrentGff() > bestGff )
+		{
+			bestGff = stats[k]->getCurrentGff();
+			best = k;
+		}
+	}
+	return best;
+}
+
+#endif /* GAUGECOPYBATCH_HXX_ */
@@ -52,20 +52,34 @@ __device__ inline double cuFabs( double a )
 	return (a>0)?(a):(-a);
 }
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> class GaugeFixingStats
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real = Real> class GaugeFixingStats
 {
 public:
-	GaugeFixingStats( Real *U, const lat_coord_t *size  );
-	GaugeFixingStats( Real *U, const lat_coord_t *size, double prec  );
+	GaugeFixingStats( T_Real *U, const lat_coord_t *size  );
+	GaugeFixingStats( T_Real *U, const lat_coord_t *size, double prec  );
 	~GaugeFixingStats();
 	void setGaugePrecision( double  prec );
 	double getGaugePrecision();
 	double getCurrentGff();
 	double getCurrentA();
  	void generateGaugeQuality();
- 	void setPointer( Real*U );
+ 	void generateGaugeQualityAsync();
+ 	void synchronize();
+ 	void setPointer( T_Real*U );
+ 	void setStream( cudaStream_t stream );
+ 	void setTiming( bool timing );
+ 	double getQualityTime();
 private:
-	Real *U;
+	T_Real *U;
+	cudaStream_t stream;
+	// events around the measurement in the stream (setTiming()), the host does not wait for the pending kernels
+	bool timing;
+	cudaEvent_t qualityStart;
+	cudaEvent_t qualityStop;
+	double qualityTime;
+	// page-locked host memory for the reduced values (needed for asynchronous copies)
+	double *hGff;
+	double *hA;
 	// device memory for collecting the parts of the gauge fixing functional and divA
 	double *dGff;
 	double *dA;
@@ -80,14 +94,20 @@ private:
 	void initReductionBlockSize();
 };
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeFixingStats<Ndim, Nc, GType, ma>::GaugeFixingStats( Real *U, const lat_coord_t *size) : site(size)
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::GaugeFixingStats( T_Real *U, const lat_coord_t *size) : site(size)
 {
 	this->U = U;
 	this->size = size;
 	this->dSize = DEVICE_CONSTANTS::SIZE;
 
+	this->stream = 0;
+	this->timing = false;
+	this->qualityTime = 0;
+
 	cudaMalloc( &dGff, site.getLatticeSize()*sizeof(double) );
 	cudaMalloc( &dA,   site.getLatticeSize()*sizeof(double) );
+	cudaMallocHost( &hGff, sizeof(double) );
+	cudaMallocHost( &hA,   sizeof(double) );
 
 //	std::cout << "size[0]:" << size[0] << std::endl;
 //	std::cout << "size[1]:" << size[1] << std::endl;
@@ -98,7 +118,7 @@ template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeFixingStats<Ndim,
 	initReductionBlockSize();
 }
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeFixingStats<Ndim, Nc, GType, ma>::GaugeFixingStats( Real *U, const lat_coord_t *size, double prec ) : site(size)
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::GaugeFixingStats( T_Real *U, const lat_coord_t *size, double prec ) : site(size)
 {
 	this->U = U;
 	this->size = size;
@@ -106,24 +126,67 @@ template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeFixingStats<Ndim,
 	this->reqPrec = prec;
 //	site(size);
 
+	this->stream = 0;
+	this->timing = false;
+	this->qualityTime = 0;
+
 	cudaMalloc( &dGff, site.getLatticeSize()*sizeof(double) );
 	cudaMalloc( &dA,   site.getLatticeSize()*sizeof(double) );
+	cudaMallocHost( &hGff, sizeof(double) );
+	cudaMallocHost( &hA,   sizeof(double) );
 
 	redBlockSize=512;
 	initReductionBlockSize();
 }
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeFixingStats<Ndim, Nc, GType, ma>::~GaugeFixingStats()
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::~GaugeFixingStats()
 {
 	cudaFree( &dGff );
 	cudaFree( &dA );
+	cudaFreeHost( hGff );
+	cudaFreeHost( hA );
+	setTiming( false );
 }
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeFixingStats<Ndim, Nc, GType, ma>::setPointer( Real* U )
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> void GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::setPointer( T_Real* U )
 {
 	this->U = U;
-	std::cout << "pointer set to " << U << std::endl;
+}
 
+/**
+ * All kernels and copies of the gauge quality measurement are enqueued to this stream.
+ * Stream 0 (default) keeps the synchronous behaviour.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> void GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::setStream( cudaStream_t stream )
+{
+	this->stream = stream;
+}
+
+/**
+ * With timing, the measurement is enclosed by events in its stream: getQualityTime() is the device time of the
+ * last measurement without synchronizing the kernels that were enqueued before.
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> void GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::setTiming( bool timing )
+{
+	if( timing && !this->timing )
+	{
+		cudaEventCreate( &qualityStart );
+		cudaEventCreate( &qualityStop );
+	}
+	else if( !timing && this->timing )
+	{
+		cudaEventDestroy( qualityStart );
+		cudaEventDestroy( qualityStop );
+	}
+	this->timing = timing;
+}
+
+/**
+ * Device time in seconds of the last measurement (0 without setTiming()).
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> double GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::getQualityTime()
+{
+	return qualityTime;
 }
 
 /**
@@ -132,7 +195,7 @@ template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeFixingStats<N
  * For good performance we want the block size to be at least 32 (one warp).
  * TODO 24^3*T coulomb has redBlockSize = 16 => make reduction more flexible (skip reduction stages).
  */
-template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeFixingStats<Ndim, Nc, GType, ma>::initReductionBlockSize()
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> void GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::initReductionBlockSize()
 {
 	int pot = 1;
 	for( int i = 1; i < 10; i++ )
@@ -152,22 +215,22 @@ template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeFixingStats<N
 	else printf( "We can't use parallel reduction in last reduction step\n" );
 }
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeFixingStats<Ndim, Nc, GType, ma>::setGaugePrecision( double  prec )
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> void GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::setGaugePrecision( double  prec )
 {
 	reqPrec = prec;
 }
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> double GaugeFixingStats<Ndim, Nc, GType, ma>::getGaugePrecision()
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> double GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::getGaugePrecision()
 {
 	return reqPrec;
 }
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> double GaugeFixingStats<Ndim, Nc, GType, ma>::getCurrentGff()
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> double GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::getCurrentGff()
 {
 	return currentGff;
 }
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> double GaugeFixingStats<Ndim, Nc, GType, ma>::getCurrentA()
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> double GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::getCurrentA()
 {
 	return currentA;
 }
@@ -183,20 +246,48 @@ __device__ double average_or_max( double a, double b, StoppingCrit ma);
 
 
 
-template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeFixingStats<Ndim,Nc,GType,ma>::generateGaugeQuality()
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> void GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::generateGaugeQuality()
+{
+	generateGaugeQualityAsync();
+	synchronize();
+}
+
+/**
+ * Enqueues the measurement to the stream and returns immediately.
+ * The results are available after synchronize().
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> void GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::generateGaugeQualityAsync()
 {
+	if( timing ) cudaEventRecord( qualityStart, stream );
 
-	GType::generateGaugeQualityPerSite(site.getLatticeSize()/NSB, NSB, U, dGff, dA );
+	GType::generateGaugeQualityPerSite(site.getLatticeSize()/NSB, NSB, stream, U, dGff, dA );
 //	generateGaugeQualityPerSite<Ndim,Nc,lc,ma><<<site.getLatticeSize()/32,32>>>(U, dGff, dA, dSize);
 
 	//reduce1GaugeQuality<<<site.getLatticeSize()/redBlockSize,redBlockSize>>>(dGff, dA, ma);
 	//reduce2GaugeQuality<<<site.getLatticeSize()/redBlockSize/redBlockSize,redBlockSize>>>(dGff, dA, ma);
 	//reduce3GaugeQuality<<<1,site.getLatticeSize()/redBlockSize/redBlockSize>>>(dGff, dA, redBlockSize, ma);
 
-		reduceGaugeQuality<<<1,1>>>(dGff,dA,site.getLatticeSize(), ma);
+		reduceGaugeQuality<<<1,1,0,stream>>>(dGff,dA,site.getLatticeSize(), ma);
+
+	cudaMemcpyAsync( hGff, dGff, sizeof(double), cudaMemcpyDeviceToHost, stream );
+	cudaMemcpyAsync( hA,   dA,   sizeof(double), cudaMemcpyDeviceToHost, stream );
+
+	if( timing ) cudaEventRecord( qualityStop, stream );
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma, class T_Real> void GaugeFixingStats<Ndim,Nc,GType,ma,T_Real>::synchronize()
+{
+	cudaStreamSynchronize( stream );
+
+	if( timing )
+	{
+		float ms;
+		cudaEventElapsedTime( &ms, qualityStart, qualityStop );
+		qualityTime = ms*1e-3;
+	}
 
-	cudaMemcpy( &currentGff, dGff, sizeof(double), cudaMemcpyDeviceToHost );
-	cudaMemcpy( &currentA,   dA,   sizeof(double), cudaMemcpyDeviceToHost );
+	currentGff = *hGff;
+	currentA   = *hA;
 
         //printf("currentGff = %f\n", currentGff);
 	
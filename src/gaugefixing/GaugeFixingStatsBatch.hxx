@@ -0,0 +1,164 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Gauge quality of a batch of configurations that share one strided allocation
+ * (config c starts at U+c*configStride).
+ *
+ * The per-site values are reduced separately for each configuration: one block of REDUCE_BATCH_THREADS
+ * threads per configuration sums its sites in shared memory. For small lattices this is much faster than
+ * the single-thread reduction of GaugeFixingStats, and all configurations need only one kernel call.
+ */
+
+#ifndef GAUGEFIXINGSTATSBATCH_HXX_
+#define GAUGEFIXINGSTATSBATCH_HXX_
+
+#include "GlobalConstants.h"
+#include "GaugeFixingStats.hxx"
+#include "../lattice/datatype/datatypes.h"
+#include "../lattice/datatype/lattice_typedefs.h"
+#include "../lattice/SiteCoord.hxx"
+
+#include <assert.h>
+
+#define REDUCE_BATCH_THREADS 256
+
+__global__ void reduceGaugeQualityBatch( double *dGff, double *dA, double *dGffSum, double *dASum, int latticeSize, StoppingCrit ma );
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> class GaugeFixingStatsBatch
+{
+public:
+	GaugeFixingStatsBatch( Real *U, int configs, lat_array_index_t configStride, const lat_coord_t *size );
+	~GaugeFixingStatsBatch();
+	void setConfigs( int configs );
+	int getConfigs();
+	double getCurrentGff( int config );
+	double getCurrentA( int config );
+	void generateGaugeQuality();
+private:
+	Real *U;
+	int maxConfigs;
+	int configs;
+	lat_array_index_t configStride;
+	// per-site values of all configurations
+	double *dGff;
+	double *dA;
+	// reduced values per configuration on the device and in page-locked host memory
+	double *dGffSum;
+	double *dASum;
+	double *hGff;
+	double *hA;
+	SiteCoord<Ndim,FULL_SPLIT> site;
+};
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeFixingStatsBatch<Ndim,Nc,GType,ma>::GaugeFixingStatsBatch( Real *U, int configs, lat_array_index_t configStride, const lat_coord_t *size ) : U(U), maxConfigs(configs), configs(configs), configStride(configStride), site(size)
+{
+	cudaMalloc( &dGff, (size_t)configs*site.getLatticeSize()*sizeof(double) );
+	cudaMalloc( &dA,   (size_t)configs*site.getLatticeSize()*sizeof(double) );
+	cudaMalloc( &dGffSum, configs*sizeof(double) );
+	cudaMalloc( &dASum,   configs*sizeof(double) );
+	cudaMallocHost( &hGff, configs*sizeof(double) );
+	cudaMallocHost( &hA,   configs*sizeof(double) );
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> GaugeFixingStatsBatch<Ndim,Nc,GType,ma>::~GaugeFixingStatsBatch()
+{
+	cudaFree( dGff );
+	cudaFree( dA );
+	cudaFree( dGffSum );
+	cudaFree( dASum );
+	cudaFreeHost( hGff );
+	cudaFreeHost( hA );
+}
+
+/**
+ * Number of configurations in the batch (the last batch of an ensemble may be smaller).
+ */
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeFixingStatsBatch<Ndim,Nc,GType,ma>::setConfigs( int configs )
+{
+	assert( configs <= maxConfigs );
+	this->configs = configs;
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> int GaugeFixingStatsBatch<Ndim,Nc,GType,ma>::getConfigs()
+{
+	return configs;
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> double GaugeFixingStatsBatch<Ndim,Nc,GType,ma>::getCurrentGff( int config )
+{
+	return hGff[config]*GType::getGaugeQualityPrefactorGff()/double(site.getLatticeSize());
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> double GaugeFixingStatsBatch<Ndim,Nc,GType,ma>::getCurrentA( int config )
+{
+	double A = hA[config]*GType::getGaugeQualityPrefactorA();
+	if( ma == AVERAGE ) A = A/double(site.getLatticeSize());
+	return A;
+}
+
+template<int Ndim, int Nc, class GType, StoppingCrit ma> void GaugeFixingStatsBatch<Ndim,Nc,GType,ma>::generateGaugeQuality()
+{
+	GType::generateGaugeQualityPerSiteBatch( site.getLatticeSize()/NSB, NSB, configs, U, configStride, dGff, dA );
+	reduceGaugeQualityBatch<<<configs,REDUCE_BATCH_THREADS>>>( dGff, dA, dGffSum, dASum, site.getLatticeSize(), ma );
+	cudaMemcpy( hGff, dGffSum, configs*sizeof(double), cudaMemcpyDeviceToHost );
+	cudaMemcpy( hA,   dASum,   configs*sizeof(double), cudaMemcpyDeviceToHost );
+}
+
+/**
+ * One block per configuration: strided partial sums per thread, then a tree reduction in shared memory.
+ */
+__global__ void reduceGaugeQualityBatch( double *dGff, double *dA, double *dGffSum, double *dASum, int latticeSize, StoppingCrit ma )
+{
+	__shared__ double gff[REDUCE_BATCH_THREADS];
+	__shared__ double A[REDUCE_BATCH_THREADS];
+
+	const double* configGff = &dGff[(size_t)blockIdx.x*latticeSize];
+	const double* configA = &dA[(size_t)blockIdx.x*latticeSize];
+
+	double localGff = 0;
+	double localA = 0;
+	for( int i = threadIdx.x; i < latticeSize; i += blockDim.x )
+	{
+		localGff += configGff[i];
+		localA = average_or_max( localA, configA[i], ma );
+	}
+	gff[threadIdx.x] = localGff;
+	A[threadIdx.x] = localA;
+	__syncthreads();
+
+	for( int stride = blockDim.x/2; stride > 0; stride /= 2 )
+	{
+		if( threadIdx.x < stride )
+		{
+			gff[threadIdx.x] += gff[threadIdx.x+stride];
+			A[threadIdx.x] = average_or_max( A[threadIdx.x], A[threadIdx.x+stride], ma );
+		}
+		__syncthreads();
+	}
+
+	if( threadIdx.x == 0 )
+	{
+		dGffSum[blockIdx.x] = gff[0];
+		dASum[blockIdx.x] = A[0];
+	}
+}
+
+#endif /* GAUGEFIXINGSTATSBATCH_HXX_ */
@@ -73,6 +73,7 @@ template<class SUx, class Algorithm, GaugeType lc > __device__ GaugeFixingSubgro
 
 template<class SUx, class Algorithm, GaugeType lc > __device__ void GaugeFixingSubgroupStep<SUx, Algorithm, lc>::subgroup( const int i, const int j )
 {
+	typedef typename SUx::RealType Real; // the update runs in the precision of the SU3 class
 	Quaternion<Real> q;
 #ifdef USEATOMIC
 	__shared__ Real shA[4*NSB];
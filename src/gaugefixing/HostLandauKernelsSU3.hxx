@@ -0,0 +1,418 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Landau gauge fixing on the host (CPU) for tiled patterns (AoSoAPattern, MortonPattern).
+ *
+ * The sites of a tile (Pattern::Tile sites of the same parity) are updated together: the eight links of each site
+ * (up and down in all directions) are gathered to the local arrays TileLinks::u[link][component][lane] and all
+ * arithmetic runs in loops over the lanes. These loops have no dependencies between lanes and are vectorized by the
+ * compiler (-O3), one SIMD instruction processes the whole tile. Within a tile the up-links and, except for the
+ * z-direction, also the down-links are contiguous in memory.
+ *
+ * The update is the same as in LandauKernelsSU3 (OrUpdate in the subgroups (0,2), (1,2), (0,1)). Only the first two
+ * rows are read, the third row is reconstructed and all three rows are written back.
+ * Same parity tiles do not share links, thus the tiles of a parity may be processed in any order. They are visited in
+ * storage order (Pattern::getTileCoordinates()), for MortonPattern this is the Morton curve that keeps the neighbour
+ * links in the cache.
+ *
+ * The tile loops are parallelized with OpenMP (compile with -fopenmp, e.g. -Xcompiler -fopenmp for nvcc), each thread
+ * works on its own TileLinks. Without OpenMP the pragmas are ignored and the sweeps run on a single core.
+ * SA and the microcanonical steps stay on the GPU (LandauKernelsSU3), the host backend runs OR only.
+ *
+ * T_Real = CountingReal<Real> counts the flops and link accesses of the OR update (orStepTile() on single tiles, the
+ * host counters are not thread safe), see HostLandauGaugeFixingSU3_4D.
+ */
+
+#ifndef HOSTLANDAUKERNELSSU3_HXX_
+#define HOSTLANDAUKERNELSSU3_HXX_
+
+#include "../lattice/datatype/datatypes.h"
+#include "../lattice/datatype/lattice_typedefs.h"
+#include "../lattice/SiteCoord.hxx"
+#include "../lattice/Link.hxx"
+
+#include <math.h>
+
+template<class Pattern, class T_Real = Real> class HostLandauKernelsSU3
+{
+public:
+	static const int Ndim = 4;
+	static const int Nc = 3;
+	static const int W = Pattern::Tile;
+	typedef SiteCoord<4,NO_SPLIT> Site;
+
+	HostLandauKernelsSU3( const lat_coord_t size[4] );
+
+	void orStep( T_Real* U, bool parity, float orParameter );
+	void orStepTile( T_Real* U, lat_index_t tile, bool parity, float orParameter );
+	void projectSU3( T_Real* U );
+	void generateGaugeQuality( T_Real* U, double& gff, double& A );
+
+	static double getGaugeQualityPrefactorA()
+	{
+		return 1./(double)Nc;
+	};
+	static double getGaugeQualityPrefactorGff()
+	{
+		return 1./(double)(Nc*Ndim);
+	};
+private:
+	lat_coord_t size[4];
+	lat_index_t latticeSize;
+
+	// links of a tile (0..3 up-links, 4..7 down-links), local to the thread that updates the tile
+	struct TileLinks
+	{
+		T_Real u[2*Ndim][Nc*Nc*2][W];
+		lat_array_index_t index[2*Ndim][W];
+	};
+
+	void setTile( TileLinks& links, lat_index_t tile, bool parity );
+	static void subgroupStep( TileLinks& links, int i, int j, float orParameter );
+	static void reconstructThirdLine( TileLinks& links, int link );
+};
+
+template<class Pattern, class T_Real> HostLandauKernelsSU3<Pattern,T_Real>::HostLandauKernelsSU3( const lat_coord_t size[4] )
+{
+	latticeSize = 1;
+	for( int i = 0; i < Ndim; i++ )
+	{
+		this->size[i] = size[i];
+		latticeSize *= size[i];
+	}
+}
+
+/**
+ * Calculates the array index of the up- and down-links of all sites in the tile (number "tile" of the given parity in
+ * storage order). Only the first lane is calculated by the Pattern, the lanes of a tile are consecutive (index + lane).
+ * The down-neighbours in z-direction of a tile with zOffset 0 are lane W-1 of the previous tile (first lane) and
+ * lanes 0..W-2 of the opposite parity tile at the same position.
+ */
+template<class Pattern, class T_Real> void HostLandauKernelsSU3<Pattern,T_Real>::setTile( TileLinks& links, lat_index_t tile, bool parity )
+{
+	lat_coord_t coord[Ndim];
+	Pattern::getTileCoordinates( tile, size, coord );
+
+	Site s( size );
+	s[0] = coord[0];
+	s[1] = coord[1];
+	s[2] = coord[2];
+	lat_coord_t zOffset = (parity+coord[0]+coord[1]+coord[2])%2;
+	s[3] = 2*coord[3]*W+zOffset;
+
+	for( int mu = 0; mu < Ndim; mu++ )
+	{
+		lat_array_index_t up = Pattern::getLinkIndex( s, mu );
+
+		Site down( s );
+		down[mu] = (down[mu] == 0)?(size[mu]-1):(down[mu]-1);
+		lat_array_index_t first = Pattern::getLinkIndex( down, mu );
+
+		for( int lane = 0; lane < W; lane++ )
+		{
+			links.index[mu][lane] = up + lane;
+			links.index[Ndim+mu][lane] = first + lane;
+		}
+
+		if( mu == Ndim-1 && zOffset == 0 && W > 1 )
+		{
+			Site opposite( s );
+			opposite[mu]++;
+			lat_array_index_t next = Pattern::getLinkIndex( opposite, mu );
+			for( int lane = 1; lane < W; lane++ )
+			{
+				links.index[Ndim+mu][lane] = next + lane-1;
+			}
+		}
+	}
+}
+
+/**
+ * One sweep over all tiles of the given parity.
+ */
+template<class Pattern, class T_Real> void HostLandauKernelsSU3<Pattern,T_Real>::orStep( T_Real* U, bool parity, float orParameter )
+{
+#pragma omp parallel for
+	for( lat_index_t tile = 0; tile < latticeSize/2/W; tile++ )
+	{
+		orStepTile( U, tile, parity, orParameter );
+	}
+}
+
+/**
+ * OR update of the sites of one tile.
+ */
+template<class Pattern, class T_Real> void HostLandauKernelsSU3<Pattern,T_Real>::orStepTile( T_Real* U, lat_index_t tile, bool parity, float orParameter )
+{
+	TileLinks links;
+	setTile( links, tile, parity );
+
+	// gather (components of a link are W Reals apart)
+	countLinkAccess( U, 2*Ndim*2*Nc*2*W, 0 );
+	for( int l = 0; l < 2*Ndim; l++ )
+	{
+		for( int k = 0; k < 2*Nc*2; k++ )
+			for( int lane = 0; lane < W; lane++ )
+				links.u[l][k][lane] = U[links.index[l][lane]+k*W];
+		reconstructThirdLine( links, l );
+	}
+
+	subgroupStep( links, 0, 2, orParameter );
+	subgroupStep( links, 1, 2, orParameter );
+	subgroupStep( links, 0, 1, orParameter );
+
+	// scatter
+	countLinkAccess( U, 0, 2*Ndim*Nc*Nc*2*W );
+	for( int l = 0; l < 2*Ndim; l++ )
+		for( int k = 0; k < Nc*Nc*2; k++ )
+			for( int lane = 0; lane < W; lane++ )
+				U[links.index[l][lane]+k*W] = links.u[l][k][lane];
+}
+
+/**
+ * Third row = complex conjugate of the cross product of the first two rows.
+ */
+template<class Pattern, class T_Real> void HostLandauKernelsSU3<Pattern,T_Real>::reconstructThirdLine( TileLinks& links, int l )
+{
+	T_Real (&m)[Nc*Nc*2][W] = links.u[l];
+	for( int lane = 0; lane < W; lane++ )
+	{
+		// element (i,j) is at 2*(j+3*i) (real part) and 2*(j+3*i)+1 (imaginary part)
+		for( int j = 0; j < 3; j++ )
+		{
+			int j1 = (j+1)%3;
+			int j2 = (j+2)%3;
+			T_Real re = m[2*j1][lane]*m[2*(3+j2)][lane] - m[2*j1+1][lane]*m[2*(3+j2)+1][lane]
+					- m[2*j2][lane]*m[2*(3+j1)][lane] + m[2*j2+1][lane]*m[2*(3+j1)+1][lane];
+			T_Real im = m[2*j1][lane]*m[2*(3+j2)+1][lane] + m[2*j1+1][lane]*m[2*(3+j2)][lane]
+					- m[2*j2][lane]*m[2*(3+j1)+1][lane] - m[2*j2+1][lane]*m[2*(3+j1)][lane];
+			m[2*(6+j)][lane] = re;
+			m[2*(6+j)+1][lane] = -im;
+		}
+	}
+}
+
+/**
+ * Collects the SU(2) subgroup (i,j) of the local functional, calculates the OR update and applies it to the links:
+ * U_mu(x) -> g U_mu(x), U_mu(x-mu) -> U_mu(x-mu) g^dagger (cf. GaugeFixingSubgroupStep and SU3::getSubgroupQuaternion()).
+ */
+template<class Pattern, class T_Real> void HostLandauKernelsSU3<Pattern,T_Real>::subgroupStep( TileLinks& links, int i, int j, float orParameter )
+{
+	const int ii = 2*(i+3*i);
+	const int jj = 2*(j+3*j);
+	const int ij = 2*(j+3*i);
+	const int ji = 2*(i+3*j);
+
+	T_Real a[4][W];
+	for( int lane = 0; lane < W; lane++ )
+	{
+		a[0][lane] = 0;
+		a[1][lane] = 0;
+		a[2][lane] = 0;
+		a[3][lane] = 0;
+	}
+
+	for( int l = 0; l < 2*Ndim; l++ )
+	{
+		T_Real sign = ( l < Ndim )?(-1.):(1.);
+		for( int lane = 0; lane < W; lane++ )
+		{
+			a[0][lane] += links.u[l][ii][lane] + links.u[l][jj][lane];
+			a[1][lane] += sign*( links.u[l][ij+1][lane] + links.u[l][ji+1][lane] );
+			a[2][lane] += sign*( links.u[l][ij][lane] - links.u[l][ji][lane] );
+			a[3][lane] += sign*( links.u[l][ii+1][lane] - links.u[l][jj+1][lane] );
+		}
+	}
+
+	// OrUpdate::calculateUpdate()
+	for( int lane = 0; lane < W; lane++ )
+	{
+		T_Real ai_sq = a[1][lane]*a[1][lane]+a[2][lane]*a[2][lane]+a[3][lane]*a[3][lane];
+		T_Real a0_sq = a[0][lane]*a[0][lane];
+
+		T_Real b = (orParameter*a0_sq+ai_sq)/(a0_sq+ai_sq);
+		T_Real c = 1./sqrt(a0_sq+b*b*ai_sq);
+
+		a[0][lane] *= c;
+		a[1][lane] *= b*c;
+		a[2][lane] *= b*c;
+		a[3][lane] *= b*c;
+	}
+
+	// g = ( (a0,a3) (a2,a1) ; (-a2,a1) (a0,-a3) )
+	for( int l = 0; l < Ndim; l++ )
+	{
+		for( int k = 0; k < 3; k++ )
+		{
+			const int ik = 2*(k+3*i);
+			const int jk = 2*(k+3*j);
+			for( int lane = 0; lane < W; lane++ )
+			{
+				T_Real ikRe = links.u[l][ik][lane], ikIm = links.u[l][ik+1][lane];
+				T_Real jkRe = links.u[l][jk][lane], jkIm = links.u[l][jk+1][lane];
+
+				links.u[l][ik][lane]   = a[0][lane]*ikRe - a[3][lane]*ikIm + a[2][lane]*jkRe - a[1][lane]*jkIm;
+				links.u[l][ik+1][lane] = a[0][lane]*ikIm + a[3][lane]*ikRe + a[2][lane]*jkIm + a[1][lane]*jkRe;
+				links.u[l][jk][lane]   = -a[2][lane]*ikRe - a[1][lane]*ikIm + a[0][lane]*jkRe + a[3][lane]*jkIm;
+				links.u[l][jk+1][lane] = -a[2][lane]*ikIm + a[1][lane]*ikRe + a[0][lane]*jkIm - a[3][lane]*jkRe;
+			}
+		}
+	}
+
+	// g^dagger = ( (a0,-a3) (-a2,-a1) ; (a2,-a1) (a0,a3) )
+	for( int l = Ndim; l < 2*Ndim; l++ )
+	{
+		for( int k = 0; k < 3; k++ )
+		{
+			const int ki = 2*(i+3*k);
+			const int kj = 2*(j+3*k);
+			for( int lane = 0; lane < W; lane++ )
+			{
+				T_Real kiRe = links.u[l][ki][lane], kiIm = links.u[l][ki+1][lane];
+				T_Real kjRe = links.u[l][kj][lane], kjIm = links.u[l][kj+1][lane];
+
+				// KI = g^dagger(0,0)*ki + g^dagger(1,0)*kj, KJ = g^dagger(0,1)*ki + g^dagger(1,1)*kj
+				links.u[l][ki][lane]   = a[0][lane]*kiRe + a[3][lane]*kiIm + a[2][lane]*kjRe + a[1][lane]*kjIm;
+				links.u[l][ki+1][lane] = a[0][lane]*kiIm - a[3][lane]*kiRe + a[2][lane]*kjIm - a[1][lane]*kjRe;
+				links.u[l][kj][lane]   = -a[2][lane]*kiRe + a[1][lane]*kiIm + a[0][lane]*kjRe - a[3][lane]*kjIm;
+				links.u[l][kj+1][lane] = -a[2][lane]*kiIm - a[1][lane]*kiRe + a[0][lane]*kjIm + a[3][lane]*kjRe;
+			}
+		}
+	}
+}
+
+/**
+ * Gram-Schmidt for the first two rows, the third row is reconstructed.
+ */
+template<class Pattern, class T_Real> void HostLandauKernelsSU3<Pattern,T_Real>::projectSU3( T_Real* U )
+{
+	for( int parity = 0; parity < 2; parity++ )
+#pragma omp parallel for
+		for( lat_index_t tile = 0; tile < latticeSize/2/W; tile++ )
+		{
+			TileLinks links;
+			setTile( links, tile, parity );
+			for( int l = 0; l < Ndim; l++ )
+			{
+				for( int k = 0; k < 2*Nc*2; k++ )
+					for( int lane = 0; lane < W; lane++ )
+						links.u[l][k][lane] = U[links.index[l][lane]+k*W];
+
+				T_Real (&m)[Nc*Nc*2][W] = links.u[l];
+				for( int lane = 0; lane < W; lane++ )
+				{
+					T_Real norm = 0;
+					for( int k = 0; k < 6; k++ ) norm += m[k][lane]*m[k][lane];
+					norm = 1./sqrt(norm);
+					for( int k = 0; k < 6; k++ ) m[k][lane] *= norm;
+
+					// row1 -= <row0,row1> row0
+					T_Real re = 0, im = 0;
+					for( int k = 0; k < 3; k++ )
+					{
+						re += m[2*k][lane]*m[6+2*k][lane] + m[2*k+1][lane]*m[6+2*k+1][lane];
+						im += m[2*k][lane]*m[6+2*k+1][lane] - m[2*k+1][lane]*m[6+2*k][lane];
+					}
+					for( int k = 0; k < 3; k++ )
+					{
+						T_Real r0 = m[2*k][lane], i0 = m[2*k+1][lane];
+						m[6+2*k][lane]   -= re*r0 - im*i0;
+						m[6+2*k+1][lane] -= re*i0 + im*r0;
+					}
+
+					norm = 0;
+					for( int k = 6; k < 12; k++ ) norm += m[k][lane]*m[k][lane];
+					norm = 1./sqrt(norm);
+					for( int k = 6; k < 12; k++ ) m[k][lane] *= norm;
+				}
+				reconstructThirdLine( links, l );
+
+				for( int k = 0; k < Nc*Nc*2; k++ )
+					for( int lane = 0; lane < W; lane++ )
+						U[links.index[l][lane]+k*W] = links.u[l][k][lane];
+			}
+		}
+}
+
+/**
+ * gff = sum_x sum_mu ReTr U_mu(x) and A = sum_x |Delta(x) - Delta(x)^dagger|^2 with the traceless part Delta(x) of
+ * sum_mu ( U_mu(x) - U_mu(x-mu) ), normalized as in GaugeFixingStats (AVERAGE).
+ */
+template<class Pattern, class T_Real> void HostLandauKernelsSU3<Pattern,T_Real>::generateGaugeQuality( T_Real* U, double& gff, double& A )
+{
+	double gffSum = 0;
+	double ASum = 0;
+	for( int parity = 0; parity < 2; parity++ )
+#pragma omp parallel for reduction(+:gffSum,ASum)
+		for( lat_index_t tile = 0; tile < latticeSize/2/W; tile++ )
+		{
+			TileLinks links;
+			setTile( links, tile, parity );
+			for( int l = 0; l < 2*Ndim; l++ )
+			{
+				for( int k = 0; k < 2*Nc*2; k++ )
+					for( int lane = 0; lane < W; lane++ )
+						links.u[l][k][lane] = U[links.index[l][lane]+k*W];
+				reconstructThirdLine( links, l );
+			}
+
+			for( int lane = 0; lane < W; lane++ )
+			{
+				double delta[Nc*Nc*2];
+				for( int k = 0; k < Nc*Nc*2; k++ )
+				{
+					delta[k] = 0;
+					for( int mu = 0; mu < Ndim; mu++ )
+					{
+						delta[k] += links.u[mu][k][lane] - links.u[Ndim+mu][k][lane];
+					}
+				}
+				for( int mu = 0; mu < Ndim; mu++ )
+				{
+					gffSum += links.u[mu][0][lane] + links.u[mu][8][lane] + links.u[mu][16][lane];
+				}
+
+				double trRe = (delta[0]+delta[8]+delta[16])/3.;
+				double trIm = (delta[1]+delta[9]+delta[17])/3.;
+				for( int k = 0; k < 3; k++ )
+				{
+					delta[2*(k+3*k)] -= trRe;
+					delta[2*(k+3*k)+1] -= trIm;
+				}
+
+				for( int i = 0; i < 3; i++ )
+				{
+					for( int j = 0; j < 3; j++ )
+					{
+						// (Delta - Delta^dagger)_ij
+						double re = delta[2*(j+3*i)] - delta[2*(i+3*j)];
+						double im = delta[2*(j+3*i)+1] + delta[2*(i+3*j)+1];
+						ASum += re*re + im*im;
+					}
+				}
+			}
+		}
+
+	gff = gffSum*getGaugeQualityPrefactorGff()/(double)latticeSize;
+	A = ASum*getGaugeQualityPrefactorA()/(double)latticeSize;
+}
+
+#endif /* HOSTLANDAUKERNELSSU3_HXX_ */
@@ -0,0 +1,118 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Storage policy of the Landau kernels (template parameter of BasicLandauKernelsSU3): the Site class that the kernels
+ * use for the neighbour access, the type of its neighbour table and the number of reals per link.
+ *
+ *	KernelStorage<SiteIndex<4,FULL_SPLIT> >            neighbour table of lat_index_t, 18 reals (DefaultKernelStorage)
+ *	KernelStorage<SiteIndexCompressed<4,FULL_SPLIT> >  16 bit offsets (lat_offset_t)
+ *	KernelStorage<SiteIndexOnTheFly<4,FULL_SPLIT> >    no table, the neighbours are calculated (pass NULL)
+ *	KernelStorage<SiteIndex<4,FULL_SPLIT>,12>          links stored as Link12 (two rows), GpuPatternCompressed layout
+ *	KernelStorage<SiteIndex<4,FULL_SPLIT>,8>           links stored as Link8 (hot configurations only, see Link8.hxx)
+ *
+ * NeighbourTable<Site> gives the table type, its number of entries and fills it on the host, such that an application
+ * sets up the table for any of the Site classes (see NeighbourBenchmarkSU3_4D for the comparison).
+ * LinkStorage<Site,Ndim,Nc,Reals,T_Real>::Type is the link class for a number of reals (Link, Link12 or Link8), a field
+ * needs Reals*Ndim*latticeSize reals.
+ */
+
+#ifndef KERNELSTORAGE_HXX_
+#define KERNELSTORAGE_HXX_
+
+#include "../lattice/datatype/lattice_typedefs.h"
+#include "../lattice/SiteIndex.hxx"
+#include "../lattice/SiteIndexCompressed.hxx"
+#include "../lattice/SiteIndexOnTheFly.hxx"
+#include "../lattice/access_pattern/GpuPattern.hxx"
+#include "../lattice/access_pattern/GpuPatternCompressed.hxx"
+#include "../lattice/Link.hxx"
+#include "../lattice/Link12.hxx"
+#include "../lattice/Link8.hxx"
+
+template<class Site> struct NeighbourTable;
+
+template<lat_dim_t Nd, ParityType par> struct NeighbourTable<SiteIndex<Nd,par> >
+{
+	typedef lat_index_t Table;
+	static lat_index_t getEntries( lat_index_t latticeSize )
+	{
+		return 2*Nd*latticeSize;
+	}
+	static void calculate( const lat_coord_t size[Nd], Table* nn )
+	{
+		SiteIndex<Nd,par> s( size );
+		s.calculateNeighbourTable( nn );
+	}
+};
+
+template<lat_dim_t Nd, ParityType par> struct NeighbourTable<SiteIndexCompressed<Nd,par> >
+{
+	typedef lat_offset_t Table;
+	static lat_index_t getEntries( lat_index_t latticeSize )
+	{
+		return 2*Nd*latticeSize;
+	}
+	static void calculate( const lat_coord_t size[Nd], Table* nn )
+	{
+		SiteIndexCompressed<Nd,par> s( size );
+		s.calculateNeighbourTable( nn );
+	}
+};
+
+template<lat_dim_t Nd, ParityType par> struct NeighbourTable<SiteIndexOnTheFly<Nd,par> >
+{
+	typedef lat_index_t Table;
+	static lat_index_t getEntries( lat_index_t latticeSize )
+	{
+		return 0;
+	}
+	static void calculate( const lat_coord_t size[Nd], Table* nn )
+	{
+	}
+};
+
+template<class Site, lat_dim_t Ndim, lat_group_dim_t Nc, int Reals, class T_Real> struct LinkStorage;
+
+template<class Site, lat_dim_t Ndim, lat_group_dim_t Nc, class T_Real> struct LinkStorage<Site,Ndim,Nc,18,T_Real>
+{
+	typedef Link<GpuPattern<Site,Ndim,Nc>,Site,Ndim,Nc,T_Real> Type;
+};
+
+template<class Site, lat_dim_t Ndim, lat_group_dim_t Nc, class T_Real> struct LinkStorage<Site,Ndim,Nc,12,T_Real>
+{
+	typedef Link12<GpuPatternCompressed<Site,Ndim,Nc,12>,Site,Ndim,Nc,T_Real> Type;
+};
+
+template<class Site, lat_dim_t Ndim, lat_group_dim_t Nc, class T_Real> struct LinkStorage<Site,Ndim,Nc,8,T_Real>
+{
+	typedef Link8<GpuPatternCompressed<Site,Ndim,Nc,8>,Site,Ndim,Nc,T_Real> Type;
+};
+
+template<class T_Site, int T_Reals = 18> struct KernelStorage
+{
+	typedef T_Site Site;
+	typedef typename NeighbourTable<T_Site>::Table Table;
+	static const int Reals = T_Reals;
+};
+
+typedef KernelStorage<SiteIndex<4,FULL_SPLIT> > DefaultKernelStorage;
+
+#endif /* KERNELSTORAGE_HXX_ */
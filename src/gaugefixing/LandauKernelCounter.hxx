@@ -0,0 +1,233 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Flop and memory access counts of the gauge fixing kernels, derived from the code instead of hand-counted constants.
+ *
+ * The kernels of GType (LandauKernelsSU3, MAGKernelsSU3 or U1xU1KernelsSU3) are instantiated with CountingReal<T_Real>
+ * and run on a few blocks (both parities) of a private hot field. The counts are divided by the number of updated
+ * sites, i.e. they are the counts per site and sweep. The loads and stores are the reals of the link array accessed
+ * by the link storage class, e.g. Link12 for BasicLandauKernelsSU3<KernelStorage<Site,12> > (the neighbour table is not counted).
+ * The heatbath is data dependent (rejection loops), its counts are averages at the given temperature.
+ *
+ *	LandauKernelCounter<Real> counter( dNn, latticeSize );
+ *	KernelCount orCount = counter.orStep( options.getOrParameter() );
+ *	gflops = orCount.getFlops()*latticeSize*sweeps/time/1e9;
+ *
+ * Kernels with another interface (the timeslice kernels of CoulombKernelsSU3) are launched by the caller on the
+ * fields of the counter between begin() and finish():
+ *
+ *	LandauKernelCounter<Real> counter( dNnt, latticeSizeTimeslice, 4, HOST_CONSTANTS::getPtrToDeviceSizeTimeslice(), 2 );
+ *	counter.begin();
+ *	CoulombKernelsSU3::orStep( counter.getBlocks(), NSB*8, counter.getField(0), counter.getField(1), dNnt, 0, orParameter );
+ *	CoulombKernelsSU3::orStep( counter.getBlocks(), NSB*8, counter.getField(0), counter.getField(1), dNnt, 1, orParameter );
+ *	KernelCount orCount = counter.finish( 2*counter.getBlocks()*NSB );
+ *
+ * Counting kernels use atomic counters and are slow, the constructor allocates the fields (of latticeSize sites each,
+ * hot). The counter draws its random numbers with its own Philox counter, the global counter of the application is not touched.
+ */
+
+#ifndef LANDAUKERNELCOUNTER_HXX_
+#define LANDAUKERNELCOUNTER_HXX_
+
+#include <iostream>
+#include <iomanip>
+#include "GlobalConstants.h"
+#include "LandauKernelsSU3.hxx"
+#include "CommonKernelsSU3.hxx"
+#include "../lattice/datatype/CountingReal.hxx"
+#include "../lattice/rng/PhiloxWrapper.hxx"
+
+template<> __device__ inline CountingReal<float> PhiloxWrapper::rand<CountingReal<float> >()
+{
+	return CountingReal<float>( rand<float>() );
+}
+
+template<> __device__ inline CountingReal<double> PhiloxWrapper::rand<CountingReal<double> >()
+{
+	return CountingReal<double>( rand<double>() );
+}
+
+/**
+ * Counts per site and sweep.
+ */
+struct KernelCount
+{
+	double n[COUNTED_OPERATIONS];
+	int realSize;
+
+	double getFlops() const
+	{
+		return n[COUNT_ADD]+n[COUNT_MUL]+n[COUNT_DIV]+n[COUNT_SQRT]+n[COUNT_SPECIAL];
+	}
+	double getBytes() const
+	{
+		return ( n[COUNT_LOAD]+n[COUNT_STORE] )*realSize;
+	}
+};
+
+/**
+ * Hot start of the counter fields in the link storage of GType (the compressed links of BasicLandauKernelsSU3).
+ */
+template<class GType> struct CounterHotStart
+{
+	template<class T_Real> static void setHot( int a, int b, T_Real* U, lat_coord_t* dSize, int rngSeed, int rngCounter )
+	{
+		CommonKernelsSU3::setHot( a, b, U, dSize, rngSeed, rngCounter );
+	}
+};
+
+template<class Storage> struct CounterHotStart<BasicLandauKernelsSU3<Storage> >
+{
+	template<class T_Real> static void setHot( int a, int b, T_Real* U, lat_coord_t* dSize, int rngSeed, int rngCounter )
+	{
+		BasicLandauKernelsSU3<Storage>::setHot( a, b, U, dSize, rngSeed, rngCounter );
+	}
+};
+
+template<class T_Real = Real, class GType = LandauKernelsSU3> class LandauKernelCounter
+{
+public:
+	LandauKernelCounter( lat_index_t* dNn, int latticeSize, int blocks = 4, lat_coord_t* dSize = HOST_CONSTANTS::getPtrToDeviceSize(), int fields = 1 );
+	~LandauKernelCounter();
+	KernelCount orStep( float orParameter );
+	KernelCount srStep( float srParameter );
+	KernelCount saStep( float temperature );
+	KernelCount microStep();
+	KernelCount projectSU3();
+	void begin();
+	KernelCount finish( int sites );
+	CountingReal<T_Real>* getField( int field = 0 );
+	int getBlocks() const;
+	int getNextRngCounter();
+	static void print( std::ostream& out, const char* name, const KernelCount& count );
+
+private:
+	CountingReal<T_Real>* dU;
+	lat_index_t* dNn;
+	lat_coord_t* dSize;
+	int latticeSize;
+	int blocks;
+	int rngCounter;
+};
+
+template<class T_Real, class GType> LandauKernelCounter<T_Real,GType>::LandauKernelCounter( lat_index_t* dNn, int latticeSize, int blocks, lat_coord_t* dSize, int fields ) : dNn(dNn), dSize(dSize), latticeSize(latticeSize), blocks(blocks), rngCounter(0)
+{
+	cudaMalloc( &dU, (size_t)fields*latticeSize*4*3*3*2*sizeof(CountingReal<T_Real>) );
+	for( int i = 0; i < fields; i++ )
+	{
+		CounterHotStart<GType>::setHot( latticeSize/32,32, (T_Real*)getField(i), dSize, 0, rngCounter++ );
+	}
+}
+
+template<class T_Real, class GType> LandauKernelCounter<T_Real,GType>::~LandauKernelCounter()
+{
+	cudaFree( dU );
+}
+
+template<class T_Real, class GType> KernelCount LandauKernelCounter<T_Real,GType>::orStep( float orParameter )
+{
+	begin();
+	GType::orStep( blocks, NSB*8, dU, dNn, 0, orParameter );
+	GType::orStep( blocks, NSB*8, dU, dNn, 1, orParameter );
+	return finish( 2*blocks*NSB );
+}
+
+template<class T_Real, class GType> KernelCount LandauKernelCounter<T_Real,GType>::srStep( float srParameter )
+{
+	begin();
+	GType::srStep( blocks, NSB*8, dU, dNn, 0, srParameter, 0, rngCounter++ );
+	GType::srStep( blocks, NSB*8, dU, dNn, 1, srParameter, 0, rngCounter++ );
+	return finish( 2*blocks*NSB );
+}
+
+template<class T_Real, class GType> KernelCount LandauKernelCounter<T_Real,GType>::saStep( float temperature )
+{
+	begin();
+	GType::saStep( blocks, NSB*8, dU, dNn, 0, temperature, 0, rngCounter++ );
+	GType::saStep( blocks, NSB*8, dU, dNn, 1, temperature, 0, rngCounter++ );
+	return finish( 2*blocks*NSB );
+}
+
+template<class T_Real, class GType> KernelCount LandauKernelCounter<T_Real,GType>::microStep()
+{
+	begin();
+	GType::microStep( blocks, NSB*8, dU, dNn, 0 );
+	GType::microStep( blocks, NSB*8, dU, dNn, 1 );
+	return finish( 2*blocks*NSB );
+}
+
+/**
+ * Reprojection of all four links of a site (CommonKernelsSU3::projectSU3(), one thread per site).
+ */
+template<class T_Real, class GType> KernelCount LandauKernelCounter<T_Real,GType>::projectSU3()
+{
+	begin();
+	CommonKernelsSU3::projectSU3( blocks, 32, dU, dSize );
+	return finish( blocks*32 );
+}
+
+template<class T_Real, class GType> void LandauKernelCounter<T_Real,GType>::begin()
+{
+	resetDeviceOperationCounts();
+}
+
+/**
+ * Waits for the kernels launched since begin() and divides the counts by the number of updated sites.
+ */
+template<class T_Real, class GType> KernelCount LandauKernelCounter<T_Real,GType>::finish( int sites )
+{
+	cudaDeviceSynchronize();
+	OperationCounts counts = getDeviceOperationCounts();
+	KernelCount result;
+	for( int i = 0; i < COUNTED_OPERATIONS; i++ )
+	{
+		result.n[i] = (double)counts.n[i]/(double)sites;
+	}
+	result.realSize = sizeof(T_Real);
+	return result;
+}
+
+template<class T_Real, class GType> CountingReal<T_Real>* LandauKernelCounter<T_Real,GType>::getField( int field )
+{
+	return &dU[(size_t)field*latticeSize*4*3*3*2];
+}
+
+template<class T_Real, class GType> int LandauKernelCounter<T_Real,GType>::getBlocks() const
+{
+	return blocks;
+}
+
+template<class T_Real, class GType> int LandauKernelCounter<T_Real,GType>::getNextRngCounter()
+{
+	return rngCounter++;
+}
+
+template<class T_Real, class GType> void LandauKernelCounter<T_Real,GType>::print( std::ostream& out, const char* name, const KernelCount& count )
+{
+	out << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(10) << count.getFlops() << " flops (add " << count.n[COUNT_ADD] << ", mul " << count.n[COUNT_MUL]
+			<< ", div " << count.n[COUNT_DIV] << ", sqrt " << count.n[COUNT_SQRT] << ", special " << count.n[COUNT_SPECIAL]
+			<< "), " << count.getBytes() << " bytes per site and sweep" << std::endl;
+	out.unsetf( std::ios::fixed );
+	out << std::setprecision(6);
+}
+
+#endif /* LANDAUKERNELCOUNTER_HXX_ */
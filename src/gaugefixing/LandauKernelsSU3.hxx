@@ -31,11 +31,13 @@
 #include "GaugeFixingSubgroupStep.hxx"
 #include "algorithms/SaUpdate.hxx"
 #include "algorithms/OrUpdate.hxx"
+#include "algorithms/SrUpdate.hxx"
 #include "algorithms/MicroUpdate.hxx"
 #include "algorithms/RandomUpdate.hxx"
 #include "../lattice/Matrix.hxx"
 #include "../lattice/SU3.hxx"
 #include "../lattice/Link.hxx"
+#include "KernelStorage.hxx"
 
 
 // kernels as class members are not supported (even static): wrap the kernel calls and hide the kernels in namespace.
@@ -43,34 +45,64 @@ namespace LKSU3
 {
 static const int Ndim = 4;
 static const int Nc = 3;
-__global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA );
-__global__ void restoreThirdLine( Real* U, lat_index_t* nnt );
-__global__ void randomTrafo( Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter );
-__global__ void orStep( Real* U, lat_index_t* nnt, bool parity, float orParameter );
+template<class T_Real, class Storage> __global__ void generateGaugeQualityPerSite( T_Real* U, double *dGff, double *dA );
+template<class T_Real, class Storage> __global__ void projectSU3( T_Real* U );
+template<class T_Real, class Storage> __global__ void setHot( T_Real* U, lat_coord_t* ptrToDeviceSize, int rngSeed, int rngCounter );
+template<class T_Real, class Storage> __global__ void restoreThirdLine( T_Real* U, typename Storage::Table* nnt );
+template<class T_Real, class Storage> __global__ void randomTrafo( T_Real* U,typename Storage::Table* nnt, bool parity, int rngSeed, int rngCounter );
+template<class T_Real, class Storage> __global__ void orStep( T_Real* U, typename Storage::Table* nnt, bool parity, float orParameter );
 __global__ void orStepSingleThread( Real* U, lat_index_t* nnt, bool parity, float orParameter );
-__global__ void microStep( Real* U, lat_index_t* nnt, bool parity );
-__global__ void saStep( Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
+template<class T_Real, class Storage> __global__ void microStep( T_Real* U, typename Storage::Table* nnt, bool parity );
+template<class T_Real, class Storage> __global__ void saStep( T_Real* U, typename Storage::Table* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
+template<class T_Real, class Storage> __global__ void srStep( T_Real* U, typename Storage::Table* nnt, bool parity, float srParameter, int rngSeed, int rngCounter );
+
+// batched versions: configuration blockIdx.y starts at U+blockIdx.y*configStride, inactive configurations are skipped
+template<class T_Real, class Storage> __global__ void generateGaugeQualityPerSiteBatch( T_Real* U, lat_array_index_t configStride, double *dGff, double *dA );
+template<class T_Real, class Storage> __global__ void randomTrafoBatch( T_Real* U, lat_array_index_t configStride, typename Storage::Table* nnt, bool parity, int rngSeed, int rngCounter );
+template<class T_Real, class Storage> __global__ void orStepBatch( T_Real* U, lat_array_index_t configStride, typename Storage::Table* nnt, bool parity, float orParameter, const int* active );
+template<class T_Real, class Storage> __global__ void microStepBatch( T_Real* U, lat_array_index_t configStride, typename Storage::Table* nnt, bool parity, const int* active );
+template<class T_Real, class Storage> __global__ void saStepBatch( T_Real* U, lat_array_index_t configStride, typename Storage::Table* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
 }
 
-class LandauKernelsSU3
+/**
+ * Storage selects the Site class of the neighbour access, the type of the neighbour table and the link storage
+ * (see KernelStorage.hxx), LandauKernelsSU3 is the default (SiteIndex with a full lat_index_t table, 18 reals per link).
+ * The fields passed to the kernels are in the layout of the link storage (Reals*4*latticeSize reals), compress() and
+ * decompress() convert from and to the 18 real GpuPattern field on the host.
+ */
+template<class Storage = DefaultKernelStorage> class BasicLandauKernelsSU3
 {
 public:
+	typedef typename Storage::Table Table;
+	static const int Reals = Storage::Reals;
+
 //	__global__ static void heatbathStep( Real* UtDw, Real* Ut, Real* UtUp, lat_index_t* nnt, float beta, bool parity, int counter );
 
 	// TODO remove static and make the init in constructor
-	static void initCacheConfig()
-	{
-		cudaFuncSetCacheConfig( LKSU3::generateGaugeQualityPerSite, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( LKSU3::restoreThirdLine, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( LKSU3::randomTrafo, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( LKSU3::orStep, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( LKSU3::microStep, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( LKSU3::saStep, cudaFuncCachePreferL1 );
+	template<class T_Real = Real> static void initCacheConfig()
+	{
+		cudaFuncSetCacheConfig( LKSU3::generateGaugeQualityPerSite<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::restoreThirdLine<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::projectSU3<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::randomTrafo<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::orStep<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::microStep<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::saStep<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::srStep<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::generateGaugeQualityPerSiteBatch<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::randomTrafoBatch<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::orStepBatch<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::microStepBatch<T_Real,Storage>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( LKSU3::saStepBatch<T_Real,Storage>, cudaFuncCachePreferL1 );
 	}
 
-	static void generateGaugeQualityPerSite( int a, int b, Real *U, double *dGff, double *dA )
+	template<class T_Real> static void generateGaugeQualityPerSite( int a, int b, T_Real *U, double *dGff, double *dA )
 	{
-		LKSU3::generateGaugeQualityPerSite<<<a,b>>>(U,dGff, dA);
+		LKSU3::generateGaugeQualityPerSite<T_Real,Storage><<<a,b>>>(U,dGff, dA);
+	};
+	template<class T_Real> static void generateGaugeQualityPerSite( int a, int b, cudaStream_t stream, T_Real *U, double *dGff, double *dA )
+	{
+		LKSU3::generateGaugeQualityPerSite<T_Real,Storage><<<a,b,0,stream>>>(U,dGff, dA);
 	};
 	static double getGaugeQualityPrefactorA()
 	{
@@ -81,29 +113,137 @@ public:
 		return 1./(double)(LKSU3::Nc*LKSU3::Ndim);
 	};
 
-	static void restoreThirdLine( int a, int b, Real* U, lat_index_t* nnt )
+	template<class T_Real> static void restoreThirdLine( int a, int b, T_Real* U, Table* nnt )
+	{
+		LKSU3::restoreThirdLine<T_Real,Storage><<<a,b>>>(U,nnt);
+	};
+
+	// reprojection to SU(3) in the link storage (one thread per site), replaces CommonKernelsSU3::projectSU3()
+	template<class T_Real> static void projectSU3( int a, int b, T_Real* U )
+	{
+		LKSU3::projectSU3<T_Real,Storage><<<a,b>>>( U );
+	};
+	template<class T_Real> static void projectSU3( int a, int b, cudaStream_t stream, T_Real* U )
+	{
+		LKSU3::projectSU3<T_Real,Storage><<<a,b,0,stream>>>( U );
+	};
+	template<class T_Real> static void setHot( int a, int b, T_Real* U, lat_coord_t* ptrToDeviceSize, int rngSeed, int rngCounter )
+	{
+		LKSU3::setHot<T_Real,Storage><<<a,b>>>( U, ptrToDeviceSize, rngSeed, rngCounter );
+	};
+
+	/**
+	 * Copies the 18 real field U (GpuPattern) to the field UStorage in the link storage (compress = true) or back.
+	 * Link12 drops the third row, Link8 keeps eight parameters; the third row is reconstructed when decompressing.
+	 */
+	template<class T_Real> static void convert( T_Real* U, T_Real* UStorage, bool compress )
+	{
+		typedef SiteIndex<LKSU3::Ndim,FULL_SPLIT> Site;
+		typedef typename LinkStorage<Site,LKSU3::Ndim,LKSU3::Nc,18,T_Real>::Type TLink18;
+		typedef typename LinkStorage<Site,LKSU3::Ndim,LKSU3::Nc,Reals,T_Real>::Type TLink;
+
+		Site s( HOST_CONSTANTS::SIZE );
+		for( lat_index_t site = 0; site < s.getLatticeSize(); site++ )
+		{
+			s.setLatticeIndex( site );
+			for( int mu = 0; mu < LKSU3::Ndim; mu++ )
+			{
+				TLink18 fullLink( U, s, mu );
+				SU3<TLink18,T_Real> full( fullLink );
+				TLink storageLink( UStorage, s, mu );
+				SU3<TLink,T_Real> stored( storageLink );
+
+				Matrix<Complex<T_Real>,LKSU3::Nc> locMat;
+				SU3<Matrix<Complex<T_Real>,LKSU3::Nc>,T_Real> locU( locMat );
+				if( compress )
+				{
+					locU = full;
+					stored = locU;
+				}
+				else
+				{
+					locU.assignWithoutThirdLine( stored );
+					locU.reconstructThirdLine();
+					full = locU;
+				}
+			}
+		}
+	}
+	template<class T_Real> static void compress( T_Real* U, T_Real* UStorage )
+	{
+		convert( U, UStorage, true );
+	}
+	template<class T_Real> static void decompress( T_Real* UStorage, T_Real* U )
+	{
+		convert( U, UStorage, false );
+	}
+	template<class T_Real> static void randomTrafo( int a, int b, T_Real* U,Table* nnt, bool parity, int rngSeed, int rngCounter )
+	{
+		LKSU3::randomTrafo<T_Real,Storage><<<a,b>>>( U, nnt, parity, rngSeed, rngCounter );
+	};
+	template<class T_Real> static void randomTrafo( int a, int b, cudaStream_t stream, T_Real* U,Table* nnt, bool parity, int rngSeed, int rngCounter )
+	{
+		LKSU3::randomTrafo<T_Real,Storage><<<a,b,0,stream>>>( U, nnt, parity, rngSeed, rngCounter );
+	};
+	template<class T_Real> static void orStep( int a, int b,  T_Real* U, Table* nnt, bool parity, float orParameter )
 	{
-		LKSU3::restoreThirdLine<<<a,b>>>(U,nnt);
+		LKSU3::orStep<T_Real,Storage><<<a,b>>>( U, nnt, parity, orParameter );
 	};
-	static void randomTrafo( int a, int b, Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+	template<class T_Real> static void orStep( int a, int b, cudaStream_t stream, T_Real* U, Table* nnt, bool parity, float orParameter )
 	{
-		LKSU3::randomTrafo<<<a,b>>>( U, nnt, parity, rngSeed, rngCounter );
+		LKSU3::orStep<T_Real,Storage><<<a,b,0,stream>>>( U, nnt, parity, orParameter );
 	};
-	static void orStep( int a, int b,  Real* U, lat_index_t* nnt, bool parity, float orParameter )
+	template<class T_Real> static void microStep( int a, int b, T_Real* U, Table* nnt, bool parity )
 	{
-		LKSU3::orStep<<<a,b>>>( U, nnt, parity, orParameter );
+		LKSU3::microStep<T_Real,Storage><<<a,b>>>( U, nnt, parity );
 	};
-	static void microStep( int a, int b, Real* U, lat_index_t* nnt, bool parity )
+	template<class T_Real> static void microStep( int a, int b, cudaStream_t stream, T_Real* U, Table* nnt, bool parity )
 	{
-		LKSU3::microStep<<<a,b>>>( U, nnt, parity );
+		LKSU3::microStep<T_Real,Storage><<<a,b,0,stream>>>( U, nnt, parity );
 	};
-	static void saStep( int a, int b, Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+	template<class T_Real> static void saStep( int a, int b, T_Real* U, Table* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
 	{
-		LKSU3::saStep<<<a,b>>>( U, nnt, parity, temperature, rngSeed, rngCounter);
+		LKSU3::saStep<T_Real,Storage><<<a,b>>>( U, nnt, parity, temperature, rngSeed, rngCounter);
+	};
+	template<class T_Real> static void saStep( int a, int b, cudaStream_t stream, T_Real* U, Table* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+	{
+		LKSU3::saStep<T_Real,Storage><<<a,b,0,stream>>>( U, nnt, parity, temperature, rngSeed, rngCounter);
+	};
+	template<class T_Real> static void srStep( int a, int b, T_Real* U, Table* nnt, bool parity, float srParameter, int rngSeed, int rngCounter )
+	{
+		LKSU3::srStep<T_Real,Storage><<<a,b>>>( U, nnt, parity, srParameter, rngSeed, rngCounter );
+	};
+	template<class T_Real> static void srStep( int a, int b, cudaStream_t stream, T_Real* U, Table* nnt, bool parity, float srParameter, int rngSeed, int rngCounter )
+	{
+		LKSU3::srStep<T_Real,Storage><<<a,b,0,stream>>>( U, nnt, parity, srParameter, rngSeed, rngCounter );
+	};
+
+	// many small configurations in one strided allocation, the grid is (a,configs)
+	template<class T_Real> static void generateGaugeQualityPerSiteBatch( int a, int b, int configs, T_Real *U, lat_array_index_t configStride, double *dGff, double *dA )
+	{
+		LKSU3::generateGaugeQualityPerSiteBatch<T_Real,Storage><<<dim3(a,configs),b>>>( U, configStride, dGff, dA );
+	};
+	template<class T_Real> static void randomTrafoBatch( int a, int b, int configs, T_Real* U, lat_array_index_t configStride, Table* nnt, bool parity, int rngSeed, int rngCounter )
+	{
+		LKSU3::randomTrafoBatch<T_Real,Storage><<<dim3(a,configs),b>>>( U, configStride, nnt, parity, rngSeed, rngCounter );
+	};
+	template<class T_Real> static void orStepBatch( int a, int b, int configs, T_Real* U, lat_array_index_t configStride, Table* nnt, bool parity, float orParameter, const int* active )
+	{
+		LKSU3::orStepBatch<T_Real,Storage><<<dim3(a,configs),b>>>( U, configStride, nnt, parity, orParameter, active );
+	};
+	template<class T_Real> static void microStepBatch( int a, int b, int configs, T_Real* U, lat_array_index_t configStride, Table* nnt, bool parity, const int* active )
+	{
+		LKSU3::microStepBatch<T_Real,Storage><<<dim3(a,configs),b>>>( U, configStride, nnt, parity, active );
+	};
+	template<class T_Real> static void saStepBatch( int a, int b, int configs, T_Real* U, lat_array_index_t configStride, Table* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+	{
+		LKSU3::saStepBatch<T_Real,Storage><<<dim3(a,configs),b>>>( U, configStride, nnt, parity, temperature, rngSeed, rngCounter );
 	};
 private:
 };
 
+typedef BasicLandauKernelsSU3<> LandauKernelsSU3;
+
 
 
 
@@ -111,16 +251,14 @@ private:
 namespace LKSU3
 {
 
-__global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA )
+template<class Storage, class T_Real> inline __device__ void gaugeQualityPerSite( T_Real *U, int site, double *dGff, double *dA )
 {
-	typedef GpuPattern< SiteCoord<Ndim,FULL_SPLIT>,Ndim,Nc> Gpu;
-	typedef Link<Gpu,SiteCoord<Ndim,FULL_SPLIT>,Ndim,Nc> TLink;
+	typedef typename LinkStorage<SiteCoord<Ndim,FULL_SPLIT>,Ndim,Nc,Storage::Reals,T_Real>::Type TLink;
 
 	SiteCoord<Ndim,FULL_SPLIT> s(DEVICE_CONSTANTS::SIZE);
-	int site = blockIdx.x * blockDim.x + threadIdx.x;
 
-	Matrix<Complex<Real>,Nc> locMatSum;
-	SU3<Matrix<Complex<Real>,Nc> > Sum(locMatSum);
+	Matrix<Complex<T_Real>,Nc> locMatSum;
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real> Sum(locMatSum);
 
 	Sum.zero();
 
@@ -129,11 +267,11 @@ __global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA )
 	{
 		s.setLatticeIndex( site );
 
-		Matrix<Complex<Real>,Nc> locMat;
-		SU3<Matrix<Complex<Real>,Nc> > temp(locMat);
+		Matrix<Complex<T_Real>,Nc> locMat;
+		SU3<Matrix<Complex<T_Real>,Nc>,T_Real> temp(locMat);
 
 		TLink linkUp( U, s, mu );
-		SU3<TLink> globUp( linkUp );
+		SU3<TLink,T_Real> globUp( linkUp );
 
 		temp.assignWithoutThirdLine( globUp );
 //				temp.projectSU3withoutThirdRow();// TODO project here?
@@ -143,7 +281,7 @@ __global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA )
 
 		s.setNeighbour(mu,false);
 		TLink linkDw( U, s, mu );
-		SU3<TLink> globDw( linkDw );
+		SU3<TLink,T_Real> globDw( linkDw );
 		temp.assignWithoutThirdLine( globDw );
 //				temp.projectSU3withoutThirdRow(); // TODO project here?
 //				globDw.assignWithoutThirdLine( temp ); // TODO
@@ -151,10 +289,10 @@ __global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA )
 		Sum -= temp;
 	}
 
-	Sum -= Sum.trace()/Real(3.);
+	Sum -= Sum.trace()/T_Real(3.);
 
-	Matrix<Complex<Real>,Nc> locMatSumHerm;
-	SU3<Matrix<Complex<Real>,Nc> > SumHerm(locMatSumHerm);
+	Matrix<Complex<T_Real>,Nc> locMatSumHerm;
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real> SumHerm(locMatSumHerm);
 	SumHerm = Sum;
 	SumHerm.hermitian();
 
@@ -175,12 +313,12 @@ __global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA )
 	s.setLatticeIndex( site );
 	double result = 0;
 
-	Matrix<Complex<Real>,Nc> locTemp;
-	SU3<Matrix<Complex<Real>,Nc> > temp(locTemp);
+	Matrix<Complex<T_Real>,Nc> locTemp;
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real> temp(locTemp);
 	for( int mu = 0; mu < 4; mu++ )
 	{
 		TLink linkUp( U, s, mu );
-		SU3<TLink> globUp( linkUp );
+		SU3<TLink,T_Real> globUp( linkUp );
 		temp.assignWithoutThirdLine( globUp );  // TODO put this in the loop of dA to reuse globUp
 		temp.reconstructThirdLine();
 		result += temp.trace().x;
@@ -190,13 +328,29 @@ __global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA )
 
 }
 
-__global__ void restoreThirdLine( Real* U, lat_index_t* nnt )
+template<class T_Real, class Storage> __global__ void generateGaugeQualityPerSite( T_Real* U, double *dGff, double *dA )
+{
+	int site = blockIdx.x * blockDim.x + threadIdx.x;
+	gaugeQualityPerSite<Storage>( U, site, dGff, dA );
+}
+
+/**
+ * The per-site values of configuration blockIdx.y are stored at offset blockIdx.y*latticeSize.
+ */
+template<class T_Real, class Storage> __global__ void generateGaugeQualityPerSiteBatch( T_Real* U, lat_array_index_t configStride, double *dGff, double *dA )
 {
-	typedef GpuPattern< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> Gpu;
-	typedef Link<Gpu,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLink;
+	int latticeSize = gridDim.x * blockDim.x;
+	int site = blockIdx.x * blockDim.x + threadIdx.x;
+	gaugeQualityPerSite<Storage>( &U[(size_t)blockIdx.y*configStride], site, &dGff[(size_t)blockIdx.y*latticeSize], &dA[(size_t)blockIdx.y*latticeSize] );
+}
+
+template<class T_Real, class Storage> __global__ void restoreThirdLine( T_Real* U, typename Storage::Table* nnt )
+{
+	typedef typename Storage::Site Site;
+	typedef typename LinkStorage<Site,Ndim,Nc,Storage::Reals,T_Real>::Type TLink;
 
 //	const lat_coord_t size[Ndim] = {1,Nx,Ny,Nz};
-	SiteIndex<Ndim,FULL_SPLIT> s(DEVICE_CONSTANTS::SIZE);
+	Site s(DEVICE_CONSTANTS::SIZE);
 	s.nn = nnt;
 
 	int site = blockIdx.x * blockDim.x + threadIdx.x;
@@ -206,20 +360,91 @@ __global__ void restoreThirdLine( Real* U, lat_index_t* nnt )
 	for( int mu = 0; mu < 4; mu++ )
 	{
 		TLink link( U, s, mu );
-		SU3<TLink> glob( link );
+		SU3<TLink,T_Real> glob( link );
 		glob.projectSU3();
 	}
 }
 
+/**
+ * Same as COMKSU3::projectSU3 but the link is projected locally and written back with the storage class
+ * (the stored parameters of Link8 are a point on SU(3) anyway, for Link12 this restores unitarity of the two rows).
+ */
+template<class T_Real, class Storage> __global__ void projectSU3( T_Real* U )
+{
+	typedef SiteCoord<Ndim,FULL_SPLIT> Site;
+	typedef typename LinkStorage<Site,Ndim,Nc,Storage::Reals,T_Real>::Type TLink;
+
+	Site s(DEVICE_CONSTANTS::SIZE);
+	s.setLatticeIndex( blockIdx.x * blockDim.x + threadIdx.x );
+
+	for( int mu = 0; mu < 4; mu++ )
+	{
+		TLink link( U, s, mu );
+		SU3<TLink,T_Real> glob( link );
+
+		Matrix<Complex<T_Real>,Nc> locMat;
+		SU3<Matrix<Complex<T_Real>,Nc>,T_Real> locU(locMat);
+
+		locU.assignWithoutThirdLine( glob );
+		locU.projectSU3();
+		glob.assignWithoutThirdLine( locU );
+	}
+}
+
+/**
+ * COMKSU3::setHot in the link storage.
+ */
+template<class T_Real, class Storage> __global__ void setHot( T_Real* U, lat_coord_t* ptrToDeviceSize, int rngSeed, int rngCounter )
+{
+	typedef SiteCoord<Ndim,FULL_SPLIT> Site;
+	typedef typename LinkStorage<Site,Ndim,Nc,Storage::Reals,T_Real>::Type TLink;
+
+	Site s( ptrToDeviceSize );
+	int site = blockIdx.x * blockDim.x + threadIdx.x;
+	s.setLatticeIndex( site );
+
+	PhiloxWrapper rng( site, rngSeed, rngCounter );
+
+	Quaternion<T_Real> q;
+
+	for( int mu = 0; mu < 4; mu++ )
+	{
+		TLink link( U, s, mu );
+		SU3<TLink,T_Real> glob( link );
+
+		Matrix<Complex<T_Real>,Nc> locMat;
+		SU3<Matrix<Complex<T_Real>,Nc>,T_Real> locU(locMat);
+
+		locU.identity();
+
+		for( int i=0; i<2; i++ )
+			for( int j=i+1; j<3; j++ )
+			{
+				q[0] = rng.rand<T_Real>()*2.0-1.0;
+				q[1] = rng.rand<T_Real>()*2.0-1.0;
+				q[2] = rng.rand<T_Real>()*2.0-1.0;
+				q[3] = rng.rand<T_Real>()*2.0-1.0;
+
+				q.projectSU2();
+				locU.rightSubgroupMult( i, j, &q );
+			}
+		glob = locU;
+	}
+}
+
 
 
-template<class Algorithm> inline __device__ void apply( Real* U, lat_index_t* nn, bool parity, Algorithm algorithm  )
+/**
+ * The neighbour access is the one of Storage::Site (SiteIndex, SiteIndexCompressed, SiteIndexOnTheFly), nn is its table.
+ * The links are read and written with the storage class of Storage::Reals (Link, Link12, Link8).
+ */
+template<class Storage, class T_Real, class Algorithm> inline __device__ void apply( T_Real* U, typename Storage::Table* nn, bool parity, Algorithm algorithm  )
 {
-	typedef GpuPattern< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuIndex;
-	typedef Link<GpuIndex,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLinkIndex;
+	typedef typename Storage::Site Site;
+	typedef typename LinkStorage<Site,Ndim,Nc,Storage::Reals,T_Real>::Type TLinkIndex;
 
 	const lat_coord_t size[Ndim] = {Nt,Nx,Ny,Nz};
-	SiteIndex<4,FULL_SPLIT> s(size);
+	Site s(size);
 	s.nn = nn;
 
 	const bool updown = threadIdx.x / (4*NSB);
@@ -235,54 +460,94 @@ template<class Algorithm> inline __device__ void apply( Real* U, lat_index_t* nn
 		s.setNeighbour(mu,false);
 	}
 
-	Matrix<Complex<Real>,Nc> locMat;
-	SU3<Matrix<Complex<Real>,Nc> > locU(locMat);
+	Matrix<Complex<T_Real>,Nc> locMat;
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real> locU(locMat);
 
 	TLinkIndex link( U, s, mu );
 
-	SU3<TLinkIndex> globU( link );
+	SU3<TLinkIndex,T_Real> globU( link );
 
 	// make link local
 	locU.assignWithoutThirdLine(globU);
 	locU.reconstructThirdLine();
 
-	GaugeFixingSubgroupStep<SU3<Matrix<Complex<Real>,Nc> >, Algorithm, LANDAU> subgroupStep( &locU, algorithm, id, mu, updown );
+	GaugeFixingSubgroupStep<SU3<Matrix<Complex<T_Real>,Nc>,T_Real>, Algorithm, LANDAU> subgroupStep( &locU, algorithm, id, mu, updown );
 
 	// do the subgroup iteration
-	SU3<Matrix<Complex<Real>,Nc> >::perSubgroup( subgroupStep );
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real>::perSubgroup( subgroupStep );
 
 	// copy link back
 	globU.assignWithoutThirdLine(locU);
 }
 
-__global__ void __launch_bounds__(8*NSB,OR_MINBLOCKS) orStep( Real* U, lat_index_t* nnt, bool parity, float orParameter )
+template<class T_Real, class Storage> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::OR_MINBLOCKS) orStep( T_Real* U, typename Storage::Table* nnt, bool parity, float orParameter )
 {
 	OrUpdate overrelax( orParameter );
-	apply( U, nnt, parity, overrelax );
+	apply<Storage>( U, nnt, parity, overrelax );
 }
 
-__global__ void __launch_bounds__(8*NSB,MS_MINBLOCKS) microStep( Real* U, lat_index_t* nnt, bool parity )
+template<class T_Real, class Storage> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::MS_MINBLOCKS) microStep( T_Real* U, typename Storage::Table* nnt, bool parity )
 {
 	MicroUpdate micro;
-	apply( U, nnt, parity, micro );
+	apply<Storage>( U, nnt, parity, micro );
 }
 
-__global__ void __launch_bounds__(8*NSB,SA_MINBLOCKS) saStep( Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+template<class T_Real, class Storage> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::SA_MINBLOCKS) saStep( T_Real* U, typename Storage::Table* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	SaUpdate sa( temperature, &rng );
-	apply( U, nnt, parity, sa );
+	apply<Storage>( U, nnt, parity, sa );
+}
+
+template<class T_Real, class Storage> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::SR_MINBLOCKS) srStep( T_Real* U, typename Storage::Table* nnt, bool parity, float srParameter, int rngSeed, int rngCounter )
+{
+	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
+	SrUpdate sr( srParameter, &rng );
+	apply<Storage>( U, nnt, parity, sr );
 }
 
 /**
  *  We do a lot of useless stuff here (gather a local functional value)
  *  but the random trafo is applied only once, so we don't care.
  */
-__global__ void randomTrafo( Real* U, lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+template<class T_Real, class Storage> __global__ void randomTrafo( T_Real* U, typename Storage::Table* nnt, bool parity, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	RandomUpdate random( &rng );
-	apply( U, nnt, parity, random );
+	apply<Storage>( U, nnt, parity, random );
+}
+
+/*
+ * Batched kernels: the configurations of the batch are stored one after another in a single allocation,
+ * i.e. the pattern index is extended by the batch index, index = config*configStride + Gpu::getIndex(...).
+ * Each configuration uses gridDim.x blocks, the y-dimension of the grid runs over the configurations.
+ */
+template<class T_Real, class Storage> __global__ void randomTrafoBatch( T_Real* U, lat_array_index_t configStride, typename Storage::Table* nnt, bool parity, int rngSeed, int rngCounter )
+{
+	PhiloxWrapper rng( (blockIdx.y*gridDim.x + blockIdx.x) * blockDim.x + threadIdx.x, rngSeed, rngCounter );
+	RandomUpdate random( &rng );
+	apply<Storage>( &U[(size_t)blockIdx.y*configStride], nnt, parity, random );
+}
+
+template<class T_Real, class Storage> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::OR_MINBLOCKS) orStepBatch( T_Real* U, lat_array_index_t configStride, typename Storage::Table* nnt, bool parity, float orParameter, const int* active )
+{
+	if( !active[blockIdx.y] ) return;
+	OrUpdate overrelax( orParameter );
+	apply<Storage>( &U[(size_t)blockIdx.y*configStride], nnt, parity, overrelax );
+}
+
+template<class T_Real, class Storage> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::MS_MINBLOCKS) microStepBatch( T_Real* U, lat_array_index_t configStride, typename Storage::Table* nnt, bool parity, const int* active )
+{
+	if( !active[blockIdx.y] ) return;
+	MicroUpdate micro;
+	apply<Storage>( &U[(size_t)blockIdx.y*configStride], nnt, parity, micro );
+}
+
+template<class T_Real, class Storage> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::SA_MINBLOCKS) saStepBatch( T_Real* U, lat_array_index_t configStride, typename Storage::Table* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+{
+	PhiloxWrapper rng( (blockIdx.y*gridDim.x + blockIdx.x) * blockDim.x + threadIdx.x, rngSeed, rngCounter );
+	SaUpdate sa( temperature, &rng );
+	apply<Storage>( &U[(size_t)blockIdx.y*configStride], nnt, parity, sa );
 }
 
 }
@@ -0,0 +1,140 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Picks the fastest memory layout for the given machine and lattice size.
+ *
+ * The application times a few sweeps for each candidate layout (addTiming()) and asks for the fastest one
+ * (getBest()). The decision is stored in a tuning file, one line per machine, lattice size and precision:
+ * 	<hostname> <Nt> <Nx> <Ny> <Nz> <precision> <layout> <seconds per sweep>
+ * Subsequent runs find the line via lookup() and skip the timing. Delete the line (or the file) to retune,
+ * e.g. after a hardware or compiler change. An empty filename disables the cache.
+ */
+
+#ifndef LAYOUTTUNER_HXX_
+#define LAYOUTTUNER_HXX_
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include "../lattice/datatype/datatypes.h"
+#include "../lattice/datatype/lattice_typedefs.h"
+
+class LayoutTuner
+{
+public:
+	LayoutTuner( std::string filename, const lat_coord_t size[4] );
+
+	bool lookup( std::string& layout ) const;
+	void addTiming( std::string layout, double secondsPerSweep );
+	std::string getBest() const;
+	double getBestTime() const;
+	void store() const;
+
+	std::string getKey() const;
+
+private:
+	std::string filename;
+	std::string key;
+	std::string best;
+	double bestTime;
+};
+
+inline LayoutTuner::LayoutTuner( std::string filename, const lat_coord_t size[4] ) : filename(filename), bestTime(-1)
+{
+	char hostname[256];
+	if( gethostname( hostname, sizeof(hostname) ) != 0 ) hostname[0] = '\0';
+	hostname[sizeof(hostname)-1] = '\0';
+
+	std::ostringstream k;
+	k << ((hostname[0]=='\0')?"unknown":hostname) << " " << size[0] << " " << size[1] << " " << size[2] << " " << size[3];
+#ifdef DOUBLEPRECISION
+	k << " DP";
+#else
+	k << " SP";
+#endif
+	key = k.str();
+}
+
+inline std::string LayoutTuner::getKey() const
+{
+	return key;
+}
+
+/**
+ * Returns true and the cached layout if the tuning file has an entry for this machine and lattice.
+ * The last matching line wins.
+ */
+inline bool LayoutTuner::lookup( std::string& layout ) const
+{
+	if( filename.empty() ) return false;
+
+	std::ifstream in( filename.c_str() );
+	if( !in.good() ) return false;
+
+	bool found = false;
+	std::string line;
+	while( std::getline( in, line ) )
+	{
+		if( line.compare( 0, key.size()+1, key + " " ) != 0 ) continue;
+
+		std::istringstream rest( line.substr( key.size()+1 ) );
+		std::string l;
+		if( rest >> l )
+		{
+			layout = l;
+			found = true;
+		}
+	}
+	return found;
+}
+
+inline void LayoutTuner::addTiming( std::string layout, double secondsPerSweep )
+{
+	if( bestTime < 0 || secondsPerSweep < bestTime )
+	{
+		best = layout;
+		bestTime = secondsPerSweep;
+	}
+}
+
+inline std::string LayoutTuner::getBest() const
+{
+	return best;
+}
+
+inline double LayoutTuner::getBestTime() const
+{
+	return bestTime;
+}
+
+/**
+ * Appends the fastest layout to the tuning file.
+ */
+inline void LayoutTuner::store() const
+{
+	if( filename.empty() || bestTime < 0 ) return;
+
+	std::ofstream out( filename.c_str(), std::ios::app );
+	out << key << " " << best << " " << bestTime << std::endl;
+}
+
+#endif /* LAYOUTTUNER_HXX_ */
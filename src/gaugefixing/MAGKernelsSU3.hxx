@@ -38,6 +38,8 @@
 #include "../lattice/Matrix.hxx"
 #include "../lattice/SU3.hxx"
 #include "../lattice/Link.hxx"
+#include "../lattice/SiteIndex.hxx"
+#include "CommonKernelsSU3.hxx"
 
 
 // kernels as class members are not supported (even static): wrap the kernel calls and hide the kernels in namespace.
@@ -47,11 +49,11 @@ static const int Ndim = 4;
 static const int Nc = 3;
 __global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA );
 __global__ void restoreThirdLine( Real* U, lat_index_t* nnt );
-__global__ void randomTrafo( Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter );
-__global__ void orStep( Real* U, lat_index_t* nnt, bool parity, float orParameter );
-__global__ void srStep( Real* U, lat_index_t* nnt, bool parity, float srParameter, int rngSeed, int rngCounter );
-__global__ void microStep( Real* U, lat_index_t* nnt, bool parity );
-__global__ void saStep( Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
+template<class T_Real> __global__ void randomTrafo( T_Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter );
+template<class T_Real> __global__ void orStep( T_Real* U, lat_index_t* nnt, bool parity, float orParameter );
+template<class T_Real> __global__ void srStep( T_Real* U, lat_index_t* nnt, bool parity, float srParameter, int rngSeed, int rngCounter );
+template<class T_Real> __global__ void microStep( T_Real* U, lat_index_t* nnt, bool parity );
+template<class T_Real> __global__ void saStep( T_Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
 }
 
 class MAGKernelsSU3
@@ -62,17 +64,21 @@ public:
 	{
 		cudaFuncSetCacheConfig( MAGKSU3::generateGaugeQualityPerSite, cudaFuncCachePreferL1 );
 		cudaFuncSetCacheConfig( MAGKSU3::restoreThirdLine, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( MAGKSU3::randomTrafo, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( MAGKSU3::orStep, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( MAGKSU3::srStep, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( MAGKSU3::microStep, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( MAGKSU3::saStep, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( MAGKSU3::randomTrafo<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( MAGKSU3::orStep<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( MAGKSU3::srStep<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( MAGKSU3::microStep<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( MAGKSU3::saStep<Real>, cudaFuncCachePreferL1 );
 	}
 
 	static void generateGaugeQualityPerSite( int a, int b, Real *U, double *dGff, double *dA )
 	{
 		MAGKSU3::generateGaugeQualityPerSite<<<a,b>>>(U,dGff, dA);
 	};
+	static void generateGaugeQualityPerSite( int a, int b, cudaStream_t stream, Real *U, double *dGff, double *dA )
+	{
+		MAGKSU3::generateGaugeQualityPerSite<<<a,b,0,stream>>>(U,dGff, dA);
+	};
 	static double getGaugeQualityPrefactorA()
 	{
 		return 1./(double)MAGKSU3::Nc;
@@ -86,25 +92,50 @@ public:
 	{
 		MAGKSU3::restoreThirdLine<<<a,b>>>(U,nnt);
 	};
-	static void randomTrafo( int a, int b, Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+	// 18 real links: the common reprojection (same interface as BasicLandauKernelsSU3::projectSU3(), used by ReplicaExchange)
+	template<class T_Real> static void projectSU3( int a, int b, cudaStream_t stream, T_Real* U )
+	{
+		CommonKernelsSU3::projectSU3( a, b, stream, U, HOST_CONSTANTS::getPtrToDeviceSize() );
+	};
+	template<class T_Real> static void randomTrafo( int a, int b, T_Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+	{
+		MAGKSU3::randomTrafo<T_Real><<<a,b>>>( U, nnt, parity, rngSeed, rngCounter );
+	};
+	template<class T_Real> static void randomTrafo( int a, int b, cudaStream_t stream, T_Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+	{
+		MAGKSU3::randomTrafo<T_Real><<<a,b,0,stream>>>( U, nnt, parity, rngSeed, rngCounter );
+	};
+	template<class T_Real> static void orStep( int a, int b,  T_Real* U, lat_index_t* nnt, bool parity, float orParameter )
+	{
+		MAGKSU3::orStep<T_Real><<<a,b>>>( U, nnt, parity, orParameter );
+	};
+	template<class T_Real> static void orStep( int a, int b, cudaStream_t stream, T_Real* U, lat_index_t* nnt, bool parity, float orParameter )
+	{
+		MAGKSU3::orStep<T_Real><<<a,b,0,stream>>>( U, nnt, parity, orParameter );
+	};
+	template<class T_Real> static void srStep( int a, int b,  T_Real* U, lat_index_t* nnt, bool parity, float srParameter, int rngSeed, int rngCounter )
+	{
+		MAGKSU3::srStep<T_Real><<<a,b>>>( U, nnt, parity, srParameter, rngSeed, rngCounter );
+	};
+	template<class T_Real> static void srStep( int a, int b, cudaStream_t stream, T_Real* U, lat_index_t* nnt, bool parity, float srParameter, int rngSeed, int rngCounter )
 	{
-		MAGKSU3::randomTrafo<<<a,b>>>( U, nnt, parity, rngSeed, rngCounter );
+		MAGKSU3::srStep<T_Real><<<a,b,0,stream>>>( U, nnt, parity, srParameter, rngSeed, rngCounter );
 	};
-	static void orStep( int a, int b,  Real* U, lat_index_t* nnt, bool parity, float orParameter )
+	template<class T_Real> static void microStep( int a, int b, T_Real* U, lat_index_t* nnt, bool parity )
 	{
-		MAGKSU3::orStep<<<a,b>>>( U, nnt, parity, orParameter );
+		MAGKSU3::microStep<T_Real><<<a,b>>>( U, nnt, parity );
 	};
-	static void srStep( int a, int b,  Real* U, lat_index_t* nnt, bool parity, float srParameter, int rngSeed, int rngCounter )
+	template<class T_Real> static void microStep( int a, int b, cudaStream_t stream, T_Real* U, lat_index_t* nnt, bool parity )
 	{
-		MAGKSU3::srStep<<<a,b>>>( U, nnt, parity, srParameter, rngSeed, rngCounter );
+		MAGKSU3::microStep<T_Real><<<a,b,0,stream>>>( U, nnt, parity );
 	};
-	static void microStep( int a, int b, Real* U, lat_index_t* nnt, bool parity )
+	template<class T_Real> static void saStep( int a, int b, T_Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
 	{
-		MAGKSU3::microStep<<<a,b>>>( U, nnt, parity );
+		MAGKSU3::saStep<T_Real><<<a,b>>>( U, nnt, parity, temperature, rngSeed, rngCounter );
 	};
-	static void saStep( int a, int b, Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+	template<class T_Real> static void saStep( int a, int b, cudaStream_t stream, T_Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
 	{
-		MAGKSU3::saStep<<<a,b>>>( U, nnt, parity, temperature, rngSeed, rngCounter );
+		MAGKSU3::saStep<T_Real><<<a,b,0,stream>>>( U, nnt, parity, temperature, rngSeed, rngCounter );
 	};
 private:
 };
@@ -245,10 +276,10 @@ __global__ void restoreThirdLine( Real* U, lat_index_t* nnt )
 
 
 
-template<class Algorithm> inline __device__ void apply( Real* U, lat_index_t* nn, bool parity, Algorithm algorithm  )
+template<class T_Real, class Algorithm> inline __device__ void apply( T_Real* U, lat_index_t* nn, bool parity, Algorithm algorithm  )
 {
 	typedef GpuPattern< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuIndex;
-	typedef Link<GpuIndex,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLinkIndex;
+	typedef Link<GpuIndex,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc,T_Real> TLinkIndex;
 
 	const lat_coord_t size[Ndim] = {Nt,Nx,Ny,Nz};
 	SiteIndex<4,FULL_SPLIT> s(size);
@@ -267,12 +298,12 @@ template<class Algorithm> inline __device__ void apply( Real* U, lat_index_t* nn
 		s.setNeighbour(mu,false);
 	}
 
-	Matrix<Complex<Real>,Nc> locMat;
-	SU3<Matrix<Complex<Real>,Nc> > locU(locMat);
+	Matrix<Complex<T_Real>,Nc> locMat;
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real> locU(locMat);
 
 	TLinkIndex link( U, s, mu );
 
-	SU3<TLinkIndex> globU( link );
+	SU3<TLinkIndex,T_Real> globU( link );
 
 	// make link local
 	locU.assignWithoutThirdLine(globU);
@@ -280,46 +311,46 @@ template<class Algorithm> inline __device__ void apply( Real* U, lat_index_t* nn
 //	locU = globU;
 
 
-	GaugeFixingSubgroupStep<SU3<Matrix<Complex<Real>,Nc> >, Algorithm, MAG> subgroupStep( &locU, algorithm, id, mu, updown );
+	GaugeFixingSubgroupStep<SU3<Matrix<Complex<T_Real>,Nc>,T_Real>, Algorithm, MAG> subgroupStep( &locU, algorithm, id, mu, updown );
 
 
 
 	// do the subgroup iteration
-	SU3<Matrix<Complex<Real>,Nc> >::perSubgroup( subgroupStep );
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real>::perSubgroup( subgroupStep );
 
 	// copy link back
 	globU.assignWithoutThirdLine(locU);
 //	globU = locU;
 }
 
-__global__ void __launch_bounds__(8*NSB,OR_MINBLOCKS) orStep( Real* U, lat_index_t* nnt, bool parity, float orParameter )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::OR_MINBLOCKS) orStep( T_Real* U, lat_index_t* nnt, bool parity, float orParameter )
 {
 //	OrUpdateExact overrelax( orParameter );
 	OrUpdate overrelax( orParameter );
 	apply( U, nnt, parity, overrelax );
 }
 
-__global__ void __launch_bounds__(8*NSB,MS_MINBLOCKS) microStep( Real* U, lat_index_t* nnt, bool parity )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::MS_MINBLOCKS) microStep( T_Real* U, lat_index_t* nnt, bool parity )
 {
 	MicroUpdate micro;
 	apply( U, nnt, parity, micro );
 }
 
-__global__ void __launch_bounds__(8*NSB,SA_MINBLOCKS) saStep( Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::SA_MINBLOCKS) saStep( T_Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	SaUpdate sa( temperature, &rng );
 	apply( U, nnt, parity, sa );
 }
 
-__global__ void __launch_bounds__(8*NSB,SR_MINBLOCKS) srStep( Real* U, lat_index_t* nnt, bool parity, float srParameter, int rngSeed, int rngCounter )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::SR_MINBLOCKS) srStep( T_Real* U, lat_index_t* nnt, bool parity, float srParameter, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	SrUpdate sr( srParameter, &rng );
 	apply( U, nnt, parity, sr );
 }
 
-__global__ void randomTrafo( Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+template<class T_Real> __global__ void randomTrafo( T_Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	RandomUpdate random( &rng );
@@ -0,0 +1,250 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Replica exchange (parallel tempering) search for the global maximum of the gauge functional.
+ *
+ * M replicas of the same gauge copy are simulated with the SA heatbath (SaUpdate) at a fixed
+ * geometric ladder of temperatures between samin and samax. After every <resweeps> sweeps neighbouring
+ * rungs of the ladder try to exchange their configurations with the Metropolis probability
+ * 	P = min( 1, exp( (beta_i - beta_j)*(F_j - F_i) ) ).
+ * F is the unnormalised functional sum_{x,mu} ReTr U_mu(x) = gff*V/prefactor. The heatbath samples a
+ * local gauge transformation g with weight exp( ReTr(g w)/(2T) ), i.e. beta = 1/(2T) in these units.
+ * For MAG the functional is quadratic in g and the heatbath samples a linearisation around the
+ * current field, so exp( F/(2T) ) is only approximately its equilibrium weight: the swaps still
+ * satisfy detailed balance with respect to that weight, the ladder is a heuristic for MAG.
+ * The ladder needs 0 < samin <= samax (isValid()), otherwise beta is inf/NaN.
+ * We do not move the fields: a swap exchanges the temperatures of the two slots.
+ * Even and odd pairs of rungs are tried in alternating rounds.
+ *
+ * The random numbers for the swap decisions are generated on the host with Philox (key = (seed, copy)).
+ * The replicas are the slots of a GaugeCopyBatch and run concurrently on their streams.
+ * After the last round the replica at the lowest temperature is the result, it has to be finished
+ * by the usual relaxation algorithms (OR, SR).
+ */
+
+#ifndef REPLICAEXCHANGE_HXX_
+#define REPLICAEXCHANGE_HXX_
+
+#include "GlobalConstants.h"
+#include "../lattice/datatype/datatypes.h"
+#include "../lattice/datatype/lattice_typedefs.h"
+#include "../lattice/rng/PhiloxWrapper.hxx"
+#include "../external/Random123/philox.h"
+#include "../external/Random123/u01.h"
+
+#include <math.h>
+#include <stdio.h>
+
+class ReplicaExchange
+{
+public:
+	ReplicaExchange( int replicas, float tMin, float tMax, long seed );
+	~ReplicaExchange();
+
+	bool isValid() const;
+	void reset( int copy );
+	float getTemperature( int slot ) const;
+	int getColdestSlot() const;
+	int exchange( const double* action );
+
+	long getAccepted() const;
+	long getAttempted() const;
+
+	template<class GKernels, class Batch, class Table> int run( Batch& batch, Table* dNn, int numBlocks, int threadsPerBlock, int rounds, int sweeps, int microupdates, int reproject, int checkPrecision, long seed );
+
+private:
+	int replicas;
+	bool valid;
+	float* ladder; // temperature of each rung, ladder[0] is the coldest
+	int* slotOfRung;
+	int* rungOfSlot;
+	double* action;
+
+	philox4x32_key_t k;
+	unsigned int copy;
+	unsigned int round;
+
+	long accepted;
+	long attempted;
+
+	double rand( unsigned int pair );
+};
+
+inline ReplicaExchange::ReplicaExchange( int replicas, float tMin, float tMax, long seed ) : replicas(replicas), copy(0), round(0), accepted(0), attempted(0)
+{
+	ladder = new float[replicas];
+	slotOfRung = new int[replicas];
+	rungOfSlot = new int[replicas];
+	action = new double[replicas];
+
+	// beta = 1/(2T) requires a positive, finite temperature range
+	valid = ( tMin > 0.f ) && ( tMax >= tMin ) && isfinite( tMax );
+	if( !valid ) tMin = tMax = 1.f;
+
+	for( int i = 0; i < replicas; i++ )
+	{
+		if( replicas > 1 )
+			ladder[i] = tMin*pow( (double)tMax/(double)tMin, (double)i/(double)(replicas-1) );
+		else
+			ladder[i] = tMin;
+	}
+
+	k.v[0] = (unsigned int)seed;
+	k.v[1] = 0x52455843; // "REXC"
+
+	reset( 0 );
+}
+
+inline ReplicaExchange::~ReplicaExchange()
+{
+	delete[] ladder;
+	delete[] slotOfRung;
+	delete[] rungOfSlot;
+	delete[] action;
+}
+
+inline bool ReplicaExchange::isValid() const
+{
+	return valid;
+}
+
+/**
+ * Starts a new gauge copy: slot i is at rung i.
+ */
+inline void ReplicaExchange::reset( int copy )
+{
+	this->copy = copy;
+	round = 0;
+	for( int i = 0; i < replicas; i++ )
+	{
+		slotOfRung[i] = i;
+		rungOfSlot[i] = i;
+	}
+}
+
+inline float ReplicaExchange::getTemperature( int slot ) const
+{
+	return ladder[rungOfSlot[slot]];
+}
+
+inline int ReplicaExchange::getColdestSlot() const
+{
+	return slotOfRung[0];
+}
+
+inline double ReplicaExchange::rand( unsigned int pair )
+{
+	philox4x32_ctr_t c = {{ round, pair, copy, 0xabcdef09 }};
+	philox4x32_ctr_t r = philox4x32( c, k );
+	return u01_open_open_32_24( r.v[0] );
+}
+
+/**
+ * One exchange round. action[slot] is the unnormalised functional of the replica in this slot.
+ * Returns the number of accepted swaps.
+ */
+inline int ReplicaExchange::exchange( const double* action )
+{
+	int acc = 0;
+	for( int i = round%2; i+1 < replicas; i += 2 )
+	{
+		int a = slotOfRung[i];
+		int b = slotOfRung[i+1];
+		double betaA = 1./(2.*ladder[i]);
+		double betaB = 1./(2.*ladder[i+1]);
+		double dS = (betaA-betaB)*(action[b]-action[a]);
+
+		attempted++;
+		if( dS >= 0. || rand( i ) < exp( dS ) )
+		{
+			slotOfRung[i] = b;
+			slotOfRung[i+1] = a;
+			rungOfSlot[a] = i+1;
+			rungOfSlot[b] = i;
+			acc++;
+		}
+	}
+	accepted += acc;
+	round++;
+	return acc;
+}
+
+inline long ReplicaExchange::getAccepted() const
+{
+	return accepted;
+}
+
+inline long ReplicaExchange::getAttempted() const
+{
+	return attempted;
+}
+
+/**
+ * Runs <rounds> exchange rounds with <sweeps> heatbath sweeps (plus microcanonical steps) per round
+ * on all slots of the batch. Returns the slot of the coldest replica.
+ * The fields are reprojected with GKernels::projectSU3(), i.e. in the link storage of GKernels.
+ */
+template<class GKernels, class Batch, class Table> int ReplicaExchange::run( Batch& batch, Table* dNn, int numBlocks, int threadsPerBlock, int rounds, int sweeps, int microupdates, int reproject, int checkPrecision, long seed )
+{
+	const int latticeSize = Nt*Nx*Ny*Nz;
+
+	printf( "round:\t\tgff (coldest):\t\tdA:\t\tacceptance:\n" );
+	for( int r = 0; r < rounds; r++ )
+	{
+		for( int s = 0; s < batch.getUsedSlots(); s++ )
+		{
+			for( int sw = 0; sw < sweeps; sw++ )
+			{
+				GKernels::saStep(numBlocks,threadsPerBlock,batch.getStream(s),batch.getField(s), dNn, 0, getTemperature(s), batch.getSeed(s,seed), PhiloxWrapper::getNextCounter() );
+				GKernels::saStep(numBlocks,threadsPerBlock,batch.getStream(s),batch.getField(s), dNn, 1, getTemperature(s), batch.getSeed(s,seed), PhiloxWrapper::getNextCounter() );
+
+				for( int mic = 0; mic < microupdates; mic++ )
+				{
+					GKernels::microStep(numBlocks,threadsPerBlock,batch.getStream(s),batch.getField(s), dNn, 0 );
+					GKernels::microStep(numBlocks,threadsPerBlock,batch.getStream(s),batch.getField(s), dNn, 1 );
+				}
+
+				if( (r*sweeps+sw) % reproject == 0 )
+				{
+					GKernels::projectSU3( latticeSize/32,32, batch.getStream(s), batch.getField(s) );
+				}
+			}
+		}
+
+		batch.generateGaugeQuality();
+		for( int s = 0; s < batch.getUsedSlots(); s++ )
+		{
+			action[s] = batch.getStats(s).getCurrentGff()/GKernels::getGaugeQualityPrefactorGff()*(double)latticeSize;
+		}
+		exchange( action );
+
+		if( r % checkPrecision == 0 )
+		{
+			int cold = getColdestSlot();
+			printf( "%d\t\t%1.10f\t\t%e\t\t%1.3f\n", r, batch.getStats(cold).getCurrentGff(), batch.getStats(cold).getCurrentA(), (attempted>0)?((double)accepted/(double)attempted):(0.) );
+		}
+	}
+	batch.synchronize();
+
+	return getColdestSlot();
+}
+
+#endif /* REPLICAEXCHANGE_HXX_ */
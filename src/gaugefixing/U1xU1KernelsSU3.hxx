@@ -45,11 +45,11 @@ static const int Ndim = 4;
 static const int Nc = 3;
 __global__ void generateGaugeQualityPerSite( Real *U, double *dGff, double *dA );
 __global__ void restoreThirdLine( Real* U, lat_index_t* nnt );
-__global__ void randomTrafo( Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter );
-__global__ void orStep( Real* U, lat_index_t* nnt, bool parity, float orParameter );
+template<class T_Real> __global__ void randomTrafo( T_Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter );
+template<class T_Real> __global__ void orStep( T_Real* U, lat_index_t* nnt, bool parity, float orParameter );
 __global__ void orStepSingleThread( Real* U, lat_index_t* nnt, bool parity, float orParameter );
-__global__ void microStep( Real* U, lat_index_t* nnt, bool parity );
-__global__ void saStep( Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
+template<class T_Real> __global__ void microStep( T_Real* U, lat_index_t* nnt, bool parity );
+template<class T_Real> __global__ void saStep( T_Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
 }
 
 class U1xU1KernelsSU3
@@ -62,16 +62,20 @@ public:
 	{
 		cudaFuncSetCacheConfig( U1xU1SU3::generateGaugeQualityPerSite, cudaFuncCachePreferL1 );
 		cudaFuncSetCacheConfig( U1xU1SU3::restoreThirdLine, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( U1xU1SU3::randomTrafo, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( U1xU1SU3::orStep, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( U1xU1SU3::microStep, cudaFuncCachePreferL1 );
-		cudaFuncSetCacheConfig( U1xU1SU3::saStep, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( U1xU1SU3::randomTrafo<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( U1xU1SU3::orStep<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( U1xU1SU3::microStep<Real>, cudaFuncCachePreferL1 );
+		cudaFuncSetCacheConfig( U1xU1SU3::saStep<Real>, cudaFuncCachePreferL1 );
 	}
 
 	static void generateGaugeQualityPerSite( int a, int b, Real *U, double *dGff, double *dA )
 	{
 		U1xU1SU3::generateGaugeQualityPerSite<<<a,b>>>(U,dGff, dA);
 	};
+	static void generateGaugeQualityPerSite( int a, int b, cudaStream_t stream, Real *U, double *dGff, double *dA )
+	{
+		U1xU1SU3::generateGaugeQualityPerSite<<<a,b,0,stream>>>(U,dGff, dA);
+	};
 	static double getGaugeQualityPrefactorA()
 	{
 		return 1./(double)U1xU1SU3::Nc;
@@ -85,21 +89,21 @@ public:
 	{
 		U1xU1SU3::restoreThirdLine<<<a,b>>>(U,nnt);
 	};
-	static void randomTrafo( int a, int b, Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+	template<class T_Real> static void randomTrafo( int a, int b, T_Real* U,lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
 	{
-		U1xU1SU3::randomTrafo<<<a,b>>>( U, nnt, parity, rngSeed, rngCounter );
+		U1xU1SU3::randomTrafo<T_Real><<<a,b>>>( U, nnt, parity, rngSeed, rngCounter );
 	};
-	static void orStep( int a, int b,  Real* U, lat_index_t* nnt, bool parity, float orParameter )
+	template<class T_Real> static void orStep( int a, int b,  T_Real* U, lat_index_t* nnt, bool parity, float orParameter )
 	{
-		U1xU1SU3::orStep<<<a,b>>>( U, nnt, parity, orParameter );
+		U1xU1SU3::orStep<T_Real><<<a,b>>>( U, nnt, parity, orParameter );
 	};
-	static void microStep( int a, int b, Real* U, lat_index_t* nnt, bool parity )
+	template<class T_Real> static void microStep( int a, int b, T_Real* U, lat_index_t* nnt, bool parity )
 	{
-		U1xU1SU3::microStep<<<a,b>>>( U, nnt, parity );
+		U1xU1SU3::microStep<T_Real><<<a,b>>>( U, nnt, parity );
 	};
-	static void saStep( int a, int b, Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+	template<class T_Real> static void saStep( int a, int b, T_Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
 	{
-		U1xU1SU3::saStep<<<a,b>>>( U, nnt, parity, temperature, rngSeed, rngCounter);
+		U1xU1SU3::saStep<T_Real><<<a,b>>>( U, nnt, parity, temperature, rngSeed, rngCounter);
 	};
 private:
 };
@@ -213,10 +217,10 @@ __global__ void restoreThirdLine( Real* U, lat_index_t* nnt )
 
 
 
-template<class Algorithm> inline __device__ void apply( Real* U, lat_index_t* nn, bool parity, Algorithm algorithm  )
+template<class T_Real, class Algorithm> inline __device__ void apply( T_Real* U, lat_index_t* nn, bool parity, Algorithm algorithm  )
 {
 	typedef GpuPattern< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuIndex;
-	typedef Link<GpuIndex,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLinkIndex;
+	typedef Link<GpuIndex,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc,T_Real> TLinkIndex;
 
 	const lat_coord_t size[Ndim] = {Nt,Nx,Ny,Nz};
 	SiteIndex<4,FULL_SPLIT> s(size);
@@ -235,39 +239,39 @@ template<class Algorithm> inline __device__ void apply( Real* U, lat_index_t* nn
 		s.setNeighbour(mu,false);
 	}
 
-	Matrix<Complex<Real>,Nc> locMat;
-	SU3<Matrix<Complex<Real>,Nc> > locU(locMat);
+	Matrix<Complex<T_Real>,Nc> locMat;
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real> locU(locMat);
 
 	TLinkIndex link( U, s, mu );
 
-	SU3<TLinkIndex> globU( link );
+	SU3<TLinkIndex,T_Real> globU( link );
 
 	// make link local
 	locU.assignWithoutThirdLine(globU);
 	locU.reconstructThirdLine();
 
-	GaugeFixingSubgroupStep<SU3<Matrix<Complex<Real>,Nc> >, Algorithm, U1xU1> subgroupStep( &locU, algorithm, id, mu, updown );
+	GaugeFixingSubgroupStep<SU3<Matrix<Complex<T_Real>,Nc>,T_Real>, Algorithm, U1xU1> subgroupStep( &locU, algorithm, id, mu, updown );
 
 	// do the subgroup iteration
-	SU3<Matrix<Complex<Real>,Nc> >::perSubgroup( subgroupStep );
+	SU3<Matrix<Complex<T_Real>,Nc>,T_Real>::perSubgroup( subgroupStep );
 
 	// copy link back
 	globU.assignWithoutThirdLine(locU);
 }
 
-__global__ void __launch_bounds__(8*NSB,OR_MINBLOCKS) orStep( Real* U, lat_index_t* nnt, bool parity, float orParameter )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::OR_MINBLOCKS) orStep( T_Real* U, lat_index_t* nnt, bool parity, float orParameter )
 {
 	OrUpdate overrelax( orParameter );
 	apply( U, nnt, parity, overrelax );
 }
 
-__global__ void __launch_bounds__(8*NSB,MS_MINBLOCKS) microStep( Real* U, lat_index_t* nnt, bool parity )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::MS_MINBLOCKS) microStep( T_Real* U, lat_index_t* nnt, bool parity )
 {
 	MicroUpdate micro;
 	apply( U, nnt, parity, micro );
 }
 
-__global__ void __launch_bounds__(8*NSB,SA_MINBLOCKS) saStep( Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+template<class T_Real> __global__ void __launch_bounds__(8*NSB,LaunchBounds<T_Real>::SA_MINBLOCKS) saStep( T_Real* U, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	SaUpdate sa( temperature, &rng );
@@ -278,7 +282,7 @@ __global__ void __launch_bounds__(8*NSB,SA_MINBLOCKS) saStep( Real* U, lat_index
  *  We do a lot of useless stuff here (gather a local functional value)
  *  but the random trafo is applied only once, so we don't care.
  */
-__global__ void randomTrafo( Real* U, lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+template<class T_Real> __global__ void randomTrafo( T_Real* U, lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	RandomUpdate random( &rng );
@@ -0,0 +1,196 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Kennedy-Pendleton heatbath (as in SaUpdate) for a batch of sites on the host, without waiting for the slowest lane.
+ *
+ * In SaUpdate every site loops until its candidate is accepted, in SIMD execution all lanes wait for the slowest one.
+ * Here the W lanes of a HostPhiloxWrapper work on a queue of sites: in each round every lane draws a candidate for
+ * its site, lanes with an accepted candidate store it and take the next site from the queue, rejected lanes try again.
+ * Thus all lanes do useful work until the queue is empty. The angles of the accepted elements are drawn afterwards,
+ * in lockstep for W sites.
+ *
+ * The distribution is the same as in SaUpdate: the cut r1,r2 >= 0.0001 is applied by rejecting the whole candidate,
+ * which is equivalent since r1, r2, r3 and r4 are independent. The random numbers of a site depend on the lane it
+ * is processed by, i.e. the sequence differs from SaUpdate on the device.
+ *
+ * The subgroup elements are passed as in GaugeFixingSubgroupStep, component k of site i in a[k*n+i].
+ */
+
+#ifndef BATCHSAUPDATE_HXX_
+#define BATCHSAUPDATE_HXX_
+
+#include "../../lattice/rng/HostPhiloxWrapper.hxx"
+#include <math.h>
+
+template<int W, class T_Real> class BatchSaUpdate
+{
+public:
+	BatchSaUpdate( float temperature, HostPhiloxWrapper<W>* rng );
+	~BatchSaUpdate();
+	void calculateUpdate( T_Real* a, int n );
+	void setTemperature( float temperature );
+	float getTemperature();
+	long getCandidates();
+	long getUpdates();
+private:
+	float temperature;
+	HostPhiloxWrapper<W>* rng;
+	int capacity;
+	T_Real* dk;
+	T_Real* a0;
+	long candidates;
+	long updates;
+};
+
+template<int W, class T_Real> BatchSaUpdate<W,T_Real>::BatchSaUpdate( float temperature, HostPhiloxWrapper<W>* rng ) : temperature(temperature), rng(rng), capacity(0), dk(0), a0(0), candidates(0), updates(0)
+{
+}
+
+template<int W, class T_Real> BatchSaUpdate<W,T_Real>::~BatchSaUpdate()
+{
+	delete[] dk;
+	delete[] a0;
+}
+
+template<int W, class T_Real> void BatchSaUpdate<W,T_Real>::calculateUpdate( T_Real* a, int n )
+{
+	if( n > capacity )
+	{
+		delete[] dk;
+		delete[] a0;
+		capacity = n;
+		dk = new T_Real[capacity];
+		a0 = new T_Real[capacity];
+	}
+
+	for( int i = 0; i < n; i++ )
+	{
+		dk[i] = 1./sqrt( a[i]*a[i]+a[n+i]*a[n+i]+a[2*n+i]*a[2*n+i]+a[3*n+i]*a[3*n+i] );
+	}
+
+	// the lanes draw a0 = 1-delta until the queue of sites is empty
+	int site[W];
+	int next = 0;
+	int active = 0;
+	for( int l = 0; l < W; l++ )
+	{
+		site[l] = ( next < n )?( next++ ):( -1 );
+		if( site[l] >= 0 ) active++;
+	}
+
+	T_Real r1[W], r2[W], r3[W], r4[W], p0[W], delta[W];
+	bool accept[W];
+	while( active > 0 )
+	{
+		for( int l = 0; l < W; l++ )
+		{
+			p0[l] = ( site[l] >= 0 )?( dk[site[l]]*temperature ):( 0 ); // equals a*beta
+		}
+
+		rng->rand( r1 );
+		rng->rand( r2 );
+		rng->rand( r3 );
+		rng->rand( r4 );
+
+		for( int l = 0; l < W; l++ )
+		{
+			T_Real c = cos( (T_Real)(2.*M_PI)*r3[l] );
+			delta[l] = -log(r2[l])*p0[l] - log(r1[l])*p0[l]*c*c;
+			accept[l] = ( r1[l] >= (T_Real)0.0001 ) && ( r2[l] >= (T_Real)0.0001 ) && ( r4[l]*r4[l] <= (T_Real)1.-(T_Real)0.5*delta[l] );
+		}
+
+		candidates += active;
+		for( int l = 0; l < W; l++ )
+		{
+			if( site[l] >= 0 && accept[l] )
+			{
+				a0[site[l]] = 1.-delta[l];
+				if( next < n )
+				{
+					site[l] = next++;
+				}
+				else
+				{
+					site[l] = -1;
+					active--;
+				}
+			}
+		}
+	}
+	updates += n;
+
+	// angles of the new element and multiplication with the hermitian of the input, W sites at a time
+	T_Real r5[W], r6[W];
+	for( int i0 = 0; i0 < n; i0 += W )
+	{
+		rng->rand( r5 );
+		rng->rand( r6 );
+
+		int lanes = ( n-i0 < W )?( n-i0 ):( W );
+		for( int l = 0; l < lanes; l++ )
+		{
+			int i = i0+l;
+			T_Real b0 = a0[i];
+			T_Real cos_theta = 2.*r5[l]-1.;
+			T_Real sin_theta = sqrt( 1.-cos_theta*cos_theta );
+			T_Real sin_alpha = sqrt( 1.-b0*b0 );
+			T_Real phi = (T_Real)(2.*M_PI)*r6[l];
+			T_Real b1 = sin_alpha*sin_theta*cos(phi);
+			T_Real b2 = sin_alpha*sin_theta*sin(phi);
+			T_Real b3 = sin_alpha*cos_theta;
+
+			T_Real e0 = a[i]*dk[i];
+			T_Real e1 = -a[n+i]*dk[i]; // the minus sign is for the hermitian of the input (as in SaUpdate)
+			T_Real e2 = -a[2*n+i]*dk[i];
+			T_Real e3 = -a[3*n+i]*dk[i];
+
+			a[i] = b0*e0+b3*e3+b2*e2+e1*b1;
+			a[3*n+i] = e0*b3-e3*b0+b1*e2-b2*e1;
+			a[2*n+i] = b3*e1-b0*e2+b2*e0-b1*e3;
+			a[n+i] = b2*e3+b1*e0-b3*e2-e1*b0;
+		}
+	}
+}
+
+template<int W, class T_Real> void BatchSaUpdate<W,T_Real>::setTemperature( float temperature )
+{
+	this->temperature = temperature;
+}
+
+template<int W, class T_Real> float BatchSaUpdate<W,T_Real>::getTemperature()
+{
+	return temperature;
+}
+
+/**
+ * Number of candidates drawn so far (getCandidates()/getUpdates() is the mean number of tries per update).
+ */
+template<int W, class T_Real> long BatchSaUpdate<W,T_Real>::getCandidates()
+{
+	return candidates;
+}
+
+template<int W, class T_Real> long BatchSaUpdate<W,T_Real>::getUpdates()
+{
+	return updates;
+}
+
+#endif /* BATCHSAUPDATE_HXX_ */
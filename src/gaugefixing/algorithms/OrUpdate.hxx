@@ -28,13 +28,14 @@
 
 #include "../GlobalConstants.h"
 #include "../../lattice/datatype/datatypes.h"
+#include "UpdateReal.hxx"
 
 class OrUpdate
 {
 public:
 	__device__ inline OrUpdate();
 	__device__ inline OrUpdate( float param );
-	__device__ inline void calculateUpdate( volatile Real (&shA)[4*NSB], short id );
+	template<class T_Real> __device__ inline void calculateUpdate( volatile T_Real (&shA)[4*NSB], short id );
 	__device__ inline void setParameter( float param );
 	__device__ inline float getParameter();
 private:
@@ -49,32 +50,21 @@ __device__ OrUpdate::OrUpdate( float param ) : orParameter(param)
 {
 }
 
-__device__ void OrUpdate::calculateUpdate( volatile Real (&shA)[4*NSB], short id )
+template<class T_Real> __device__ void OrUpdate::calculateUpdate( volatile T_Real (&shA)[4*NSB], short id )
 {
-#ifdef USE_DP_ORUPDATE
-	double ai_sq = shA[id+NSB]*shA[id+NSB]+shA[id+2*NSB]*shA[id+2*NSB]+shA[id+3*NSB]*shA[id+3*NSB];
-	double a0_sq = shA[id]*shA[id];
+	typedef typename UpdateReal<T_Real,OR_UPDATE>::Type UReal;
 
-	double b=((double)orParameter*a0_sq+ai_sq)/(a0_sq+ai_sq);
-	double c=rsqrt(a0_sq+b*b*ai_sq); // even in DP calculation the rsqrt has no effect on the stability of GFF
+	UReal ai_sq = shA[id+NSB]*shA[id+NSB]+shA[id+2*NSB]*shA[id+2*NSB]+shA[id+3*NSB]*shA[id+3*NSB];
+	UReal a0_sq = shA[id]*shA[id];
 
-	shA[id]*=c;
-	shA[id+NSB]*=b*c;
-	shA[id+2*NSB]*=b*c;
-	shA[id+3*NSB]*=b*c;
-#else
-	Real ai_sq = shA[id+NSB]*shA[id+NSB]+shA[id+2*NSB]*shA[id+2*NSB]+shA[id+3*NSB]*shA[id+3*NSB];
-	Real a0_sq = shA[id]*shA[id];
-
-	Real b=(orParameter*a0_sq+ai_sq)/(a0_sq+ai_sq);
-	Real c=rsqrt(a0_sq+b*b*ai_sq);
+	UReal b=(orParameter*a0_sq+ai_sq)/(a0_sq+ai_sq);
+	UReal c=rsqrt(a0_sq+b*b*ai_sq);
 
 	shA[id]*=c;
 	shA[id+NSB]*=b*c;
 	shA[id+2*NSB]*=b*c;
 	shA[id+3*NSB]*=b*c;
 	// 22 flops
-#endif
 }
 
 __device__ void OrUpdate::setParameter( float param )
@@ -31,7 +31,7 @@ class RandomUpdate
 public:
 	__device__ inline RandomUpdate();
 	__device__ inline RandomUpdate( PhiloxWrapper *rng );
-	__device__ inline void calculateUpdate( volatile Real (&shA)[4*NSB], short id );
+	template<class T_Real> __device__ inline void calculateUpdate( volatile T_Real (&shA)[4*NSB], short id );
 private:
 	PhiloxWrapper *rng;
 };
@@ -44,12 +44,12 @@ __device__ RandomUpdate::RandomUpdate( PhiloxWrapper *rng ) : rng(rng)
 {
 }
 
-__device__ void RandomUpdate::calculateUpdate( volatile Real (&shA)[4*NSB], short id )
+template<class T_Real> __device__ void RandomUpdate::calculateUpdate( volatile T_Real (&shA)[4*NSB], short id )
 {
-	Real alpha, phi, cos_theta, sin_theta, sin_alpha;
-	alpha = rng->rand();
-	phi = 2.0 * rng->rand();
-	cos_theta = 2.0 * rng->rand() - 1.0;
+	T_Real alpha, phi, cos_theta, sin_theta, sin_alpha;
+	alpha = rng->rand<T_Real>();
+	phi = 2.0 * rng->rand<T_Real>();
+	cos_theta = 2.0 * rng->rand<T_Real>() - 1.0;
 	sin_theta = sqrt(1.0 - cos_theta * cos_theta);
 	sin_alpha = sinpi(alpha);
 	shA[id] = cospi(alpha);
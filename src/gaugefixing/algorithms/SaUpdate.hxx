@@ -26,6 +26,7 @@
 #define SAUPDATE_HXX_
 
 #include "../../lattice/datatype/datatypes.h"
+#include "UpdateReal.hxx"
 #include "../../lattice/rng/PhiloxWrapper.hxx"
 
 class SaUpdate
@@ -33,7 +34,7 @@ class SaUpdate
 public:
 	__device__ inline SaUpdate();
 	__device__ inline SaUpdate( float temperature, PhiloxWrapper *rng );
-	__device__ inline void calculateUpdate( volatile Real (&shA)[4*NSB], short id );
+	template<class T_Real> __device__ inline void calculateUpdate( volatile T_Real (&shA)[4*NSB], short id );
 	__device__ inline void setTemperature( float temperature );
 	__device__ inline float getTemperature();
 private:
@@ -49,62 +50,14 @@ __device__ SaUpdate::SaUpdate( float temperature, PhiloxWrapper *rng ) : tempera
 {
 }
 
-__device__ void SaUpdate::calculateUpdate( volatile Real (&shA)[4*NSB], short id )
+template<class T_Real> __device__ void SaUpdate::calculateUpdate( volatile T_Real (&shA)[4*NSB], short id )
 {
-#ifdef USE_DP_SAUPDATE
-	// TODO test the DP update in SP code
-	double e0,e1,e2,e3, dk, p0;
-	double r1,r2,r3,r4;
-	double a0,a1,a2,a3;
-	double delta, phi, sin_alpha, sin_theta, cos_theta;
-	e0=shA[id];
-	e1=-shA[id+NSB]; // the minus sign is for the hermitian of the input! be aware of this when reusing this code fragment
-	e2=-shA[id+2*NSB]; // "
-	e3=-shA[id+3*NSB]; // "
-	dk=rsqrt(e0*e0+e1*e1+e2*e2+e3*e3);
-	p0=(dk*temperature); // equals a*beta
-
-//	16 flop
-
-	do
-	{
-	  do; while ((r1 = rng->rand()) < 0.0001);
-	  r1 = -log(r1)*p0;
-	  do; while ((r2 = rng->rand()) < 0.0001);
-	  r2 = -log(r2)*p0;
-	  r3 = cospi(2.0*rng->rand());
-	  r3 = r3*r3;
-	  delta = r2+r1*r3;
-	  r4=rng->rand();
-	} while(r4*r4 > (1.0-0.5*delta));
-//	17 flop (if no loops, counting rand() as 1 operation, cospi/sinpi as 2)
-	a0=1.0-delta;
-	cos_theta=2.0*rng->rand()-1.0;
-	sin_theta=sqrt(1.0-cos_theta*cos_theta);
-	sin_alpha=sqrt(1-a0*a0);
-	phi=2.0*rng->rand();
-	a1=sin_alpha*sin_theta*cospi(phi);
-	a2=sin_alpha*sin_theta*sinpi(phi);
-	a3=sin_alpha*cos_theta;
-
-	e0 *= dk;
-	e1 *= dk;
-	e2 *= dk;
-	e3 *= dk;
-//	25 flop
-
-	shA[id] = a0*e0+a3*e3+a2*e2+e1*a1;
-	shA[id+3*NSB] = e0*a3-e3*a0+a1*e2-a2*e1;
-	shA[id+2*NSB] = a3*e1-a0*e2+a2*e0-a1*e3;
-	shA[id+NSB] = a2*e3+a1*e0-a3*e2-e1*a0;
-//	28 flop
+	typedef typename UpdateReal<T_Real,SA_UPDATE>::Type UReal;
 
-//	sum: 86 flop
-#else
-	Real e0,e1,e2,e3, dk, p0;
-	Real r1,r2,r3,r4;
-	Real a0,a1,a2,a3;
-	Real delta, phi, sin_alpha, sin_theta, cos_theta;
+	UReal e0,e1,e2,e3, dk, p0;
+	UReal r1,r2,r3,r4;
+	UReal a0,a1,a2,a3;
+	UReal delta, phi, sin_alpha, sin_theta, cos_theta;
 	e0=shA[id];
 	e1=-shA[id+NSB]; // the minus sign is for the hermitian of the input! be aware of this when reusing this code fragment
 	e2=-shA[id+2*NSB]; // "
@@ -115,20 +68,20 @@ __device__ void SaUpdate::calculateUpdate( volatile Real (&shA)[4*NSB], short id
 
 	do
 	{
-	  do; while ((r1 = rng->rand()) < 0.0001);
+	  do; while ((r1 = rng->rand<T_Real>()) < (UReal)0.0001);
 	  r1 = -log(r1)*p0;
-	  do; while ((r2 = rng->rand()) < 0.0001);
+	  do; while ((r2 = rng->rand<T_Real>()) < (UReal)0.0001);
 	  r2 = -log(r2)*p0;
-	  r3 = cospi(2.0*rng->rand());
+	  r3 = cospi((UReal)2.*rng->rand<T_Real>());
 	  r3 = r3*r3;
 	  delta = r2+r1*r3;
-	  r4=rng->rand();
-	} while(r4*r4 > (1.0-0.5*delta));
-	a0=1.0-delta;
-	cos_theta=2.0*rng->rand()-1.0;
-	sin_theta=sqrt(1.0-cos_theta*cos_theta);
-	sin_alpha=sqrt(1-a0*a0);
-	phi=2.0*rng->rand();
+	  r4=rng->rand<T_Real>();
+	} while(r4*r4 > ((UReal)1.-(UReal)0.5*delta));
+	a0=(UReal)1.-delta;
+	cos_theta=(UReal)2.*rng->rand<T_Real>()-(UReal)1.;
+	sin_theta=sqrt((UReal)1.-cos_theta*cos_theta);
+	sin_alpha=sqrt((UReal)1.-a0*a0);
+	phi=(UReal)2.*rng->rand<T_Real>();
 	a1=sin_alpha*sin_theta*cospi(phi);
 	a2=sin_alpha*sin_theta*sinpi(phi);
 	a3=sin_alpha*cos_theta;
@@ -143,7 +96,6 @@ __device__ void SaUpdate::calculateUpdate( volatile Real (&shA)[4*NSB], short id
 	shA[id+2*NSB] = a3*e1-a0*e2+a2*e0-a1*e3;
 	shA[id+NSB] = a2*e3+a1*e0-a3*e2-e1*a0;
 
-#endif
 }
 
 __device__ void SaUpdate::setTemperature( float temperature )
@@ -0,0 +1,69 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Floating point type of the update calculation (calculateUpdate()) in a kernel that is instantiated with T_Real.
+ *
+ * By default an update is calculated in the precision of the kernel. With USE_DP_ORUPDATE, USE_DP_SAUPDATE,
+ * USE_DP_MICROUPDATE and USE_DP_SRUPDATE (make DPUPDATES=true) the updates of single precision kernels are calculated
+ * in double precision. This applies to SP builds only: in a DP build the float instantiations are the single precision
+ * stage of MixedPrecisionLandauGaugeFixingSU3_4D and calculate their updates in float.
+ */
+
+#ifndef UPDATEREAL_HXX_
+#define UPDATEREAL_HXX_
+
+#include "../../lattice/datatype/datatypes.h"
+
+enum UpdateKind { OR_UPDATE, SA_UPDATE, MICRO_UPDATE, SR_UPDATE };
+
+template<class T_Real, UpdateKind kind> struct UpdateReal
+{
+	typedef T_Real Type;
+};
+
+#ifndef DOUBLEPRECISION
+#ifdef USE_DP_ORUPDATE
+template<> struct UpdateReal<float, OR_UPDATE>
+{
+	typedef double Type;
+};
+#endif
+#ifdef USE_DP_SAUPDATE
+template<> struct UpdateReal<float, SA_UPDATE>
+{
+	typedef double Type;
+};
+#endif
+#ifdef USE_DP_MICROUPDATE
+template<> struct UpdateReal<float, MICRO_UPDATE>
+{
+	typedef double Type;
+};
+#endif
+#ifdef USE_DP_SRUPDATE
+template<> struct UpdateReal<float, SR_UPDATE>
+{
+	typedef double Type;
+};
+#endif
+#endif
+
+#endif /* UPDATEREAL_HXX_ */
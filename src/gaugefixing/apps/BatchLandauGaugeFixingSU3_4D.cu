@@ -0,0 +1,413 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Landau gauge fixing of many small configurations at once.
+ *
+ * The configurations of a batch are stored in one device allocation (configuration c at dU+c*arraySize)
+ * and each kernel call updates all of them: the grid has one row of blocks per configuration.
+ * This fills the device for lattices (e.g. 16^4) where a single configuration leaves most of the
+ * multiprocessors idle. The gauge quality is reduced per configuration and each configuration stops
+ * the OR iteration separately when it reaches the precision.
+ */
+
+#include <iostream>
+#include <math.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifndef OSX
+#include "malloc.h"
+#endif
+#include "../GlobalConstants.h"
+#include "../GaugeFixingStats.hxx"
+#include "../GaugeFixingStatsBatch.hxx"
+#include "../../lattice/access_pattern/StandardPattern.hxx"
+#include "../../lattice/access_pattern/GpuPattern.hxx"
+#include "../../lattice/SiteCoord.hxx"
+#include "../../lattice/SiteIndex.hxx"
+#include "../../util/timer/Chronotimer.h"
+#include "../../lattice/filetypes/FileHeaderOnly.hxx"
+#include "../../lattice/filetypes/FilePlain.hxx"
+#include "../../lattice/filetypes/FileVogt.hxx"
+#include "../../lattice/filetypes/filetype_typedefs.h"
+#include "../../lattice/LinkFile.hxx"
+#include "../LandauKernelsSU3.hxx"
+#include "../CommonKernelsSU3.hxx"
+#include "../LandauKernelCounter.hxx"
+#include "program_options/ProgramOptions.hxx"
+#include "program_options/FileIterator.hxx"
+
+using namespace std;
+
+const lat_dim_t Ndim = 4;
+const short Nc = 3;
+
+const int arraySize = Nt*Nx*Ny*Nz*Ndim*Nc*Nc*2;
+
+typedef StandardPattern<SiteCoord<Ndim,NO_SPLIT>,Ndim,Nc> Standard;
+typedef GpuPattern< SiteCoord<Ndim,FULL_SPLIT>,Ndim,Nc> Gpu;
+
+void readILDG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
+void writeILDG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const char *output_name, const short SIZE[4], Real *U, int steps);
+
+bool readQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
+bool writeQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *output_name, const short SIZE[4], Real *U);
+
+int main(int argc, char* argv[])
+{
+	Chronotimer allTimer;
+	allTimer.reset();
+	allTimer.start();
+
+	LandauKernelsSU3::initCacheConfig();
+
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	// Choose device and print device infos
+	cudaDeviceProp deviceProp;
+	int selectedDeviceNumber;
+	if( options.getDeviceNumber() >= 0 )
+	{
+		cudaSetDevice( options.getDeviceNumber() );
+		selectedDeviceNumber = options.getDeviceNumber();
+	}
+	else
+	{
+		cudaGetDevice( &selectedDeviceNumber );
+	}
+	cudaGetDeviceProperties(&deviceProp, selectedDeviceNumber );
+
+	printf("\nDevice %d: \"%s\"\n", selectedDeviceNumber, deviceProp.name);
+	printf("CUDA Capability Major/Minor version number:    %d.%d\n\n", deviceProp.major, deviceProp.minor);
+
+	// SiteCoord is faster than SiteIndex when loading files
+	SiteCoord<4,FULL_SPLIT> s(HOST_CONSTANTS::SIZE);
+
+	const int batchSize = options.getBatchSize();
+	printf( "processing %d configurations per batch\n", batchSize );
+
+	// allocate Memory
+	// host memory for configuration
+	Real* U = (Real*)malloc( arraySize*sizeof(Real) );
+
+	// device memory for all configurations of a batch and the best copies
+	Real* dU;
+	Real* dBest;
+	cudaMalloc( &dU, (size_t)batchSize*arraySize*sizeof(Real) );
+	cudaMalloc( &dBest, (size_t)batchSize*arraySize*sizeof(Real) );
+	// the loaded configurations, each gauge copy starts from them (only needed for more than one copy)
+	Real* dPristine = 0;
+	if( options.getGaugeCopies() > 1 ) cudaMalloc( &dPristine, (size_t)batchSize*arraySize*sizeof(Real) );
+
+	// the configurations that are not yet gauge fixed (on host and device)
+	int* active = (int*)malloc( batchSize*sizeof(int) );
+	int* dActive;
+	cudaMalloc( &dActive, batchSize*sizeof(int) );
+
+	// all configurations are updated in SA and by the random trafo
+	int* dAll;
+	cudaMalloc( &dAll, batchSize*sizeof(int) );
+	for( int c = 0; c < batchSize; c++ ) active[c] = 1;
+	cudaMemcpy( dAll, active, batchSize*sizeof(int), cudaMemcpyHostToDevice );
+
+	double* bestGff = (double*)malloc( batchSize*sizeof(double) );
+
+	// host memory for the neighbour table
+	lat_index_t* nn = (lat_index_t*)malloc( s.getLatticeSize()*(2*(Ndim))*sizeof(lat_index_t) );
+
+	// device memory for the neighbour table
+	lat_index_t *dNn;
+	cudaMalloc( &dNn, s.getLatticeSize()*(2*(Ndim))*sizeof( lat_index_t ) );
+
+	// initialise the neighbour table for SiteIndex (this is used in device code)
+	SiteIndex<4,FULL_SPLIT> sTemp( HOST_CONSTANTS::SIZE );
+	sTemp.calculateNeighbourTable( nn );
+
+	// copy neighbour table to device
+	cudaMemcpy( dNn, nn, s.getLatticeSize()*(2*(Ndim))*sizeof( lat_index_t ), cudaMemcpyHostToDevice );
+
+	LinkFile<FileHeaderOnly, Standard, Gpu, SiteCoord<4,FULL_SPLIT> > lfHeaderOnly( options.getReinterpret() );
+	LinkFile<FileVogt, Standard, Gpu, SiteCoord<4,FULL_SPLIT> > lfVogt( options.getReinterpret() );
+	LinkFile<FilePlain, Standard, Gpu, SiteCoord<4,FULL_SPLIT> > lfPlain( options.getReinterpret() );
+
+
+	int threadsPerBlock = NSB*8; // NSB sites are updated within a block (8 threads are needed per site)
+	int numBlocks = s.getLatticeSize()/2/NSB; // blocks per configuration (half of the lattice sites are updated in a kernel call)
+
+	GaugeFixingStatsBatch<Ndim,Nc,LandauKernelsSU3,AVERAGE> gaugeStats( dU, batchSize, arraySize, HOST_CONSTANTS::SIZE );
+
+	// timer to measure kernel times
+	Chronotimer kernelTimer;
+	kernelTimer.reset();
+	kernelTimer.start();
+
+	double orTotalKernelTime = 0; // sum up total kernel time for OR
+	long orTotalStepnumber = 0;
+	double saTotalKernelTime = 0;
+	long totalConfigs = 0;
+
+	FileIterator fi( options );
+	fi.reset();
+	while( fi.hasNext() )
+	{
+		// collect the next batch of configurations
+		vector<string> filenames;
+		vector<string> outputFilenames;
+		for( ; fi.hasNext() && (int)filenames.size() < batchSize; fi.next() )
+		{
+			int c = filenames.size();
+			bool loadOk;
+
+			if( !options.isSetHot() ) // load a file
+			{
+				switch( options.getFType() )
+				{
+				case VOGT:
+					loadOk = lfVogt.load( s, fi.getFilename(), U );
+					break;
+				case PLAIN:
+					loadOk = lfPlain.load( s, fi.getFilename(), U );
+					break;
+				case HEADERONLY:
+					loadOk = lfHeaderOnly.load( s, fi.getFilename(), U );
+					break;
+				case ILDG:
+					loadOk = true;
+					readILDG(s, fi.getFilename().c_str(), HOST_CONSTANTS::SIZE, U);
+					break;
+				case QCDSTAG:
+					loadOk = readQCDSTAG(s, fi.getFilename().c_str(), HOST_CONSTANTS::SIZE, U);
+					break;
+				default:
+					cout << "Filetype not set to a known value. Exiting...";
+					exit(1);
+				}
+
+				if( !loadOk )
+				{
+					cout << "Error while loading " << fi.getFilename() << ". Trying next file." << endl;
+					continue;
+				}
+
+				cudaMemcpy( &dU[(size_t)c*arraySize], U, arraySize*sizeof(Real), cudaMemcpyHostToDevice );
+			}
+			else // or initialize with a hot configuration (ignore file options)
+			{
+				CommonKernelsSU3::setHot( s.getLatticeSize()/32,32, &dU[(size_t)c*arraySize], HOST_CONSTANTS::getPtrToDeviceSize(), options.getSeed(), PhiloxWrapper::getNextCounter() );
+			}
+
+			filenames.push_back( fi.getFilename() );
+			outputFilenames.push_back( fi.getOutputFilename() );
+		}
+
+		int configs = filenames.size();
+		if( configs == 0 ) break;
+		cout << "Loaded " << configs << " configurations." << endl;
+
+		gaugeStats.setConfigs( configs );
+
+		// the loaded configurations are the best copies until the first copy is finished
+		cudaMemcpy( dBest, dU, (size_t)configs*arraySize*sizeof(Real), cudaMemcpyDeviceToDevice );
+		if( dPristine ) cudaMemcpy( dPristine, dU, (size_t)configs*arraySize*sizeof(Real), cudaMemcpyDeviceToDevice );
+		for( int c = 0; c < configs; c++ ) bestGff[c] = 0.0;
+
+		for( int copy = 0; copy < options.getGaugeCopies(); copy++ )
+		{
+			// every gauge copy is a random gauge transformation of the loaded configuration
+			if( copy > 0 )
+			{
+				for( int c = 0; c < configs; c++ ) active[c] = 1;
+				cudaMemcpy( dU, dPristine, (size_t)configs*arraySize*sizeof(Real), cudaMemcpyDeviceToDevice );
+			}
+
+			if( options.isRandomTrafo() )
+			{
+				LandauKernelsSU3::randomTrafoBatch(numBlocks,threadsPerBlock,configs,dU,arraySize, dNn, 0, options.getSeed(), PhiloxWrapper::getNextCounter() );
+				LandauKernelsSU3::randomTrafoBatch(numBlocks,threadsPerBlock,configs,dU,arraySize, dNn, 1, options.getSeed(), PhiloxWrapper::getNextCounter() );
+			}
+
+			// calculate and print the gauge quality
+			printf( "i:\t\tgff:\t\tdA:\n");
+			gaugeStats.generateGaugeQuality();
+			for( int c = 0; c < configs; c++ )
+			{
+				printf( "[%d] \t\t%1.10f\t\t%e\n", c, gaugeStats.getCurrentGff(c), gaugeStats.getCurrentA(c) );
+			}
+
+			// SIMULATED ANNEALING
+			if( options.getSaSteps() > 0 ) printf( "SIMULATED ANNEALING\n" );
+			float temperature = options.getSaMax();
+			float tempStep = (options.getSaMax()-options.getSaMin())/(float)options.getSaSteps();
+
+			kernelTimer.reset();
+			kernelTimer.start();
+			for( int i = 0; i < options.getSaSteps(); i++ )
+			{
+				LandauKernelsSU3::saStepBatch(numBlocks,threadsPerBlock,configs,dU,arraySize, dNn, 0, temperature, options.getSeed(), PhiloxWrapper::getNextCounter() );
+				LandauKernelsSU3::saStepBatch(numBlocks,threadsPerBlock,configs,dU,arraySize, dNn, 1, temperature, options.getSeed(), PhiloxWrapper::getNextCounter() );
+
+				for( int mic = 0; mic < options.getSaMicroupdates(); mic++ )
+				{
+					LandauKernelsSU3::microStepBatch(numBlocks,threadsPerBlock,configs,dU,arraySize, dNn, 0, dAll );
+					LandauKernelsSU3::microStepBatch(numBlocks,threadsPerBlock,configs,dU,arraySize, dNn, 1, dAll );
+				}
+
+				if( i % options.getReproject() == 0 )
+				{
+					CommonKernelsSU3::projectSU3Batch( s.getLatticeSize()/32,32, configs, dU, arraySize, HOST_CONSTANTS::getPtrToDeviceSize() );
+				}
+
+				if( i % options.getCheckPrecision() == 0 )
+				{
+					gaugeStats.generateGaugeQuality();
+					for( int c = 0; c < configs; c++ )
+					{
+						printf( "[%d] %d\t\t%1.10f\t\t%e\n", c, i, gaugeStats.getCurrentGff(c), gaugeStats.getCurrentA(c) );
+					}
+				}
+				temperature -= tempStep;
+			}
+			cudaDeviceSynchronize();
+			kernelTimer.stop();
+			cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
+			saTotalKernelTime += kernelTimer.getTime();
+
+			// OVERRELAXATION
+			if( options.getOrMaxIter() > 0 ) printf( "OVERRELAXATION\n" );
+			for( int c = 0; c < configs; c++ ) active[c] = 1;
+			cudaMemcpy( dActive, active, configs*sizeof(int), cudaMemcpyHostToDevice );
+			int activeConfigs = configs;
+
+			kernelTimer.reset();
+			kernelTimer.start();
+			for( int i = 0; i < options.getOrMaxIter() && activeConfigs > 0; i++ )
+			{
+				// blocks of converged configurations return immediately
+				LandauKernelsSU3::orStepBatch(numBlocks,threadsPerBlock,configs,dU,arraySize, dNn, 0, options.getOrParameter(), dActive );
+				LandauKernelsSU3::orStepBatch(numBlocks,threadsPerBlock,configs,dU,arraySize, dNn, 1, options.getOrParameter(), dActive );
+
+				if( i % options.getReproject() == 0 )
+				{
+					CommonKernelsSU3::projectSU3Batch( s.getLatticeSize()/32,32, configs, dU, arraySize, HOST_CONSTANTS::getPtrToDeviceSize(), dActive );
+				}
+
+				orTotalStepnumber += activeConfigs;
+
+				if( i % options.getCheckPrecision() == 0 )
+				{
+					gaugeStats.generateGaugeQuality();
+					bool changed = false;
+					for( int c = 0; c < configs; c++ )
+					{
+						if( !active[c] ) continue;
+
+						printf( "[%d] %d\t\t%1.10f\t\t%e\n", c, i, gaugeStats.getCurrentGff(c), gaugeStats.getCurrentA(c) );
+						if( gaugeStats.getCurrentA(c) < options.getPrecision() )
+						{
+							active[c] = 0;
+							activeConfigs--;
+							changed = true;
+						}
+					}
+					if( changed ) cudaMemcpy( dActive, active, configs*sizeof(int), cudaMemcpyHostToDevice );
+				}
+			}
+
+			cudaDeviceSynchronize();
+			kernelTimer.stop();
+			cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
+			orTotalKernelTime += kernelTimer.getTime();
+
+			// reconstruct third line
+			CommonKernelsSU3::projectSU3Batch( s.getLatticeSize()/32,32, configs, dU, arraySize, HOST_CONSTANTS::getPtrToDeviceSize() );
+
+			// check for best copies
+			gaugeStats.generateGaugeQuality();
+			for( int c = 0; c < configs; c++ )
+			{
+				if( gaugeStats.getCurrentGff(c) > bestGff[c] )
+				{
+					cout << "FOUND BETTER COPY (configuration " << c << ")" << endl;
+					bestGff[c] = gaugeStats.getCurrentGff(c);
+					cudaMemcpy( &dBest[(size_t)c*arraySize], &dU[(size_t)c*arraySize], arraySize*sizeof(Real), cudaMemcpyDeviceToDevice );
+				}
+			}
+		}
+
+		//saving files
+		if( !options.isSetHot() )
+		{
+			for( int c = 0; c < configs; c++ )
+			{
+				cudaMemcpy( U, &dBest[(size_t)c*arraySize], arraySize*sizeof(Real), cudaMemcpyDeviceToHost );
+				cout << "saving " << outputFilenames[c] << " as " << options.getFType() << endl;
+				switch( options.getFType() )
+				{
+				case VOGT:
+					lfVogt.save( s, outputFilenames[c], U );
+					break;
+				case PLAIN:
+					lfPlain.save( s, outputFilenames[c], U );
+					break;
+				case HEADERONLY:
+					lfHeaderOnly.save( s, outputFilenames[c], U );
+					break;
+				case ILDG:
+					writeILDG(s, filenames[c].c_str(), outputFilenames[c].c_str(), HOST_CONSTANTS::SIZE, U, options.getSaSteps());
+					break;
+				case QCDSTAG:
+					writeQCDSTAG(s, outputFilenames[c].c_str(), HOST_CONSTANTS::SIZE, U);
+					break;
+				default:
+					cout << "Filetype not set to a known value. Exiting";
+					exit(1);
+				}
+			}
+		}
+
+		totalConfigs += configs;
+	}
+
+	allTimer.stop();
+	cout << "total time: " << allTimer.getTime() << " s" << endl;
+	cout << "total kernel time for SA: " << saTotalKernelTime << " s" << endl;
+	cout << "total kernel time for OR: " << orTotalKernelTime << " s" << endl;
+	cout << "configurations per hour: " << (double)totalConfigs/allTimer.getTime()*3600. << endl;
+
+	// the batched kernels do the same update per site and configuration as the single field kernels
+	KernelCount orCount = LandauKernelCounter<Real>( dNn, s.getLatticeSize() ).orStep( options.getOrParameter() );
+	cout << "Overrelaxation: " << orCount.getFlops()*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << " GFlops at "
+				<< orCount.getBytes()*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+
+	cudaFree( dU );
+	cudaFree( dBest );
+	if( dPristine ) cudaFree( dPristine );
+	cudaFree( dActive );
+	cudaFree( dAll );
+	cudaFree( dNn );
+	free( U );
+	free( nn );
+	free( active );
+	free( bestGff );
+}
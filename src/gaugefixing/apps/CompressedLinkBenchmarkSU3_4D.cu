@@ -0,0 +1,169 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Benchmark of the link storage classes in the Landau OR sweep:
+ *  - Link: 18 reals per link (used by the gauge fixing applications)
+ *  - Link12: the first two rows, 12 reals per link
+ *  - Link8: 8 real parametrization
+ *
+ * The same hot configuration is set up in each storage (BasicLandauKernelsSU3<KernelStorage<Site,Reals> >::setHot())
+ * and overrelaxed with the production kernel of that storage (ormaxiter sweeps of orStep). The results are converted
+ * back on the host (decompress()) and compared to the 18 real run, the sweep throughput and the memory of the field
+ * are printed (LandauGaugeFixingSU3_4D selects the storage with --links 18|12|8). The flops and link accesses per
+ * site are counted by running the kernel with CountingReal on a few blocks (Link8 includes the reconstruction).
+ * The OR kernel reads and writes only two rows of Link as well, thus Link12 saves memory but not bandwidth,
+ * Link8 saves both (at the cost of the reconstruction). Link8 is only valid away from the identity (see Link8.hxx),
+ * the benchmark runs on a hot configuration.
+ *
+ * make APP=CompressedLinkBenchmarkSU3_4D X=<x> T=<t>
+ */
+
+#include <iostream>
+#include <math.h>
+#ifndef OSX
+#include "malloc.h"
+#endif
+#include "../GlobalConstants.h"
+#include "../LandauKernelsSU3.hxx"
+#include "../KernelStorage.hxx"
+#include "../../lattice/datatype/CountingReal.hxx"
+#include "../../util/timer/Chronotimer.h"
+#include "program_options/ProgramOptions.hxx"
+
+using namespace std;
+
+const lat_dim_t Ndim = 4;
+const short Nc = 3;
+
+const int arraySize = Nt*Nx*Ny*Nz*Ndim*Nc*Nc*2;
+
+typedef SiteIndex<Ndim,FULL_SPLIT> Site;
+
+/**
+ * Runs the OR sweeps on the hot configuration in the storage of Reals reals per link, prints the throughput and
+ * leaves the result (uncompressed) in U.
+ */
+template<int Reals> void benchmark( const char* name, Real* dU, Real* U, lat_index_t* dNn, int sweeps, float orParameter, long seed, int hotCounter )
+{
+	typedef BasicLandauKernelsSU3<KernelStorage<Site,Reals> > GKernels;
+
+	int latticeSize = Nt*Nx*Ny*Nz;
+	int threadsPerBlock = NSB*8;
+	int numBlocks = latticeSize/2/NSB;
+	const int storageArraySize = latticeSize*Ndim*Reals;
+
+	GKernels::initCacheConfig();
+
+	// count the flops and link accesses per site on a few blocks
+	const int countBlocks = 4;
+	GKernels::setHot( latticeSize/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize(), seed, hotCounter );
+	resetDeviceOperationCounts();
+	GKernels::orStep( countBlocks, threadsPerBlock, (CountingReal<Real>*)dU, dNn, 0, orParameter );
+	GKernels::orStep( countBlocks, threadsPerBlock, (CountingReal<Real>*)dU, dNn, 1, orParameter );
+	cudaDeviceSynchronize();
+	OperationCounts counts = getDeviceOperationCounts();
+	double orFlops = (double)counts.getFlops()/(double)(2*countBlocks*NSB);
+	double orBytes = (double)counts.getAccesses()*sizeof(Real)/(double)(2*countBlocks*NSB);
+
+	// the same random numbers for all storages
+	GKernels::setHot( latticeSize/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize(), seed, hotCounter );
+
+	Chronotimer timer;
+	timer.reset();
+	timer.start();
+	for( int i = 0; i < sweeps; i++ )
+	{
+		GKernels::orStep( numBlocks, threadsPerBlock, dU, dNn, 0, orParameter );
+		GKernels::orStep( numBlocks, threadsPerBlock, dU, dNn, 1, orParameter );
+	}
+	cudaDeviceSynchronize();
+	timer.stop();
+
+	Real* UStorage = (Real*)malloc( storageArraySize*sizeof(Real) );
+	cudaMemcpy( UStorage, dU, storageArraySize*sizeof(Real), cudaMemcpyDeviceToHost );
+	GKernels::decompress( UStorage, U );
+	free( UStorage );
+
+	cout << name << ":" << endl;
+	cout << "\tfield memory: " << (double)storageArraySize*sizeof(Real)/1024./1024. << " MB" << endl;
+	cout << "\ttime per sweep: " << timer.getTime()/(double)sweeps*1000. << " ms" << endl;
+	cout << "\t" << orFlops << " flops and " << orBytes << " bytes (links only) per site and sweep" << endl;
+	cout << "\t" << orFlops*(double)latticeSize*(double)sweeps/timer.getTime()/1.0e9 << " GFlops at "
+			<< orBytes*(double)latticeSize*(double)sweeps/timer.getTime()/1.0e9 << " GB/s memory throughput (links only)" << endl;
+}
+
+/**
+ * Maximal deviation of the links in a from b.
+ */
+double maxDeviation( Real* a, Real* b )
+{
+	double dev = 0;
+	for( int i = 0; i < arraySize; i++ )
+	{
+		dev = fmax( dev, fabs( a[i]-b[i] ) );
+	}
+	return dev;
+}
+
+int main(int argc, char* argv[])
+{
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	if( options.getDeviceNumber() >= 0 ) cudaSetDevice( options.getDeviceNumber() );
+
+	const int latticeSize = Nt*Nx*Ny*Nz;
+	const int sweeps = options.getOrMaxIter();
+
+	lat_index_t* nn = (lat_index_t*)malloc( latticeSize*(2*(Ndim))*sizeof(lat_index_t) );
+	Site s( HOST_CONSTANTS::SIZE );
+	s.calculateNeighbourTable( nn );
+
+	lat_index_t* dNn;
+	cudaMalloc( &dNn, latticeSize*(2*(Ndim))*sizeof(lat_index_t) );
+	cudaMemcpy( dNn, nn, latticeSize*(2*(Ndim))*sizeof(lat_index_t), cudaMemcpyHostToDevice );
+
+	// the field of the largest storage
+	Real* dU;
+	cudaMalloc( &dU, arraySize*sizeof(Real) );
+	int hotCounter = PhiloxWrapper::getNextCounter();
+
+	Real* U18 = (Real*)malloc( arraySize*sizeof(Real) );
+	Real* U = (Real*)malloc( arraySize*sizeof(Real) );
+
+	cout << "lattice " << Nt << "x" << Nx << "x" << Ny << "x" << Nz << ", " << sweeps << " OR sweeps" << endl;
+
+	benchmark<18>( "18 reals (Link)", dU, U18, dNn, sweeps, options.getOrParameter(), options.getSeed(), hotCounter );
+
+	benchmark<12>( "12 reals (Link12)", dU, U, dNn, sweeps, options.getOrParameter(), options.getSeed(), hotCounter );
+	cout << "\tmax deviation from Link: " << maxDeviation( U, U18 ) << endl;
+
+	benchmark<8>( "8 reals (Link8)", dU, U, dNn, sweeps, options.getOrParameter(), options.getSeed(), hotCounter );
+	cout << "\tmax deviation from Link: " << maxDeviation( U, U18 ) << endl;
+
+	cudaFree( dU );
+	cudaFree( dNn );
+	free( nn );
+	free( U18 );
+	free( U );
+}
@@ -0,0 +1,130 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Reader for the convergence traces (--trace) of LandauGaugeFixingSU3_4D and MAGaugeFixingSU3_4D.
+ *
+ * Prints one line per configuration and gauge copy: the number of measurements, the last measured iteration of
+ * SA, SR and OR, the final gff and dA and the time between the first and the last measurement. With --tracecsv
+ * all records are written as CSV (config,copy,phase,iteration,temperature,gff,dA,time), e.g. for plots of gff
+ * over the temperature or dA over the iterations.
+ *
+ * make APP=ConvergenceTraceReader
+ * ./ConvergenceTraceReader_SP_N32T32 --trace landau.trace --tracecsv landau.csv
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <map>
+#include <vector>
+#include "../GlobalConstants.h"
+#include "../../util/metrics/ConvergenceTrace.hxx"
+#include "program_options/ProgramOptions.hxx"
+
+using namespace std;
+
+namespace CTR
+{
+
+struct Summary
+{
+	int measurements;
+	int last[ConvergenceTrace::PHASES];
+	double gff;
+	double dA;
+	double begin;
+	double end;
+};
+
+}
+
+int main(int argc, char* argv[])
+{
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	if( options.getTraceFile().size() == 0 )
+	{
+		cout << "No trace file given (--trace)." << endl;
+		return 1;
+	}
+
+	vector<TraceRecord> records;
+	if( !ConvergenceTrace::read( options.getTraceFile(), records ) ) return 1;
+
+	// records of the concurrent copies are interleaved, sort them by configuration and copy
+	map<pair<int,int>, CTR::Summary> summaries;
+	for( unsigned int i = 0; i < records.size(); i++ )
+	{
+		const TraceRecord& r = records[i];
+		pair<int,int> key( r.config, r.copy );
+		if( summaries.find( key ) == summaries.end() )
+		{
+			CTR::Summary s;
+			s.measurements = 0;
+			for( int p = 0; p < ConvergenceTrace::PHASES; p++ ) s.last[p] = -1;
+			s.begin = r.time;
+			summaries[key] = s;
+		}
+		CTR::Summary& s = summaries[key];
+		s.measurements++;
+		if( r.phase >= 0 && r.phase < ConvergenceTrace::PHASES ) s.last[r.phase] = r.iteration;
+		s.gff = r.gff;
+		s.dA = r.dA;
+		s.end = r.time;
+	}
+
+	cout << records.size() << " records of " << summaries.size() << " gauge copies" << endl;
+	cout << setw(8) << "config" << setw(8) << "copy" << setw(14) << "measurements" << setw(8) << "SA" << setw(8) << "SR" << setw(8) << "OR"
+			<< setw(18) << "gff" << setw(14) << "dA" << setw(12) << "time [s]" << endl;
+	for( map<pair<int,int>, CTR::Summary>::iterator it = summaries.begin(); it != summaries.end(); ++it )
+	{
+		const CTR::Summary& s = it->second;
+		cout << setw(8) << it->first.first << setw(8) << it->first.second << setw(14) << s.measurements
+				<< setw(8) << s.last[ConvergenceTrace::SA] << setw(8) << s.last[ConvergenceTrace::SR] << setw(8) << s.last[ConvergenceTrace::OR]
+				<< setw(18) << fixed << setprecision(10) << s.gff << setw(14) << scientific << setprecision(4) << s.dA
+				<< setw(12) << fixed << setprecision(3) << s.end-s.begin << endl;
+		cout.unsetf( ios::floatfield );
+	}
+
+	if( options.getTraceCsv().size() > 0 )
+	{
+		ofstream csv( options.getTraceCsv().c_str() );
+		if( !csv.good() )
+		{
+			cout << "Can not open " << options.getTraceCsv() << endl;
+			return 1;
+		}
+		csv.precision( 17 );
+		csv << "config,copy,phase,iteration,temperature,gff,dA,time" << endl;
+		for( unsigned int i = 0; i < records.size(); i++ )
+		{
+			const TraceRecord& r = records[i];
+			const char* phase = ( r.phase >= 0 && r.phase < ConvergenceTrace::PHASES )?( ConvergenceTrace::getPhaseName( (ConvergenceTrace::Phase)r.phase ) ):( "?" );
+			csv << r.config << "," << r.copy << "," << phase << "," << r.iteration << "," << r.temperature << ","
+					<< r.gff << "," << r.dA << "," << r.time << "\n";
+		}
+		cout << "records written to " << options.getTraceCsv() << endl;
+	}
+
+	return 0;
+}
@@ -35,6 +35,7 @@
 #include "../../lattice/SiteIndex.hxx"
 #include "../../lattice/LinkFile.hxx"
 #include "../../util/timer/Chronotimer.h"
+#include "../../util/metrics/PhaseMetrics.hxx"
 #include "../../lattice/filetypes/FileVogt.hxx"
 #include "../../lattice/filetypes/FilePlain.hxx"
 #include "../../lattice/filetypes/FileHeaderOnly.hxx"
@@ -44,6 +45,7 @@
 #include "program_options/ProgramOptions.hxx"
 #include "program_options/FileIterator.hxx"
 #include "../CoulombKernelsSU3.hxx"
+#include "../LandauKernelCounter.hxx"
 #include "../CommonKernelsSU3.hxx"
 
 using namespace std;
@@ -64,6 +66,15 @@ void writeILDG_timeslice(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const
 bool readQCDSTAG_timeslice(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
 bool writeQCDSTAG_timeslice(SiteCoord<4,FULL_SPLIT> s, const char *output_name, const short SIZE[4], Real *U);
 
+/**
+ * Calculates the gauge quality, the metrics take the device time of the measurement (GaugeFixingStats::setTiming()).
+ */
+template<class Stats> void generateGaugeQuality( Stats& stats, PhaseMetrics& metrics )
+{
+	stats.generateGaugeQuality();
+	metrics.add( PhaseMetrics::QUALITY, 0, stats.getQualityTime(), 1 );
+}
+
 int main(int argc, char* argv[])
 {
 	Chronotimer allTimer;
@@ -77,6 +88,8 @@ int main(int argc, char* argv[])
 	int returncode = options.init( argc, argv );
 	if( returncode != 0 ) return returncode;
 
+	PhaseMetrics metrics( options.getMetricsFile(), options.getMetricsFormat() );
+
 	// Choose device and print device infos
 	cudaDeviceProp deviceProp;
 	int selectedDeviceNumber;
@@ -139,6 +152,38 @@ int main(int argc, char* argv[])
 
 
 	GaugeFixingStats<Ndim,Nc,CoulombKernelsSU3,AVERAGE> gaugeStats( dUtUp, HOST_CONSTANTS::SIZE_TIMESLICE );
+	gaugeStats.setTiming( metrics.isEnabled() );
+
+	// flops and bytes per site and sweep, a sweep updates the sites of a timeslice; counted from the kernels on two
+	// timeslices of the counter (the heatbath at the mean SA temperature)
+	double saFlops, saBytes, orFlops, orBytes;
+	{
+		LandauKernelCounter<Real> counter( dNnt, s.getLatticeSizeTimeslice(), 4, HOST_CONSTANTS::getPtrToDeviceSizeTimeslice(), 2 );
+		const int countedSites = 2*counter.getBlocks()*NSB;
+
+		counter.begin();
+		CoulombKernelsSU3::saStep( counter.getBlocks(), NSB*8, counter.getField(0), counter.getField(1), dNnt, 0, .5*(options.getSaMax()+options.getSaMin()), 0, counter.getNextRngCounter() );
+		CoulombKernelsSU3::saStep( counter.getBlocks(), NSB*8, counter.getField(0), counter.getField(1), dNnt, 1, .5*(options.getSaMax()+options.getSaMin()), 0, counter.getNextRngCounter() );
+		KernelCount hbCount = counter.finish( countedSites );
+
+		counter.begin();
+		CoulombKernelsSU3::microStep( counter.getBlocks(), NSB*8, counter.getField(0), counter.getField(1), dNnt, 0 );
+		CoulombKernelsSU3::microStep( counter.getBlocks(), NSB*8, counter.getField(0), counter.getField(1), dNnt, 1 );
+		KernelCount microCount = counter.finish( countedSites );
+
+		counter.begin();
+		CoulombKernelsSU3::orStep( counter.getBlocks(), NSB*8, counter.getField(0), counter.getField(1), dNnt, 0, options.getOrParameter() );
+		CoulombKernelsSU3::orStep( counter.getBlocks(), NSB*8, counter.getField(0), counter.getField(1), dNnt, 1, options.getOrParameter() );
+		KernelCount orCount = counter.finish( countedSites );
+
+		LandauKernelCounter<Real>::print( cout, "heatbath", hbCount );
+		LandauKernelCounter<Real>::print( cout, "micro", microCount );
+		LandauKernelCounter<Real>::print( cout, "OR", orCount );
+		saFlops = hbCount.getFlops()+options.getSaMicroupdates()*microCount.getFlops();
+		saBytes = hbCount.getBytes()+options.getSaMicroupdates()*microCount.getBytes();
+		orFlops = orCount.getFlops();
+		orBytes = orCount.getBytes();
+	}
 
 	// timer to measure kernel times
 	Chronotimer kernelTimer;
@@ -149,10 +194,12 @@ int main(int argc, char* argv[])
 	long orTotalStepnumber = 0;
 	double saTotalKernelTime = 0;
 
+	int config = 0;
 	FileIterator fi( options );
-	for( fi.reset(); fi.hasNext(); fi.next() )
+	for( fi.reset(); fi.hasNext(); fi.next(), config++ )
 	{
 		bool loadOk;
+		metrics.beginConfig( config, (options.isSetHot())?(""):(fi.getFilename()) );
 
 		// ofstream output;
 		// output.precision(17);
@@ -161,6 +208,9 @@ int main(int argc, char* argv[])
 
 		if( !options.isSetHot() ) // load a file
 		{
+			Chronotimer loadTimer;
+			loadTimer.reset();
+			loadTimer.start();
 
 			switch(  options.getFType() )
 			{
@@ -194,6 +244,8 @@ int main(int argc, char* argv[])
 			{
 				cout << "File loaded." << endl;
 			}
+			loadTimer.stop();
+			metrics.addConfig( PhaseMetrics::LOAD, loadTimer.getTime(), 0, 0, (double)arraySize*sizeof(Real) );
 		}
 
 		for( int t = 0; t < s.size[0]; t++ )
@@ -203,6 +255,7 @@ int main(int argc, char* argv[])
 			double bestGff = 0.0;
 			for( int copy = 0; copy < options.getGaugeCopies(); copy++ )
 			{
+				metrics.beginCopy( copy );
 				if( !options.isSetHot() ) // if we want a hot random configuration we do not need to copy
 				{
 					// copying timeslice t ...
@@ -226,7 +279,7 @@ int main(int argc, char* argv[])
 
 				// calculate and print the gauge quality
 				printf( "i:\t\tgff:\t\tdA:\n");
-				gaugeStats.generateGaugeQuality();
+				generateGaugeQuality( gaugeStats, metrics );
 
 
 				// SIMUALTED ANNEALING
@@ -251,11 +304,12 @@ int main(int argc, char* argv[])
 					{
 						CommonKernelsSU3::projectSU3( s.getLatticeSizeTimeslice()/32, 32, dUtUp, HOST_CONSTANTS::getPtrToDeviceSizeTimeslice() );
 						CommonKernelsSU3::projectSU3( s.getLatticeSizeTimeslice()/32, 32, dUtDw, HOST_CONSTANTS::getPtrToDeviceSizeTimeslice() );
+						metrics.add( PhaseMetrics::REPROJECT, 0, 0, 2 );
 					}
 
 					if( i % options.getCheckPrecision() == 0 )
 					{
-						gaugeStats.generateGaugeQuality();
+						generateGaugeQuality( gaugeStats, metrics );
 						printf( "%f\t\t%1.10f\t\t%e\n", temperature, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
 						// output<<temperature<<","<<gaugeStats.getCurrentGff()<<","<<t<<endl;
 					}
@@ -264,10 +318,16 @@ int main(int argc, char* argv[])
 				cudaDeviceSynchronize();
 				kernelTimer.stop();
 				saTotalKernelTime += kernelTimer.getTime();
+				if( options.getSaSteps() > 0 )
+				{
+					long sweeps = options.getSaSteps();
+					metrics.add( PhaseMetrics::SA, 0, kernelTimer.getTime(), sweeps, saFlops*s.getLatticeSizeTimeslice()*sweeps, saBytes*s.getLatticeSizeTimeslice()*sweeps );
+				}
 
 
 				// OVERRELAXATION
 				if( options.getOrMaxIter() > 0 ) printf( "OVERRELAXATION\n" );
+				long orSteps = 0;
 				kernelTimer.reset();
 				kernelTimer.start();
 				for( int i = 0; i < options.getOrMaxIter(); i++ )
@@ -279,26 +339,38 @@ int main(int argc, char* argv[])
 					{
 						CommonKernelsSU3::projectSU3( s.getLatticeSizeTimeslice()/32, 32, dUtUp, HOST_CONSTANTS::getPtrToDeviceSizeTimeslice() );
 						CommonKernelsSU3::projectSU3( s.getLatticeSizeTimeslice()/32, 32, dUtDw, HOST_CONSTANTS::getPtrToDeviceSizeTimeslice() );
+						metrics.add( PhaseMetrics::REPROJECT, 0, 0, 2 );
 					}
 
 					if( i % options.getCheckPrecision() == 0 )
 					{
-						gaugeStats.generateGaugeQuality();
+						generateGaugeQuality( gaugeStats, metrics );
 						printf( "%d\t\t%1.10f\t\t%e\n", i, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
 						if( gaugeStats.getCurrentA() < options.getPrecision() ) break;
 					}
 
 					orTotalStepnumber++;
+					orSteps++;
 				}
 
 				cudaDeviceSynchronize();
 				kernelTimer.stop();
 				orTotalKernelTime += kernelTimer.getTime();
+				if( options.getOrMaxIter() > 0 )
+				{
+					metrics.add( PhaseMetrics::OR, 0, kernelTimer.getTime(), orSteps, orFlops*s.getLatticeSizeTimeslice()*orSteps, orBytes*s.getLatticeSizeTimeslice()*orSteps );
+				}
 
 
 				// reconstruct third line before copy back
+				kernelTimer.reset();
+				kernelTimer.start();
 				CommonKernelsSU3::projectSU3( s.getLatticeSizeTimeslice()/32, 32, dUtUp, HOST_CONSTANTS::getPtrToDeviceSizeTimeslice() );
 				CommonKernelsSU3::projectSU3( s.getLatticeSizeTimeslice()/32, 32, dUtDw, HOST_CONSTANTS::getPtrToDeviceSizeTimeslice() );
+				if( metrics.isEnabled() ) cudaDeviceSynchronize();
+				kernelTimer.stop();
+				metrics.add( PhaseMetrics::REPROJECT, 0, kernelTimer.getTime(), 2 );
+				metrics.setResult( 0, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
 
 				if( gaugeStats.getCurrentGff() > bestGff )
 				{
@@ -319,6 +391,9 @@ int main(int argc, char* argv[])
 		//saving file
 		if( !options.isSetHot() )
 		{
+			Chronotimer saveTimer;
+			saveTimer.reset();
+			saveTimer.start();
 			cout << "saving " << fi.getOutputFilename() << " as " << options.getFType() << endl;
 
 			switch( options.getFType() )
@@ -343,20 +418,20 @@ int main(int argc, char* argv[])
 				cout << "Filetype not set to a known value. Exiting";
 				exit(1);
 			}
+			saveTimer.stop();
+			metrics.addConfig( PhaseMetrics::SAVE, saveTimer.getTime(), 0, 0, (double)arraySize*sizeof(Real) );
 		}
 	}
+	metrics.flush();
 
 	allTimer.stop();
 	cout << "total time: " << allTimer.getTime() << " s" << endl;
 
 
-	long hbFlops = 2252+86-16;
-	long microFlops = 2252+14-16;
-	cout << "Simulated Annealing (HB+Micro): " << (double)((long)(hbFlops+microFlops*options.getSaMicroupdates())*(long)s.getLatticeSize()*(long)options.getSaSteps()*(long)options.getGaugeCopies())/saTotalKernelTime/1.0e9 << " GFlops at "
-					<< (double)((long)192*(long)s.getLatticeSize()*options.getSaSteps()*(options.getSaMicroupdates()+1)*(long)sizeof(Real))/saTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	cout << "Simulated Annealing (HB+Micro): " << saFlops*(double)s.getLatticeSize()*(double)options.getSaSteps()*(double)options.getGaugeCopies()/saTotalKernelTime/1.0e9 << " GFlops at "
+					<< saBytes*(double)s.getLatticeSize()*(double)options.getSaSteps()/saTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
 
 
-	long orFlops = 2252+22-16;
-	cout << "Overrelaxation: " << (double)((long)orFlops*(long)s.getLatticeSize()*(long)orTotalStepnumber)/orTotalKernelTime/1.0e9/(double)s.size[0] << " GFlops at "
-				<< (double)((long)192*(long)s.getLatticeSize()*(long)(orTotalStepnumber)*(long)sizeof(Real))/orTotalKernelTime/1.0e9/(double)s.size[0] << "GB/s memory throughput." << endl;
+	cout << "Overrelaxation: " << orFlops*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9/(double)s.size[0] << " GFlops at "
+				<< orBytes*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9/(double)s.size[0] << "GB/s memory throughput." << endl;
 }
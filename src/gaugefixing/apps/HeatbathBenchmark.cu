@@ -0,0 +1,228 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Benchmark of the batched heatbath BatchSaUpdate against the site by site update of SaUpdate (on the host).
+ *
+ * Random subgroup elements (as collected by GaugeFixingSubgroupStep) are updated at the lowest (--samin) and the
+ * highest (--samax) SA temperature:
+ *  - site by site with the rejection loops of SaUpdate, W sites in lockstep (each step waits for the slowest site)
+ *  - with BatchSaUpdate (the lanes take the next site as soon as their candidate is accepted)
+ * and the effective heatbath updates per second, the lane slots (candidates) per update and the mean and standard
+ * deviation of a0 (the overlap of the new and the old element) are printed. The latter have to agree within the
+ * statistical errors.
+ *
+ * make APP=HeatbathBenchmark X=<x> T=<t>
+ */
+
+#include <iostream>
+#include <math.h>
+#ifndef OSX
+#include "malloc.h"
+#endif
+#include "../GlobalConstants.h"
+#include "../algorithms/BatchSaUpdate.hxx"
+#include "../../lattice/rng/HostPhiloxWrapper.hxx"
+#include "../../util/timer/Chronotimer.h"
+#include "program_options/ProgramOptions.hxx"
+
+using namespace std;
+
+const int W = 8;
+
+namespace HBB
+{
+
+/**
+ * SaUpdate::calculateUpdate for W sites in lockstep: a lane repeats the rejection loop until all lanes accepted.
+ */
+void lockstepUpdate( Real* a, int n, float temperature, HostPhiloxWrapper<W>* rng, long& candidates )
+{
+	for( int i0 = 0; i0 < n; i0 += W )
+	{
+		Real e[4][W], dk[W], a0[W], r[4][W];
+		bool done[W];
+		int open = 0;
+		for( int l = 0; l < W; l++ )
+		{
+			int i = ( i0+l < n )?( i0+l ):( i0 );
+			for( int k = 0; k < 4; k++ ) e[k][l] = a[k*n+i];
+			dk[l] = 1./sqrt( e[0][l]*e[0][l]+e[1][l]*e[1][l]+e[2][l]*e[2][l]+e[3][l]*e[3][l] );
+			done[l] = ( i0+l >= n );
+			if( !done[l] ) open++;
+		}
+
+		while( open > 0 )
+		{
+			// all lanes draw, the finished ones discard their numbers
+			do
+			{
+				rng->rand( r[0] );
+				candidates += W; // lane slots, including the waiting lanes
+				bool retry = false;
+				for( int l = 0; l < W; l++ ) if( !done[l] && r[0][l] < 0.0001 ) retry = true;
+				if( !retry ) break;
+			} while( true );
+			do
+			{
+				rng->rand( r[1] );
+				bool retry = false;
+				for( int l = 0; l < W; l++ ) if( !done[l] && r[1][l] < 0.0001 ) retry = true;
+				if( !retry ) break;
+			} while( true );
+			rng->rand( r[2] );
+			rng->rand( r[3] );
+
+			for( int l = 0; l < W; l++ )
+			{
+				if( done[l] ) continue;
+				Real p0 = dk[l]*temperature;
+				Real c = cos( 2.*M_PI*r[2][l] );
+				Real delta = -log(r[1][l])*p0 - log(r[0][l])*p0*c*c;
+				if( r[3][l]*r[3][l] <= 1.-0.5*delta )
+				{
+					a0[l] = 1.-delta;
+					done[l] = true;
+					open--;
+				}
+			}
+		}
+
+		rng->rand( r[0] );
+		rng->rand( r[1] );
+		for( int l = 0; l < W && i0+l < n; l++ )
+		{
+			int i = i0+l;
+			Real cos_theta = 2.*r[0][l]-1.;
+			Real sin_theta = sqrt( 1.-cos_theta*cos_theta );
+			Real sin_alpha = sqrt( 1.-a0[l]*a0[l] );
+			Real phi = 2.*M_PI*r[1][l];
+			Real b0 = a0[l];
+			Real b1 = sin_alpha*sin_theta*cos(phi);
+			Real b2 = sin_alpha*sin_theta*sin(phi);
+			Real b3 = sin_alpha*cos_theta;
+			Real e0 = e[0][l]*dk[l];
+			Real e1 = -e[1][l]*dk[l];
+			Real e2 = -e[2][l]*dk[l];
+			Real e3 = -e[3][l]*dk[l];
+			a[i] = b0*e0+b3*e3+b2*e2+e1*b1;
+			a[3*n+i] = e0*b3-e3*b0+b1*e2-b2*e1;
+			a[2*n+i] = b3*e1-b0*e2+b2*e0-b1*e3;
+			a[n+i] = b2*e3+b1*e0-b3*e2-e1*b0;
+		}
+	}
+}
+
+void randomElements( Real* a, int n, int seed )
+{
+	HostPhiloxWrapper<1> rng( 0, seed, 0 );
+	for( int i = 0; i < 4*n; i++ )
+	{
+		Real r;
+		rng.rand( &r );
+		a[i] = 4.*(2.*r-1.);
+	}
+}
+
+/**
+ * Mean and standard deviation of a0, the overlap of the new element a with the input element e (a0 is the variable
+ * drawn by the heatbath).
+ */
+void moments( const Real* a, const Real* e, int n, double& mean, double& sigma )
+{
+	double s = 0, s2 = 0;
+	for( int i = 0; i < n; i++ )
+	{
+		double norm = sqrt( e[i]*e[i]+e[n+i]*e[n+i]+e[2*n+i]*e[2*n+i]+e[3*n+i]*e[3*n+i] );
+		double a0 = ( a[i]*e[i]+a[n+i]*e[n+i]+a[2*n+i]*e[2*n+i]+a[3*n+i]*e[3*n+i] )/norm;
+		s += a0;
+		s2 += a0*a0;
+	}
+	mean = s/(double)n;
+	sigma = sqrt( s2/(double)n - mean*mean );
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	// one subgroup element per lattice site, --sasteps repetitions
+	const int n = Nt*Nx*Ny*Nz;
+	const int repetitions = ( options.getSaSteps() > 0 )?( options.getSaSteps() ):( 1 );
+	Real* a = (Real*)malloc( 4*n*sizeof(Real) );
+	Real* e = (Real*)malloc( 4*n*sizeof(Real) );
+
+	float temperatures[2] = { options.getSaMin(), options.getSaMax() };
+	for( int t = 0; t < 2; t++ )
+	{
+		cout << "temperature " << temperatures[t] << endl;
+		double mean[2], sigma[2], updatesPerSecond[2], candidatesPerUpdate[2];
+
+		for( int method = 0; method < 2; method++ )
+		{
+			HostPhiloxWrapper<W> rng( 0, options.getSeed()+method, 0 );
+			BatchSaUpdate<W,Real> batch( temperatures[t], &rng );
+			long candidates = 0;
+			double sumMean = 0, sumSigma = 0;
+
+			Chronotimer timer;
+			timer.reset();
+			double time = 0;
+			for( int rep = 0; rep < repetitions; rep++ )
+			{
+				HBB::randomElements( e, n, options.getSeed()+rep );
+				for( int i = 0; i < 4*n; i++ ) a[i] = e[i];
+
+				timer.reset();
+				timer.start();
+				if( method == 0 ) HBB::lockstepUpdate( a, n, temperatures[t], &rng, candidates );
+				else batch.calculateUpdate( a, n );
+				timer.stop();
+				time += timer.getTime();
+
+				double m, s;
+				HBB::moments( a, e, n, m, s );
+				sumMean += m;
+				sumSigma += s;
+			}
+			if( method == 1 ) candidates = batch.getCandidates();
+
+			mean[method] = sumMean/(double)repetitions;
+			sigma[method] = sumSigma/(double)repetitions;
+			updatesPerSecond[method] = (double)n*(double)repetitions/time;
+			candidatesPerUpdate[method] = (double)candidates/(double)n/(double)repetitions;
+		}
+
+		cout << "lockstep (SaUpdate):\t" << updatesPerSecond[0] << " updates/s, " << candidatesPerUpdate[0] << " lane slots per update" << endl;
+		cout << "batched:\t\t" << updatesPerSecond[1] << " updates/s, " << candidatesPerUpdate[1] << " lane slots per update" << endl;
+		cout << "speedup: " << updatesPerSecond[1]/updatesPerSecond[0] << endl;
+
+		double error = sigma[0]/sqrt( (double)n*(double)repetitions );
+		cout << "a0: mean " << mean[0] << " vs. " << mean[1] << " (" << fabs(mean[0]-mean[1])/error/sqrt(2.) << " sigma), std. dev. " << sigma[0] << " vs. " << sigma[1] << endl;
+	}
+
+	free( a );
+	free( e );
+}
@@ -0,0 +1,376 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Landau gauge fixing (overrelaxation) on the host with a SIMD friendly tiled pattern.
+ *
+ * The configuration is kept in AoSoAPattern (tiles of HOST_TILE same-parity sites, lexicographic tile order) or
+ * MortonPattern (the same tiles in Morton order, --hostlayout morton) and updated by HostLandauKernelsSU3.
+ * LinkFile converts the file pattern directly to the host pattern, the ILDG/QCDSTAG readers (which produce GpuPattern)
+ * are converted with LinkFile::convertFrom()/convertTo().
+ *
+ * With --hostlayout auto all layouts that are compatible with the lattice are timed for --tunesweeps sweeps on a
+ * random field and the fastest one is used. The choice is cached per machine and lattice size in --tuningfile
+ * (see LayoutTuner), later runs on the same machine skip the timing.
+ *
+ * The host backend runs a single gauge copy without SA (no random numbers on the host), i.e.
+ * the options ormaxiter, orparameter, precision, checkprecision and reproject are used.
+ */
+
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+#ifndef OSX
+#include "malloc.h"
+#endif
+#include "../GlobalConstants.h"
+#include "../FieldBuffers.hxx"
+#include "../memory/HostMemory.hxx"
+#include "../HostLandauKernelsSU3.hxx"
+#include "../LayoutTuner.hxx"
+#include "../../lattice/access_pattern/StandardPattern.hxx"
+#include "../../lattice/access_pattern/GpuPattern.hxx"
+#include "../../lattice/access_pattern/AoSoAPattern.hxx"
+#include "../../lattice/access_pattern/MortonPattern.hxx"
+#include "../../lattice/SiteCoord.hxx"
+#include "../../util/timer/Chronotimer.h"
+#include "../../lattice/filetypes/FileHeaderOnly.hxx"
+#include "../../lattice/filetypes/FilePlain.hxx"
+#include "../../lattice/filetypes/FileVogt.hxx"
+#include "../../lattice/filetypes/filetype_typedefs.h"
+#include "../../lattice/LinkFile.hxx"
+#include "../../lattice/datatype/CountingReal.hxx"
+#include "program_options/ProgramOptions.hxx"
+#include "program_options/FileIterator.hxx"
+
+using namespace std;
+
+const lat_dim_t Ndim = 4;
+const short Nc = 3;
+
+const int arraySize = Nt*Nx*Ny*Nz*Ndim*Nc*Nc*2;
+
+// SIMD width in Reals (AVX)
+#ifdef DOUBLEPRECISION
+const int HOST_TILE = 4;
+#else
+const int HOST_TILE = 8;
+#endif
+
+typedef SiteCoord<Ndim,NO_SPLIT> HostSite;
+typedef StandardPattern<HostSite,Ndim,Nc> Standard;
+typedef GpuPattern< SiteCoord<Ndim,FULL_SPLIT>,Ndim,Nc> Gpu;
+typedef AoSoAPattern<HostSite,Ndim,Nc,HOST_TILE> HostAoSoA;
+typedef MortonPattern<HostSite,Ndim,Nc,HOST_TILE,2> HostMorton;
+typedef MortonPattern<HostSite,Ndim,Nc,HOST_TILE,4> HostMorton4;
+
+void readILDG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
+void writeILDG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const char *output_name, const short SIZE[4], Real *U, int steps);
+
+bool readQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
+bool writeQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *output_name, const short SIZE[4], Real *U);
+
+/**
+ * Flops and bytes per site of an OR sweep, counted with CountingReal on the first tile of each parity of a random field
+ * (the OR arithmetic does not depend on the values). The loads and stores are the reals of the link array.
+ */
+template<class Pattern> void countOrStep( float orParameter, double& flops, double& bytes )
+{
+	CountingReal<Real>* U = (CountingReal<Real>*)malloc( arraySize*sizeof(CountingReal<Real>) );
+	srand( 1 );
+	for( int i = 0; i < arraySize; i++ )
+	{
+		U[i] = (Real)rand()/(Real)RAND_MAX - .5;
+	}
+
+	HostLandauKernelsSU3<Pattern,CountingReal<Real> > kernels( HOST_CONSTANTS::SIZE );
+	resetHostOperationCounts();
+	kernels.orStepTile( U, 0, 0, orParameter );
+	kernels.orStepTile( U, 0, 1, orParameter );
+	OperationCounts counts = getHostOperationCounts();
+
+	const int sites = 2*Pattern::Tile;
+	flops = (double)counts.getFlops()/(double)sites;
+	bytes = (double)counts.getAccesses()*sizeof(Real)/(double)sites;
+	free( U );
+}
+
+template<class Pattern> int run( ProgramOptions& options )
+{
+	HostSite s(HOST_CONSTANTS::SIZE);
+	SiteCoord<4,FULL_SPLIT> sGpu(HOST_CONSTANTS::SIZE);
+
+	// host memory for configuration (in Pattern) and for the conversion from/to GpuPattern
+	Real* U = (Real*)malloc( arraySize*sizeof(Real) );
+	Real* UGpu = (Real*)malloc( arraySize*sizeof(Real) );
+
+	FieldBuffers<HostMemory> fields( 1, arraySize );
+
+	LinkFile<FileHeaderOnly, Standard, Pattern, HostSite> lfHeaderOnly( options.getReinterpret() );
+	LinkFile<FileVogt, Standard, Pattern, HostSite> lfVogt( options.getReinterpret() );
+	LinkFile<FilePlain, Standard, Pattern, HostSite> lfPlain( options.getReinterpret() );
+
+	HostLandauKernelsSU3<Pattern> kernels( HOST_CONSTANTS::SIZE );
+
+	double orFlops, orBytes;
+	countOrStep<Pattern>( options.getOrParameter(), orFlops, orBytes );
+	cout << "OR: " << orFlops << " flops and " << orBytes << " bytes per site and sweep" << endl;
+
+	Chronotimer kernelTimer;
+	double orTotalKernelTime = 0;
+	long orTotalStepnumber = 0;
+
+	FileIterator fi( options );
+	for( fi.reset(); fi.hasNext(); fi.next() )
+	{
+		bool loadOk;
+
+		switch( options.getFType() )
+		{
+		case VOGT:
+			loadOk = lfVogt.load( s, fi.getFilename(), U );
+			break;
+		case PLAIN:
+			loadOk = lfPlain.load( s, fi.getFilename(), U );
+			break;
+		case HEADERONLY:
+			loadOk = lfHeaderOnly.load( s, fi.getFilename(), U );
+			break;
+		case ILDG:
+			loadOk = true;
+			readILDG(sGpu, fi.getFilename().c_str(), HOST_CONSTANTS::SIZE, UGpu);
+			lfVogt.template convertFrom<Gpu>( s, UGpu, U );
+			break;
+		case QCDSTAG:
+			loadOk = readQCDSTAG(sGpu, fi.getFilename().c_str(), HOST_CONSTANTS::SIZE, UGpu);
+			lfVogt.template convertFrom<Gpu>( s, UGpu, U );
+			break;
+		default:
+			cout << "Filetype not set to a known value. Exiting...";
+			exit(1);
+		}
+
+		if( !loadOk )
+		{
+			cout << "Error while loading. Trying next file." << endl;
+			continue;
+		}
+		cout << "File loaded." << endl;
+
+		fields.load( U );
+		fields.reset( 0 );
+		Real* UWork = fields.getWorking( 0 );
+
+		double gff, A;
+		printf( "i:\t\tgff:\t\tdA:\n");
+		kernels.generateGaugeQuality( UWork, gff, A );
+		printf( "   \t\t%1.10f\t\t%e\n", gff, A );
+
+		// OVERRELAXATION
+		printf( "OVERRELAXATION\n" );
+		kernelTimer.reset();
+		kernelTimer.start();
+		for( int i = 0; i < options.getOrMaxIter(); i++ )
+		{
+			kernels.orStep( UWork, 0, options.getOrParameter() );
+			kernels.orStep( UWork, 1, options.getOrParameter() );
+			orTotalStepnumber++;
+
+			if( i % options.getReproject() == 0 )
+			{
+				kernels.projectSU3( UWork );
+			}
+
+			if( i % options.getCheckPrecision() == 0 )
+			{
+				kernels.generateGaugeQuality( UWork, gff, A );
+				printf( "%d\t\t%1.10f\t\t%e\n", i, gff, A );
+				if( A < options.getPrecision() ) break;
+			}
+		}
+		kernels.projectSU3( UWork );
+		kernelTimer.stop();
+		cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
+		orTotalKernelTime += kernelTimer.getTime();
+
+		fields.promote( 0 );
+		fields.store( U );
+
+		cout << "saving " << fi.getOutputFilename() << " as " << options.getFType() << endl;
+		switch( options.getFType() )
+		{
+		case VOGT:
+			loadOk = lfVogt.save( s, fi.getOutputFilename(), U );
+			break;
+		case PLAIN:
+			loadOk = lfPlain.save( s, fi.getOutputFilename(), U );
+			break;
+		case HEADERONLY:
+			loadOk = lfHeaderOnly.save( s, fi.getOutputFilename(), U );
+			break;
+		case ILDG:
+			lfVogt.template convertTo<Gpu>( s, U, UGpu );
+			writeILDG(sGpu, fi.getFilename().c_str(), fi.getOutputFilename().c_str(), HOST_CONSTANTS::SIZE, UGpu, 0);
+			break;
+		case QCDSTAG:
+			lfVogt.template convertTo<Gpu>( s, U, UGpu );
+			loadOk = writeQCDSTAG(sGpu, fi.getOutputFilename().c_str(), HOST_CONSTANTS::SIZE, UGpu);
+			break;
+		default:
+			cout << "Filetype not set to a known value. Exiting";
+			exit(1);
+		}
+	}
+
+	cout << "Overrelaxation: " << orFlops*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << " GFlops at "
+				<< orBytes*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+
+	free( U );
+	free( UGpu );
+	return 0;
+}
+
+/**
+ * Seconds per OR sweep (both parities) for the given Pattern, measured on a random field projected to SU(3).
+ * The OR arithmetic does not depend on the values, thus any field is representative.
+ */
+template<class Pattern> double timeSweeps( int sweeps )
+{
+	Real* U = (Real*)malloc( arraySize*sizeof(Real) );
+	srand( 1 );
+	for( int i = 0; i < arraySize; i++ )
+	{
+		U[i] = (Real)rand()/(Real)RAND_MAX - .5;
+	}
+
+	HostLandauKernelsSU3<Pattern> kernels( HOST_CONSTANTS::SIZE );
+	kernels.projectSU3( U );
+
+	// one sweep to warm up the caches
+	kernels.orStep( U, 0, 1.7 );
+	kernels.orStep( U, 1, 1.7 );
+
+	Chronotimer timer;
+	timer.reset();
+	timer.start();
+	for( int i = 0; i < sweeps; i++ )
+	{
+		kernels.orStep( U, 0, 1.7 );
+		kernels.orStep( U, 1, 1.7 );
+	}
+	timer.stop();
+
+	free( U );
+	return timer.getTime()/(double)sweeps;
+}
+
+/**
+ * Returns the layout from the tuning file or times all compatible layouts and caches the fastest one.
+ */
+std::string tuneLayout( ProgramOptions& options )
+{
+	LayoutTuner tuner( options.getTuningFile(), HOST_CONSTANTS::SIZE );
+
+	std::string layout;
+	if( tuner.lookup( layout ) )
+	{
+		cout << "host layout from tuning file " << options.getTuningFile() << ": " << layout << endl;
+		return layout;
+	}
+
+	cout << "tuning host layout (" << options.getTuneSweeps() << " sweeps per layout)" << endl;
+	double t = timeSweeps<HostAoSoA>( options.getTuneSweeps() );
+	cout << "aosoa:\t\t" << t << " s/sweep" << endl;
+	tuner.addTiming( "aosoa", t );
+	if( HostMorton::isCompatible( HOST_CONSTANTS::SIZE ) )
+	{
+		t = timeSweeps<HostMorton>( options.getTuneSweeps() );
+		cout << "morton:\t\t" << t << " s/sweep" << endl;
+		tuner.addTiming( "morton", t );
+	}
+	if( HostMorton4::isCompatible( HOST_CONSTANTS::SIZE ) )
+	{
+		t = timeSweeps<HostMorton4>( options.getTuneSweeps() );
+		cout << "morton4:\t" << t << " s/sweep" << endl;
+		tuner.addTiming( "morton4", t );
+	}
+	tuner.store();
+
+	return tuner.getBest();
+}
+
+int main(int argc, char* argv[])
+{
+	Chronotimer allTimer;
+	allTimer.reset();
+	allTimer.start();
+
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	if( options.isSetHot() )
+	{
+		cout << "The host backend needs a configuration file (no random numbers on the host)." << endl;
+		return 1;
+	}
+	if( options.getGaugeCopies() > 1 || options.getSaSteps() > 0 )
+	{
+		cout << "The host backend runs a single copy with OR only (gaugecopies and SA are ignored)." << endl;
+	}
+
+	if( !HostAoSoA::isCompatible( HOST_CONSTANTS::SIZE ) )
+	{
+		cout << "The z-extent has to be a multiple of " << 2*HOST_TILE << " for the host patterns." << endl;
+		return 1;
+	}
+
+	std::string layout = options.getHostLayout();
+	if( layout == "auto" )
+	{
+		layout = tuneLayout( options );
+	}
+
+	if( layout == "morton4" && HostMorton4::isCompatible( HOST_CONSTANTS::SIZE ) )
+	{
+		cout << "host layout: Morton ordered tiles of " << HOST_TILE << " sites (blocks of 4^4 tiles)" << endl;
+		returncode = run<HostMorton4>( options );
+	}
+	else if( ( layout == "morton" || layout == "morton4" ) && HostMorton::isCompatible( HOST_CONSTANTS::SIZE ) )
+	{
+		cout << "host layout: Morton ordered tiles of " << HOST_TILE << " sites" << endl;
+		returncode = run<HostMorton>( options );
+	}
+	else
+	{
+		if( layout != "aosoa" )
+		{
+			cout << "Lattice not compatible with layout " << layout << ", using AoSoA." << endl;
+		}
+		cout << "host layout: AoSoA tiles of " << HOST_TILE << " sites" << endl;
+		returncode = run<HostAoSoA>( options );
+	}
+
+	allTimer.stop();
+	cout << "total time: " << allTimer.getTime() << " s" << endl;
+	return returncode;
+}
@@ -28,18 +28,26 @@
 #endif
 #include "../GlobalConstants.h"
 #include "../GaugeFixingStats.hxx"
+#include "../GaugeCopyBatch.hxx"
+#include "../EarlyStopPolicy.hxx"
 #include "../../lattice/access_pattern/StandardPattern.hxx"
 #include "../../lattice/access_pattern/GpuPattern.hxx"
 #include "../../lattice/SiteCoord.hxx"
 #include "../../lattice/SiteIndex.hxx"
-#include "../../util/timer/Chronotimer.h"
+#include "../../util/timer/ScopedTimer.hxx"
+#include "../../util/metrics/PhaseMetrics.hxx"
+#include "../../util/metrics/ConvergenceTrace.hxx"
+#include "../../util/log/Logger.hxx"
 #include "../../lattice/filetypes/FileHeaderOnly.hxx"
 #include "../../lattice/filetypes/FilePlain.hxx"
 #include "../../lattice/filetypes/FileVogt.hxx"
 #include "../../lattice/filetypes/filetype_typedefs.h"
 #include "../../lattice/LinkFile.hxx"
 #include "../LandauKernelsSU3.hxx"
+#include "../KernelStorage.hxx"
+#include "../LandauKernelCounter.hxx"
 #include "../CommonKernelsSU3.hxx"
+#include "../ReplicaExchange.hxx"
 #include "program_options/ProgramOptions.hxx"
 #include "program_options/FileIterator.hxx"
 
@@ -59,18 +67,51 @@ void writeILDG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const char *out
 bool readQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
 bool writeQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *output_name, const short SIZE[4], Real *U);
 
-int main(int argc, char* argv[])
+/**
+ * Calculates the gauge quality of the active slots. The metrics take the device times of the measurements from
+ * events in the streams (GaugeCopyBatch::setTiming()). With profiling, the pending kernels are finished first such
+ * that only the quality kernels are in the "quality" region.
+ */
+template<class Batch> void generateGaugeQuality( Batch& batch, int slots, PhaseMetrics& metrics )
+{
+	if( Profiler::isEnabled() )
+	{
+		batch.synchronize();
+		ScopedTimer timer( "quality" );
+		batch.generateGaugeQuality();
+	}
+	else
+	{
+		batch.generateGaugeQuality();
+	}
+	metrics.addQuality( batch, slots );
+}
+
+/**
+ * The gauge fixing with the link storage of Storage on the device (--links): the fields of the batch are in the layout
+ * of the storage class, the files are converted on the host (BasicLandauKernelsSU3::compress(), decompress()).
+ */
+template<class Storage> int gaugeFix( const ProgramOptions& options )
 {
-	Chronotimer allTimer;
-	allTimer.reset();
-	allTimer.start();
+	typedef BasicLandauKernelsSU3<Storage> GKernels;
+	typedef LandauKernelCounter<Real,GKernels> Counter;
 
-	LandauKernelsSU3::initCacheConfig();
+	GKernels::initCacheConfig();
 
-	// read configuration from file or command line
-	ProgramOptions options;
-	int returncode = options.init( argc, argv );
-	if( returncode != 0 ) return returncode;
+	// reals of a field in the link storage
+	const int storageArraySize = Nt*Nx*Ny*Nz*Ndim*GKernels::Reals;
+
+	// the profile of the regions is printed at exit
+	if( options.isProfile() ) Profiler::enable();
+	ScopedTimer allTimer( "total" );
+
+	PhaseMetrics metrics( options.getMetricsFile(), options.getMetricsFormat() );
+	ConvergenceTrace trace( options.getTraceFile() );
+
+	// the progress of the gauge fixing loops is written by the asynchronous logger
+	util::Logger::setLevel( options.getLogLevel() );
+
+	if( GKernels::Reals == 8 ) util::Logger::logf( util::WARN, "--links 8: the reconstruction of Link8 is ill conditioned for links close to the identity, use --links 12 for cold or gauge fixed configurations." );
 
 	// Choose device and print device infos
 	cudaDeviceProp deviceProp;
@@ -97,9 +138,9 @@ int main(int argc, char* argv[])
 	// host memory for configuration
 	Real* U = (Real*)malloc( arraySize*sizeof(Real) );
 
-	// device memory for configuration
-	Real* dU;
-	cudaMalloc( &dU, arraySize*sizeof(Real) );
+	// host memory for the configuration in the link storage (the same as U for 18 reals)
+	Real* UStorage = U;
+	if( GKernels::Reals != 18 ) UStorage = (Real*)malloc( storageArraySize*sizeof(Real) );
 
 	// host memory for the neighbour table
 	lat_index_t* nn = (lat_index_t*)malloc( s.getLatticeSize()*(2*(Ndim))*sizeof(lat_index_t) );
@@ -115,6 +156,22 @@ int main(int argc, char* argv[])
 	// copy neighbour table to device
 	cudaMemcpy( dNn, nn, s.getLatticeSize()*(2*(Ndim))*sizeof( lat_index_t ), cudaMemcpyHostToDevice );
 
+	// flops and bytes per site and sweep, counted from the kernels (the heatbath at the mean SA temperature)
+	double saFlops, saBytes, orFlops, orBytes;
+	{
+		Counter counter( dNn, s.getLatticeSize() );
+		KernelCount hbCount = counter.saStep( .5*(options.getSaMax()+options.getSaMin()) );
+		KernelCount microCount = counter.microStep();
+		KernelCount orCount = counter.orStep( options.getOrParameter() );
+		Counter::print( cout, "heatbath", hbCount );
+		Counter::print( cout, "micro", microCount );
+		Counter::print( cout, "OR", orCount );
+		saFlops = hbCount.getFlops()+options.getSaMicroupdates()*microCount.getFlops();
+		saBytes = hbCount.getBytes()+options.getSaMicroupdates()*microCount.getBytes();
+		orFlops = orCount.getFlops();
+		orBytes = orCount.getBytes();
+	}
+
 	// TODO maybe we should choose the filetype at compile time
 	LinkFile<FileHeaderOnly, Standard, Gpu, SiteCoord<4,FULL_SPLIT> > lfHeaderOnly( options.getReinterpret() );
 	LinkFile<FileVogt, Standard, Gpu, SiteCoord<4,FULL_SPLIT> > lfVogt( options.getReinterpret() );
@@ -124,24 +181,47 @@ int main(int argc, char* argv[])
 	int threadsPerBlock = NSB*8; // NSB sites are updated within a block (8 threads are needed per site)
 	int numBlocks = s.getLatticeSize()/2/NSB; // // half of the lattice sites (a parity) are updated in a kernel call
 
-	GaugeFixingStats<Ndim,Nc,LandauKernelsSU3,AVERAGE> gaugeStats( dU, HOST_CONSTANTS::SIZE );
+	// device memory for the configurations of the concurrently processed gauge copies
+	// (in replica exchange mode these are the replicas of a single gauge copy)
+	bool replicaMode = ( options.getReplicas() > 1 );
+	GaugeCopyBatch<Ndim,Nc,GKernels,AVERAGE> batch( (replicaMode)?(options.getReplicas()):(options.getConcurrentCopies()), storageArraySize, HOST_CONSTANTS::SIZE );
+	batch.setReplicaMode( replicaMode );
+	batch.setTiming( metrics.isEnabled() );
 
-	// timer to measure kernel times
-	Chronotimer kernelTimer;
-	kernelTimer.reset();
-	kernelTimer.start();
+	// abandons copies that can not become the best copy
+	EarlyStopPolicy earlyStop( batch.getSlots(), options.getEarlyStopMargin() );
+
+	// temperature ladder and swap statistics for the replica exchange mode
+	ReplicaExchange replicaExchange( batch.getSlots(), options.getSaMin(), options.getSaMax(), options.getSeed() );
+	if( replicaMode && !replicaExchange.isValid() )
+	{
+		util::Logger::logf( util::FATAL, "Replica exchange needs 0 < samin <= samax." );
+		return 1;
+	}
 
 	double orTotalKernelTime = 0; // sum up total kernel time for OR
 	long orTotalStepnumber = 0;
 	double saTotalKernelTime = 0;
+	long saTotalStepnumber = 0; // SA sweeps summed over the copies
+	double reTotalKernelTime = 0;
+	long reTotalStepnumber = 0; // replica exchange sweeps summed over the replicas
 
+	int config = 0;
 	FileIterator fi( options );
-	for( fi.reset(); fi.hasNext(); fi.next() )
+	for( fi.reset(); fi.hasNext(); fi.next(), config++ )
 	{
 		bool loadOk;
+		ScopedTimer configTimer( "configuration" );
+
+		metrics.beginConfig( config, (options.isSetHot())?(""):(fi.getFilename()) );
+		util::Logger::setConfig( config );
+		trace.setConfig( config );
+		util::Logger::setCopy( -1 );
+		util::Logger::setIteration( -1 );
 
 		if( !options.isSetHot() ) // load a file
 		{
+			ScopedTimer timer( "load" );
 			//cout << "loading " << fi.getFilename() << " as " << options.getFType() << endl;
 			switch( options.getFType() )
 			{
@@ -168,127 +248,253 @@ int main(int argc, char* argv[])
 
 			if( !loadOk )
 			{
-				cout << "Error while loading. Trying next file." << endl;
+				util::Logger::logf( util::ERROR, "Error while loading. Trying next file." );
 				break;
 			}
 			else
 			{
-				cout << "File loaded." << endl;
+				util::Logger::logf( util::INFO, "File loaded." );
 			}
+
+			// keep a clean copy of the configuration on the device, all gauge copies start from it
+			if( UStorage != U ) GKernels::compress( U, UStorage );
+			batch.load( UStorage );
+			metrics.addConfig( PhaseMetrics::LOAD, timer.stop(), 0, 0, (double)arraySize*sizeof(Real) );
 		}
 		else // or initialize with a hot configuration (ignore file options)
 		{
-			CommonKernelsSU3::setHot( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize(), options.getSeed(), PhiloxWrapper::getNextCounter() );
+			// all copies start from the same hot configuration
+			GKernels::setHot( s.getLatticeSize()/32,32, batch.getPristine(), HOST_CONSTANTS::getPtrToDeviceSize(), options.getSeed(), PhiloxWrapper::getNextCounter() );
 		}
 
 		double bestGff = 0.0;
-		for( int copy = 0; copy < options.getGaugeCopies(); copy++ )
+		for( int firstCopy = 0; firstCopy < options.getGaugeCopies(); firstCopy += batch.getCopiesPerBatch() )
 		{
-			// we copy from host in every gaugecopy step to have a cleaner configuration (concerning numerical errors)
-			// it would be best to keep a completely clean copy on host side
-			if( !options.isSetHot() ) cudaMemcpy( dU, U, arraySize*sizeof(Real), cudaMemcpyHostToDevice );
+			ScopedTimer copiesTimer( "copies" );
+			int slots = batch.begin( firstCopy, options.getGaugeCopies() );
+			earlyStop.reset();
+			metrics.beginCopies( batch, slots );
+
+			// each gaugecopy starts from the pristine configuration (concerning numerical errors)
+			batch.reset();
 
 
 			if( options.isRandomTrafo() )
 			{
-				LandauKernelsSU3::randomTrafo(numBlocks,threadsPerBlock,dU, dNn, 0, options.getSeed(), PhiloxWrapper::getNextCounter() );
-				LandauKernelsSU3::randomTrafo(numBlocks,threadsPerBlock,dU, dNn, 1, options.getSeed(), PhiloxWrapper::getNextCounter() );
+				for( int k = 0; k < slots; k++ )
+				{
+					GKernels::randomTrafo(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 0, batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
+					GKernels::randomTrafo(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 1, batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
+				}
 			}
 
 
 			// calculate and print the gauge quality
-			printf( "i:\t\tgff:\t\tdA:\n");
-			gaugeStats.generateGaugeQuality();
-			printf( "   \t\t%1.10f\t\t%e\n", gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
+			generateGaugeQuality( batch, slots, metrics );
+			trace.addActive( batch, slots, ConvergenceTrace::INITIAL, 0 );
+			for( int k = 0; k < slots; k++ )
+			{
+				util::Logger::setCopy( batch.getCopy(k) );
+				util::Logger::logf( util::INFO, "gff: %1.10f dA: %e", batch.getStats(k).getCurrentGff(), batch.getStats(k).getCurrentA() );
+			}
+			util::Logger::setCopy( (slots > 1)?(-1):(batch.getCopy(0)) );
 
 
-			// SIMULATED ANNEALING
-			if( options.getSaSteps() > 0 ) printf( "SIMULATED ANNEALING\n" );
-			float temperature = options.getSaMax();
-			float tempStep = (options.getSaMax()-options.getSaMin())/(float)options.getSaSteps();
-
-			kernelTimer.reset();
-			kernelTimer.start();
-			for( int i = 0; i < options.getSaSteps(); i++ )
+			// REPLICA EXCHANGE (replaces simulated annealing)
+			if( replicaMode )
 			{
-				LandauKernelsSU3::saStep(numBlocks,threadsPerBlock,dU, dNn, 0, temperature, options.getSeed(), PhiloxWrapper::getNextCounter() );
-				LandauKernelsSU3::saStep(numBlocks,threadsPerBlock,dU, dNn, 1, temperature, options.getSeed(), PhiloxWrapper::getNextCounter() );
+				util::Logger::logf( util::INFO, "REPLICA EXCHANGE" );
+				ScopedTimer timer( "replica exchange" );
+				replicaExchange.reset( firstCopy );
+				int coldest = replicaExchange.run<GKernels>( batch, dNn, numBlocks, threadsPerBlock, options.getReRounds(), options.getReSweeps(), options.getSaMicroupdates(), options.getReproject(), options.getCheckPrecision(), options.getSeed() );
 
-				for( int mic = 0; mic < options.getSaMicroupdates(); mic++ )
+				// only the coldest replica is finished
+				for( int k = 0; k < slots; k++ )
 				{
-					LandauKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 0 );
-					LandauKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 1 );
+					if( k != coldest ) batch.dismiss(k);
 				}
+				double kernelTime = timer.stop();
+				util::Logger::logf( util::INFO, "kernel time: %g s", kernelTime );
+				reTotalKernelTime += kernelTime;
 
-				if( i % options.getReproject() == 0 )
+				long sweeps = (long)options.getReRounds()*(long)options.getReSweeps();
+				reTotalStepnumber += sweeps*slots;
+				for( int k = 0; k < slots; k++ )
 				{
-					CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+					metrics.add( PhaseMetrics::SA, k, kernelTime, sweeps, saFlops*s.getLatticeSize()*sweeps, saBytes*s.getLatticeSize()*sweeps );
 				}
+			}
 
-				if( i % options.getCheckPrecision() == 0 )
+			// SIMULATED ANNEALING
+			int saSteps = (replicaMode)?(0):(options.getSaSteps());
+			if( saSteps > 0 ) util::Logger::logf( util::INFO, "SIMULATED ANNEALING" );
+			float temperature = options.getSaMax();
+			float tempStep = (options.getSaMax()-options.getSaMin())/(float)options.getSaSteps();
+
+			double kernelTime;
+			{
+				ScopedTimer timer( "SA" );
+				for( int i = 0; i < saSteps; i++ )
 				{
-					gaugeStats.generateGaugeQuality();
-					printf( "%d\t\t%1.10f\t\t%e\n", i, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
+					// the kernels of different copies are independent and may overlap on the device
+					for( int k = 0; k < slots; k++ )
+					{
+						GKernels::saStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 0, temperature, batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
+						GKernels::saStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 1, temperature, batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
+
+						for( int mic = 0; mic < options.getSaMicroupdates(); mic++ )
+						{
+							GKernels::microStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 0 );
+							GKernels::microStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 1 );
+						}
+
+						if( i % options.getReproject() == 0 )
+						{
+							GKernels::projectSU3( s.getLatticeSize()/32,32, batch.getStream(k), batch.getField(k) );
+							metrics.add( PhaseMetrics::REPROJECT, k, 0, 1 );
+						}
+					}
+
+					if( i % options.getCheckPrecision() == 0 )
+					{
+						generateGaugeQuality( batch, slots, metrics );
+						trace.addActive( batch, slots, ConvergenceTrace::SA, i, temperature );
+						util::Logger::setIteration( i );
+						for( int k = 0; k < slots; k++ )
+						{
+							util::Logger::setCopy( batch.getCopy(k) );
+							util::Logger::logf( util::INFO, "gff: %1.10f dA: %e", batch.getStats(k).getCurrentGff(), batch.getStats(k).getCurrentA() );
+						}
+					}
+					temperature -= tempStep;
 				}
-				temperature -= tempStep;
+				batch.synchronize();
+				kernelTime = timer.stop();
+			}
+			util::Logger::setCopy( (slots > 1)?(-1):(batch.getCopy(0)) );
+			util::Logger::setIteration( -1 );
+			util::Logger::logf( util::INFO, "kernel time: %g s", kernelTime );
+			saTotalKernelTime += kernelTime;
+			saTotalStepnumber += (long)saSteps*slots;
+			for( int k = 0; k < slots && saSteps > 0; k++ )
+			{
+				metrics.add( PhaseMetrics::SA, k, kernelTime, saSteps, saFlops*s.getLatticeSize()*saSteps, saBytes*s.getLatticeSize()*saSteps );
 			}
-			cudaDeviceSynchronize();
-			kernelTimer.stop();
-			cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
-			saTotalKernelTime += kernelTimer.getTime();
 
 			// OVERRELAXATION
-			if( options.getOrMaxIter() > 0 ) printf( "OVERRELAXATION\n" );
-			kernelTimer.reset();
-			kernelTimer.start();
-			for( int i = 0; i < options.getOrMaxIter(); i++ )
+			long* orSteps = new long[slots];
+			for( int k = 0; k < slots; k++ ) orSteps[k] = 0;
+			if( options.getOrMaxIter() > 0 ) util::Logger::logf( util::INFO, "OVERRELAXATION" );
 			{
-				LandauKernelsSU3::orStep(numBlocks,threadsPerBlock,dU, dNn, 0, options.getOrParameter() );
-				LandauKernelsSU3::orStep(numBlocks,threadsPerBlock,dU, dNn, 1, options.getOrParameter() );
-
-				if( i % options.getReproject() == 0 )
-				{
-					CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
-				}
-
-				if( i % options.getCheckPrecision() == 0 )
+				ScopedTimer timer( "OR" );
+				for( int i = 0; i < options.getOrMaxIter() && batch.anyActive(); i++ )
 				{
-					gaugeStats.generateGaugeQuality();
-					printf( "%d\t\t%1.10f\t\t%e\n", i, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
-					if( gaugeStats.getCurrentA() < options.getPrecision() ) break;
+					for( int k = 0; k < slots; k++ )
+					{
+						if( !batch.isActive(k) ) continue;
+
+						GKernels::orStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 0, options.getOrParameter() );
+						GKernels::orStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 1, options.getOrParameter() );
+
+						if( i % options.getReproject() == 0 )
+						{
+							GKernels::projectSU3( s.getLatticeSize()/32,32, batch.getStream(k), batch.getField(k) );
+							metrics.add( PhaseMetrics::REPROJECT, k, 0, 1 );
+						}
+					}
+
+					if( i % options.getCheckPrecision() == 0 )
+					{
+						generateGaugeQuality( batch, slots, metrics );
+						trace.addActive( batch, slots, ConvergenceTrace::OR, i );
+						util::Logger::setIteration( i );
+						for( int k = 0; k < slots; k++ )
+						{
+							if( !batch.isActive(k) ) continue;
+
+							util::Logger::setCopy( batch.getCopy(k) );
+							util::Logger::logf( util::INFO, "gff: %1.10f dA: %e", batch.getStats(k).getCurrentGff(), batch.getStats(k).getCurrentA() );
+							if( batch.getStats(k).getCurrentA() < options.getPrecision() ) batch.deactivate(k);
+							else if( options.isEarlyStop() )
+							{
+								earlyStop.addSample( k, batch.getStats(k).getCurrentGff() );
+								if( earlyStop.isHopeless( k, bestGff ) )
+								{
+									util::Logger::logf( util::INFO, "EARLY STOP: predicted gff %1.10f is below best gff %1.10f", earlyStop.getPrediction(k), bestGff );
+									earlyStop.countEarlyStop();
+									batch.deactivate(k);
+								}
+							}
+						}
+					}
+
+					for( int k = 0; k < slots; k++ )
+					{
+						if( batch.isActive(k) )
+						{
+							orTotalStepnumber++;
+							orSteps[k]++;
+						}
+					}
 				}
 
-				orTotalStepnumber++;
+				batch.synchronize();
+				kernelTime = timer.stop();
 			}
-
-			cudaDeviceSynchronize();
-			kernelTimer.stop();
-			cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
-			orTotalKernelTime += kernelTimer.getTime();
+			util::Logger::setCopy( (slots > 1)?(-1):(batch.getCopy(0)) );
+			util::Logger::setIteration( -1 );
+			util::Logger::logf( util::INFO, "kernel time: %g s", kernelTime );
+			orTotalKernelTime += kernelTime;
+			for( int k = 0; k < slots && options.getOrMaxIter() > 0; k++ )
+			{
+				metrics.add( PhaseMetrics::OR, k, kernelTime, orSteps[k], orFlops*s.getLatticeSize()*orSteps[k], orBytes*s.getLatticeSize()*orSteps[k] );
+			}
+			delete[] orSteps;
 
 
 			// reconstruct third line
-			CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+			{
+				ScopedTimer timer( "reproject" );
+				for( int k = 0; k < slots; k++ )
+				{
+					GKernels::projectSU3( s.getLatticeSize()/32,32, batch.getStream(k), batch.getField(k) );
+				}
+				batch.synchronize();
+				kernelTime = timer.stop();
+			}
+			for( int k = 0; k < slots; k++ )
+			{
+				metrics.add( PhaseMetrics::REPROJECT, k, kernelTime, 1 );
+				metrics.setResult( k, batch.getStats(k).getCurrentGff(), batch.getStats(k).getCurrentA() );
+			}
 
 			// check for best copy
-			if( gaugeStats.getCurrentGff() > bestGff )
+			int bestSlot = batch.getBestSlot( bestGff );
+			if( bestSlot >= 0 )
 			{
-				cout << "FOUND BETTER COPY" << endl;
-				bestGff = gaugeStats.getCurrentGff();
+				if( slots > 1 ) util::Logger::logf( util::INFO, "FOUND BETTER COPY (copy %d)", batch.getCopy(bestSlot) );
+				else util::Logger::logf( util::INFO, "FOUND BETTER COPY" );
+				bestGff = batch.getStats(bestSlot).getCurrentGff();
 
-				// copy back
-				cudaMemcpy( U, dU, arraySize*sizeof(Real), cudaMemcpyDeviceToHost );
+				// keep the copy on the device (swaps the buffers of the slot and the best copy)
+				batch.promote( bestSlot );
 			}
 			else
 			{
-				cout << "NO BETTER COPY" << endl;
+				util::Logger::logf( util::INFO, "NO BETTER COPY" );
 			}
 		}
 
+		trace.flush();
+
 		//saving file
 		if( !options.isSetHot() )
 		{
-			cout << "saving " << fi.getOutputFilename() << " as " << options.getFType() << endl;
+			ScopedTimer timer( "save" );
+			batch.store( UStorage );
+			if( UStorage != U ) GKernels::decompress( UStorage, U );
+			util::Logger::setCopy( -1 );
+			util::Logger::logf( util::INFO, "saving %s", fi.getOutputFilename().c_str() );
 			switch( options.getFType() )
 			{
 			case VOGT:
@@ -311,19 +517,41 @@ int main(int argc, char* argv[])
 				cout << "Filetype not set to a known value. Exiting";
 				exit(1);
 			}
+			metrics.addConfig( PhaseMetrics::SAVE, timer.stop(), 0, 0, (double)arraySize*sizeof(Real) );
 		}
 	}
+	metrics.flush();
+	util::Logger::flush();
 
-	allTimer.stop();
 	cout << "total time: " << allTimer.getTime() << " s" << endl;
+	if( options.isEarlyStop() ) cout << "early stopped copies: " << earlyStop.getEarlyStops() << " of " << (long)options.getGaugeCopies()*(long)options.getNconf() << endl;
+
+	if( saTotalStepnumber > 0 ) cout << "Simulated Annealing (HB+Micro): " << saFlops*(double)s.getLatticeSize()*(double)saTotalStepnumber/saTotalKernelTime/1.0e9 << " GFlops at "
+					<< saBytes*(double)s.getLatticeSize()*(double)saTotalStepnumber/saTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	if( reTotalStepnumber > 0 ) cout << "Replica Exchange (HB+Micro): " << saFlops*(double)s.getLatticeSize()*(double)reTotalStepnumber/reTotalKernelTime/1.0e9 << " GFlops at "
+					<< saBytes*(double)s.getLatticeSize()*(double)reTotalStepnumber/reTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
 
-	long hbFlops = 2252+86;
-	long microFlops = 2252+14;
-	cout << "Simulated Annealing (HB+Micro): " << (double)((long)(hbFlops+microFlops*options.getSaMicroupdates())*(long)s.getLatticeSize()*(long)options.getSaSteps()*(long)options.getGaugeCopies())/saTotalKernelTime/1.0e9 << " GFlops at "
-					<< (double)((long)192*(long)s.getLatticeSize()*options.getSaSteps()*(options.getSaMicroupdates()+1)*(long)sizeof(Real))/saTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	cout << "Overrelaxation: " << orFlops*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << " GFlops at "
+				<< orBytes*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
 
-	long orFlops = 2252+22;
-	cout << "Overrelaxation: " << (double)((long)orFlops*(long)s.getLatticeSize()*(long)orTotalStepnumber)/orTotalKernelTime/1.0e9 << " GFlops at "
-				<< (double)((long)192*(long)s.getLatticeSize()*(long)(orTotalStepnumber)*(long)sizeof(Real))/orTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	return 0;
+}
 
+int main(int argc, char* argv[])
+{
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	// reals per link on the device (Link, Link12 or Link8), the neighbour access is SiteIndex for all
+	switch( options.getLinks() )
+	{
+	case 12:
+		return gaugeFix<KernelStorage<SiteIndex<Ndim,FULL_SPLIT>,12> >( options );
+	case 8:
+		return gaugeFix<KernelStorage<SiteIndex<Ndim,FULL_SPLIT>,8> >( options );
+	default:
+		return gaugeFix<DefaultKernelStorage>( options );
+	}
 }
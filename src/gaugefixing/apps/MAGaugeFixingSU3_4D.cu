@@ -28,14 +28,21 @@
 #endif
 #include "../GlobalConstants.h"
 #include "../GaugeFixingStats.hxx"
+#include "../GaugeCopyBatch.hxx"
+#include "../EarlyStopPolicy.hxx"
 #include "../MAGKernelsSU3.hxx"
+#include "../LandauKernelCounter.hxx"
 #include "../CommonKernelsSU3.hxx"
+#include "../ReplicaExchange.hxx"
+#include "../Checkpoint.hxx"
 #include "../../lattice/access_pattern/StandardPattern.hxx"
 #include "../../lattice/access_pattern/GpuPattern.hxx"
 #include "../../lattice/SiteCoord.hxx"
 #include "../../lattice/SiteIndex.hxx"
 #include "../../lattice/LinkFile.hxx"
 #include "../../util/timer/Chronotimer.h"
+#include "../../util/metrics/PhaseMetrics.hxx"
+#include "../../util/metrics/ConvergenceTrace.hxx"
 #include "../../lattice/filetypes/FileHeaderOnly.hxx"
 #include "../../lattice/filetypes/FilePlain.hxx"
 #include "../../lattice/filetypes/FileVogt.hxx"
@@ -60,6 +67,16 @@ void writeILDG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const char *out
 bool readQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
 bool writeQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *output_name, const short SIZE[4], Real *U);
 
+/**
+ * Calculates the gauge quality of the active slots, the metrics take the device times of the measurements
+ * (GaugeCopyBatch::setTiming()).
+ */
+template<class Batch> void generateGaugeQuality( Batch& batch, int slots, PhaseMetrics& metrics )
+{
+	batch.generateGaugeQuality();
+	metrics.addQuality( batch, slots );
+}
+
 int main(int argc, char* argv[])
 {
 	Chronotimer allTimer;
@@ -73,6 +90,9 @@ int main(int argc, char* argv[])
 	int returncode = options.init( argc, argv );
 	if( returncode != 0 ) return returncode;
 
+	PhaseMetrics metrics( options.getMetricsFile(), options.getMetricsFormat() );
+	ConvergenceTrace trace( options.getTraceFile(), options.isRestart() );
+
 	// Choose device and print device infos
 	cudaDeviceProp deviceProp;
 	int selectedDeviceNumber;
@@ -102,10 +122,6 @@ int main(int argc, char* argv[])
 	// host memory for configuration
 	Real* U = (Real*)malloc( arraySize*sizeof(Real) );
 
-	// device memory for configuration
-	Real* dU;
-	cudaMalloc( &dU, arraySize*sizeof(Real) );
-
 	// host memory for the neighbour table
 	lat_index_t* nn = (lat_index_t*)malloc( s.getLatticeSize()*(2*(Ndim))*sizeof(lat_index_t) );
 
@@ -131,7 +147,40 @@ int main(int argc, char* argv[])
 	int numBlocks = s.getLatticeSize()/2/NSB; // // half of the lattice sites (a parity) are updated in a kernel call
 
 
-	GaugeFixingStats<Ndim,Nc,MAGKernelsSU3,AVERAGE> gaugeStats( dU, HOST_CONSTANTS::SIZE );
+	// device memory for the configurations of the concurrently processed gauge copies
+	// (in replica exchange mode these are the replicas of a single gauge copy)
+	bool replicaMode = ( options.getReplicas() > 1 );
+	GaugeCopyBatch<Ndim,Nc,MAGKernelsSU3,AVERAGE> batch( (replicaMode)?(options.getReplicas()):(options.getConcurrentCopies()), arraySize, HOST_CONSTANTS::SIZE );
+	batch.setReplicaMode( replicaMode );
+	batch.setTiming( metrics.isEnabled() );
+
+	// abandons copies that can not become the best copy
+	EarlyStopPolicy earlyStop( batch.getSlots(), options.getEarlyStopMargin() );
+
+	// temperature ladder and swap statistics for the replica exchange mode
+	ReplicaExchange replicaExchange( batch.getSlots(), options.getSaMin(), options.getSaMax(), options.getSeed() );
+	if( replicaMode && !replicaExchange.isValid() )
+	{
+		cout << "Replica exchange needs 0 < samin <= samax." << endl;
+		return 1;
+	}
+
+	// flops and bytes per site and sweep, counted from the kernels (the heatbath at the mean SA temperature);
+	// an SA sweep is 5 heatbath steps with their microcanonical steps
+	KernelCount hbCount, microCount, srCount, orCount;
+	{
+		LandauKernelCounter<Real,MAGKernelsSU3> counter( dNn, s.getLatticeSize() );
+		hbCount = counter.saStep( .5*(options.getSaMax()+options.getSaMin()) );
+		microCount = counter.microStep();
+		srCount = counter.srStep( options.getSrParameter() );
+		orCount = counter.orStep( options.getOrParameter() );
+		LandauKernelCounter<Real>::print( cout, "heatbath", hbCount );
+		LandauKernelCounter<Real>::print( cout, "micro", microCount );
+		LandauKernelCounter<Real>::print( cout, "SR", srCount );
+		LandauKernelCounter<Real>::print( cout, "OR", orCount );
+	}
+	double saFlops = 5*( hbCount.getFlops()+options.getSaMicroupdates()*microCount.getFlops() );
+	double saBytes = 5*( hbCount.getBytes()+options.getSaMicroupdates()*microCount.getBytes() );
 
 	// timer to measure kernel times
 	Chronotimer kernelTimer;
@@ -139,24 +188,68 @@ int main(int argc, char* argv[])
 	kernelTimer.start();
 
 	double saTotalKernelTime = 0;
+	long saTotalStepnumber = 0; // SA sweeps (5 heatbath steps each) summed over the copies
+	double reTotalKernelTime = 0;
+	long reTotalStepnumber = 0; // replica exchange sweeps summed over the replicas
 	double srTotalKernelTime = 0;
 	long srTotalStepnumber = 0;
 	double orTotalKernelTime = 0; // sum up total kernel time for OR
 	long orTotalStepnumber = 0;
 
+	// periodic checkpoints of the gauge copy search
+	Checkpoint checkpoint( options.getCheckpointFile(), batch.getSlots(), arraySize );
+	CheckpointState restartState;
+	bool restart = options.isRestart();
+	if( restart )
+	{
+		if( !checkpoint.isEnabled() || !checkpoint.read( restartState ) )
+		{
+			cout << "Can not restart: no valid checkpoint (--checkpoint)." << endl;
+			return 1;
+		}
+		cout << "continuing from checkpoint " << options.getCheckpointFile() << endl;
+	}
+
 	FileIterator fi( options );
-	for( fi.reset(); fi.hasNext(); fi.next() )
+	int fileIndex = 0;
+	bool complete = true;
+	for( fi.reset(); fi.hasNext(); fi.next(), fileIndex++ )
 	{
+		if( restart && fileIndex < restartState.fileIndex ) continue;
+		trace.setConfig( fileIndex );
+		metrics.beginConfig( fileIndex, (options.isSetHot())?(""):(fi.getFilename()) );
 
 		ofstream output;
 		output.precision(17);
-		output.open(fi.getOutputFunctional().c_str());
-		output << "copy,functional"<<endl;
+		int functionalLines = 0; // lines written for the finished copies
+		if( restart )
+		{
+			// drop the lines of copies that finished after the checkpoint, they are redone
+			functionalLines = restartState.functionalLines;
+			if( Checkpoint::truncateLines( fi.getOutputFunctional(), 1+functionalLines ) )
+			{
+				output.open(fi.getOutputFunctional().c_str(), ios::app);
+			}
+			else
+			{
+				cout << "Can not truncate " << fi.getOutputFunctional() << ", the functionals of the earlier copies are lost." << endl;
+				output.open(fi.getOutputFunctional().c_str());
+				output << "copy,functional"<<endl;
+			}
+		}
+		else
+		{
+			output.open(fi.getOutputFunctional().c_str());
+			output << "copy,functional"<<endl;
+		}
 
 		bool loadOk;
 
 		if( !options.isSetHot() ) // load a file
 		{
+			Chronotimer loadTimer;
+			loadTimer.reset();
+			loadTimer.start();
 			switch( options.getFType() )
 			{
 			case VOGT:
@@ -184,43 +277,109 @@ int main(int argc, char* argv[])
 			if( !loadOk )
 			{
 				cout << "Error while loading. Trying next file." << endl;
+				complete = false;
 				break;
 			}
 			else
 			{
 				cout << "File loaded." << endl;
 			}
+
+			// keep a clean copy of the configuration on the device, all gauge copies start from it
+			batch.load( U );
+			loadTimer.stop();
+			metrics.addConfig( PhaseMetrics::LOAD, loadTimer.getTime(), 0, 0, (double)arraySize*sizeof(Real) );
 		}
 		else // or initialize with a hot configuration (ignore file options)
 		{
-			CommonKernelsSU3::setHot( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize(), options.getSeed(), PhiloxWrapper::getNextCounter() );
+			// all copies start from the same hot configuration
+			CommonKernelsSU3::setHot( s.getLatticeSize()/32,32, batch.getPristine(), HOST_CONSTANTS::getPtrToDeviceSize(), options.getSeed(), PhiloxWrapper::getNextCounter() );
 		}
 
 		double bestGff = 0.0;
-		for( int copy = 0; copy < options.getGaugeCopies(); copy++ )
+		int startCopy = 0;
+		if( restart )
 		{
-			// we copy from host in every gaugecopy step to have a cleaner configuration (concerning numerical errors)
-			if( !options.isSetHot() ) cudaMemcpy( dU, U, arraySize*sizeof(Real), cudaMemcpyHostToDevice );
+			checkpoint.restore( batch, restartState );
+			bestGff = restartState.bestGff;
+			startCopy = restartState.firstCopy;
+		}
 
+		for( int firstCopy = startCopy; firstCopy < options.getGaugeCopies(); firstCopy += batch.getCopiesPerBatch() )
+		{
+			int slots = batch.begin( firstCopy, options.getGaugeCopies() );
+			earlyStop.reset();
+			metrics.beginCopies( batch, slots );
 
-                        gaugeStats.generateGaugeQuality();
-                        cout<<"initial functional "<<gaugeStats.getCurrentGff()<<endl;
+			// continue within SA: the working fields were restored from the checkpoint
+			bool resumeSA = restart && ( restartState.phase == CHECKPOINT_SA );
+			restart = false;
 
-			if( options.isRandomTrafo() ) // I'm an optimist! This should be called isRandomTrafo()!
+			if( !resumeSA )
 			{
-				MAGKernelsSU3::randomTrafo(numBlocks,threadsPerBlock,dU, dNn, 0, options.getSeed(), PhiloxWrapper::getNextCounter() );
-				MAGKernelsSU3::randomTrafo(numBlocks,threadsPerBlock,dU, dNn, 1, options.getSeed(), PhiloxWrapper::getNextCounter() );
+				if( checkpoint.isEnabled() )
+				{
+					CheckpointState state = { fileIndex, firstCopy, CHECKPOINT_BATCH, 0, 0.f, bestGff, 0, 0, functionalLines };
+					checkpoint.store( batch, state );
+				}
+
+				// each gaugecopy starts from the pristine configuration (concerning numerical errors)
+				batch.reset();
+
+
+				generateGaugeQuality( batch, slots, metrics );
+				cout<<"initial functional "<<batch.getStats(0).getCurrentGff()<<endl;
+
+				if( options.isRandomTrafo() ) // I'm an optimist! This should be called isRandomTrafo()!
+				{
+					for( int k = 0; k < slots; k++ )
+					{
+						MAGKernelsSU3::randomTrafo(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 0, batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
+						MAGKernelsSU3::randomTrafo(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 1, batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
+					}
+				}
 			}
 
 
 			// calculate and print the gauge quality
 			printf( "i:\t\tgff:\t\tdA:\n");
-			gaugeStats.generateGaugeQuality();
-			printf( "   \t\t%1.10f\t\t%e\n", gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
+			generateGaugeQuality( batch, slots, metrics );
+			trace.addActive( batch, slots, ConvergenceTrace::INITIAL, 0 );
+			for( int k = 0; k < slots; k++ )
+			{
+				if( slots > 1 ) printf( "[%d] ", batch.getCopy(k) );
+				printf( "   \t\t%1.10f\t\t%e\n", batch.getStats(k).getCurrentGff(), batch.getStats(k).getCurrentA() );
+			}
+
 
+			// REPLICA EXCHANGE (replaces simulated annealing)
+			if( replicaMode )
+			{
+				printf( "REPLICA EXCHANGE\n" );
+				kernelTimer.reset();
+				kernelTimer.start();
+				replicaExchange.reset( firstCopy );
+				int coldest = replicaExchange.run<MAGKernelsSU3>( batch, dNn, numBlocks, threadsPerBlock, options.getReRounds(), options.getReSweeps(), options.getSaMicroupdates(), options.getReproject(), options.getCheckPrecision(), options.getSeed() );
+
+				// only the coldest replica is finished
+				for( int k = 0; k < slots; k++ )
+				{
+					if( k != coldest ) batch.dismiss(k);
+				}
+				kernelTimer.stop();
+				cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
+				reTotalKernelTime += kernelTimer.getTime();
+
+				long sweeps = (long)options.getReRounds()*(long)options.getReSweeps();
+				reTotalStepnumber += sweeps*slots;
+				for( int k = 0; k < slots; k++ )
+				{
+					metrics.add( PhaseMetrics::SA, k, kernelTimer.getTime(), sweeps, saFlops/5*s.getLatticeSize()*sweeps, saBytes/5*s.getLatticeSize()*sweeps );
+				}
+			}
 
 			// SIMULATED ANNEALING
-			if (options.getDoSA()) {
+			if (options.getDoSA() && !replicaMode) {
 				if( options.getSaSteps() > 0 ) printf( "SIMULATED ANNEALING\n" );
 				float temperature = options.getSaMax();
 				float tempStep = (options.getSaMax()-options.getSaMin())/(float)options.getSaSteps();
@@ -229,6 +388,12 @@ int main(int argc, char* argv[])
 				kernelTimer.reset();
 				kernelTimer.start();
 				int i = 0;
+				if( resumeSA )
+				{
+					i = restartState.sweep;
+					temperature = restartState.temperature;
+				}
+				int firstSweep = i;
 				//for( int i = 0; i < options.getSaSteps(); i++ )
 				do
 				{
@@ -237,22 +402,27 @@ int main(int argc, char* argv[])
 					else
 						tempStep = (options.getSaMax()-options.getSaMin())/(float)options.getSaSteps();
 
-					for(int j = 0;j < 5;j++){
-						MAGKernelsSU3::saStep(numBlocks,threadsPerBlock,dU, dNn, 0, temperature, options.getSeed(), PhiloxWrapper::getNextCounter() );
-						MAGKernelsSU3::saStep(numBlocks,threadsPerBlock,dU, dNn, 1, temperature, options.getSeed(), PhiloxWrapper::getNextCounter() );
+					// the kernels of different copies are independent and may overlap on the device
+					for( int k = 0; k < slots; k++ )
+					{
+						for(int j = 0;j < 5;j++){
+							MAGKernelsSU3::saStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 0, temperature, batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
+							MAGKernelsSU3::saStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 1, temperature, batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
+
+							for( int mic = 0; mic < options.getSaMicroupdates(); mic++ )
+							{
+								MAGKernelsSU3::microStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 0 );
+								MAGKernelsSU3::microStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 1 );
+							}
+						}
 
-						for( int mic = 0; mic < options.getSaMicroupdates(); mic++ )
+						if( i % options.getReproject() == 0 )
 						{
-							MAGKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 0 );
-							MAGKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 1 );
+							CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, batch.getStream(k), batch.getField(k), HOST_CONSTANTS::getPtrToDeviceSize() );
+							metrics.add( PhaseMetrics::REPROJECT, k, 0, 1 );
 						}
 					}
 
-					if( i % options.getReproject() == 0 )
-					{
-						CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
-					}
-
 					/*if( i % options.getCheckPrecision() == 0 )
 					{
 						gaugeStats.generateGaugeQuality();
@@ -263,89 +433,191 @@ int main(int argc, char* argv[])
 					temperature -= tempStep;
 
 					i++;
+
+					if( checkpoint.isEnabled() && i % options.getCheckpointInterval() == 0 && temperature >= temperature_min )
+					{
+						CheckpointState state = { fileIndex, firstCopy, CHECKPOINT_SA, i, temperature, bestGff, 0, 0, functionalLines };
+						checkpoint.store( batch, state );
+					}
 				}while(temperature >= temperature_min);
-				cudaDeviceSynchronize();
+				batch.synchronize();
 				kernelTimer.stop();
 				cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
 				saTotalKernelTime += kernelTimer.getTime();
+
+				long sweeps = i-firstSweep;
+				saTotalStepnumber += sweeps*slots;
+				for( int k = 0; k < slots; k++ )
+				{
+					metrics.add( PhaseMetrics::SA, k, kernelTimer.getTime(), sweeps, saFlops*s.getLatticeSize()*sweeps, saBytes*s.getLatticeSize()*sweeps );
+				}
 			}
 
 
 			// STOCHASTIC RELAXATION
+			long* srSteps = new long[slots];
+			long* orSteps = new long[slots];
+			for( int k = 0; k < slots; k++ )
+			{
+				srSteps[k] = 0;
+				orSteps[k] = 0;
+			}
 			if( options.getOrMaxIter() > 0 ) printf( "STOCHASTIC RELAXATION\n" );
 			kernelTimer.reset();
 			kernelTimer.start();
-			for( int i = 0; i < options.getSrMaxIter(); i++ )
+			for( int i = 0; i < options.getSrMaxIter() && batch.anyActive(); i++ )
 			{
+				for( int k = 0; k < slots; k++ )
+				{
+					if( !batch.isActive(k) ) continue;
 
-				MAGKernelsSU3::srStep(numBlocks,threadsPerBlock,dU, dNn, 0, options.getSrParameter(), options.getSeed(), PhiloxWrapper::getNextCounter() );
-				MAGKernelsSU3::srStep(numBlocks,threadsPerBlock,dU, dNn, 1, options.getSrParameter(), options.getSeed(), PhiloxWrapper::getNextCounter() );
+					MAGKernelsSU3::srStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 0, options.getSrParameter(), batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
+					MAGKernelsSU3::srStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 1, options.getSrParameter(), batch.getSeed(k,options.getSeed()), PhiloxWrapper::getNextCounter() );
 
-				if( i % options.getReproject() == 0 )
-				{
-					CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+					if( i % options.getReproject() == 0 )
+					{
+						CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, batch.getStream(k), batch.getField(k), HOST_CONSTANTS::getPtrToDeviceSize() );
+						metrics.add( PhaseMetrics::REPROJECT, k, 0, 1 );
+					}
 				}
 
 				if( i % options.getCheckPrecision() == 0 )
 				{
-					gaugeStats.generateGaugeQuality();
-					printf( "%d\t\t%1.10f\t\t%e\n", i, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
+					generateGaugeQuality( batch, slots, metrics );
+					trace.addActive( batch, slots, ConvergenceTrace::SR, i );
+					for( int k = 0; k < slots; k++ )
+					{
+						if( !batch.isActive(k) ) continue;
+
+						if( slots > 1 ) printf( "[%d] ", batch.getCopy(k) );
+						printf( "%d\t\t%1.10f\t\t%e\n", i, batch.getStats(k).getCurrentGff(), batch.getStats(k).getCurrentA() );
 
-					if( gaugeStats.getCurrentA() < options.getPrecision() || gaugeStats.getCurrentA() < 1E-6 ) break;
+						if( batch.getStats(k).getCurrentA() < options.getPrecision() || batch.getStats(k).getCurrentA() < 1E-6 ) batch.deactivate(k);
+					}
+				}
+
+				for( int k = 0; k < slots; k++ )
+				{
+					if( batch.isActive(k) )
+					{
+						srTotalStepnumber++;
+						srSteps[k]++;
+					}
 				}
-				srTotalStepnumber++;
 			}
-			cudaDeviceSynchronize();
+			batch.synchronize();
 			kernelTimer.stop();
 			srTotalKernelTime += kernelTimer.getTime();
+			for( int k = 0; k < slots && options.getSrMaxIter() > 0; k++ )
+			{
+				metrics.add( PhaseMetrics::SR, k, kernelTimer.getTime(), srSteps[k], srCount.getFlops()*s.getLatticeSize()*srSteps[k], srCount.getBytes()*s.getLatticeSize()*srSteps[k] );
+			}
 
 
 			// OVERRELAXATION
 			if( options.getOrMaxIter() > 0 ) printf( "OVERRELAXATION\n" );
+			batch.activateAll();
 			kernelTimer.reset();
 			kernelTimer.start();
-			for( int i = 0; i < options.getOrMaxIter(); i++ )
+			for( int i = 0; i < options.getOrMaxIter() && batch.anyActive(); i++ )
 			{
+				for( int k = 0; k < slots; k++ )
+				{
+					if( !batch.isActive(k) ) continue;
 
-				MAGKernelsSU3::orStep(numBlocks,threadsPerBlock,dU, dNn, 0, options.getOrParameter() );
-				MAGKernelsSU3::orStep(numBlocks,threadsPerBlock,dU, dNn, 1, options.getOrParameter() );
+					MAGKernelsSU3::orStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 0, options.getOrParameter() );
+					MAGKernelsSU3::orStep(numBlocks,threadsPerBlock,batch.getStream(k),batch.getField(k), dNn, 1, options.getOrParameter() );
 
-				if( i % options.getReproject() == 0 )
-				{
-					CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+					if( i % options.getReproject() == 0 )
+					{
+						CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, batch.getStream(k), batch.getField(k), HOST_CONSTANTS::getPtrToDeviceSize() );
+						metrics.add( PhaseMetrics::REPROJECT, k, 0, 1 );
+					}
 				}
 
 				if( i % options.getCheckPrecision() == 0 )
 				{
-					gaugeStats.generateGaugeQuality();
-					printf( "%d\t\t%1.10f\t\t%e\n", i, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
+					generateGaugeQuality( batch, slots, metrics );
+					trace.addActive( batch, slots, ConvergenceTrace::OR, i );
+					for( int k = 0; k < slots; k++ )
+					{
+						if( !batch.isActive(k) ) continue;
 
-					if( gaugeStats.getCurrentA() < options.getPrecision() ) break;
+						if( slots > 1 ) printf( "[%d] ", batch.getCopy(k) );
+						printf( "%d\t\t%1.10f\t\t%e\n", i, batch.getStats(k).getCurrentGff(), batch.getStats(k).getCurrentA() );
+
+						if( batch.getStats(k).getCurrentA() < options.getPrecision() ) batch.deactivate(k);
+						else if( options.isEarlyStop() )
+						{
+							earlyStop.addSample( k, batch.getStats(k).getCurrentGff() );
+							if( earlyStop.isHopeless( k, bestGff ) )
+							{
+								printf( "EARLY STOP: predicted gff %1.10f is below best gff %1.10f\n", earlyStop.getPrediction(k), bestGff );
+								earlyStop.countEarlyStop();
+								batch.deactivate(k);
+							}
+						}
+					}
 				}
 
-				orTotalStepnumber++;
+				for( int k = 0; k < slots; k++ )
+				{
+					if( batch.isActive(k) )
+					{
+						orTotalStepnumber++;
+						orSteps[k]++;
+					}
+				}
 			}
-			cudaDeviceSynchronize();
+			batch.synchronize();
 			kernelTimer.stop();
 			orTotalKernelTime += kernelTimer.getTime();
+			for( int k = 0; k < slots && options.getOrMaxIter() > 0; k++ )
+			{
+				metrics.add( PhaseMetrics::OR, k, kernelTimer.getTime(), orSteps[k], orCount.getFlops()*s.getLatticeSize()*orSteps[k], orCount.getBytes()*s.getLatticeSize()*orSteps[k] );
+			}
+			delete[] srSteps;
+			delete[] orSteps;
 
 			// reconstruct third line
-			CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+			kernelTimer.reset();
+			kernelTimer.start();
+			for( int k = 0; k < slots; k++ )
+			{
+				CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, batch.getStream(k), batch.getField(k), HOST_CONSTANTS::getPtrToDeviceSize() );
+			}
+			if( metrics.isEnabled() ) batch.synchronize();
+			kernelTimer.stop();
 
-			gaugeStats.generateGaugeQuality();
-                        output << copy<<","<<gaugeStats.getCurrentGff()<<endl;
+			batch.activateAll();
+			generateGaugeQuality( batch, slots, metrics );
+			for( int k = 0; k < slots; k++ )
+			{
+				metrics.add( PhaseMetrics::REPROJECT, k, kernelTimer.getTime(), 1 );
+				metrics.setResult( k, batch.getStats(k).getCurrentGff(), batch.getStats(k).getCurrentA() );
+				if( batch.isCandidate(k) )
+				{
+					output << batch.getCopy(k)<<","<<batch.getStats(k).getCurrentGff()<<endl;
+					functionalLines++;
+				}
+			}
 
 			// check for best copy
-			if( gaugeStats.getCurrentGff() > bestGff )
+			int bestSlot = batch.getBestSlot( bestGff );
+			if( bestSlot >= 0 )
 			{
-				cout << "FOUND BETTER COPY" << endl;
-				bestGff = gaugeStats.getCurrentGff();
+				cout << "FOUND BETTER COPY";
+				if( slots > 1 ) cout << " (copy " << batch.getCopy(bestSlot) << ")";
+				cout << endl;
+				bestGff = batch.getStats(bestSlot).getCurrentGff();
+				int copy = batch.getCopy(bestSlot);
 
-				// copy back
-				cudaMemcpy( U, dU, arraySize*sizeof(Real), cudaMemcpyDeviceToHost );
+				// keep the copy on the device (swaps the buffers of the slot and the best copy)
+				batch.promote( bestSlot );
 
 				if(copy < options.getGaugeCopies() - 1 && options.getSaveEach()){
 						std::cout<<"ok"<<std::endl;
+				batch.store( U );
 				stringstream filename(stringstream::out);
 				filename << fi.getOutputFilename() << "_" << copy + 1;
 				string copy_path = filename.str();
@@ -377,11 +649,16 @@ int main(int argc, char* argv[])
 				cout << "NO BETTER COPY" << endl;
 			}
 		}
+		trace.flush();
 
 
 		//saving file
 		if( !options.isSetHot() && !options.getSaveEach())
 		{
+			Chronotimer saveTimer;
+			saveTimer.reset();
+			saveTimer.start();
+			batch.store( U );
 			cout << "saving " << fi.getOutputFilename() << " as " << options.getFType() << endl;
 
 			switch( options.getFType() )
@@ -406,27 +683,33 @@ int main(int argc, char* argv[])
 				cout << "Filetype not set to a known value. Exiting";
 				exit(1);
 			}
+			saveTimer.stop();
+			metrics.addConfig( PhaseMetrics::SAVE, saveTimer.getTime(), 0, 0, (double)arraySize*sizeof(Real) );
 		}
 
 		output.close();
 	}
 
+	metrics.flush();
+
+	// a completed run needs no checkpoint
+	if( complete ) checkpoint.remove();
+
 	allTimer.stop();
 	cout << "total time: " << allTimer.getTime() << " s" << endl;
+	if( options.isEarlyStop() ) cout << "early stopped copies: " << earlyStop.getEarlyStops() << " of " << (long)options.getGaugeCopies()*(long)options.getNconf() << endl;
 
-	long hbFlops = 2252+86-8;
-	long microFlops = 2252+14-8;
-	cout << "Simulated Annealing (HB+Micro): " << (double)((long)(hbFlops+microFlops*options.getSaMicroupdates())*(long)s.getLatticeSize()*(long)options.getSaSteps()*(long)options.getGaugeCopies())/saTotalKernelTime/1.0e9 << " GFlops at "
-					<< (double)((long)192*(long)s.getLatticeSize()*options.getSaSteps()*(options.getSaMicroupdates()+1)*(long)sizeof(Real))/saTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	if( saTotalStepnumber > 0 ) cout << "Simulated Annealing (HB+Micro): " << saFlops*(double)s.getLatticeSize()*(double)saTotalStepnumber/saTotalKernelTime/1.0e9 << " GFlops at "
+					<< saBytes*(double)s.getLatticeSize()*(double)saTotalStepnumber/saTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	if( reTotalStepnumber > 0 ) cout << "Replica Exchange (HB+Micro): " << saFlops/5*(double)s.getLatticeSize()*(double)reTotalStepnumber/reTotalKernelTime/1.0e9 << " GFlops at "
+					<< saBytes/5*(double)s.getLatticeSize()*(double)reTotalStepnumber/reTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
 
-	long srFlops = 2252+32-8;
-	cout << "Stochastic Relaxation: " << (double)((long)srFlops*(long)s.getLatticeSize()*(long)srTotalStepnumber)/srTotalKernelTime/1.0e9 << " GFlops at "
-				<< (double)((long)192*(long)s.getLatticeSize()*(long)(srTotalStepnumber)*(long)sizeof(Real))/srTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	cout << "Stochastic Relaxation: " << srCount.getFlops()*(double)s.getLatticeSize()*(double)srTotalStepnumber/srTotalKernelTime/1.0e9 << " GFlops at "
+				<< srCount.getBytes()*(double)s.getLatticeSize()*(double)srTotalStepnumber/srTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
 
 
-	long orFlops = 2252+22-8;
-	cout << "Overrelaxation: " << (double)((long)orFlops*(long)s.getLatticeSize()*(long)orTotalStepnumber)/orTotalKernelTime/1.0e9 << " GFlops at "
-				<< (double)((long)192*(long)s.getLatticeSize()*(long)(orTotalStepnumber)*(long)sizeof(Real))/orTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	cout << "Overrelaxation: " << orCount.getFlops()*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << " GFlops at "
+				<< orCount.getBytes()*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
 
 	//output.close();
 
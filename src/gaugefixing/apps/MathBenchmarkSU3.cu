@@ -0,0 +1,484 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Host micro benchmark of the SU3/Quaternion operations in lattice/ that are used in the inner loops of the kernels:
+ *  - SU3::projectSU3(), SU3::reconstructThirdLine()
+ *  - SU3::getSubgroupQuaternion(), SU3::leftSubgroupMult(), SU3::rightSubgroupMult()
+ *  - SU3::operator* (U = W*U with a fixed W, the product is written back)
+ *  - Quaternion::projectSU2()
+ * on SU3<Matrix> (an array of matrices) and on SU3<Link<GpuPattern>> (a field of 4*Nt*Nx*Ny*Nz links in the
+ * device layout, accessed as in the kernels), in single and double precision.
+ *
+ * Each operation is applied to all links of the field and repeated until at least 0.2 s are spent, then the time
+ * per operation and the GFlops (from the flop count of the implementation) are printed. The field follows the
+ * lattice size, i.e. small lattices measure in-cache throughput.
+ *
+ * The results are written to --benchmarkfile (CSV: op,storage,precision,ns,gflops). With --benchmarkreference
+ * (a file of an earlier run) the time ratio to the reference is printed and slowdowns of more than 10% are marked.
+ *
+ * make APP=MathBenchmarkSU3 X=<x> T=<t>
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <map>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+#ifndef OSX
+#include "malloc.h"
+#endif
+#include "../GlobalConstants.h"
+#include "../../lattice/access_pattern/GpuPattern.hxx"
+#include "../../lattice/SiteIndex.hxx"
+#include "../../lattice/Matrix.hxx"
+#include "../../lattice/Complex.hxx"
+#include "../../lattice/Quaternion.hxx"
+#include "../../lattice/SU3.hxx"
+#include "../../lattice/Link.hxx"
+#include "../../lattice/rng/HostPhiloxWrapper.hxx"
+#include "../../util/timer/ScopedTimer.hxx"
+#include "program_options/ProgramOptions.hxx"
+
+using namespace std;
+
+const lat_dim_t Ndim = 4;
+const short Nc = 3;
+
+typedef SiteIndex<Ndim,FULL_SPLIT> Site;
+
+// minimal time per measurement in seconds
+const double minTime = 0.2;
+
+namespace MBSU3
+{
+
+/**
+ * Random SU3 matrix (random first two rows, projected).
+ */
+template<class T> SU3<Matrix<Complex<T>,3>,T> randomSU3( HostPhiloxWrapper<1>& rng )
+{
+	SU3<Matrix<Complex<T>,3>,T> u;
+	for( int i = 0; i < 2; i++ )
+	{
+		for( int j = 0; j < 3; j++ )
+		{
+			double r[2];
+			rng.rand( &r[0] );
+			rng.rand( &r[1] );
+			u.set( i, j, Complex<T>( 2.*r[0]-1., 2.*r[1]-1. ) );
+		}
+	}
+	u.projectSU3();
+	return u;
+}
+
+template<class T> Quaternion<T> randomSU2( HostPhiloxWrapper<1>& rng )
+{
+	Quaternion<T> q;
+	for( int i = 0; i < 4; i++ )
+	{
+		double r;
+		rng.rand( &r );
+		q[i] = 2.*r-1.;
+	}
+	T norm = 1./sqrt( q.reDet() );
+	q *= norm;
+	return q;
+}
+
+/**
+ * SU3<Matrix>: the element is a reference into the array.
+ */
+template<class T> class MatrixStorage
+{
+public:
+	typedef SU3<Matrix<Complex<T>,3>,T>& Element;
+
+	MatrixStorage( int n, HostPhiloxWrapper<1>& rng ) : n(n)
+	{
+		u = new SU3<Matrix<Complex<T>,3>,T>[n];
+		for( int i = 0; i < n; i++ ) u[i] = randomSU3<T>( rng );
+	}
+	~MatrixStorage()
+	{
+		delete[] u;
+	}
+	inline Element element( int i )
+	{
+		return u[i];
+	}
+	static const char* getName()
+	{
+		return "Matrix";
+	}
+private:
+	int n;
+	SU3<Matrix<Complex<T>,3>,T>* u;
+};
+
+/**
+ * SU3<Link<GpuPattern>>: the element reads and writes the field (link i is direction i/latticeSize of site
+ * i%latticeSize, as in the kernels consecutive threads access consecutive sites).
+ */
+template<class T> class LinkStorage
+{
+public:
+	typedef Link<GpuPattern<Site,Ndim,Nc>,Site,Ndim,Nc,T> TLink;
+	typedef SU3<TLink,T> Element;
+
+	LinkStorage( int n, HostPhiloxWrapper<1>& rng ) : n(n), s(HOST_CONSTANTS::SIZE)
+	{
+		U = new T[n*Nc*Nc*2];
+		for( int i = 0; i < n; i++ )
+		{
+			Element e = element( i );
+			e = randomSU3<T>( rng );
+		}
+	}
+	~LinkStorage()
+	{
+		delete[] U;
+	}
+	inline Element element( int i )
+	{
+		s.setLatticeIndex( i % s.getLatticeSize() );
+		return Element( TLink( U, s, i / s.getLatticeSize() ) );
+	}
+	static const char* getName()
+	{
+		return "Link<GpuPattern>";
+	}
+private:
+	int n;
+	Site s;
+	T* U;
+};
+
+/**
+ * The operations, apply() is called for each link i of the field. The flop counts follow the implementation
+ * (complex multiplication 6, addition 2, abs_squared 3, division by a real 2, sqrt and rsqrt 1).
+ * Operations that do not write to the field return their results in getSink() (to keep the compiler from
+ * removing the computation).
+ */
+class Operation
+{
+public:
+	double getSink()
+	{
+		return 0;
+	}
+};
+
+template<class T> class ProjectSU3 : public Operation
+{
+public:
+	static const long flops = 147;
+	static const char* getName() { return "projectSU3"; }
+	template<class Element> inline void apply( Element u, int i )
+	{
+		u.projectSU3();
+	}
+};
+
+template<class T> class ReconstructThirdLine : public Operation
+{
+public:
+	static const long flops = 61;
+	static const char* getName() { return "reconstructThirdLine"; }
+	template<class Element> inline void apply( Element u, int i )
+	{
+		u.reconstructThirdLine();
+	}
+};
+
+template<class T> class GetSubgroupQuaternion : public Operation
+{
+public:
+	static const long flops = 4;
+	static const char* getName() { return "getSubgroupQuaternion"; }
+	GetSubgroupQuaternion() : sum(0)
+	{
+	}
+	template<class Element> inline void apply( Element u, int i )
+	{
+		Quaternion<T> q = u.getSubgroupQuaternion( (i%3==2), 1+(i%3!=0) );
+		sum += q[0]+q[1]+q[2]+q[3];
+	}
+	double getSink()
+	{
+		return sum;
+	}
+	T sum;
+};
+
+template<class T> class LeftSubgroupMult : public Operation
+{
+public:
+	static const long flops = 84;
+	static const char* getName() { return "leftSubgroupMult"; }
+	LeftSubgroupMult( Quaternion<T> q ) : q(q)
+	{
+	}
+	template<class Element> inline void apply( Element u, int i )
+	{
+		u.leftSubgroupMult( (i%3==2), 1+(i%3!=0), &q );
+	}
+	Quaternion<T> q;
+};
+
+template<class T> class RightSubgroupMult : public Operation
+{
+public:
+	static const long flops = 84;
+	static const char* getName() { return "rightSubgroupMult"; }
+	RightSubgroupMult( Quaternion<T> q ) : q(q)
+	{
+	}
+	template<class Element> inline void apply( Element u, int i )
+	{
+		u.rightSubgroupMult( (i%3==2), 1+(i%3!=0), &q );
+	}
+	Quaternion<T> q;
+};
+
+template<class T> class Multiply : public Operation
+{
+public:
+	static const long flops = 216;
+	static const char* getName() { return "operator*"; }
+	Multiply( SU3<Matrix<Complex<T>,3>,T> w ) : w(w)
+	{
+	}
+	template<class Element> inline void apply( Element u, int i )
+	{
+		u = w*u;
+	}
+	SU3<Matrix<Complex<T>,3>,T> w;
+};
+
+/**
+ * Quaternion::projectSU2() on an array of quaternions (independent of the link storage).
+ */
+template<class T> class QuaternionStorage
+{
+public:
+	typedef Quaternion<T>& Element;
+
+	QuaternionStorage( int n, HostPhiloxWrapper<1>& rng ) : n(n)
+	{
+		q = new Quaternion<T>[n];
+		for( int i = 0; i < n; i++ )
+		{
+			q[i] = randomSU2<T>( rng );
+			q[i] *= 1.5; // projectSU2() rescales
+		}
+	}
+	~QuaternionStorage()
+	{
+		delete[] q;
+	}
+	inline Element element( int i )
+	{
+		return q[i];
+	}
+	static const char* getName()
+	{
+		return "Quaternion";
+	}
+private:
+	int n;
+	Quaternion<T>* q;
+};
+
+template<class T> class ProjectSU2 : public Operation
+{
+public:
+	static const long flops = 12;
+	static const char* getName() { return "projectSU2"; }
+	template<class Element> inline void apply( Element q, int i )
+	{
+		q.projectSU2();
+	}
+};
+
+}
+
+/**
+ * Collects the results and compares them to the reference.
+ */
+class BenchmarkResults
+{
+public:
+	BenchmarkResults( string referenceFile )
+	{
+		if( referenceFile.size() == 0 ) return;
+		ifstream in( referenceFile.c_str() );
+		if( !in.good() )
+		{
+			cout << "Can not open reference " << referenceFile << endl;
+			return;
+		}
+		string line;
+		getline( in, line ); // header
+		while( getline( in, line ) )
+		{
+			// op,storage,precision,ns,gflops
+			size_t third = line.find( ',', line.find( ',', line.find( ',' )+1 )+1 );
+			if( third == string::npos ) continue;
+			reference[line.substr( 0, third )] = atof( line.substr( third+1 ).c_str() );
+		}
+	}
+
+	void add( const char* op, const char* storage, const char* precision, double ns, long flops )
+	{
+		ostringstream key;
+		key << op << "," << storage << "," << precision;
+		ostringstream line;
+		line << key.str() << "," << ns << "," << (double)flops/ns;
+		lines.push_back( line.str() );
+
+		cout << left << setw(24) << op << setw(20) << storage << setw(8) << precision << right << setw(12) << ns << setw(12) << (double)flops/ns;
+		if( reference.count( key.str() ) > 0 )
+		{
+			double ratio = ns/reference[key.str()];
+			cout << setw(12) << ratio;
+			if( ratio > 1.1 ) cout << "  REGRESSION";
+		}
+		cout << endl;
+	}
+
+	void write( string filename )
+	{
+		if( filename.size() == 0 ) return;
+		ofstream out( filename.c_str() );
+		out << "op,storage,precision,ns,gflops" << endl;
+		for( unsigned int i = 0; i < lines.size(); i++ ) out << lines[i] << endl;
+	}
+
+private:
+	map<string,double> reference;
+	vector<string> lines;
+};
+
+volatile double sink;
+
+/**
+ * Returns the time per operation in ns: all n elements are processed, the sweep is repeated (doubling the
+ * repetitions) until minTime is reached.
+ */
+template<class Storage, class Op> double measure( Storage& storage, Op& op, int n )
+{
+	long reps = 1;
+	while( true )
+	{
+		ScopedTimer timer( "benchmark" );
+		for( long r = 0; r < reps; r++ )
+		{
+			for( int i = 0; i < n; i++ )
+			{
+				op.template apply<typename Storage::Element>( storage.element( i ), i );
+			}
+		}
+		double time = timer.stop();
+		sink = op.getSink();
+		if( time >= minTime || reps >= (1l<<30) ) return time/(double)reps/(double)n*1e9;
+		reps *= 2;
+	}
+}
+
+template<class Storage, class Op> void run( Storage& storage, Op op, int n, const char* precision, BenchmarkResults& results )
+{
+	double ns = measure( storage, op, n );
+	results.add( Op::getName(), Storage::getName(), precision, ns, Op::flops );
+}
+
+template<class T, template<class> class Storage> void runAll( int n, int seed, const char* precision, BenchmarkResults& results )
+{
+	HostPhiloxWrapper<1> rng( 0, seed, 0 );
+	Storage<T> storage( n, rng );
+	Quaternion<T> q = MBSU3::randomSU2<T>( rng );
+	SU3<Matrix<Complex<T>,3>,T> w = MBSU3::randomSU3<T>( rng );
+
+	run( storage, MBSU3::ProjectSU3<T>(), n, precision, results );
+	run( storage, MBSU3::ReconstructThirdLine<T>(), n, precision, results );
+	run( storage, MBSU3::GetSubgroupQuaternion<T>(), n, precision, results );
+	run( storage, MBSU3::LeftSubgroupMult<T>( q ), n, precision, results );
+	run( storage, MBSU3::RightSubgroupMult<T>( q ), n, precision, results );
+	run( storage, MBSU3::Multiply<T>( w ), n, precision, results );
+
+	// unitarity after all operations
+	double deviation = 0;
+	for( int i = 0; i < n; i++ )
+	{
+		SU3<Matrix<Complex<T>,3>,T> u;
+		u = storage.element( i );
+		SU3<Matrix<Complex<T>,3>,T> uDagger = u;
+		uDagger.hermitian();
+		SU3<Matrix<Complex<T>,3>,T> one = u*uDagger;
+		for( int a = 0; a < 3; a++ )
+		{
+			for( int b = 0; b < 3; b++ )
+			{
+				Complex<T> c = one.get( a, b );
+				double d = sqrt( (c.x-(a==b))*(c.x-(a==b))+c.y*c.y );
+				if( d > deviation ) deviation = d;
+			}
+		}
+	}
+	cout << "  (max. deviation from unitarity " << deviation << ")" << endl;
+}
+
+template<class T> void runQuaternion( int n, int seed, const char* precision, BenchmarkResults& results )
+{
+	HostPhiloxWrapper<1> rng( 0, seed, 0 );
+	MBSU3::QuaternionStorage<T> storage( n, rng );
+	run( storage, MBSU3::ProjectSU2<T>(), n, precision, results );
+}
+
+int main(int argc, char* argv[])
+{
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	// one element per link
+	const int n = Ndim*Nt*Nx*Ny*Nz;
+	BenchmarkResults results( options.getBenchmarkReference() );
+
+	cout << n << " links, min. " << minTime << " s per measurement" << endl;
+	cout << left << setw(24) << "op" << setw(20) << "storage" << setw(8) << "prec." << right << setw(12) << "ns/op" << setw(12) << "GFlops";
+	if( options.getBenchmarkReference().size() > 0 ) cout << setw(12) << "ratio";
+	cout << endl;
+
+	runAll<float,MBSU3::MatrixStorage>( n, options.getSeed(), "SP", results );
+	runAll<float,MBSU3::LinkStorage>( n, options.getSeed(), "SP", results );
+	runQuaternion<float>( n, options.getSeed(), "SP", results );
+	runAll<double,MBSU3::MatrixStorage>( n, options.getSeed(), "DP", results );
+	runAll<double,MBSU3::LinkStorage>( n, options.getSeed(), "DP", results );
+	runQuaternion<double>( n, options.getSeed(), "DP", results );
+
+	results.write( options.getBenchmarkFile() );
+}
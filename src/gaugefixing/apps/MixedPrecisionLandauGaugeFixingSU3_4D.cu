@@ -0,0 +1,406 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Landau gauge fixing with iterative refinement in precision.
+ *
+ * The field is kept on the device twice, in single and in double precision. Random gauge transformation,
+ * simulated annealing and the bulk of the overrelaxation run on the single precision field until dA drops
+ * below --spprecision (single precision stalls around 1e-7..1e-8). Then the field is promoted to double
+ * precision (CommonKernelsSU3::convertAndProject, the promotion and the reunitarization are one pass) and
+ * overrelaxation finishes the last decades down to --precision in double precision.
+ *
+ * --realtype selects the precision at runtime: mixed (as described), sp (all stages in single precision) or dp
+ * (all stages in double precision). All kernels are instantiated for float and double in this binary.
+ * The float instantiations use the SP launch bounds (LaunchBounds<float>) and calculate their updates in float
+ * (UpdateReal), DPUPDATES has no effect in this binary.
+ *
+ * Compile with PREC=DP (the host field and the files are double precision).
+ */
+
+#include <iostream>
+#include <math.h>
+#include <sstream>
+#ifndef OSX
+#include "malloc.h"
+#endif
+#include "../GlobalConstants.h"
+#include "../GaugeFixingStats.hxx"
+#include "../../lattice/access_pattern/StandardPattern.hxx"
+#include "../../lattice/access_pattern/GpuPattern.hxx"
+#include "../../lattice/SiteCoord.hxx"
+#include "../../lattice/SiteIndex.hxx"
+#include "../../util/timer/Chronotimer.h"
+#include "../../lattice/filetypes/FileHeaderOnly.hxx"
+#include "../../lattice/filetypes/FilePlain.hxx"
+#include "../../lattice/filetypes/FileVogt.hxx"
+#include "../../lattice/filetypes/filetype_typedefs.h"
+#include "../../lattice/LinkFile.hxx"
+#include "../LandauKernelsSU3.hxx"
+#include "../CommonKernelsSU3.hxx"
+#include "../LandauKernelCounter.hxx"
+#include "program_options/ProgramOptions.hxx"
+#include "program_options/FileIterator.hxx"
+
+#ifndef DOUBLEPRECISION
+#error "MixedPrecisionLandauGaugeFixingSU3_4D needs PREC=DP"
+#endif
+
+using namespace std;
+
+const lat_dim_t Ndim = 4;
+const short Nc = 3;
+
+const int arraySize = Nt*Nx*Ny*Nz*Ndim*Nc*Nc*2;
+
+typedef StandardPattern<SiteCoord<Ndim,NO_SPLIT>,Ndim,Nc> Standard;
+typedef GpuPattern< SiteCoord<Ndim,FULL_SPLIT>,Ndim,Nc> Gpu;
+
+void readILDG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
+void writeILDG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const char *output_name, const short SIZE[4], Real *U, int steps);
+
+bool readQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
+bool writeQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *output_name, const short SIZE[4], Real *U);
+
+/**
+ * Random gauge transformation and simulated annealing in the precision of the field dU.
+ */
+template<class T_Real> void saStage( T_Real* dU, GaugeFixingStats<Ndim,Nc,LandauKernelsSU3,AVERAGE,T_Real>& stats, lat_index_t* dNn, int latticeSize, const ProgramOptions& options, double& kernelTime )
+{
+	int threadsPerBlock = NSB*8; // NSB sites are updated within a block (8 threads are needed per site)
+	int numBlocks = latticeSize/2/NSB; // // half of the lattice sites (a parity) are updated in a kernel call
+	const char* prec = ( sizeof(T_Real) == sizeof(double) )?("DP"):("SP");
+
+	if( options.isRandomTrafo() )
+	{
+		LandauKernelsSU3::randomTrafo(numBlocks,threadsPerBlock,dU, dNn, 0, options.getSeed(), PhiloxWrapper::getNextCounter() );
+		LandauKernelsSU3::randomTrafo(numBlocks,threadsPerBlock,dU, dNn, 1, options.getSeed(), PhiloxWrapper::getNextCounter() );
+	}
+
+	// calculate and print the gauge quality
+	printf( "i:\t\tgff:\t\tdA:\n");
+	stats.generateGaugeQuality();
+	printf( "   \t\t%1.10f\t\t%e\n", stats.getCurrentGff(), stats.getCurrentA() );
+
+	if( options.getSaSteps() > 0 ) printf( "SIMULATED ANNEALING (%s)\n", prec );
+	float temperature = options.getSaMax();
+	float tempStep = (options.getSaMax()-options.getSaMin())/(float)options.getSaSteps();
+
+	Chronotimer kernelTimer;
+	kernelTimer.reset();
+	kernelTimer.start();
+	for( int i = 0; i < options.getSaSteps(); i++ )
+	{
+		LandauKernelsSU3::saStep(numBlocks,threadsPerBlock,dU, dNn, 0, temperature, options.getSeed(), PhiloxWrapper::getNextCounter() );
+		LandauKernelsSU3::saStep(numBlocks,threadsPerBlock,dU, dNn, 1, temperature, options.getSeed(), PhiloxWrapper::getNextCounter() );
+
+		for( int mic = 0; mic < options.getSaMicroupdates(); mic++ )
+		{
+			LandauKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 0 );
+			LandauKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 1 );
+		}
+
+		if( i % options.getReproject() == 0 )
+		{
+			CommonKernelsSU3::projectSU3( latticeSize/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+		}
+
+		if( i % options.getCheckPrecision() == 0 )
+		{
+			stats.generateGaugeQuality();
+			printf( "%d\t\t%1.10f\t\t%e\n", i, stats.getCurrentGff(), stats.getCurrentA() );
+		}
+		temperature -= tempStep;
+	}
+	cudaDeviceSynchronize();
+	kernelTimer.stop();
+	if( options.getSaSteps() > 0 ) cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
+	kernelTime += kernelTimer.getTime();
+}
+
+/**
+ * Overrelaxation in the precision of the field dU until dA < precision or --ormaxiter iterations (counted
+ * from firstIter, the iterations of the previous stage) are reached. Returns the number of iterations.
+ */
+template<class T_Real> int orStage( T_Real* dU, GaugeFixingStats<Ndim,Nc,LandauKernelsSU3,AVERAGE,T_Real>& stats, lat_index_t* dNn, int latticeSize, int firstIter, float precision, const ProgramOptions& options, double& kernelTime )
+{
+	int threadsPerBlock = NSB*8;
+	int numBlocks = latticeSize/2/NSB;
+
+	if( firstIter >= options.getOrMaxIter() ) return 0;
+	printf( "OVERRELAXATION (%s)\n", ( sizeof(T_Real) == sizeof(double) )?("DP"):("SP") );
+
+	Chronotimer kernelTimer;
+	kernelTimer.reset();
+	kernelTimer.start();
+	int j;
+	for( j = 0; firstIter+j < options.getOrMaxIter(); j++ )
+	{
+		if( j % options.getCheckPrecision() == 0 )
+		{
+			stats.generateGaugeQuality();
+			printf( "%d\t\t%1.10f\t\t%e\n", firstIter+j, stats.getCurrentGff(), stats.getCurrentA() );
+			if( stats.getCurrentA() < precision ) break;
+		}
+
+		LandauKernelsSU3::orStep(numBlocks,threadsPerBlock,dU, dNn, 0, options.getOrParameter() );
+		LandauKernelsSU3::orStep(numBlocks,threadsPerBlock,dU, dNn, 1, options.getOrParameter() );
+
+		if( j % options.getReproject() == 0 )
+		{
+			CommonKernelsSU3::projectSU3( latticeSize/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+		}
+	}
+	cudaDeviceSynchronize();
+	kernelTimer.stop();
+	cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
+	kernelTime += kernelTimer.getTime();
+	return j;
+}
+
+int main(int argc, char* argv[])
+{
+	Chronotimer allTimer;
+	allTimer.reset();
+	allTimer.start();
+
+	LandauKernelsSU3::initCacheConfig<float>();
+	LandauKernelsSU3::initCacheConfig<double>();
+	CommonKernelsSU3::initCacheConfig<float>();
+	CommonKernelsSU3::initCacheConfig<double>();
+
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	if( options.getRealType() != "sp" && options.getRealType() != "dp" && options.getRealType() != "mixed" )
+	{
+		cout << "Unknown --realtype " << options.getRealType() << " (sp, dp or mixed). Exiting..." << endl;
+		return 1;
+	}
+	cout << "precision: " << options.getRealType() << endl;
+
+	// Choose device and print device infos
+	cudaDeviceProp deviceProp;
+	int selectedDeviceNumber;
+	if( options.getDeviceNumber() >= 0 )
+	{
+		cudaSetDevice( options.getDeviceNumber() );
+		selectedDeviceNumber = options.getDeviceNumber();
+	}
+	else
+	{
+		cudaGetDevice( &selectedDeviceNumber );
+	}
+	cudaGetDeviceProperties(&deviceProp, selectedDeviceNumber );
+
+	printf("\nDevice %d: \"%s\"\n", selectedDeviceNumber, deviceProp.name);
+	printf("CUDA Capability Major/Minor version number:    %d.%d\n\n", deviceProp.major, deviceProp.minor);
+
+	// SiteCoord is faster than SiteIndex when loading files
+	SiteCoord<4,FULL_SPLIT> s(HOST_CONSTANTS::SIZE);
+
+
+	// allocate Memory
+	// host memory for configuration
+	Real* U = (Real*)malloc( arraySize*sizeof(Real) );
+
+	// device memory: the pristine configuration and the best copy (double), the working fields in both precisions
+	double* dUPristine;
+	double* dUBest;
+	double* dUDp;
+	float* dUSp;
+	cudaMalloc( &dUPristine, arraySize*sizeof(double) );
+	cudaMalloc( &dUBest, arraySize*sizeof(double) );
+	cudaMalloc( &dUDp, arraySize*sizeof(double) );
+	cudaMalloc( &dUSp, arraySize*sizeof(float) );
+
+	// host memory for the neighbour table
+	lat_index_t* nn = (lat_index_t*)malloc( s.getLatticeSize()*(2*(Ndim))*sizeof(lat_index_t) );
+
+	// device memory for the neighbour table
+	lat_index_t *dNn;
+	cudaMalloc( &dNn, s.getLatticeSize()*(2*(Ndim))*sizeof( lat_index_t ) );
+
+	// initialise the neighbour table for SiteIndex (this is used in device code)
+	SiteIndex<4,FULL_SPLIT> sTemp( HOST_CONSTANTS::SIZE );
+	sTemp.calculateNeighbourTable( nn );
+
+	// copy neighbour table to device
+	cudaMemcpy( dNn, nn, s.getLatticeSize()*(2*(Ndim))*sizeof( lat_index_t ), cudaMemcpyHostToDevice );
+
+	LinkFile<FileHeaderOnly, Standard, Gpu, SiteCoord<4,FULL_SPLIT> > lfHeaderOnly( options.getReinterpret() );
+	LinkFile<FileVogt, Standard, Gpu, SiteCoord<4,FULL_SPLIT> > lfVogt( options.getReinterpret() );
+	LinkFile<FilePlain, Standard, Gpu, SiteCoord<4,FULL_SPLIT> > lfPlain( options.getReinterpret() );
+
+
+	// gauge quality of the single and the double precision field
+	GaugeFixingStats<Ndim,Nc,LandauKernelsSU3,AVERAGE,float> statsSp( dUSp, HOST_CONSTANTS::SIZE );
+	GaugeFixingStats<Ndim,Nc,LandauKernelsSU3,AVERAGE,double> statsDp( dUDp, HOST_CONSTANTS::SIZE );
+
+	double saTotalKernelTime = 0;
+	double orSpTotalKernelTime = 0;
+	long orSpTotalStepnumber = 0;
+	double orDpTotalKernelTime = 0;
+	long orDpTotalStepnumber = 0;
+
+	FileIterator fi( options );
+	for( fi.reset(); fi.hasNext(); fi.next() )
+	{
+		bool loadOk;
+
+		if( !options.isSetHot() ) // load a file
+		{
+			switch( options.getFType() )
+			{
+			case VOGT:
+				loadOk = lfVogt.load( s, fi.getFilename(), U );
+				break;
+			case PLAIN:
+				loadOk = lfPlain.load( s, fi.getFilename(), U );
+				break;
+			case HEADERONLY:
+				loadOk = lfHeaderOnly.load( s, fi.getFilename(), U );
+				break;
+			case ILDG:
+				loadOk = true;
+				readILDG(s, fi.getFilename().c_str(), HOST_CONSTANTS::SIZE, U);
+				break;
+			case QCDSTAG:
+				loadOk = readQCDSTAG(s, fi.getFilename().c_str(), HOST_CONSTANTS::SIZE, U);
+				break;
+			default:
+				cout << "Filetype not set to a known value. Exiting...";
+				exit(1);
+			}
+
+			if( !loadOk )
+			{
+				cout << "Error while loading. Trying next file." << endl;
+				break;
+			}
+			else
+			{
+				cout << "File loaded." << endl;
+			}
+
+			cudaMemcpy( dUPristine, U, arraySize*sizeof(double), cudaMemcpyHostToDevice );
+		}
+		else // or initialize with a hot configuration (ignore file options)
+		{
+			CommonKernelsSU3::setHot( s.getLatticeSize()/32,32, dUPristine, HOST_CONSTANTS::getPtrToDeviceSize(), options.getSeed(), PhiloxWrapper::getNextCounter() );
+		}
+
+		double bestGff = 0.0;
+		for( int copy = 0; copy < options.getGaugeCopies(); copy++ )
+		{
+			int spIter = 0;
+			if( options.getRealType() == "dp" )
+			{
+				// each gaugecopy starts from the pristine configuration
+				CommonKernelsSU3::convertAndProject( s.getLatticeSize()/32,32, dUPristine, dUDp, HOST_CONSTANTS::getPtrToDeviceSize() );
+				saStage( dUDp, statsDp, dNn, s.getLatticeSize(), options, saTotalKernelTime );
+			}
+			else
+			{
+				// each gaugecopy starts from the pristine configuration, demoted to single precision
+				CommonKernelsSU3::convertAndProject( s.getLatticeSize()/32,32, dUPristine, dUSp, HOST_CONSTANTS::getPtrToDeviceSize() );
+				saStage( dUSp, statsSp, dNn, s.getLatticeSize(), options, saTotalKernelTime );
+
+				float spPrecision = ( options.getRealType() == "sp" )?( options.getPrecision() ):( options.getSpPrecision() );
+				spIter = orStage( dUSp, statsSp, dNn, s.getLatticeSize(), 0, spPrecision, options, orSpTotalKernelTime );
+				orSpTotalStepnumber += spIter;
+
+				// promote to double precision and reunitarize in the same pass
+				CommonKernelsSU3::convertAndProject( s.getLatticeSize()/32,32, dUSp, dUDp, HOST_CONSTANTS::getPtrToDeviceSize() );
+			}
+
+			if( options.getRealType() != "sp" )
+			{
+				orDpTotalStepnumber += orStage( dUDp, statsDp, dNn, s.getLatticeSize(), spIter, options.getPrecision(), options, orDpTotalKernelTime );
+			}
+
+			// reconstruct third line
+			CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dUDp, HOST_CONSTANTS::getPtrToDeviceSize() );
+
+			// check for best copy
+			statsDp.generateGaugeQuality();
+			if( statsDp.getCurrentGff() > bestGff )
+			{
+				cout << "FOUND BETTER COPY" << endl;
+				bestGff = statsDp.getCurrentGff();
+				cudaMemcpy( dUBest, dUDp, arraySize*sizeof(double), cudaMemcpyDeviceToDevice );
+			}
+			else
+			{
+				cout << "NO BETTER COPY" << endl;
+			}
+		}
+
+		//saving file
+		if( !options.isSetHot() )
+		{
+			cudaMemcpy( U, dUBest, arraySize*sizeof(double), cudaMemcpyDeviceToHost );
+			cout << "saving " << fi.getOutputFilename() << " as " << options.getFType() << endl;
+			switch( options.getFType() )
+			{
+			case VOGT:
+				loadOk = lfVogt.save( s, fi.getOutputFilename(), U );
+				break;
+			case PLAIN:
+				loadOk = lfPlain.save( s, fi.getOutputFilename(), U );
+				break;
+			case HEADERONLY:
+				loadOk = lfHeaderOnly.save( s, fi.getOutputFilename(), U );
+				break;
+			case ILDG:
+				loadOk = true;
+				writeILDG(s, fi.getFilename().c_str(), fi.getOutputFilename().c_str(), HOST_CONSTANTS::SIZE, U, options.getSaSteps());
+				break;
+			case QCDSTAG:
+				loadOk = writeQCDSTAG(s, fi.getOutputFilename().c_str(), HOST_CONSTANTS::SIZE, U);
+				break;
+			default:
+				cout << "Filetype not set to a known value. Exiting";
+				exit(1);
+			}
+		}
+	}
+
+	allTimer.stop();
+	cout << "total time: " << allTimer.getTime() << " s" << endl;
+
+	double orSpFlops = LandauKernelCounter<float>( dNn, s.getLatticeSize() ).orStep( options.getOrParameter() ).getFlops();
+	double orDpFlops = LandauKernelCounter<double>( dNn, s.getLatticeSize() ).orStep( options.getOrParameter() ).getFlops();
+	cout << "Simulated Annealing (" << ((options.getRealType() == "dp")?("DP"):("SP")) << "): " << saTotalKernelTime << " s" << endl;
+	if( orSpTotalStepnumber > 0 ) cout << "Overrelaxation (SP): " << orSpFlops*(double)s.getLatticeSize()*(double)orSpTotalStepnumber/orSpTotalKernelTime/1.0e9 << " GFlops, "
+			<< orSpTotalStepnumber << " iterations in " << orSpTotalKernelTime << " s" << endl;
+	if( orDpTotalStepnumber > 0 ) cout << "Overrelaxation (DP): " << orDpFlops*(double)s.getLatticeSize()*(double)orDpTotalStepnumber/orDpTotalKernelTime/1.0e9 << " GFlops, "
+			<< orDpTotalStepnumber << " iterations in " << orDpTotalKernelTime << " s" << endl;
+
+	cudaFree( dUPristine );
+	cudaFree( dUBest );
+	cudaFree( dUDp );
+	cudaFree( dUSp );
+	cudaFree( dNn );
+	free( U );
+	free( nn );
+}
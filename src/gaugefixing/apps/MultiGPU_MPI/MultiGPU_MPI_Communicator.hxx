@@ -23,11 +23,20 @@
  * 
  * This class takes care of the complete MPI communication:
  * 
- * -it offers methods to scatter and collect the gauge field from/to
- * the master host process to all process's devices.
+ * -it decomposes the lattice on a Cartesian process grid (t,x,y,z), given
+ * as TxXxYxZ (--mpigrid) or chosen by MPI_Dims_create. Each process owns
+ * a subdomain (MultiGPU_MPI_Subdomain.hxx): a range of timeslices (one
+ * device array per timeslice) and a spatial block with halo sites for each
+ * split spatial direction. Without --mpigrid only the time direction is
+ * split if there are at most Nt processes.
+ * -it copies the gauge field between the local host buffer, which holds
+ * the subdomain loaded by each process (MultiGPU_MPI_LinkFile), and the
+ * device (upload/downloadGaugeField).
  * -it applies an algorithm and takes care of the communication at 
  * the boundaries while hiding the time for the latter behind calculations
- * in the inner part of the domain.
+ * in the inner part of the domain (time direction). The halos of the
+ * split spatial directions are exchanged for all timeslices at once before
+ * (and sent back after) each half sweep.
  * -it offers methods setHot and projectSU3 that iterated over all
  * timeslices (no comm. necessary).
  * -it takes care of generating the gauge quality.
@@ -38,12 +47,14 @@
 #define MULTIGPU_MPI_COMMUNICATOR_HXX_
 
 #include <stdio.h>
+#include <string>
 #include "../../../lattice/datatype/datatypes.h"
 #include "../../../lattice/datatype/lattice_typedefs.h"
 #include "../../GlobalConstants.h"
 #include "./MultiGPU_MPI_LandauKernelsSU3.h"
 #include "./MultiGPU_MPI_Reduce.h"
 #include "./MultiGPU_MPI_AlgorithmOptions.h"
+#include "./MultiGPU_MPI_Subdomain.hxx"
 
 // MPI error handling macro
 #define MPI_CHECK( call) \
@@ -55,8 +66,6 @@
 //TODO where to put these constants?
 const int Ndim = 4;
 const int Nc = 3;
-const int timesliceArraySize = Nx*Ny*Nz*Ndim*Nc*Nc*2;
-const size_t timesliceSize = timesliceArraySize*sizeof(Real); 
         
 
 template< class MultiGPU_MPI_GaugeKernels >
@@ -64,13 +73,17 @@ class MultiGPU_MPI_Communicator
 {
 public:
 	// constructor
-	MultiGPU_MPI_Communicator( int argc, char** argv );
+	MultiGPU_MPI_Communicator( int argc, char** argv, std::string grid = "" );
 	// destructor
 	~MultiGPU_MPI_Communicator();
-	// scatter the gauge field from 'master' to all other processes
-	void scatterGaugeField( Real **dU, Real *U );
-	// collect the gauge field from all processes to 'master'
-	void collectGaugeField( Real **dU, Real *U );
+	// copy the own timeslices from host (U[(t-tmin)*getTimesliceArraySize()]) to the device
+	void uploadGaugeField( Real **dU, Real *U );
+	// copy the own timeslices from the device to host (U[(t-tmin)*getTimesliceArraySize()])
+	void downloadGaugeField( Real **dU, Real *U );
+	// the subdomain (layout of the local timeslices) of the process
+	const MultiGPU_MPI_Subdomain& getSubdomain();
+	// number of reals of a local timeslice (incl. halo sites)
+	int getTimesliceArraySize();
 	// get number of processes in MPI universe
 	int getNumbProcs();
 	// get rank
@@ -107,12 +120,27 @@ public:
 private:
 	// assign a device to the process
 	void initDevice( const int device );
+	// choose the process grid
+	void initGrid( std::string grid );
+	// exchange the halos of the split spatial directions
+	void exchangeSpatialHalos( Real** dU, bool evenodd, bool back );
 	int nprocs, rank, namelen;
 	char processor_name[MPI_MAX_PROCESSOR_NAME];
 	bool master;
 	int lRank;
 	int rRank;
 	
+	// Cartesian process grid
+	MPI_Comm cartComm;
+	int dims[Ndim];
+	int coords[Ndim];
+	int dwRank[Ndim];
+	int upRank[Ndim];
+	MultiGPU_MPI_Subdomain* subdomain;
+	lat_index_t latticeSize;
+	int sliceArraySize;
+	size_t sliceSize;
+	
 	// MPI comm.
 	MPI_Request request1, request2;
 	MPI_Status  status;
@@ -123,7 +151,6 @@ private:
 	int numbSlices;
 	int startPart[6];
 	int endPart[6];
-	int theProcess[Nt];
 	
 	// device memory to collect the gauge fixing quality
 	double *dGff;
@@ -136,6 +163,15 @@ private:
 	Real* haloIn;
 	Real* dHalo;
 	
+	// halos of the spatial directions: sites and buffers (all local timeslices)
+	lat_index_t* dBoundarySites[Ndim][2];
+	lat_index_t* dHaloSites[Ndim][2];
+	Real* spatialOut[Ndim];
+	Real* spatialIn[Ndim];
+	Real* dSpatialOut[Ndim];
+	Real* dSpatialIn[Ndim];
+	MPI_Request spatialRequest[2*Ndim];
+	
 	// cudaStreams 
 	cudaStream_t streamStd;
 	cudaStream_t streamCpy;
@@ -143,7 +179,7 @@ private:
 
 
 template< class MultiGPU_MPI_GaugeKernels >
-MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::MultiGPU_MPI_Communicator( int argc, char** argv )
+MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::MultiGPU_MPI_Communicator( int argc, char** argv, std::string grid )
 {
 	
 	// initialize MPI communication
@@ -153,12 +189,29 @@ MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::MultiGPU_MPI_Communicato
   MPI_CHECK( MPI_Get_processor_name(processor_name, &namelen) );
 	printf("Process %d on %s out of %d alive.\n", rank, processor_name, nprocs);
 	
-	// init. some variables
-	lRank = ( rank - 1 + nprocs ) % nprocs;
-	rRank = ( rank + 1 ) % nprocs;
 	master = ( rank == 0 ? true : false );
-	tmin = rank*Nt/nprocs;
-	tmax = (rank+1)*Nt/nprocs;
+	
+	// Cartesian process grid (periodic, the ranks are not reordered)
+	initGrid( grid );
+	int periods[Ndim] = { 1, 1, 1, 1 };
+	MPI_CHECK( MPI_Cart_create( MPI_COMM_WORLD, Ndim, dims, periods, 0, &cartComm ) );
+	MPI_CHECK( MPI_Cart_coords( cartComm, rank, Ndim, coords ) );
+	for( int mu=0; mu<Ndim; mu++ )
+	{
+		MPI_CHECK( MPI_Cart_shift( cartComm, mu, 1, &dwRank[mu], &upRank[mu] ) );
+	}
+	
+	const int size[Ndim] = { Nt, Nx, Ny, Nz };
+	subdomain = new MultiGPU_MPI_Subdomain( size, dims, coords );
+	latticeSize = subdomain->getLatticeSize();
+	sliceArraySize = subdomain->getTimesliceArraySize();
+	sliceSize = sliceArraySize*sizeof(Real);
+	
+	// init. some variables
+	lRank = dwRank[0];
+	rRank = upRank[0];
+	tmin = subdomain->getOffset(0);
+	tmax = tmin + subdomain->getSize(0);
 	numbSlices = tmax-tmin;
 	
 	// set boarders of six parts to hide the comm. (apply,generateGaugeQuality)
@@ -183,36 +236,59 @@ MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::MultiGPU_MPI_Communicato
 		}
 	}
 	
-	// to which process belongs timeslice 't':
-	for( int k=0; k<nprocs; k++ )
-		for( int t = k*Nt/nprocs; t < (k+1)*Nt/nprocs; t++ )
-			theProcess[t] = k;
-	
 
 	// print some information
-	printf("Process %d: numbSlices %d\n", rank, numbSlices );
+	printf("Process %d: grid coords (%d,%d,%d,%d), numbSlices %d, local sites %d (%d with halo)\n", rank, coords[0], coords[1], coords[2], coords[3], numbSlices, subdomain->getInteriorSize(), latticeSize );
 	for( int l=0; l<6; l++ )
 	{
 		printf("Process %d: startPart[%d] = %d, endPart[%d] = %d\n", rank, l, startPart[l], l, endPart[l] );
 	}
 	
-	// init. the device
-	initDevice( rank%4 );
+	// init. the device (several processes may share a device, e.g. for tests with local processes)
+	int deviceCount = 1;
+	cudaGetDeviceCount( &deviceCount );
+	initDevice( rank%deviceCount );
 	
 	// init. cuda streams
 	cudaStreamCreate( &streamStd );
 	cudaStreamCreate( &streamCpy );
 	
 	// page-locked host memory for halo timeslices (two per thread)
- 	if( nprocs > 1 ) cudaHostAlloc( &haloIn,  timesliceSize, 0 );
-	if( nprocs > 1 ) cudaHostAlloc( &haloOut, timesliceSize, 0 );
+	haloIn = haloOut = dHalo = 0;
+ 	if( dims[0] > 1 ) cudaHostAlloc( &haloIn,  sliceSize, 0 );
+	if( dims[0] > 1 ) cudaHostAlloc( &haloOut, sliceSize, 0 );
 	
 	// device memory for halo timeslice (one per device)
-	if( nprocs > 1 ) cudaMalloc( &dHalo, timesliceSize );
+	if( dims[0] > 1 ) cudaMalloc( &dHalo, sliceSize );
+	
+	// spatial halos: index lists of the boundary and halo sites per parity, buffers for the first two lines
+	// of the links of all local timeslices
+	for( int mu=1; mu<Ndim; mu++ )
+	{
+		if( !subdomain->isSplit(mu) ) continue;
+		const int haloSize = subdomain->getHaloSize(mu);
+		lat_index_t* sites = (lat_index_t*)malloc( haloSize*sizeof(lat_index_t) );
+		for( int parity=0; parity<2; parity++ )
+		{
+			cudaMalloc( &dBoundarySites[mu][parity], haloSize*sizeof(lat_index_t) );
+			subdomain->getBoundarySites( mu, parity, sites );
+			cudaMemcpy( dBoundarySites[mu][parity], sites, haloSize*sizeof(lat_index_t), cudaMemcpyHostToDevice );
+			cudaMalloc( &dHaloSites[mu][parity], haloSize*sizeof(lat_index_t) );
+			subdomain->getHaloSites( mu, parity, sites );
+			cudaMemcpy( dHaloSites[mu][parity], sites, haloSize*sizeof(lat_index_t), cudaMemcpyHostToDevice );
+		}
+		free( sites );
+		
+		const size_t bufferSize = (size_t)numbSlices*haloSize*12*sizeof(Real);
+		cudaHostAlloc( &spatialOut[mu], bufferSize, 0 );
+		cudaHostAlloc( &spatialIn[mu], bufferSize, 0 );
+		cudaMalloc( &dSpatialOut[mu], bufferSize );
+		cudaMalloc( &dSpatialIn[mu], bufferSize );
+	}
 	
 	// device memory for gauge quality
-	cudaMalloc( &dGff, Nx*Ny*Nz*sizeof(double)/2 );
-	cudaMalloc( &dA,   Nx*Ny*Nz*sizeof(double)/2 );
+	cudaMalloc( &dGff, subdomain->getInteriorSize()*sizeof(double)/2 );
+	cudaMalloc( &dA,   subdomain->getInteriorSize()*sizeof(double)/2 );
 	
 	// tell CUDA to prefer the L1 cache
 	MultiGPU_MPI_GaugeKernels::initCacheConfig();
@@ -224,11 +300,29 @@ template< class MultiGPU_MPI_GaugeKernels >
 MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::~MultiGPU_MPI_Communicator()
 {
 	// free halo memory
- 	cudaFreeHost( haloIn );
-	cudaFreeHost( haloOut );
-	cudaFree( dHalo );
+ 	if( haloIn ) cudaFreeHost( haloIn );
+	if( haloOut ) cudaFreeHost( haloOut );
+	if( dHalo ) cudaFree( dHalo );
+	
+	for( int mu=1; mu<Ndim; mu++ )
+	{
+		if( !subdomain->isSplit(mu) ) continue;
+		for( int parity=0; parity<2; parity++ )
+		{
+			cudaFree( dBoundarySites[mu][parity] );
+			cudaFree( dHaloSites[mu][parity] );
+		}
+		cudaFreeHost( spatialOut[mu] );
+		cudaFreeHost( spatialIn[mu] );
+		cudaFree( dSpatialOut[mu] );
+		cudaFree( dSpatialIn[mu] );
+	}
+	cudaFree( dGff );
+	cudaFree( dA );
+	delete subdomain;
 	
 	MPI_CHECK( MPI_Barrier(MPI_COMM_WORLD) );
+	MPI_CHECK( MPI_Comm_free( &cartComm ) );
 	MPI_CHECK( MPI_Finalize() );
 }
 
@@ -242,49 +336,80 @@ void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::initDevice( const i
 	printf("CUDA Capability Major/Minor version number:    %d.%d\n\n", deviceProp.major, deviceProp.minor);
 }
 
+/**
+ * The process grid TxXxYxZ (grid, e.g. "4x2x1x1") or, if grid is empty, the time direction for up to Nt
+ * processes and MPI_Dims_create otherwise. The spatial extents have to be divisible by the grid with an
+ * even local extent, half of the local timeslice volume has to be a multiple of NSB (threads per block).
+ */
 template< class MultiGPU_MPI_GaugeKernels >
-void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::scatterGaugeField( Real **dU, Real *U )
+void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::initGrid( std::string grid )
 {
-	for( int t=0; t<Nt; t++ )
+	const int size[Ndim] = { Nt, Nx, Ny, Nz };
+	bool ok = true;
+
+	if( grid.size() > 0 )
 	{
-		if( master && theProcess[t] == 0 )
-		{
-			cudaMemcpy( dU[t], &U[t*timesliceArraySize], timesliceArraySize*sizeof(Real), cudaMemcpyHostToDevice );
-		}
-		else if( theProcess[t] == rank )
-		{
-			MPI_CHECK( MPI_Recv( haloIn,  timesliceArraySize, MPI_Real, 0, 0, MPI_COMM_WORLD, &status ) );
-			cudaMemcpy( dU[t], haloIn, timesliceArraySize*sizeof(Real), cudaMemcpyHostToDevice );
-		}
-		else if( master )
-		{
-			MPI_CHECK( MPI_Send( &U[t*timesliceArraySize], timesliceArraySize, MPI_Real, theProcess[t], 0, MPI_COMM_WORLD ) );
-		}
-		MPI_CHECK( MPI_Barrier(MPI_COMM_WORLD) );
+		ok = ( sscanf( grid.c_str(), "%dx%dx%dx%d", &dims[0], &dims[1], &dims[2], &dims[3] ) == Ndim );
+	}
+	else if( nprocs <= Nt )
+	{
+		dims[0] = nprocs;
+		dims[1] = dims[2] = dims[3] = 1;
+	}
+	else
+	{
+		dims[0] = dims[1] = dims[2] = dims[3] = 0;
+		MPI_CHECK( MPI_Dims_create( nprocs, Ndim, dims ) );
+	}
+
+	int volume = 1;
+	for( int mu=0; mu<Ndim && ok; mu++ )
+	{
+		if( dims[mu] < 1 || dims[mu] > size[mu] ) ok = false;
+		else if( mu > 0 && ( size[mu]%dims[mu] != 0 || (size[mu]/dims[mu])%2 != 0 ) ) ok = false;
+		else volume *= size[mu]/dims[mu];
 	}
+	volume /= Nt/dims[0];
+	ok = ok && ( dims[0]*dims[1]*dims[2]*dims[3] == nprocs ) && ( (volume/2)%NSB == 0 );
+
+	if( !ok )
+	{
+		if( master ) printf( "No valid process grid TxXxYxZ for %d processes and the lattice %dx%dx%dx%d (%s), set --mpigrid\n", nprocs, Nt, Nx, Ny, Nz, ( grid.size() > 0 )?( grid.c_str() ):( "auto" ) );
+		MPI_Abort( MPI_COMM_WORLD, -1 );
+	}
+	if( master ) printf( "Process grid %dx%dx%dx%d\n", dims[0], dims[1], dims[2], dims[3] );
 }
 
 template< class MultiGPU_MPI_GaugeKernels >
-void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::collectGaugeField( Real **dU, Real *U )
+void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::uploadGaugeField( Real **dU, Real *U )
 {
-	// send back all timeslices to master
-	for( int t=0; t<Nt; t++ )
+	for( int t=tmin; t<tmax; t++ )
 	{
-		if( master && theProcess[t] == 0 )
-		{
-			cudaMemcpy( &U[t*timesliceArraySize], dU[t], timesliceArraySize*sizeof(Real), cudaMemcpyDeviceToHost );
-		}
-		else if( theProcess[t] == rank )
-		{
-			cudaMemcpy( haloOut, dU[t], timesliceArraySize*sizeof(Real), cudaMemcpyDeviceToHost );
-			MPI_CHECK( MPI_Send( haloOut,  timesliceArraySize, MPI_Real, 0, 0, MPI_COMM_WORLD ) );
-		}
-		else if( master )
-		{
-			MPI_CHECK( MPI_Recv( &U[t*timesliceArraySize], timesliceArraySize, MPI_Real, theProcess[t], 0, MPI_COMM_WORLD, &status ) );
-		}
-		MPI_CHECK( MPI_Barrier(MPI_COMM_WORLD) );
+		cudaMemcpyAsync( dU[t], &U[(size_t)(t-tmin)*sliceArraySize], sliceSize, cudaMemcpyHostToDevice, streamCpy );
+	}
+	cudaStreamSynchronize( streamCpy );
+}
+
+template< class MultiGPU_MPI_GaugeKernels >
+void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::downloadGaugeField( Real **dU, Real *U )
+{
+	for( int t=tmin; t<tmax; t++ )
+	{
+		cudaMemcpyAsync( &U[(size_t)(t-tmin)*sliceArraySize], dU[t], sliceSize, cudaMemcpyDeviceToHost, streamCpy );
 	}
+	cudaStreamSynchronize( streamCpy );
+}
+
+template< class MultiGPU_MPI_GaugeKernels >
+const MultiGPU_MPI_Subdomain& MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::getSubdomain()
+{
+	return *subdomain;
+}
+
+template< class MultiGPU_MPI_GaugeKernels >
+int MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::getTimesliceArraySize()
+{
+	return sliceArraySize;
 }
 
 template< class MultiGPU_MPI_GaugeKernels >
@@ -351,97 +476,103 @@ template< class MultiGPU_MPI_GaugeKernels >
 inline void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::apply( Real** dU, lat_index_t** dNnt, bool evenodd, MultiGPU_MPI_AlgorithmOptions algoOptions )
 {
 	static const int threadsPerBlock = NSB*8; // NSB sites are updated within a block (8 threads are needed per site)
-	static const int numBlocks = Nx*Ny*Nz/2/NSB; // // half of the lattice sites (a parity) are updated in a kernel call
+	const int numBlocks = subdomain->getInteriorSize()/2/NSB; // // half of the local sites (a parity) are updated in a kernel call
 	
 	// instantiate object of kernel wrapper class
 	static MultiGPU_MPI_GaugeKernels kernelWrapper;
 
+	// spatial halos of all timeslices
+	exchangeSpatialHalos( dU, evenodd, false );
 	
-	if( nprocs > 1 )
+	if( dims[0] > 1 )
 	{
-		int p_offset = evenodd?timesliceArraySize/2:0;
+		int p_offset = evenodd?sliceArraySize/2:0;
 		
 		// halo exchange forward step 1
-		cudaMemcpyAsync( haloOut+p_offset, dU[tmax-1]+p_offset, timesliceSize/12, cudaMemcpyDeviceToHost, streamCpy );
+		cudaMemcpyAsync( haloOut+p_offset, dU[tmax-1]+p_offset, sliceSize/12, cudaMemcpyDeviceToHost, streamCpy );
 		for( int t = startPart[2]; t < endPart[2]; t++ )
 		{
 			// call wrapper for one timelice
-			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], evenodd ^ (t%2) , algoOptions );
+			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], latticeSize, evenodd ^ (t%2) , algoOptions );
 		}
 		cudaDeviceSynchronize(); // to ensure cudaMemcpyAsync finished
 		
 		// halo exchange forward step 2
-		MPI_CHECK( MPI_Irecv( haloIn+p_offset,  timesliceArraySize/12, MPI_Real, lRank, 0, MPI_COMM_WORLD, &request2) );	
-		MPI_CHECK( MPI_Isend( haloOut+p_offset, timesliceArraySize/12, MPI_Real, rRank, 0, MPI_COMM_WORLD, &request1) );
+		MPI_CHECK( MPI_Irecv( haloIn+p_offset,  sliceArraySize/12, MPI_Real, lRank, 0, MPI_COMM_WORLD, &request2) );	
+		MPI_CHECK( MPI_Isend( haloOut+p_offset, sliceArraySize/12, MPI_Real, rRank, 0, MPI_COMM_WORLD, &request1) );
 		for( int t = startPart[0]; t < endPart[0]; t++ )
 		{
-			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], evenodd ^ (t%2) , algoOptions );
+			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], latticeSize, evenodd ^ (t%2) , algoOptions );
 		}
 		MPI_CHECK( MPI_Wait( &request1, &status ) );
 		MPI_CHECK( MPI_Wait( &request2, &status ) );
 		
 		// halo exchange forward step 3
-		cudaMemcpyAsync( dHalo+p_offset, haloIn+p_offset, timesliceSize/12, cudaMemcpyHostToDevice, streamCpy );
+		cudaMemcpyAsync( dHalo+p_offset, haloIn+p_offset, sliceSize/12, cudaMemcpyHostToDevice, streamCpy );
 		for( int t = startPart[3]; t < endPart[3]; t++ )
 		{
-			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], evenodd ^ (t%2) , algoOptions );		
+			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], latticeSize, evenodd ^ (t%2) , algoOptions );		
 		}
 		
 		// now call kernel wrapper for tmin with dU[t-1] replaced by dHalo
-		kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamCpy, dU[tmin], dHalo, dNnt[rank], evenodd ^ (tmin%2) , algoOptions );
+		kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamCpy, dU[tmin], dHalo, dNnt[rank], latticeSize, evenodd ^ (tmin%2) , algoOptions );
 		
 		// halo exchange back step 1
-		cudaMemcpyAsync( haloOut+p_offset, dHalo+p_offset, timesliceSize/12, cudaMemcpyDeviceToHost, streamCpy );
+		cudaMemcpyAsync( haloOut+p_offset, dHalo+p_offset, sliceSize/12, cudaMemcpyDeviceToHost, streamCpy );
 		for( int t = startPart[4]; t < endPart[4]; t++ )
 		{
-			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], evenodd ^ (t%2) , algoOptions );
+			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], latticeSize, evenodd ^ (t%2) , algoOptions );
 		}
 		cudaDeviceSynchronize(); // to ensure cudaMemcpyAsync finished
 		
 		// halo exchange back step 2
-		MPI_CHECK( MPI_Irecv( haloIn+p_offset,  timesliceArraySize/12, MPI_Real, rRank, 0, MPI_COMM_WORLD, &request2) );	
-		MPI_CHECK( MPI_Isend( haloOut+p_offset, timesliceArraySize/12, MPI_Real, lRank, 0, MPI_COMM_WORLD, &request1) );
+		MPI_CHECK( MPI_Irecv( haloIn+p_offset,  sliceArraySize/12, MPI_Real, rRank, 0, MPI_COMM_WORLD, &request2) );	
+		MPI_CHECK( MPI_Isend( haloOut+p_offset, sliceArraySize/12, MPI_Real, lRank, 0, MPI_COMM_WORLD, &request1) );
 		for( int t = startPart[1]; t < endPart[1]; t++ )
 		{
-			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], evenodd ^ (t%2) , algoOptions );
+			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], latticeSize, evenodd ^ (t%2) , algoOptions );
 		}
 		MPI_CHECK( MPI_Wait( &request1, &status ) );
 		MPI_CHECK( MPI_Wait( &request2, &status ) );
 		
 		// halo exchange back step 3
-		cudaMemcpyAsync( dU[tmax-1]+p_offset, haloIn+p_offset, timesliceSize/12, cudaMemcpyHostToDevice, streamCpy );
+		cudaMemcpyAsync( dU[tmax-1]+p_offset, haloIn+p_offset, sliceSize/12, cudaMemcpyHostToDevice, streamCpy );
 		for( int t = startPart[5]; t < endPart[5]; t++ )
 		{
-			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], evenodd ^ (t%2) , algoOptions );
+			kernelWrapper.applyOneTimeslice( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], latticeSize, evenodd ^ (t%2) , algoOptions );
 		}		
 		cudaDeviceSynchronize(); // to ensure cudaMemcpyAsync finished
 		
 		MPI_CHECK( MPI_Barrier(MPI_COMM_WORLD) );
 	}
-	else // nproc == 1
+	else // time direction not split
 	{
 		for( int t=tmin; t<tmax; t++ )
 		{
 			int tDw = ( t > 0 )?( t - 1 ):( Nt - 1 );
-			kernelWrapper.applyOneTimeslice( numBlocks, threadsPerBlock, streamStd, dU[t], dU[tDw], dNnt[rank], evenodd ^ (t%2), algoOptions );
+			kernelWrapper.applyOneTimeslice( numBlocks, threadsPerBlock, streamStd, dU[t], dU[tDw], dNnt[rank], latticeSize, evenodd ^ (t%2), algoOptions );
 		}
 		cudaDeviceSynchronize();
-	} // end if nproc > 1
+	} // end if dims[0] > 1
+	
+	// send the updated spatial halos back
+	exchangeSpatialHalos( dU, evenodd, true );
 }
 
 
 template< class MultiGPU_MPI_GaugeKernels >
 inline void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::projectSU3( Real** dU )
 {
+	// all sites of the local timeslices (the halo sites are overwritten before they are used)
 	int threadsPerBlock = 32;
-	int numBlocks = Nx*Ny*Nz/32;
+	int numBlocks = (latticeSize+31)/32;
 	
 	// instantiate object of kernel wrapper class
 	static MultiGPU_MPI_GaugeKernels kernelWrapper;
 
 	for( int t=tmin; t<tmax; t++ )
 	{
-		kernelWrapper.projectSU3( numBlocks, threadsPerBlock, streamStd, dU[t] );
+		kernelWrapper.projectSU3( numBlocks, threadsPerBlock, streamStd, dU[t], latticeSize );
 	}
 	cudaDeviceSynchronize();
 	MPI_CHECK( MPI_Barrier(MPI_COMM_WORLD) );
@@ -452,14 +583,14 @@ template< class MultiGPU_MPI_GaugeKernels >
 inline void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::setHot( Real** dU, MultiGPU_MPI_AlgorithmOptions algoOptions )
 {
 	int threadsPerBlock = 32;
-	int numBlocks = Nx*Ny*Nz/32;
+	int numBlocks = (latticeSize+31)/32;
 
 	// instantiate object of kernel wrapper class
 	static MultiGPU_MPI_GaugeKernels kernelWrapper;
 
 	for( int t=tmin; t<tmax; t++ )
 	{
-		kernelWrapper.setHot( numBlocks, threadsPerBlock, streamStd, dU[t], algoOptions );
+		kernelWrapper.setHot( numBlocks, threadsPerBlock, streamStd, dU[t], latticeSize, algoOptions );
 	}
 	cudaDeviceSynchronize();
 	MPI_CHECK( MPI_Barrier(MPI_COMM_WORLD) );
@@ -470,40 +601,41 @@ template< class MultiGPU_MPI_GaugeKernels >
 inline void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::generateGaugeQuality( Real** dU, lat_index_t** dNnt )
 {
 	static const int threadsPerBlock = NSB; // NSB sites are updated within a block (8 threads are needed per site)
-	static const int numBlocks = Nx*Ny*Nz/2/NSB; // // half of the lattice sites (a parity) are updated in a kernel call
+	const int numBlocks = subdomain->getInteriorSize()/2/NSB; // // half of the local sites (a parity) are updated in a kernel call
 	
 	// instantiate object of kernel wrapper class
 	static MultiGPU_MPI_GaugeKernels kernelWrapper;
 	
 	// reduce to collect dGff, dA
-	static Reduce reduce( Nx*Ny*Nz/2 );
+	static Reduce reduce( subdomain->getInteriorSize()/2 );
 	
 	double tempGff = 0.0;
 	double tempA   = 0.0;
 	
-	if( nprocs > 1 )
+	if( dims[0] > 1 )
 	{
 		for( int evenodd=0; evenodd<2; evenodd++ )
 		{
-			int p_offset = evenodd?timesliceArraySize/2:0;
+			exchangeSpatialHalos( dU, evenodd, false );
+			int p_offset = evenodd?sliceArraySize/2:0;
 			
 			// halo exchange forward step 1
-			cudaMemcpyAsync( haloOut+p_offset, dU[tmax-1]+p_offset, timesliceSize/12, cudaMemcpyDeviceToHost, streamCpy );
+			cudaMemcpyAsync( haloOut+p_offset, dU[tmax-1]+p_offset, sliceSize/12, cudaMemcpyDeviceToHost, streamCpy );
 			for( int t = startPart[0]; t < endPart[1]; t++ )
 			{
 				// call wrapper for one timelice
-				kernelWrapper.generateGaugeQualityPerSite( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], evenodd ^ (t%2) , dGff, dA );
+				kernelWrapper.generateGaugeQualityPerSite( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], latticeSize, evenodd ^ (t%2) , dGff, dA );
 				tempGff += reduce.getReducedValue( streamStd, dGff );
 				tempA   += reduce.getReducedValue( streamStd, dA );
 			}
 			cudaDeviceSynchronize(); // to ensure cudaMemcpyAsync finished
 			
 			// halo exchange forward step 2
-			MPI_CHECK( MPI_Irecv( haloIn+p_offset,  timesliceArraySize/12, MPI_Real, lRank, 0, MPI_COMM_WORLD, &request2) );	
-			MPI_CHECK( MPI_Isend( haloOut+p_offset, timesliceArraySize/12, MPI_Real, rRank, 0, MPI_COMM_WORLD, &request1) );
+			MPI_CHECK( MPI_Irecv( haloIn+p_offset,  sliceArraySize/12, MPI_Real, lRank, 0, MPI_COMM_WORLD, &request2) );	
+			MPI_CHECK( MPI_Isend( haloOut+p_offset, sliceArraySize/12, MPI_Real, rRank, 0, MPI_COMM_WORLD, &request1) );
 			for( int t = startPart[2]; t < endPart[3]; t++ )
 			{
-				kernelWrapper.generateGaugeQualityPerSite( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], evenodd ^ (t%2) , dGff, dA );
+				kernelWrapper.generateGaugeQualityPerSite( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], latticeSize, evenodd ^ (t%2) , dGff, dA );
 				tempGff += reduce.getReducedValue( streamStd, dGff );
 				tempA   += reduce.getReducedValue( streamStd, dA );
 			}
@@ -511,16 +643,16 @@ inline void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::generateGaug
 			MPI_CHECK( MPI_Wait( &request2, &status ) );
 			
 			// halo exchange forward step 3
-			cudaMemcpyAsync( dHalo+p_offset, haloIn+p_offset, timesliceSize/12, cudaMemcpyHostToDevice, streamCpy );
+			cudaMemcpyAsync( dHalo+p_offset, haloIn+p_offset, sliceSize/12, cudaMemcpyHostToDevice, streamCpy );
 			for( int t = startPart[4]; t < endPart[5]; t++ )
 			{
-				kernelWrapper.generateGaugeQualityPerSite( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], evenodd ^ (t%2) , dGff, dA );		
+				kernelWrapper.generateGaugeQualityPerSite( numBlocks,threadsPerBlock, streamStd, dU[t], dU[t-1], dNnt[rank], latticeSize, evenodd ^ (t%2) , dGff, dA );		
 				tempGff += reduce.getReducedValue( streamStd, dGff );
 				tempA   += reduce.getReducedValue( streamStd, dA );
 			}
 			
 			// now call kernel wrapper for tmin with dU[t-1] replaced by dHalo
-			kernelWrapper.generateGaugeQualityPerSite( numBlocks,threadsPerBlock, streamCpy, dU[tmin], dHalo, dNnt[rank], evenodd ^ (tmin%2) , dGff, dA );
+			kernelWrapper.generateGaugeQualityPerSite( numBlocks,threadsPerBlock, streamCpy, dU[tmin], dHalo, dNnt[rank], latticeSize, evenodd ^ (tmin%2) , dGff, dA );
 			tempGff += reduce.getReducedValue( streamCpy, dGff );
 			tempA   += reduce.getReducedValue( streamCpy, dA );
 				
@@ -528,20 +660,21 @@ inline void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::generateGaug
 			MPI_CHECK( MPI_Barrier(MPI_COMM_WORLD) );
 		}
 	}
-	else // nproc == 1
+	else // time direction not split
 	{
 		for( int evenodd=0; evenodd<2; evenodd++ )
 		{
+			exchangeSpatialHalos( dU, evenodd, false );
 			for( int t=tmin; t<tmax; t++ )
 			{
 				int tDw = ( t > tmin )?( t - 1 ):( tmax - 1 );
-				kernelWrapper.generateGaugeQualityPerSite( numBlocks, threadsPerBlock, streamStd, dU[t], dU[tDw], dNnt[rank], evenodd ^ (t%2), dGff, dA );
+				kernelWrapper.generateGaugeQualityPerSite( numBlocks, threadsPerBlock, streamStd, dU[t], dU[tDw], dNnt[rank], latticeSize, evenodd ^ (t%2), dGff, dA );
 				tempGff += reduce.getReducedValue( streamStd, dGff );
 				tempA   += reduce.getReducedValue( streamStd, dA );
 			}
 			cudaDeviceSynchronize();
 		}
-	} // end if nproc > 1
+	} // end if dims[0] > 1
 	
 
 	// collect dGff, dA from all devices
@@ -558,6 +691,65 @@ inline void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::generateGaug
 	MPI_CHECK( MPI_Barrier(MPI_COMM_WORLD) );
 }
 
+/**
+ * Exchanges the halos of the split spatial directions of all local timeslices for the half sweep of the
+ * sites evenodd^(t%2): forward (back == false) the boundary x_mu = L_mu-1 is sent to the upper neighbour
+ * and stored in its halo sites, back the (updated) halo sites are returned to the boundary. Only the
+ * first two lines of the links mu are transferred (the third line is reconstructed).
+ */
+template< class MultiGPU_MPI_GaugeKernels >
+void MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::exchangeSpatialHalos( Real** dU, bool evenodd, bool back )
+{
+	static const int threadsPerBlock = 128;
+	
+	// instantiate object of kernel wrapper class
+	static MultiGPU_MPI_GaugeKernels kernelWrapper;
+	
+	int n = 0;
+	for( int mu=1; mu<Ndim; mu++ )
+	{
+		if( !subdomain->isSplit(mu) ) continue;
+		const int haloSize = subdomain->getHaloSize(mu);
+		const int numBlocks = (haloSize+threadsPerBlock-1)/threadsPerBlock;
+		const int count = numbSlices*haloSize*12;
+		
+		for( int t=tmin; t<tmax; t++ )
+		{
+			// the halo sites are the down neighbours of the updated sites, i.e. of the other parity
+			int parity = 1 ^ evenodd ^ (t%2);
+			lat_index_t* sites = ( back )?( dHaloSites[mu][parity] ):( dBoundarySites[mu][parity] );
+			kernelWrapper.packHalo( numBlocks, threadsPerBlock, streamCpy, dU[t], latticeSize, sites, haloSize, mu, dSpatialOut[mu]+(t-tmin)*haloSize*12 );
+		}
+		cudaMemcpyAsync( spatialOut[mu], dSpatialOut[mu], count*sizeof(Real), cudaMemcpyDeviceToHost, streamCpy );
+		cudaStreamSynchronize( streamCpy );
+		
+		// the transfers of the directions overlap with the packing of the next direction
+		int dest = ( back )?( dwRank[mu] ):( upRank[mu] );
+		int source = ( back )?( upRank[mu] ):( dwRank[mu] );
+		MPI_CHECK( MPI_Irecv( spatialIn[mu], count, MPI_Real, source, mu, cartComm, &spatialRequest[n++] ) );
+		MPI_CHECK( MPI_Isend( spatialOut[mu], count, MPI_Real, dest, mu, cartComm, &spatialRequest[n++] ) );
+	}
+	if( n == 0 ) return;
+	MPI_CHECK( MPI_Waitall( n, spatialRequest, MPI_STATUSES_IGNORE ) );
+	
+	for( int mu=1; mu<Ndim; mu++ )
+	{
+		if( !subdomain->isSplit(mu) ) continue;
+		const int haloSize = subdomain->getHaloSize(mu);
+		const int numBlocks = (haloSize+threadsPerBlock-1)/threadsPerBlock;
+		const int count = numbSlices*haloSize*12;
+		
+		cudaMemcpyAsync( dSpatialIn[mu], spatialIn[mu], count*sizeof(Real), cudaMemcpyHostToDevice, streamCpy );
+		for( int t=tmin; t<tmax; t++ )
+		{
+			int parity = 1 ^ evenodd ^ (t%2);
+			lat_index_t* sites = ( back )?( dBoundarySites[mu][parity] ):( dHaloSites[mu][parity] );
+			kernelWrapper.unpackHalo( numBlocks, threadsPerBlock, streamCpy, dU[t], latticeSize, sites, haloSize, mu, dSpatialIn[mu]+(t-tmin)*haloSize*12 );
+		}
+	}
+	cudaStreamSynchronize( streamCpy );
+}
+
 template< class MultiGPU_MPI_GaugeKernels >
 double MultiGPU_MPI_Communicator< MultiGPU_MPI_GaugeKernels >::getCurrentGff()
 {
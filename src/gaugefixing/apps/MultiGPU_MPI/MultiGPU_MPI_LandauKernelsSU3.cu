@@ -37,28 +37,30 @@
 #include "../../../lattice/access_pattern/StandardPattern.hxx"
 #include "../../../lattice/access_pattern/GpuPatternTimesliceParityPriority.hxx"
 #include "../../../lattice/access_pattern/GpuPatternParityPriority.hxx"
+#include "../../../lattice/access_pattern/GpuPatternCompressed.hxx"
 #include "../../../lattice/SiteCoord.hxx"
 #include "../../../lattice/SiteIndex.hxx"
 #include "../../../lattice/Link.hxx"
+#include "../../../lattice/Link12.hxx"
 #include "../../../lattice/SU3.hxx"
 #include "../../../lattice/Matrix.hxx"
 #include "../../../lattice/rng/PhiloxWrapper.hxx"
 
 #include "./MultiGPU_MPI_LandauKernelsSU3.h"
+#include "./MultiGPU_MPI_Subdomain.hxx"
 
 
 // kernels:
 namespace MPILKSU3
 {
 
-template<class Algorithm> inline __device__ void applyOneTimeslice( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, Algorithm algorithm  )
+template<class Algorithm> inline __device__ void applyOneTimeslice( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, Algorithm algorithm  )
 {
-	typedef GpuPatternParityPriority< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuIndex;
-	typedef Link<GpuIndex,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLinkIndex;
+	typedef GpuPatternParityPriority< MultiGPU_MPI_SubdomainSite,Ndim,Nc> GpuIndex;
+	typedef Link<GpuIndex,MultiGPU_MPI_SubdomainSite,Ndim,Nc> TLinkIndex;
 
-	const lat_coord_t size[Ndim] = {1,Nx,Ny,Nz};
-	SiteIndex<4,FULL_SPLIT> s(size);
-// 	SiteIndex<4,FULL_SPLIT> s( DEVICE_CONSTANTS::SIZE_TIMESLICE );
+	// the local timeslice: interior and halo sites (see MultiGPU_MPI_Subdomain.hxx)
+	MultiGPU_MPI_SubdomainSite s( latticeSize );
 	
 	s.nn = nnt;
 
@@ -109,20 +111,18 @@ template<class Algorithm> inline __device__ void applyOneTimeslice( Real* UtUp,
 	globU.assignWithoutThirdLine(locU);
 }
 
-__global__ void generateGaugeQualityPerSite( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, double *dGff, double *dA )
+__global__ void generateGaugeQualityPerSite( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, double *dGff, double *dA )
 {
-	typedef GpuPatternParityPriority< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuIndex;
-	typedef Link<GpuIndex,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLinkIndex;
+	typedef GpuPatternParityPriority< MultiGPU_MPI_SubdomainSite,Ndim,Nc> GpuIndex;
+	typedef Link<GpuIndex,MultiGPU_MPI_SubdomainSite,Ndim,Nc> TLinkIndex;
 
-	const lat_coord_t size[Ndim] = {1,Nx,Ny,Nz};
-	SiteIndex<4,FULL_SPLIT> s(size);
-// 	SiteIndex<4,FULL_SPLIT> s( DEVICE_CONSTANTS::SIZE_TIMESLICE);
+	MultiGPU_MPI_SubdomainSite s( latticeSize );
 	
 	s.nn = nnt;
 	
 	int site = blockIdx.x * blockDim.x + threadIdx.x;
 	int resid = site;
-	if( parity == 1 ) site += Nx*Ny*Nz/2;
+	if( parity == 1 ) site += latticeSize/2;
 // 	if( site >= Nx*Ny*Nz ) return; //important in case Nx^3 is not power of 2
 
 	Matrix<Complex<Real>,Nc> locMatSum;
@@ -187,41 +187,41 @@ __global__ void generateGaugeQualityPerSite( Real* UtUp, Real* UtDw, lat_index_t
 
 
 
-__global__ void __launch_bounds__(8*NSB,OR_MINBLOCKS) orStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float orParameter )
+__global__ void __launch_bounds__(8*NSB,OR_MINBLOCKS) orStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, float orParameter )
 {
 	OrUpdate overrelax( orParameter );
-	applyOneTimeslice( UtUp, UtDw, nnt, parity, overrelax  );
+	applyOneTimeslice( UtUp, UtDw, nnt, latticeSize, parity, overrelax  );
 }
 
-__global__ void __launch_bounds__(8*NSB,MS_MINBLOCKS) microStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity )
+__global__ void __launch_bounds__(8*NSB,MS_MINBLOCKS) microStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity )
 {
 	MicroUpdate micro;
-	applyOneTimeslice( UtUp, UtDw, nnt, parity, micro );
+	applyOneTimeslice( UtUp, UtDw, nnt, latticeSize, parity, micro );
 }
 
-__global__ void __launch_bounds__(8*NSB,SA_MINBLOCKS)  saStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter )
+__global__ void __launch_bounds__(8*NSB,SA_MINBLOCKS)  saStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, float temperature, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	SaUpdate sa( temperature, &rng );
-	applyOneTimeslice( UtUp, UtDw, nnt, parity, sa );
+	applyOneTimeslice( UtUp, UtDw, nnt, latticeSize, parity, sa );
 }
 
-__global__ void randomTrafo( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, int rngSeed, int rngCounter )
+__global__ void randomTrafo( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, int rngSeed, int rngCounter )
 {
 	PhiloxWrapper rng( blockIdx.x * blockDim.x + threadIdx.x, rngSeed, rngCounter );
 	RandomUpdate random( &rng );
-	applyOneTimeslice( UtUp, UtDw, nnt, parity, random );
+	applyOneTimeslice( UtUp, UtDw, nnt, latticeSize, parity, random );
 }
 
-__global__ void projectSU3( Real* Ut )
+__global__ void projectSU3( Real* Ut, lat_index_t latticeSize )
 {
-	typedef GpuPatternParityPriority< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuIndex;
-	typedef Link<GpuIndex,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLinkIndex;
+	typedef GpuPatternParityPriority< MultiGPU_MPI_SubdomainSite,Ndim,Nc> GpuIndex;
+	typedef Link<GpuIndex,MultiGPU_MPI_SubdomainSite,Ndim,Nc> TLinkIndex;
 
-	const lat_coord_t size[Ndim] = {1,Nx,Ny,Nz};
-	SiteIndex<4,FULL_SPLIT> s(size);
+	MultiGPU_MPI_SubdomainSite s( latticeSize );
 	
 	int site = blockIdx.x * blockDim.x + threadIdx.x;
+	if( site >= latticeSize ) return;
 
 	s.setLatticeIndex( site );
 
@@ -234,14 +234,14 @@ __global__ void projectSU3( Real* Ut )
 	}
 }
 
-__global__ void setHot( Real* Ut, int rngSeed, int rngCounter )
+__global__ void setHot( Real* Ut, lat_index_t latticeSize, int rngSeed, int rngCounter )
 {
-	typedef GpuPatternParityPriority< SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> GpuIndex;
-	typedef Link<GpuIndex,SiteIndex<Ndim,FULL_SPLIT>,Ndim,Nc> TLinkIndex;
+	typedef GpuPatternParityPriority< MultiGPU_MPI_SubdomainSite,Ndim,Nc> GpuIndex;
+	typedef Link<GpuIndex,MultiGPU_MPI_SubdomainSite,Ndim,Nc> TLinkIndex;
 
-	const lat_coord_t size[Ndim] = {1,Nx,Ny,Nz};
-	SiteIndex<4,FULL_SPLIT> s(size);
+	MultiGPU_MPI_SubdomainSite s( latticeSize );
 	int site = blockIdx.x * blockDim.x + threadIdx.x;
+	if( site >= latticeSize ) return;
 	s.setLatticeIndex( site );
 	
 	PhiloxWrapper rng( site, rngSeed, rngCounter );
@@ -273,6 +273,50 @@ __global__ void setHot( Real* Ut, int rngSeed, int rngCounter )
 	}
 }
 
+/**
+ * Copies the first two lines of the links mu of the given sites to/from a contiguous buffer, used for the halos of
+ * the spatial directions. The buffer is a field of nSites links in the 12 real layout (Link12 with
+ * GpuPatternCompressed: component k of site n at buffer[n+k*nSites]), the third line is reconstructed by the
+ * kernels that read the halo links.
+ */
+__global__ void packHalo( Real* Ut, lat_index_t latticeSize, lat_index_t* sites, int nSites, int mu, Real* buffer )
+{
+	typedef GpuPatternParityPriority< MultiGPU_MPI_SubdomainSite,Ndim,Nc> GpuIndex;
+	typedef Link<GpuIndex,MultiGPU_MPI_SubdomainSite,Ndim,Nc> TLinkIndex;
+	typedef Link12<GpuPatternCompressed<MultiGPU_MPI_SubdomainSite,Ndim,Nc,12>,MultiGPU_MPI_SubdomainSite,Ndim,Nc> THaloLink;
+
+	int n = blockIdx.x * blockDim.x + threadIdx.x;
+	if( n >= nSites ) return;
+
+	MultiGPU_MPI_SubdomainSite s( latticeSize );
+	s.setLatticeIndex( sites[n] );
+	MultiGPU_MPI_SubdomainSite h( nSites );
+	h.setLatticeIndex( n );
+
+	SU3<TLinkIndex> globU( TLinkIndex( Ut, s, mu ) );
+	SU3<THaloLink> haloU( THaloLink( buffer, h, 0 ) );
+	haloU.assignWithoutThirdLine( globU );
+}
+
+__global__ void unpackHalo( Real* Ut, lat_index_t latticeSize, lat_index_t* sites, int nSites, int mu, Real* buffer )
+{
+	typedef GpuPatternParityPriority< MultiGPU_MPI_SubdomainSite,Ndim,Nc> GpuIndex;
+	typedef Link<GpuIndex,MultiGPU_MPI_SubdomainSite,Ndim,Nc> TLinkIndex;
+	typedef Link12<GpuPatternCompressed<MultiGPU_MPI_SubdomainSite,Ndim,Nc,12>,MultiGPU_MPI_SubdomainSite,Ndim,Nc> THaloLink;
+
+	int n = blockIdx.x * blockDim.x + threadIdx.x;
+	if( n >= nSites ) return;
+
+	MultiGPU_MPI_SubdomainSite s( latticeSize );
+	s.setLatticeIndex( sites[n] );
+	MultiGPU_MPI_SubdomainSite h( nSites );
+	h.setLatticeIndex( n );
+
+	SU3<TLinkIndex> globU( TLinkIndex( Ut, s, mu ) );
+	SU3<THaloLink> haloU( THaloLink( buffer, h, 0 ) );
+	globU.assignWithoutThirdLine( haloU );
+}
+
 }
 
 
@@ -295,21 +339,21 @@ void MultiGPU_MPI_LandauKernelsSU3::initCacheConfig()
 }
 
 
-void MultiGPU_MPI_LandauKernelsSU3::applyOneTimeslice( int a, int b, cudaStream_t stream, Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, MultiGPU_MPI_AlgorithmOptions algoOptions )
+void MultiGPU_MPI_LandauKernelsSU3::applyOneTimeslice( int a, int b, cudaStream_t stream, Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, MultiGPU_MPI_AlgorithmOptions algoOptions )
 {
 	switch( algoOptions.getAlgorithm() )
 	{
 	case OR:
-		MPILKSU3::orStep<<<a,b,0,stream>>>( UtUp, UtDw, nnt, parity, algoOptions.getOrParameter() );
+		MPILKSU3::orStep<<<a,b,0,stream>>>( UtUp, UtDw, nnt, latticeSize, parity, algoOptions.getOrParameter() );
 		break;
 	case MS:
-		MPILKSU3::microStep<<<a,b,0,stream>>>( UtUp, UtDw, nnt, parity );
+		MPILKSU3::microStep<<<a,b,0,stream>>>( UtUp, UtDw, nnt, latticeSize, parity );
 		break;
 	case SA:
-		MPILKSU3::saStep<<<a,b,0,stream>>>( UtUp, UtDw, nnt, parity, algoOptions.getTemperature(), PhiloxWrapper::getNextCounter(), algoOptions.getSeed() );
+		MPILKSU3::saStep<<<a,b,0,stream>>>( UtUp, UtDw, nnt, latticeSize, parity, algoOptions.getTemperature(), PhiloxWrapper::getNextCounter(), algoOptions.getSeed() );
 		break;
 	case RT:
-		MPILKSU3::randomTrafo<<<a,b,0,stream>>>( UtUp, UtDw, nnt, parity, PhiloxWrapper::getNextCounter(), algoOptions.getSeed() );
+		MPILKSU3::randomTrafo<<<a,b,0,stream>>>( UtUp, UtDw, nnt, latticeSize, parity, PhiloxWrapper::getNextCounter(), algoOptions.getSeed() );
 		break;
 	default:
 		printf("Algorithm type not set to a known value [MultiGPU_MPI_AlgorithmOptions::setAlgorithm(enum AlgoType)]. Exiting\n");
@@ -317,24 +361,28 @@ void MultiGPU_MPI_LandauKernelsSU3::applyOneTimeslice( int a, int b, cudaStream_
 	}
 }
 
-void MultiGPU_MPI_LandauKernelsSU3::projectSU3( int a, int b, cudaStream_t stream, Real* Ut )
+void MultiGPU_MPI_LandauKernelsSU3::projectSU3( int a, int b, cudaStream_t stream, Real* Ut, lat_index_t latticeSize )
 {
-	MPILKSU3::projectSU3<<<a,b,0,stream>>>( Ut );
+	MPILKSU3::projectSU3<<<a,b,0,stream>>>( Ut, latticeSize );
 }
 
-void MultiGPU_MPI_LandauKernelsSU3::setHot( int a, int b, cudaStream_t stream, Real* Ut, MultiGPU_MPI_AlgorithmOptions algoOptions )
+void MultiGPU_MPI_LandauKernelsSU3::setHot( int a, int b, cudaStream_t stream, Real* Ut, lat_index_t latticeSize, MultiGPU_MPI_AlgorithmOptions algoOptions )
 {
 	
-	MPILKSU3::setHot<<<a,b,0,stream>>>( Ut, PhiloxWrapper::getNextCounter(), algoOptions.getSeed() );
+	MPILKSU3::setHot<<<a,b,0,stream>>>( Ut, latticeSize, PhiloxWrapper::getNextCounter(), algoOptions.getSeed() );
 }
 
-void MultiGPU_MPI_LandauKernelsSU3::generateGaugeQualityPerSite( int a, int b, cudaStream_t stream, Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, double *dGff, double *dA )
+void MultiGPU_MPI_LandauKernelsSU3::generateGaugeQualityPerSite( int a, int b, cudaStream_t stream, Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, double *dGff, double *dA )
 {
-	MPILKSU3::generateGaugeQualityPerSite<<<a,b,0,stream>>>( UtUp, UtDw, nnt, parity, dGff, dA );
+	MPILKSU3::generateGaugeQualityPerSite<<<a,b,0,stream>>>( UtUp, UtDw, nnt, latticeSize, parity, dGff, dA );
 }
 
+void MultiGPU_MPI_LandauKernelsSU3::packHalo( int a, int b, cudaStream_t stream, Real* Ut, lat_index_t latticeSize, lat_index_t* sites, int nSites, int mu, Real* buffer )
+{
+	MPILKSU3::packHalo<<<a,b,0,stream>>>( Ut, latticeSize, sites, nSites, mu, buffer );
+}
 
-
-
-
-
+void MultiGPU_MPI_LandauKernelsSU3::unpackHalo( int a, int b, cudaStream_t stream, Real* Ut, lat_index_t latticeSize, lat_index_t* sites, int nSites, int mu, Real* buffer )
+{
+	MPILKSU3::unpackHalo<<<a,b,0,stream>>>( Ut, latticeSize, sites, nSites, mu, buffer );
+}
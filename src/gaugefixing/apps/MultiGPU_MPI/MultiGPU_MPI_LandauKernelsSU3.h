@@ -38,14 +38,16 @@ namespace MPILKSU3
 {
 static const int Ndim = 4;
 static const int Nc = 3;
-template<class Algorithm> inline __device__ void applyOneTimeslice( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, Algorithm algorithm  );
-__global__ void generateGaugeQualityPerSite( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, double *dGff, double *dA );
-__global__ void randomTrafo( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, int rngSeed, int rngCounter );
-__global__ void orStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float orParameter );
-__global__ void microStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity );
-__global__ void saStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, float temperature, int rngSeed, int rngCounter );
-__global__ void projectSU3( Real* Ut );
-__global__ void setHot( Real* Ut, int rngSeed, int rngCounter );
+template<class Algorithm> inline __device__ void applyOneTimeslice( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, Algorithm algorithm  );
+__global__ void generateGaugeQualityPerSite( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, double *dGff, double *dA );
+__global__ void randomTrafo( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, int rngSeed, int rngCounter );
+__global__ void orStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, float orParameter );
+__global__ void microStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity );
+__global__ void saStep( Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, float temperature, int rngSeed, int rngCounter );
+__global__ void projectSU3( Real* Ut, lat_index_t latticeSize );
+__global__ void setHot( Real* Ut, lat_index_t latticeSize, int rngSeed, int rngCounter );
+__global__ void packHalo( Real* Ut, lat_index_t latticeSize, lat_index_t* sites, int nSites, int mu, Real* buffer );
+__global__ void unpackHalo( Real* Ut, lat_index_t latticeSize, lat_index_t* sites, int nSites, int mu, Real* buffer );
 }
 
 // wrappers:
@@ -57,13 +59,17 @@ public:
 	// tell CUDA to prefer the L1 cache
 	static void initCacheConfig();
 	// applies an anlgorithm (given in algoOptions) to a single timeslice
-	void applyOneTimeslice( int a, int b, cudaStream_t stream, Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, MultiGPU_MPI_AlgorithmOptions algoOptions  );
+	void applyOneTimeslice( int a, int b, cudaStream_t stream, Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, MultiGPU_MPI_AlgorithmOptions algoOptions  );
 	// projects all SU(3) matrices in a timeslice back to the group
-	void projectSU3( int a, int b, cudaStream_t stream, Real* Ut );
+	void projectSU3( int a, int b, cudaStream_t stream, Real* Ut, lat_index_t latticeSize );
 	// fill gauge field on the devices with random SU(3) matrices
-	void setHot( int a, int b, cudaStream_t stream, Real* Ut, MultiGPU_MPI_AlgorithmOptions algoOptions );
+	void setHot( int a, int b, cudaStream_t stream, Real* Ut, lat_index_t latticeSize, MultiGPU_MPI_AlgorithmOptions algoOptions );
 	// generates the gauge quality on a timesclice for all sites, no reduction
-	void generateGaugeQualityPerSite( int a, int b, cudaStream_t stream, Real* UtUp, Real* UtDw, lat_index_t* nnt, bool parity, double *dGff, double *dA );
+	void generateGaugeQualityPerSite( int a, int b, cudaStream_t stream, Real* UtUp, Real* UtDw, lat_index_t* nnt, lat_index_t latticeSize, bool parity, double *dGff, double *dA );
+	// copy the first two lines of the links mu of the given sites to a contiguous buffer
+	void packHalo( int a, int b, cudaStream_t stream, Real* Ut, lat_index_t latticeSize, lat_index_t* sites, int nSites, int mu, Real* buffer );
+	// copy the buffer back to the links mu of the given sites
+	void unpackHalo( int a, int b, cudaStream_t stream, Real* Ut, lat_index_t latticeSize, lat_index_t* sites, int nSites, int mu, Real* buffer );
 	
 private:
 	
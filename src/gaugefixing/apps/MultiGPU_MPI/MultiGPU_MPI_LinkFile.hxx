@@ -0,0 +1,325 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * compile with mpicc
+ *
+ * Parallel counterpart of LinkFile for the MultiGPU_MPI app: every process reads and writes
+ * only its own subdomain (see MultiGPU_MPI_Subdomain.hxx) with collective MPI-IO calls, no
+ * process holds the complete configuration.
+ *
+ * The file is in the StandardPattern (t,x,y,z, the time coordinate runs slowest). The master
+ * reads (or writes) the header with the FileType and broadcasts its length. The file view of a
+ * process is the subarray of its spatial block in a timeslice, starting at its first timeslice:
+ * as the extent of the subarray is a complete timeslice, each MPI_File_read_all
+ * (MPI_File_write_all) of one block reads the next timeslice. The reals are converted to the
+ * subdomain layout (and from/to the ReinterpretReal type of the file) on the fly, the local
+ * configuration holds the timeslices tmin..tmax-1 one after the other
+ * (U[(t-tmin)*subdomain.getTimesliceArraySize()+...]).
+ *
+ * Only FileTypes without footer whose header is known after loadHeader()/saveHeader()
+ * (PLAIN, HEADERONLY, VOGT) are supported.
+ *
+ */
+
+#ifndef MULTIGPU_MPI_LINKFILE_HXX_
+#define MULTIGPU_MPI_LINKFILE_HXX_
+
+#include <mpi.h>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include "../../../lattice/datatype/datatypes.h"
+#include "../../../util/log/Logger.hxx"
+#include "../../../lattice/filetypes/filetype_typedefs.h"
+#include "./MultiGPU_MPI_Subdomain.hxx"
+
+template<class FileType> class MultiGPU_MPI_LinkFile
+{
+public:
+	MultiGPU_MPI_LinkFile( ReinterpretReal reinterpret = STANDARD );
+	virtual ~MultiGPU_MPI_LinkFile();
+	// collective: each process loads its subdomain into U
+	bool load( std::string filename, Real *U, const MultiGPU_MPI_Subdomain& subdomain );
+	// collective: each process saves its subdomain from U
+	bool save( std::string filename, Real *U, const MultiGPU_MPI_Subdomain& subdomain );
+	FileType filetype;
+private:
+	static const int Ndim = MultiGPU_MPI_Subdomain::Ndim;
+	static const int Nc = MultiGPU_MPI_Subdomain::Nc;
+	ReinterpretReal reinterpret; // defined in "filetypes/filetype_typedefs.h"
+	int getLengthOfReal( ReinterpretReal reinterpret );
+	MPI_Datatype getFileDatatype();
+	bool transfer( std::string filename, long long offset, Real *U, const MultiGPU_MPI_Subdomain& subdomain, bool write );
+	bool allOk( bool ok );
+	void fileToMemory( const MultiGPU_MPI_Subdomain& subdomain, const char *buffer, Real *Ut );
+	void memoryToFile( const MultiGPU_MPI_Subdomain& subdomain, const Real *Ut, char *buffer );
+};
+
+template <class FileType> MultiGPU_MPI_LinkFile<FileType>::MultiGPU_MPI_LinkFile( ReinterpretReal reinterpret ) : filetype( getLengthOfReal(reinterpret) ), reinterpret( reinterpret )
+{
+}
+
+template <class FileType> MultiGPU_MPI_LinkFile<FileType>::~MultiGPU_MPI_LinkFile()
+{
+}
+
+template <class FileType> bool MultiGPU_MPI_LinkFile<FileType>::load( std::string filename, Real *U, const MultiGPU_MPI_Subdomain& subdomain )
+{
+	int rank;
+	MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+
+	// the master reads the header, the data starts behind it
+	long long offset = 0;
+	if( rank == 0 )
+	{
+		std::fstream file;
+		file.open( filename.c_str(), std::ios::in | std::ios::binary );
+		if( !file )
+		{
+			util::Logger::log( util::ERROR, "Can't open file");
+			util::Logger::log( util::ERROR, filename.c_str() );
+			offset = -1;
+		}
+		else if( !filetype.loadHeader( &file ) )
+		{
+			util::Logger::log( util::ERROR, "Can't read header");
+			offset = -1;
+		}
+		else
+		{
+			offset = file.tellg();
+		}
+		file.close();
+	}
+	// offset < 0: the master failed
+	MPI_Bcast( &offset, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD );
+	if( offset < 0 ) return false;
+
+	if( !transfer( filename, offset, U, subdomain, false ) )
+	{
+		util::Logger::log( util::ERROR, "Can't read configuration");
+		return false;
+	}
+	return true;
+}
+
+template <class FileType> bool MultiGPU_MPI_LinkFile<FileType>::save( std::string filename, Real *U, const MultiGPU_MPI_Subdomain& subdomain )
+{
+	int rank;
+	MPI_Comm_rank( MPI_COMM_WORLD, &rank );
+
+	// the master (re)creates the file and writes the header
+	long long offset = 0;
+	if( rank == 0 )
+	{
+		std::fstream file;
+		file.open( filename.c_str(), std::ios::out | std::ios::binary );
+		if( !file )
+		{
+			util::Logger::log( util::ERROR, "Can't open file");
+			util::Logger::log( util::ERROR, filename.c_str() );
+			offset = -1;
+		}
+		else if( !filetype.saveHeader( &file ) )
+		{
+			util::Logger::log( util::ERROR, "Can't write header");
+			offset = -1;
+		}
+		else
+		{
+			offset = file.tellp();
+		}
+		file.close();
+	}
+	// offset < 0: the master failed
+	MPI_Bcast( &offset, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD );
+	if( offset < 0 ) return false;
+
+	if( !transfer( filename, offset, U, subdomain, true ) )
+	{
+		util::Logger::log( util::ERROR, "Can't write configuration");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Reads (write == false) or writes the subdomain, the data starts at offset.
+ */
+template <class FileType> bool MultiGPU_MPI_LinkFile<FileType>::transfer( std::string filename, long long offset, Real *U, const MultiGPU_MPI_Subdomain& subdomain, bool write )
+{
+	MPI_File fh;
+	int mode = ( write )?( MPI_MODE_WRONLY ):( MPI_MODE_RDONLY );
+	if( !allOk( MPI_File_open( MPI_COMM_WORLD, (char*)filename.c_str(), mode, MPI_INFO_NULL, &fh ) == MPI_SUCCESS ) ) return false;
+
+	// the spatial block of the subdomain in a timeslice (the reals of a site are contiguous)
+	int sizes[Ndim];
+	int subsizes[Ndim];
+	int starts[Ndim];
+	for( int mu = 1; mu < Ndim; mu++ )
+	{
+		sizes[mu-1] = subdomain.getGlobalSize( mu );
+		subsizes[mu-1] = subdomain.getSize( mu );
+		starts[mu-1] = subdomain.getOffset( mu );
+	}
+	sizes[Ndim-1] = subsizes[Ndim-1] = Ndim*Nc*Nc*2;
+	starts[Ndim-1] = 0;
+
+	MPI_Datatype block;
+	MPI_Type_create_subarray( Ndim, sizes, subsizes, starts, MPI_ORDER_C, getFileDatatype(), &block );
+	MPI_Type_commit( &block );
+
+	const MPI_Offset timesliceBytes = (MPI_Offset)sizes[0]*sizes[1]*sizes[2]*sizes[3]*getLengthOfReal( reinterpret );
+	bool ok = ( MPI_File_set_view( fh, offset + subdomain.getOffset(0)*timesliceBytes, getFileDatatype(), block, (char*)"native", MPI_INFO_NULL ) == MPI_SUCCESS );
+
+	// the configuration has to be complete (some MPI implementations report the requested count for a short read)
+	if( !write )
+	{
+		MPI_Offset fileSize;
+		if( MPI_File_get_size( fh, &fileSize ) != MPI_SUCCESS || fileSize < offset + subdomain.getGlobalSize(0)*timesliceBytes ) ok = false;
+	}
+
+	const int blockSize = subsizes[0]*subsizes[1]*subsizes[2]*subsizes[3];
+	const int numbSlices = subdomain.getSize(0);
+	int maxSlices;
+	MPI_Allreduce( (void*)&numbSlices, &maxSlices, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD );
+
+	char *buffer = (char*)malloc( (size_t)blockSize*getLengthOfReal( reinterpret ) );
+
+	// all processes have to take part in each collective call: processes with less timeslices transfer nothing
+	for( int i = 0; i < maxSlices; i++ )
+	{
+		int count = ( i < numbSlices )?( blockSize ):( 0 );
+		Real *Ut = &U[(size_t)i*subdomain.getTimesliceArraySize()];
+		MPI_Status status;
+		if( write )
+		{
+			if( i < numbSlices ) memoryToFile( subdomain, Ut, buffer );
+			if( MPI_File_write_all( fh, buffer, count, getFileDatatype(), &status ) != MPI_SUCCESS ) ok = false;
+		}
+		else
+		{
+			if( MPI_File_read_all( fh, buffer, count, getFileDatatype(), &status ) != MPI_SUCCESS ) ok = false;
+		}
+
+		// a short transfer is no error of MPI_File_read_all/write_all, only the count of the status is short
+		int transferred = -1;
+		MPI_Get_count( &status, getFileDatatype(), &transferred );
+		if( transferred != count ) ok = false;
+
+		if( !write && ok && i < numbSlices ) fileToMemory( subdomain, buffer, Ut );
+	}
+
+	free( buffer );
+	MPI_Type_free( &block );
+	MPI_File_close( &fh );
+
+	return allOk( ok );
+}
+
+/**
+ * Converts a block of the file (x,y,z,mu,i,j,c) to the local timeslice Ut.
+ */
+template <class FileType> void MultiGPU_MPI_LinkFile<FileType>::fileToMemory( const MultiGPU_MPI_Subdomain& subdomain, const char *buffer, Real *Ut )
+{
+	int n = 0;
+	for( int x = 0; x < subdomain.getSize(1); x++ )
+		for( int y = 0; y < subdomain.getSize(2); y++ )
+			for( int z = 0; z < subdomain.getSize(3); z++ )
+			{
+				lat_index_t site = subdomain.getSiteIndex( x, y, z );
+				for( int mu = 0; mu < Ndim; mu++ )
+					for( int i = 0; i < Nc; i++ )
+						for( int j = 0; j < Nc; j++ )
+							for( int c = 0; c < 2; c++ )
+							{
+								lat_array_index_t index = subdomain.getIndex( site, mu, i, j, c );
+								if( reinterpret == DOUBLE )
+									Ut[index] = (Real)((const double*)buffer)[n];
+								else if( reinterpret == FLOAT )
+									Ut[index] = (Real)((const float*)buffer)[n];
+								else
+									Ut[index] = ((const Real*)buffer)[n];
+								n++;
+							}
+			}
+}
+
+/**
+ * Converts the local timeslice Ut to a block of the file.
+ */
+template <class FileType> void MultiGPU_MPI_LinkFile<FileType>::memoryToFile( const MultiGPU_MPI_Subdomain& subdomain, const Real *Ut, char *buffer )
+{
+	int n = 0;
+	for( int x = 0; x < subdomain.getSize(1); x++ )
+		for( int y = 0; y < subdomain.getSize(2); y++ )
+			for( int z = 0; z < subdomain.getSize(3); z++ )
+			{
+				lat_index_t site = subdomain.getSiteIndex( x, y, z );
+				for( int mu = 0; mu < Ndim; mu++ )
+					for( int i = 0; i < Nc; i++ )
+						for( int j = 0; j < Nc; j++ )
+							for( int c = 0; c < 2; c++ )
+							{
+								lat_array_index_t index = subdomain.getIndex( site, mu, i, j, c );
+								if( reinterpret == DOUBLE )
+									((double*)buffer)[n] = (double)Ut[index];
+								else if( reinterpret == FLOAT )
+									((float*)buffer)[n] = (float)Ut[index];
+								else
+									((Real*)buffer)[n] = Ut[index];
+								n++;
+							}
+			}
+}
+
+/**
+ * True if ok is true on all processes.
+ */
+template <class FileType> bool MultiGPU_MPI_LinkFile<FileType>::allOk( bool ok )
+{
+	int local = ok;
+	int all;
+	MPI_Allreduce( &local, &all, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD );
+	return all;
+}
+
+template <class FileType> MPI_Datatype MultiGPU_MPI_LinkFile<FileType>::getFileDatatype()
+{
+	if( reinterpret == DOUBLE )
+		return MPI_DOUBLE;
+	else if( reinterpret == FLOAT )
+		return MPI_FLOAT;
+	else
+		return MPI_Real;
+}
+
+template <class FileType> int MultiGPU_MPI_LinkFile<FileType>::getLengthOfReal( ReinterpretReal reinterpret )
+{
+	if( reinterpret == DOUBLE )
+		return sizeof(double);
+	else if( reinterpret == FLOAT )
+		return sizeof(float);
+	else
+		return sizeof(Real);
+}
+
+#endif /* MULTIGPU_MPI_LINKFILE_HXX_ */
@@ -0,0 +1,283 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Memory layout of the subdomain of one process (MultiGPU_MPI).
+ *
+ * The lattice is decomposed on a Cartesian process grid (t,x,y,z). Each process owns the timeslices
+ * [tmin,tmax) (one device array per timeslice, as before) and of each timeslice the spatial block
+ * [x0,x0+Lx)x[y0,y0+Ly)x[z0,z0+Lz). A local timeslice is stored parity priority like
+ * GpuPatternTimesliceParityPriority, but with halo sites: for each split spatial direction mu the
+ * sites x_mu = -1 (i.e. the boundary x_mu = L_mu-1 of the lower neighbour in mu) are appended to the
+ * interior sites of each parity:
+ *
+ *   | even interior | even halo x | even halo y | even halo z | odd interior | odd halo x | ...
+ *
+ * The array index of a link is site%(S/2) + S/2*(c+2*(j+Nc*(i+Nc*(mu+Ndim*parity)))) with S the
+ * number of sites including the halo, i.e. the kernels use GpuPatternParityPriority with a
+ * MultiGPU_MPI_SubdomainSite of size S and the neighbour table of calculateNeighbourTable(): the
+ * down neighbour of a site with x_mu = 0 is its halo site. The kernels only go down, the halo
+ * holds the links U_mu(x-mu) that are updated by the sites at x_mu = 0 and is exchanged with the
+ * neighbour before (forward) and after (back) each half sweep. Without spatial split S is the
+ * timeslice volume and the layout equals GpuPatternTimesliceParityPriority.
+ *
+ * The local spatial extents have to be even, then the offsets of the blocks are even and the
+ * local parity of a site is its global parity.
+ */
+
+#ifndef MULTIGPU_MPI_SUBDOMAIN_HXX_
+#define MULTIGPU_MPI_SUBDOMAIN_HXX_
+
+#include "../../../lattice/cuda/cuda_host_device.h"
+#include "../../../lattice/datatype/lattice_typedefs.h"
+
+/**
+ * Site for the kernels: a 1 dimensional index into the S sites of a local timeslice and the
+ * neighbour table. Provides what GpuPatternParityPriority and Link need from a site (the
+ * extents of SiteIndex are shorts, S is not a product of extents).
+ */
+class MultiGPU_MPI_SubdomainSite
+{
+public:
+	CUDA_HOST_DEVICE inline MultiGPU_MPI_SubdomainSite( lat_index_t latticeSize ) : latticeSize( latticeSize )
+	{
+	}
+	CUDA_HOST_DEVICE inline lat_index_t getLatticeIndex()
+	{
+		return index;
+	}
+	CUDA_HOST_DEVICE inline void setLatticeIndex( lat_index_t latticeIndex )
+	{
+		index = latticeIndex;
+	}
+	CUDA_HOST_DEVICE inline lat_index_t getLatticeSize()
+	{
+		return latticeSize;
+	}
+	CUDA_HOST_DEVICE inline void setNeighbour( lat_dim_t mu, bool up )
+	{
+		index = nn[(2*mu+up)*latticeSize+index];
+	}
+
+	static const lat_dim_t Ndim = 4;
+	lat_index_t* nn;
+private:
+	lat_index_t index;
+	lat_index_t latticeSize;
+};
+
+
+class MultiGPU_MPI_Subdomain
+{
+public:
+	static const int Ndim = 4;
+	static const int Nc = 3;
+
+	MultiGPU_MPI_Subdomain( const int size[Ndim], const int dims[Ndim], const int coords[Ndim] );
+	// extent of the lattice in direction mu
+	int getGlobalSize( int mu ) const;
+	// local extent in direction mu (mu = 0: number of timeslices)
+	int getSize( int mu ) const;
+	// global coordinate of the first local site in direction mu
+	int getOffset( int mu ) const;
+	// is direction mu split among several processes?
+	bool isSplit( int mu ) const;
+	// number of interior sites of a local timeslice
+	lat_index_t getInteriorSize() const;
+	// number of sites of a local timeslice including the halo (S)
+	lat_index_t getLatticeSize() const;
+	// number of reals of a local timeslice
+	int getTimesliceArraySize() const;
+	// sites per parity of the halo of the split direction mu
+	int getHaloSize( int mu ) const;
+	// site of the local spatial coordinates, one coordinate may be -1 (halo) in a split direction
+	lat_index_t getSiteIndex( int x, int y, int z ) const;
+	// array index of a link component
+	lat_array_index_t getIndex( lat_index_t site, int mu, int i, int j, int c ) const;
+	// neighbour table (2*Ndim*S entries) for MultiGPU_MPI_SubdomainSite
+	void calculateNeighbourTable( lat_index_t* nn ) const;
+	// sites x_mu = L_mu-1 of the given parity (sent to the upper neighbour)
+	void getBoundarySites( int mu, int parity, lat_index_t* sites ) const;
+	// halo sites x_mu = -1 of the given parity, in the order of getBoundarySites() of the lower neighbour
+	void getHaloSites( int mu, int parity, lat_index_t* sites ) const;
+private:
+	int size[Ndim];
+	int L[Ndim];
+	int offset[Ndim];
+	bool split[Ndim];
+	lat_index_t interiorSize;
+	lat_index_t latticeSize;
+	int haloOffset[Ndim];
+	void getPlaneSites( int mu, int parity, int xmu, lat_index_t* sites ) const;
+};
+
+
+MultiGPU_MPI_Subdomain::MultiGPU_MPI_Subdomain( const int size[Ndim], const int dims[Ndim], const int coords[Ndim] )
+{
+	for( int mu = 0; mu < Ndim; mu++ )
+	{
+		this->size[mu] = size[mu];
+		// time: uneven splits are allowed, each timeslice is a separate array
+		offset[mu] = coords[mu]*size[mu]/dims[mu];
+		L[mu] = (coords[mu]+1)*size[mu]/dims[mu] - offset[mu];
+		split[mu] = ( dims[mu] > 1 );
+	}
+
+	interiorSize = L[1]*L[2]*L[3];
+	latticeSize = interiorSize;
+	for( int mu = 1; mu < Ndim; mu++ )
+	{
+		haloOffset[mu] = ( latticeSize - interiorSize )/2;
+		if( split[mu] ) latticeSize += interiorSize/L[mu];
+	}
+}
+
+int MultiGPU_MPI_Subdomain::getGlobalSize( int mu ) const
+{
+	return size[mu];
+}
+
+int MultiGPU_MPI_Subdomain::getSize( int mu ) const
+{
+	return L[mu];
+}
+
+int MultiGPU_MPI_Subdomain::getOffset( int mu ) const
+{
+	return offset[mu];
+}
+
+bool MultiGPU_MPI_Subdomain::isSplit( int mu ) const
+{
+	return split[mu];
+}
+
+lat_index_t MultiGPU_MPI_Subdomain::getInteriorSize() const
+{
+	return interiorSize;
+}
+
+lat_index_t MultiGPU_MPI_Subdomain::getLatticeSize() const
+{
+	return latticeSize;
+}
+
+int MultiGPU_MPI_Subdomain::getTimesliceArraySize() const
+{
+	return latticeSize*Ndim*Nc*Nc*2;
+}
+
+int MultiGPU_MPI_Subdomain::getHaloSize( int mu ) const
+{
+	return ( split[mu] )?( interiorSize/L[mu]/2 ):( 0 );
+}
+
+lat_index_t MultiGPU_MPI_Subdomain::getSiteIndex( int x, int y, int z ) const
+{
+	const int site[Ndim] = { 0, x, y, z };
+
+	for( int mu = 1; mu < Ndim; mu++ )
+	{
+		if( site[mu] < 0 )
+		{
+			// halo: index in the plane of the other two directions
+			int planeIndex = 0;
+			int parity = 1;
+			for( int nu = 1; nu < Ndim; nu++ )
+			{
+				if( nu == mu ) continue;
+				planeIndex = planeIndex*L[nu] + site[nu];
+				parity += site[nu];
+			}
+			return interiorSize/2 + haloOffset[mu] + planeIndex/2 + (parity%2)*(latticeSize/2);
+		}
+	}
+
+	lat_index_t index = ( x*L[2] + y )*L[3] + z;
+	return index/2 + ((x+y+z)%2)*(latticeSize/2);
+}
+
+lat_array_index_t MultiGPU_MPI_Subdomain::getIndex( lat_index_t site, int mu, int i, int j, int c ) const
+{
+	int parity = site / (latticeSize/2);
+	return site%(latticeSize/2) + latticeSize/2 * ( c + 2 * ( j + Nc *( i + Nc * ( mu + Ndim * parity ) ) ) );
+}
+
+void MultiGPU_MPI_Subdomain::calculateNeighbourTable( lat_index_t* nn ) const
+{
+	// halo sites (and the time direction, see the kernels) point to themselves
+	for( int mu = 0; mu < Ndim; mu++ )
+		for( lat_index_t i = 0; i < latticeSize; i++ )
+		{
+			nn[(2*mu)*latticeSize+i] = i;
+			nn[(2*mu+1)*latticeSize+i] = i;
+		}
+
+	for( int x = 0; x < L[1]; x++ )
+		for( int y = 0; y < L[2]; y++ )
+			for( int z = 0; z < L[3]; z++ )
+			{
+				const int site[Ndim] = { 0, x, y, z };
+				lat_index_t index = getSiteIndex( x, y, z );
+
+				for( int mu = 1; mu < Ndim; mu++ )
+				{
+					int dw[Ndim] = { 0, x, y, z };
+					dw[mu]--;
+					if( dw[mu] < 0 && !split[mu] ) dw[mu] += L[mu];
+					nn[(2*mu)*latticeSize+index] = getSiteIndex( dw[1], dw[2], dw[3] );
+
+					// in a split direction the upper neighbour of x_mu = L_mu-1 is not local (not used by the kernels)
+					int up[Ndim] = { 0, x, y, z };
+					up[mu] = ( site[mu]+1 )%L[mu];
+					nn[(2*mu+1)*latticeSize+index] = getSiteIndex( up[1], up[2], up[3] );
+				}
+			}
+}
+
+void MultiGPU_MPI_Subdomain::getBoundarySites( int mu, int parity, lat_index_t* sites ) const
+{
+	getPlaneSites( mu, parity, L[mu]-1, sites );
+}
+
+void MultiGPU_MPI_Subdomain::getHaloSites( int mu, int parity, lat_index_t* sites ) const
+{
+	getPlaneSites( mu, parity, -1, sites );
+}
+
+/**
+ * Sites of the given parity with x_mu = xmu, ordered by the coordinates of the other directions.
+ */
+void MultiGPU_MPI_Subdomain::getPlaneSites( int mu, int parity, int xmu, lat_index_t* sites ) const
+{
+	int n = 0;
+	for( int x = 0; x < L[1]; x++ )
+		for( int y = 0; y < L[2]; y++ )
+			for( int z = 0; z < L[3]; z++ )
+			{
+				int site[Ndim] = { 0, x, y, z };
+				if( site[mu] != 0 ) continue;
+				site[mu] = xmu;
+				if( ( (site[1]+site[2]+site[3])%2+2 )%2 != parity ) continue;
+				sites[n++] = getSiteIndex( site[1], site[2], site[3] );
+			}
+}
+
+#endif /* MULTIGPU_MPI_SUBDOMAIN_HXX_ */
@@ -0,0 +1,197 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Benchmark of the three neighbour access methods in the Landau OR sweep:
+ *  - SiteIndex: neighbour table with latticeSize*2*Ndim indices (used by the gauge fixing applications)
+ *  - SiteIndexCompressed: neighbour table with 16 bit offsets
+ *  - SiteIndexOnTheFly: no table, the neighbours are calculated from precomputed strides
+ *
+ * All three are checked against each other on the host first (FULL_SPLIT and TIMESLICE_SPLIT). Then a hot
+ * configuration is overrelaxed with each method (ormaxiter sweeps of the production kernel
+ * BasicLandauKernelsSU3<KernelStorage<Site> >::orStep) and the sweep throughput and the memory
+ * footprint of the neighbour data are printed. The flops and link accesses per site are counted by running
+ * the kernel with CountingReal on a few blocks.
+ *
+ * make APP=NeighbourBenchmarkSU3_4D X=<x> T=<t>
+ */
+
+#include <iostream>
+#include <math.h>
+#ifndef OSX
+#include "malloc.h"
+#endif
+#include "../GlobalConstants.h"
+#include "../CommonKernelsSU3.hxx"
+#include "../LandauKernelsSU3.hxx"
+#include "../KernelStorage.hxx"
+#include "../../lattice/datatype/CountingReal.hxx"
+#include "../../util/timer/Chronotimer.h"
+#include "program_options/ProgramOptions.hxx"
+
+using namespace std;
+
+const lat_dim_t Ndim = 4;
+const short Nc = 3;
+
+const int arraySize = Nt*Nx*Ny*Nz*Ndim*Nc*Nc*2;
+
+/**
+ * Compares the neighbours of the three methods for all sites and directions, returns the number of mismatches.
+ */
+template<ParityType par> long checkNeighbours()
+{
+	const int latticeSize = Nt*Nx*Ny*Nz;
+	lat_index_t* nn = (lat_index_t*)malloc( latticeSize*(2*(Ndim))*sizeof(lat_index_t) );
+	lat_offset_t* nnCompressed = (lat_offset_t*)malloc( latticeSize*(2*(Ndim))*sizeof(lat_offset_t) );
+
+	SiteIndex<Ndim,par> sTable( HOST_CONSTANTS::SIZE );
+	sTable.calculateNeighbourTable( nn );
+	sTable.nn = nn;
+
+	SiteIndexCompressed<Ndim,par> sCompressed( HOST_CONSTANTS::SIZE );
+	sCompressed.calculateNeighbourTable( nnCompressed );
+	sCompressed.nn = nnCompressed;
+
+	SiteIndexOnTheFly<Ndim,par> sOnTheFly( HOST_CONSTANTS::SIZE );
+
+	long mismatches = 0;
+	for( int i = 0; i < latticeSize; i++ )
+	{
+		for( int mu = 0; mu < Ndim; mu++ )
+		{
+			for( int up = 0; up < 2; up++ )
+			{
+				sTable.setLatticeIndex( i );
+				sTable.setNeighbour( mu, up );
+				sCompressed.setLatticeIndex( i );
+				sCompressed.setNeighbour( mu, up );
+				sOnTheFly.setLatticeIndex( i );
+				sOnTheFly.setNeighbour( mu, up );
+				if( sCompressed.getLatticeIndex() != sTable.getLatticeIndex() || sOnTheFly.getLatticeIndex() != sTable.getLatticeIndex() ) mismatches++;
+			}
+		}
+	}
+
+	free( nn );
+	free( nnCompressed );
+	return mismatches;
+}
+
+/**
+ * Runs the OR sweeps on a fresh copy of the hot configuration and prints the throughput.
+ */
+template<class Site> void benchmark( const char* name, Real* dU, Real* dHot, int sweeps, float orParameter )
+{
+	typedef KernelStorage<Site> Storage;
+	typedef BasicLandauKernelsSU3<Storage> GKernels;
+	typedef typename Storage::Table Table;
+
+	int latticeSize = Nt*Nx*Ny*Nz;
+	int threadsPerBlock = NSB*8;
+	int numBlocks = latticeSize/2/NSB;
+
+	// the neighbour table of the Site class (none for SiteIndexOnTheFly)
+	size_t tableBytes = (size_t)NeighbourTable<Site>::getEntries( latticeSize )*sizeof(Table);
+	Table* dNn = NULL;
+	if( tableBytes > 0 )
+	{
+		Table* nn = (Table*)malloc( tableBytes );
+		NeighbourTable<Site>::calculate( HOST_CONSTANTS::SIZE, nn );
+		cudaMalloc( &dNn, tableBytes );
+		cudaMemcpy( dNn, nn, tableBytes, cudaMemcpyHostToDevice );
+		free( nn );
+	}
+
+	GKernels::initCacheConfig();
+
+	// count the flops and link accesses per site on a few blocks
+	const int countBlocks = 4;
+	cudaMemcpy( dU, dHot, arraySize*sizeof(Real), cudaMemcpyDeviceToDevice );
+	resetDeviceOperationCounts();
+	GKernels::orStep( countBlocks, threadsPerBlock, (CountingReal<Real>*)dU, dNn, 0, orParameter );
+	GKernels::orStep( countBlocks, threadsPerBlock, (CountingReal<Real>*)dU, dNn, 1, orParameter );
+	cudaDeviceSynchronize();
+	OperationCounts counts = getDeviceOperationCounts();
+	double orFlops = (double)counts.getFlops()/(double)(2*countBlocks*NSB);
+	double orBytes = (double)counts.getAccesses()*sizeof(Real)/(double)(2*countBlocks*NSB);
+
+	cudaMemcpy( dU, dHot, arraySize*sizeof(Real), cudaMemcpyDeviceToDevice );
+
+	// warm up
+	GKernels::orStep( numBlocks, threadsPerBlock, dU, dNn, 0, orParameter );
+	GKernels::orStep( numBlocks, threadsPerBlock, dU, dNn, 1, orParameter );
+	cudaDeviceSynchronize();
+
+	Chronotimer timer;
+	timer.reset();
+	timer.start();
+	for( int i = 0; i < sweeps; i++ )
+	{
+		GKernels::orStep( numBlocks, threadsPerBlock, dU, dNn, 0, orParameter );
+		GKernels::orStep( numBlocks, threadsPerBlock, dU, dNn, 1, orParameter );
+	}
+	cudaDeviceSynchronize();
+	timer.stop();
+
+	if( dNn != NULL ) cudaFree( dNn );
+
+	cout << name << ":" << endl;
+	cout << "\tneighbour data: " << (double)tableBytes/1024./1024. << " MB" << endl;
+	cout << "\ttime per sweep: " << timer.getTime()/(double)sweeps*1000. << " ms" << endl;
+	cout << "\tsweeps per second: " << (double)sweeps/timer.getTime() << endl;
+	cout << "\t" << orFlops << " flops and " << orBytes << " bytes (links only) per site and sweep" << endl;
+	cout << "\t" << orFlops*(double)latticeSize*(double)sweeps/timer.getTime()/1.0e9 << " GFlops at "
+			<< orBytes*(double)latticeSize*(double)sweeps/timer.getTime()/1.0e9 << " GB/s memory throughput (links only)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	if( options.getDeviceNumber() >= 0 ) cudaSetDevice( options.getDeviceNumber() );
+
+	const int latticeSize = Nt*Nx*Ny*Nz;
+	const int sweeps = options.getOrMaxIter();
+
+	// all methods have to give the same neighbours
+	long mismatches = checkNeighbours<FULL_SPLIT>();
+	cout << "neighbour mismatches: " << mismatches;
+	long timesliceMismatches = checkNeighbours<TIMESLICE_SPLIT>();
+	cout << " (TIMESLICE_SPLIT: " << timesliceMismatches << ")" << endl;
+	if( mismatches > 0 || timesliceMismatches > 0 ) return 1;
+
+	Real* dU;
+	Real* dHot;
+	cudaMalloc( &dU, arraySize*sizeof(Real) );
+	cudaMalloc( &dHot, arraySize*sizeof(Real) );
+	CommonKernelsSU3::setHot( latticeSize/32,32, dHot, HOST_CONSTANTS::getPtrToDeviceSize(), options.getSeed(), PhiloxWrapper::getNextCounter() );
+
+	cout << "lattice " << Nt << "x" << Nx << "x" << Ny << "x" << Nz << ", " << sweeps << " OR sweeps" << endl;
+	benchmark<SiteIndex<Ndim,FULL_SPLIT> >( "neighbour table (SiteIndex)", dU, dHot, sweeps, options.getOrParameter() );
+	benchmark<SiteIndexCompressed<Ndim,FULL_SPLIT> >( "16 bit offset table (SiteIndexCompressed)", dU, dHot, sweeps, options.getOrParameter() );
+	benchmark<SiteIndexOnTheFly<Ndim,FULL_SPLIT> >( "on the fly (SiteIndexOnTheFly)", dU, dHot, sweeps, options.getOrParameter() );
+
+	cudaFree( dU );
+	cudaFree( dHot );
+}
@@ -0,0 +1,195 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Benchmark of the host random number generator HostPhiloxWrapper.
+ *
+ * First the host streams are checked against PhiloxWrapper on the device: one generator per lattice site
+ * (tid = site, as in the SA kernels) draws an alternating sequence of floats and doubles, the host has to
+ * reproduce every number bit by bit. Then the throughput (random numbers per second) of the host generator
+ * is measured for 1, 4, 8 and 16 lanes in single and double precision, and of the device generator for comparison.
+ *
+ * The lane loops are only vectorized with the matching instruction set, e.g. pass -Xcompiler -march=native to NVCC.
+ *
+ * make APP=PhiloxBenchmark X=<x> T=<t>
+ */
+
+#include <iostream>
+#include <math.h>
+#ifndef OSX
+#include "malloc.h"
+#endif
+#include "../GlobalConstants.h"
+#include "../../lattice/rng/PhiloxWrapper.hxx"
+#include "../../lattice/rng/HostPhiloxWrapper.hxx"
+#include "../../util/timer/Chronotimer.h"
+#include "program_options/ProgramOptions.hxx"
+
+using namespace std;
+
+// random numbers per generator
+const int checkDraws = 24;
+const int benchDraws = 1024;
+
+namespace PHB
+{
+
+// draw i of generator tid: float for i%3 != 1, double for i%3 == 1
+__global__ void generate( double* r, int generators, int seed, unsigned int counter )
+{
+	int tid = blockIdx.x * blockDim.x + threadIdx.x;
+	PhiloxWrapper rng( tid, seed, counter );
+
+	for( int i = 0; i < checkDraws; i++ )
+	{
+		if( i % 3 == 1 ) r[i*generators+tid] = rng.rand<double>();
+		else r[i*generators+tid] = rng.rand<float>();
+	}
+}
+
+template<class T> __global__ void throughput( T* sum, int draws, int seed, unsigned int counter )
+{
+	int tid = blockIdx.x * blockDim.x + threadIdx.x;
+	PhiloxWrapper rng( tid, seed, counter );
+
+	T s = 0;
+	for( int i = 0; i < draws; i++ )
+	{
+		s += rng.rand<T>();
+	}
+	sum[tid] = s;
+}
+
+}
+
+template<int W> long check( const double* r, int generators, int seed, unsigned int counter )
+{
+	long mismatches = 0;
+	for( int tid = 0; tid < generators; tid += W )
+	{
+		HostPhiloxWrapper<W> rng( tid, seed, counter );
+		for( int i = 0; i < checkDraws; i++ )
+		{
+			if( i % 3 == 1 )
+			{
+				double d[W];
+				rng.rand( d );
+				for( int l = 0; l < W; l++ ) if( d[l] != r[i*generators+tid+l] ) mismatches++;
+			}
+			else
+			{
+				float f[W];
+				rng.rand( f );
+				for( int l = 0; l < W; l++ ) if( (double)f[l] != r[i*generators+tid+l] ) mismatches++;
+			}
+		}
+	}
+	return mismatches;
+}
+
+/**
+ * Returns random numbers per second of the host generator with W lanes.
+ */
+template<int W, class T> double hostThroughput( int generators, int seed, unsigned int counter )
+{
+	Chronotimer timer;
+	timer.reset();
+	timer.start();
+
+	T sum = 0;
+	for( int tid = 0; tid < generators; tid += W )
+	{
+		HostPhiloxWrapper<W> rng( tid, seed, counter );
+		T r[W];
+		T s[W];
+		for( int l = 0; l < W; l++ ) s[l] = 0;
+
+		for( int i = 0; i < benchDraws; i++ )
+		{
+			rng.rand( r );
+			for( int l = 0; l < W; l++ ) s[l] += r[l];
+		}
+		for( int l = 0; l < W; l++ ) sum += s[l];
+	}
+	timer.stop();
+
+	// the mean has to be 1/2
+	if( fabs( sum/(double)generators/(double)benchDraws - .5 ) > 1e-2 ) cout << "unexpected mean " << sum/(double)generators/(double)benchDraws << endl;
+	return (double)generators*(double)benchDraws/timer.getTime();
+}
+
+template<class T> double deviceThroughput( int generators, int seed, unsigned int counter )
+{
+	T* dSum;
+	cudaMalloc( &dSum, generators*sizeof(T) );
+
+	// warm up
+	PHB::throughput<T><<<generators/32,32>>>( dSum, benchDraws, seed, counter );
+	cudaDeviceSynchronize();
+
+	Chronotimer timer;
+	timer.reset();
+	timer.start();
+	PHB::throughput<T><<<generators/32,32>>>( dSum, benchDraws, seed, counter );
+	cudaDeviceSynchronize();
+	timer.stop();
+
+	cudaFree( dSum );
+	return (double)generators*(double)benchDraws/timer.getTime();
+}
+
+int main(int argc, char* argv[])
+{
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+
+	if( options.getDeviceNumber() >= 0 ) cudaSetDevice( options.getDeviceNumber() );
+
+	// one generator per lattice site
+	const int generators = Nt*Nx*Ny*Nz;
+	const int seed = options.getSeed();
+	const unsigned int counter = PhiloxWrapper::getNextCounter();
+
+	// compare host and device streams
+	double* r = (double*)malloc( checkDraws*generators*sizeof(double) );
+	double* dR;
+	cudaMalloc( &dR, checkDraws*generators*sizeof(double) );
+	PHB::generate<<<generators/32,32>>>( dR, generators, seed, counter );
+	cudaMemcpy( r, dR, checkDraws*generators*sizeof(double), cudaMemcpyDeviceToHost );
+
+	long mismatches = check<1>( r, generators, seed, counter ) + check<4>( r, generators, seed, counter )
+			+ check<8>( r, generators, seed, counter ) + check<16>( r, generators, seed, counter );
+	cout << "host vs. device streams: " << mismatches << " mismatches in " << 4L*checkDraws*generators << " numbers" << endl;
+
+	cout << "random numbers per second (" << generators << " generators x " << benchDraws << " numbers):" << endl;
+	cout << "lanes\t\tfloat\t\tdouble" << endl;
+	cout << "1\t\t" << hostThroughput<1,float>( generators, seed, counter ) << "\t" << hostThroughput<1,double>( generators, seed, counter ) << endl;
+	cout << "4\t\t" << hostThroughput<4,float>( generators, seed, counter ) << "\t" << hostThroughput<4,double>( generators, seed, counter ) << endl;
+	cout << "8\t\t" << hostThroughput<8,float>( generators, seed, counter ) << "\t" << hostThroughput<8,double>( generators, seed, counter ) << endl;
+	cout << "16\t\t" << hostThroughput<16,float>( generators, seed, counter ) << "\t" << hostThroughput<16,double>( generators, seed, counter ) << endl;
+	cout << "device\t\t" << deviceThroughput<float>( generators, seed, counter ) << "\t" << deviceThroughput<double>( generators, seed, counter ) << endl;
+
+	cudaFree( dR );
+	free( r );
+
+	return ( mismatches == 0 )?(0):(1);
+}
@@ -0,0 +1,502 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Time to solution of Landau gauge fixing pipelines.
+ *
+ * For --nconf synthetic (hot) configurations and --gaugecopies random gauge copies per configuration (all with
+ * fixed seeds derived from --seed) each pipeline of --pipelines is run from the same starting field. A pipeline is
+ * a sequence of stages separated by '+', the pipelines are separated by ';':
+ *  - sa[N]      simulated annealing with N steps (default --sasteps) from --samax to --samin, --microupdates
+ *  - sr[N][@p]  stochastic relaxation, at most N iterations (default --srmaxiter) with parameter p (--srparameter)
+ *  - or[N][@p]  overrelaxation, at most N iterations (default --ormaxiter) with parameter p (--orparameter)
+ *  - micro[N]   microcanonical updates, N steps (default --ormaxiter)
+ * SR and OR stop as soon as dA < --precision (checked every --checkprecision iterations), SA and micro run all steps.
+ * Example: --pipelines "or;or@1.8;sa1000+or;sa4000+or;sa1000+sr200+or"
+ *
+ * The time to solution is the wall clock time from the random gauge transformation until dA < --precision. Per
+ * pipeline the table lists
+ *  - solved:   the fraction of the copies that reached --precision
+ *  - tts:      the mean time to solution of the solved copies
+ *  - sweeps:   the mean number of sweeps (all stages) per copy
+ *  - GFlop:    the mean compute per copy
+ *  - best gff: the mean (over the configurations) of the best functional of the copies
+ *  - best hit: the fraction of the configurations where the pipeline found the best functional of all pipelines
+ *  - gff/TFlop: the mean functional gained per TFlop (over the functional after the random gauge transformation)
+ * Run it for each lattice size (make APP=TimeToSolutionLandauSU3_4D X=<x> T=<t>) to choose the production settings.
+ * With --benchmarkfile the results per copy are written as CSV (pipeline,lattice,config,copy,solved,time,sweeps,
+ * gflop,gff,dA), files of several lattice sizes can be concatenated.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <math.h>
+#ifndef OSX
+#include "malloc.h"
+#endif
+#include "../GlobalConstants.h"
+#include "../GaugeFixingStats.hxx"
+#include "../../lattice/access_pattern/GpuPattern.hxx"
+#include "../../lattice/SiteCoord.hxx"
+#include "../../lattice/SiteIndex.hxx"
+#include "../../util/timer/ScopedTimer.hxx"
+#include "../LandauKernelsSU3.hxx"
+#include "../LandauKernelCounter.hxx"
+#include "../CommonKernelsSU3.hxx"
+#include "program_options/ProgramOptions.hxx"
+
+using namespace std;
+
+const lat_dim_t Ndim = 4;
+const short Nc = 3;
+
+const int arraySize = Nt*Nx*Ny*Nz*Ndim*Nc*Nc*2;
+
+namespace TTS
+{
+
+enum StageType { SA, SR, OR, MICRO };
+
+struct Stage
+{
+	StageType type;
+	int steps;
+	float parameter;
+};
+
+struct Pipeline
+{
+	std::string name;
+	std::vector<Stage> stages;
+};
+
+/**
+ * Flops per site and sweep of the updates (counted with LandauKernelCounter).
+ */
+struct FlopCounts
+{
+	double hb;
+	double micro;
+	double overrelax;
+	double sr;
+};
+
+/**
+ * Result of a pipeline on a gauge copy.
+ */
+struct Run
+{
+	bool solved;
+	double time;
+	long sweeps;
+	double flops;
+	double gff;
+	double dA;
+};
+
+/**
+ * Parses a stage "sa1000", "or@1.8", "sr200@1.5", ...; returns false for an unknown stage.
+ */
+bool parseStage( std::string token, const ProgramOptions& options, Stage& stage )
+{
+	std::string name = token;
+	std::string steps;
+	std::string parameter;
+	size_t at = token.find( '@' );
+	if( at != std::string::npos )
+	{
+		parameter = token.substr( at+1 );
+		name = token.substr( 0, at );
+	}
+	size_t digit = name.find_first_of( "0123456789" );
+	if( digit != std::string::npos )
+	{
+		steps = name.substr( digit );
+		name = name.substr( 0, digit );
+	}
+
+	if( name == "sa" )
+	{
+		stage.type = SA;
+		stage.steps = options.getSaSteps();
+		stage.parameter = 0;
+	}
+	else if( name == "sr" )
+	{
+		stage.type = SR;
+		stage.steps = options.getSrMaxIter();
+		stage.parameter = options.getSrParameter();
+	}
+	else if( name == "or" )
+	{
+		stage.type = OR;
+		stage.steps = options.getOrMaxIter();
+		stage.parameter = options.getOrParameter();
+	}
+	else if( name == "micro" )
+	{
+		stage.type = MICRO;
+		stage.steps = options.getOrMaxIter();
+		stage.parameter = 0;
+	}
+	else
+	{
+		return false;
+	}
+
+	if( steps.size() > 0 ) stage.steps = atoi( steps.c_str() );
+	if( parameter.size() > 0 ) stage.parameter = atof( parameter.c_str() );
+	return true;
+}
+
+bool parsePipelines( std::string list, const ProgramOptions& options, std::vector<Pipeline>& pipelines )
+{
+	std::stringstream pipelineStream( list );
+	std::string pipelineToken;
+	while( getline( pipelineStream, pipelineToken, ';' ) )
+	{
+		if( pipelineToken.size() == 0 ) continue;
+		Pipeline pipeline;
+		pipeline.name = pipelineToken;
+
+		std::stringstream stageStream( pipelineToken );
+		std::string stageToken;
+		while( getline( stageStream, stageToken, '+' ) )
+		{
+			Stage stage;
+			if( !parseStage( stageToken, options, stage ) )
+			{
+				cout << "Unknown stage " << stageToken << " in pipeline " << pipelineToken << " (sa, sr, or, micro)." << endl;
+				return false;
+			}
+			pipeline.stages.push_back( stage );
+		}
+		pipelines.push_back( pipeline );
+	}
+	return pipelines.size() > 0;
+}
+
+/**
+ * Runs a pipeline on the field dU (a random gauge copy of the configuration) until dA < --precision.
+ * The time includes the quality checks (they are part of the time to solution).
+ */
+Run runPipeline( const Pipeline& pipeline, Real* dU, GaugeFixingStats<Ndim,Nc,LandauKernelsSU3,AVERAGE>& stats, lat_index_t* dNn, int latticeSize, long seed, const FlopCounts& flops, const ProgramOptions& options )
+{
+	int threadsPerBlock = NSB*8; // NSB sites are updated within a block (8 threads are needed per site)
+	int numBlocks = latticeSize/2/NSB; // half of the lattice sites (a parity) are updated in a kernel call
+
+	Run run;
+	run.solved = false;
+	run.sweeps = 0;
+	run.flops = 0;
+
+	ScopedTimer timer( "pipeline" );
+	for( unsigned int st = 0; st < pipeline.stages.size() && !run.solved; st++ )
+	{
+		const Stage& stage = pipeline.stages[st];
+		switch( stage.type )
+		{
+		case SA:
+		{
+			ScopedTimer saTimer( "SA" );
+			float temperature = options.getSaMax();
+			float tempStep = (options.getSaMax()-options.getSaMin())/(float)stage.steps;
+			for( int i = 0; i < stage.steps; i++ )
+			{
+				LandauKernelsSU3::saStep(numBlocks,threadsPerBlock,dU, dNn, 0, temperature, seed, PhiloxWrapper::getNextCounter() );
+				LandauKernelsSU3::saStep(numBlocks,threadsPerBlock,dU, dNn, 1, temperature, seed, PhiloxWrapper::getNextCounter() );
+				for( int mic = 0; mic < options.getSaMicroupdates(); mic++ )
+				{
+					LandauKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 0 );
+					LandauKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 1 );
+				}
+				if( i % options.getReproject() == 0 )
+				{
+					CommonKernelsSU3::projectSU3( latticeSize/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+				}
+				temperature -= tempStep;
+			}
+			run.sweeps += stage.steps;
+			run.flops += (flops.hb+flops.micro*options.getSaMicroupdates())*(double)latticeSize*(double)stage.steps;
+			break;
+		}
+		case MICRO:
+		{
+			ScopedTimer microTimer( "micro" );
+			for( int i = 0; i < stage.steps; i++ )
+			{
+				LandauKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 0 );
+				LandauKernelsSU3::microStep(numBlocks,threadsPerBlock,dU, dNn, 1 );
+				if( i % options.getReproject() == 0 )
+				{
+					CommonKernelsSU3::projectSU3( latticeSize/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+				}
+			}
+			run.sweeps += stage.steps;
+			run.flops += flops.micro*(double)latticeSize*(double)stage.steps;
+			break;
+		}
+		case SR:
+		case OR:
+		{
+			ScopedTimer relaxTimer( (stage.type==SR)?("SR"):("OR") );
+			double stageFlops = (stage.type==SR)?(flops.sr):(flops.overrelax);
+			int i;
+			for( i = 0; i < stage.steps; i++ )
+			{
+				if( i % options.getCheckPrecision() == 0 )
+				{
+					stats.generateGaugeQuality();
+					if( stats.getCurrentA() < options.getPrecision() )
+					{
+						run.solved = true;
+						break;
+					}
+				}
+
+				if( stage.type == SR )
+				{
+					LandauKernelsSU3::srStep(numBlocks,threadsPerBlock,dU, dNn, 0, stage.parameter, seed, PhiloxWrapper::getNextCounter() );
+					LandauKernelsSU3::srStep(numBlocks,threadsPerBlock,dU, dNn, 1, stage.parameter, seed, PhiloxWrapper::getNextCounter() );
+				}
+				else
+				{
+					LandauKernelsSU3::orStep(numBlocks,threadsPerBlock,dU, dNn, 0, stage.parameter );
+					LandauKernelsSU3::orStep(numBlocks,threadsPerBlock,dU, dNn, 1, stage.parameter );
+				}
+
+				if( i % options.getReproject() == 0 )
+				{
+					CommonKernelsSU3::projectSU3( latticeSize/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+				}
+			}
+			run.sweeps += i;
+			run.flops += stageFlops*(double)latticeSize*(double)i;
+			break;
+		}
+		}
+	}
+
+	// the final state (the quality kernel synchronizes)
+	CommonKernelsSU3::projectSU3( latticeSize/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+	stats.generateGaugeQuality();
+	run.time = timer.stop();
+	run.gff = stats.getCurrentGff();
+	run.dA = stats.getCurrentA();
+	run.solved = run.solved || ( run.dA < options.getPrecision() );
+	return run;
+}
+
+/**
+ * Prints the summary table, runs[p][c*copies+k] is the run of pipeline p on copy k of configuration c.
+ */
+void printTable( const std::vector<Pipeline>& pipelines, const std::vector<std::vector<Run> >& runs, const std::vector<std::vector<double> >& startGff, int configs, int copies )
+{
+	// the best functional of a configuration over all pipelines
+	std::vector<double> bestOfAll( configs, -1. );
+	for( unsigned int p = 0; p < pipelines.size(); p++ )
+	{
+		for( int c = 0; c < configs; c++ )
+		{
+			for( int k = 0; k < copies; k++ )
+			{
+				if( runs[p][c*copies+k].gff > bestOfAll[c] ) bestOfAll[c] = runs[p][c*copies+k].gff;
+			}
+		}
+	}
+
+	cout << endl << "TIME TO SOLUTION (lattice " << Nt << "x" << Nx << "x" << Ny << "x" << Nz << ", " << configs << " configurations x " << copies << " copies)" << endl;
+	cout << left << setw(32) << "pipeline" << right << setw(8) << "solved" << setw(12) << "tts [s]" << setw(10) << "sweeps"
+			<< setw(12) << "GFlop" << setw(16) << "best gff" << setw(10) << "best hit" << setw(12) << "gff/TFlop" << endl;
+
+	for( unsigned int p = 0; p < pipelines.size(); p++ )
+	{
+		int solved = 0;
+		double tts = 0;
+		double sweeps = 0;
+		double flops = 0;
+		double bestGff = 0;
+		int hits = 0;
+		double gain = 0;
+		for( int c = 0; c < configs; c++ )
+		{
+			double best = -1.;
+			for( int k = 0; k < copies; k++ )
+			{
+				const Run& run = runs[p][c*copies+k];
+				if( run.solved )
+				{
+					solved++;
+					tts += run.time;
+				}
+				sweeps += run.sweeps;
+				flops += run.flops;
+				if( run.flops > 0 ) gain += ( run.gff-startGff[c][k] )/( run.flops*1e-12 );
+				if( run.gff > best ) best = run.gff;
+			}
+			bestGff += best;
+			if( best >= bestOfAll[c]-1e-10 ) hits++;
+		}
+
+		int n = configs*copies;
+		cout << left << setw(32) << pipelines[p].name << right << fixed
+				<< setw(7) << setprecision(0) << 100.*(double)solved/(double)n << "%"
+				<< setw(12) << setprecision(4) << ( (solved>0)?(tts/(double)solved):(0.) )
+				<< setw(10) << setprecision(0) << sweeps/(double)n
+				<< setw(12) << setprecision(2) << flops/(double)n*1e-9
+				<< setw(16) << setprecision(10) << bestGff/(double)configs
+				<< setw(9) << setprecision(0) << 100.*(double)hits/(double)configs << "%"
+				<< setw(12) << setprecision(4) << gain/(double)n << endl;
+		cout.unsetf( ios::fixed );
+	}
+	cout << setprecision(6);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	LandauKernelsSU3::initCacheConfig();
+	CommonKernelsSU3::initCacheConfig();
+
+	// read configuration from file or command line
+	ProgramOptions options;
+	int returncode = options.init( argc, argv );
+	if( returncode != 0 ) return returncode;
+	if( options.isProfile() ) Profiler::enable();
+
+	std::vector<TTS::Pipeline> pipelines;
+	if( !TTS::parsePipelines( options.getPipelines(), options, pipelines ) )
+	{
+		cout << "No valid pipeline in --pipelines " << options.getPipelines() << ". Exiting..." << endl;
+		return 1;
+	}
+
+	// Choose device and print device infos
+	cudaDeviceProp deviceProp;
+	int selectedDeviceNumber;
+	if( options.getDeviceNumber() >= 0 )
+	{
+		cudaSetDevice( options.getDeviceNumber() );
+		selectedDeviceNumber = options.getDeviceNumber();
+	}
+	else
+	{
+		cudaGetDevice( &selectedDeviceNumber );
+	}
+	cudaGetDeviceProperties(&deviceProp, selectedDeviceNumber );
+
+	printf("\nDevice %d: \"%s\"\n", selectedDeviceNumber, deviceProp.name);
+	printf("CUDA Capability Major/Minor version number:    %d.%d\n\n", deviceProp.major, deviceProp.minor);
+
+	SiteCoord<4,FULL_SPLIT> s(HOST_CONSTANTS::SIZE);
+	const int latticeSize = s.getLatticeSize();
+
+	// device memory: the synthetic configuration and the working field
+	Real* dUPristine;
+	Real* dU;
+	cudaMalloc( &dUPristine, arraySize*sizeof(Real) );
+	cudaMalloc( &dU, arraySize*sizeof(Real) );
+
+	// neighbour table for SiteIndex (this is used in device code)
+	lat_index_t* nn = (lat_index_t*)malloc( latticeSize*(2*(Ndim))*sizeof(lat_index_t) );
+	lat_index_t *dNn;
+	cudaMalloc( &dNn, latticeSize*(2*(Ndim))*sizeof( lat_index_t ) );
+	SiteIndex<4,FULL_SPLIT> sTemp( HOST_CONSTANTS::SIZE );
+	sTemp.calculateNeighbourTable( nn );
+	cudaMemcpy( dNn, nn, latticeSize*(2*(Ndim))*sizeof( lat_index_t ), cudaMemcpyHostToDevice );
+
+	GaugeFixingStats<Ndim,Nc,LandauKernelsSU3,AVERAGE> stats( dU, HOST_CONSTANTS::SIZE );
+
+	// flops per site and sweep, counted from the kernels (the heatbath at the mean SA temperature)
+	TTS::FlopCounts flops;
+	{
+		LandauKernelCounter<Real> counter( dNn, latticeSize );
+		flops.hb = counter.saStep( .5*(options.getSaMax()+options.getSaMin()) ).getFlops();
+		flops.micro = counter.microStep().getFlops();
+		flops.overrelax = counter.orStep( options.getOrParameter() ).getFlops();
+		flops.sr = counter.srStep( options.getSrParameter() ).getFlops();
+	}
+
+	const int configs = options.getNconf();
+	const int copies = options.getGaugeCopies();
+	std::vector<std::vector<TTS::Run> > runs( pipelines.size(), std::vector<TTS::Run>( configs*copies ) );
+	std::vector<std::vector<double> > startGff( configs, std::vector<double>( copies ) );
+
+	ofstream csv;
+	if( options.getBenchmarkFile().size() > 0 )
+	{
+		csv.open( options.getBenchmarkFile().c_str() );
+		csv << "pipeline,lattice,config,copy,solved,time,sweeps,gflop,gff,dA" << endl;
+		csv.precision( 12 );
+	}
+
+	ScopedTimer allTimer( "total" );
+	for( int c = 0; c < configs; c++ )
+	{
+		// the synthetic configuration, the random gauge copies and the random numbers of the stages only depend on
+		// --seed, c and k: each copy gets its own range of 2^20 counters, all pipelines start from the same copy
+		const long seed = options.getSeed()+c;
+		PhiloxWrapper::setCounter( 0 );
+		CommonKernelsSU3::setHot( latticeSize/32,32, dUPristine, HOST_CONSTANTS::getPtrToDeviceSize(), seed, PhiloxWrapper::getNextCounter() );
+
+		for( int k = 0; k < copies; k++ )
+		{
+			for( unsigned int p = 0; p < pipelines.size(); p++ )
+			{
+				PhiloxWrapper::setCounter( (k+1) << 20 );
+				cudaMemcpy( dU, dUPristine, arraySize*sizeof(Real), cudaMemcpyDeviceToDevice );
+				LandauKernelsSU3::randomTrafo(latticeSize/2/NSB,NSB*8,dU, dNn, 0, seed, PhiloxWrapper::getNextCounter() );
+				LandauKernelsSU3::randomTrafo(latticeSize/2/NSB,NSB*8,dU, dNn, 1, seed, PhiloxWrapper::getNextCounter() );
+				if( p == 0 )
+				{
+					stats.generateGaugeQuality();
+					startGff[c][k] = stats.getCurrentGff();
+				}
+				cudaDeviceSynchronize();
+
+				TTS::Run run = TTS::runPipeline( pipelines[p], dU, stats, dNn, latticeSize, seed, flops, options );
+				runs[p][c*copies+k] = run;
+
+				printf( "config %d copy %d %-24s %s in %f s, %ld sweeps, gff %1.10f, dA %e\n", c, k, pipelines[p].name.c_str(),
+						(run.solved)?("solved"):("NOT solved"), run.time, run.sweeps, run.gff, run.dA );
+				if( csv.is_open() )
+				{
+					csv << "\"" << pipelines[p].name << "\"," << Nt << "x" << Nx << "x" << Ny << "x" << Nz << "," << c << "," << k << ","
+							<< run.solved << "," << run.time << "," << run.sweeps << "," << run.flops*1e-9 << "," << run.gff << "," << run.dA << endl;
+				}
+			}
+		}
+	}
+	allTimer.stop();
+
+	TTS::printTable( pipelines, runs, startGff, configs, copies );
+	cout << endl << "total time: " << allTimer.getTime() << " s" << endl;
+
+	cudaFree( dUPristine );
+	cudaFree( dU );
+	cudaFree( dNn );
+	free( nn );
+}
@@ -33,6 +33,7 @@
 #include "../../lattice/SiteCoord.hxx"
 #include "../../lattice/SiteIndex.hxx"
 #include "../../util/timer/Chronotimer.h"
+#include "../../util/metrics/PhaseMetrics.hxx"
 #include "../../lattice/filetypes/FileHeaderOnly.hxx"
 #include "../../lattice/filetypes/FilePlain.hxx"
 #include "../../lattice/filetypes/FileVogt.hxx"
@@ -40,6 +41,7 @@
 #include "../../lattice/LinkFile.hxx"
 // #include "../LandauKernelsSU3.hxx"
 #include "../U1xU1KernelsSU3.hxx"
+#include "../LandauKernelCounter.hxx"
 #include "../CommonKernelsSU3.hxx"
 #include "program_options/ProgramOptions.hxx"
 #include "program_options/FileIterator.hxx"
@@ -60,6 +62,15 @@ void writeILDG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const char *out
 bool readQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *file_name, const short SIZE[4], Real *U);
 bool writeQCDSTAG(SiteCoord<4,FULL_SPLIT> s, const char *output_name, const short SIZE[4], Real *U);
 
+/**
+ * Calculates the gauge quality, the metrics take the device time of the measurement (GaugeFixingStats::setTiming()).
+ */
+template<class Stats> void generateGaugeQuality( Stats& stats, PhaseMetrics& metrics )
+{
+	stats.generateGaugeQuality();
+	metrics.add( PhaseMetrics::QUALITY, 0, stats.getQualityTime(), 1 );
+}
+
 int main(int argc, char* argv[])
 {
 	Chronotimer allTimer;
@@ -73,6 +84,8 @@ int main(int argc, char* argv[])
 	int returncode = options.init( argc, argv );
 	if( returncode != 0 ) return returncode;
 
+	PhaseMetrics metrics( options.getMetricsFile(), options.getMetricsFormat() );
+
 	// Choose device and print device infos
 	cudaDeviceProp deviceProp;
 	int selectedDeviceNumber;
@@ -126,6 +139,23 @@ int main(int argc, char* argv[])
 	int numBlocks = s.getLatticeSize()/2/NSB; // // half of the lattice sites (a parity) are updated in a kernel call
 
 	GaugeFixingStats<Ndim,Nc,U1xU1KernelsSU3,AVERAGE> gaugeStats( dU, HOST_CONSTANTS::SIZE );
+	gaugeStats.setTiming( metrics.isEnabled() );
+
+	// flops and bytes per site and sweep, counted from the kernels (the heatbath at the mean SA temperature)
+	double saFlops, saBytes, orFlops, orBytes;
+	{
+		LandauKernelCounter<Real,U1xU1KernelsSU3> counter( dNn, s.getLatticeSize() );
+		KernelCount hbCount = counter.saStep( .5*(options.getSaMax()+options.getSaMin()) );
+		KernelCount microCount = counter.microStep();
+		KernelCount orCount = counter.orStep( options.getOrParameter() );
+		LandauKernelCounter<Real>::print( cout, "heatbath", hbCount );
+		LandauKernelCounter<Real>::print( cout, "micro", microCount );
+		LandauKernelCounter<Real>::print( cout, "OR", orCount );
+		saFlops = hbCount.getFlops()+options.getSaMicroupdates()*microCount.getFlops();
+		saBytes = hbCount.getBytes()+options.getSaMicroupdates()*microCount.getBytes();
+		orFlops = orCount.getFlops();
+		orBytes = orCount.getBytes();
+	}
 
 	// timer to measure kernel times
 	Chronotimer kernelTimer;
@@ -136,10 +166,12 @@ int main(int argc, char* argv[])
 	long orTotalStepnumber = 0;
 	double saTotalKernelTime = 0;
 
+	int config = 0;
 	FileIterator fi( options );
-	for( fi.reset(); fi.hasNext(); fi.next() )
+	for( fi.reset(); fi.hasNext(); fi.next(), config++ )
 	{
 		bool loadOk;
+		metrics.beginConfig( config, (options.isSetHot())?(""):(fi.getFilename()) );
 
 		// ofstream output;
 		// output.precision(17);
@@ -148,6 +180,9 @@ int main(int argc, char* argv[])
 
 		if( !options.isSetHot() ) // load a file
 		{
+			Chronotimer loadTimer;
+			loadTimer.reset();
+			loadTimer.start();
 			//cout << "loading " << fi.getFilename() << " as " << options.getFType() << endl;
 			switch( options.getFType() )
 			{
@@ -181,6 +216,8 @@ int main(int argc, char* argv[])
 			{
 				cout << "File loaded." << endl;
 			}
+			loadTimer.stop();
+			metrics.addConfig( PhaseMetrics::LOAD, loadTimer.getTime(), 0, 0, (double)arraySize*sizeof(Real) );
 		}
 		else // or initialize with a hot configuration (ignore file options)
 		{
@@ -190,6 +227,7 @@ int main(int argc, char* argv[])
 		double bestGff = 0.0;
 		for( int copy = 0; copy < options.getGaugeCopies(); copy++ )
 		{
+			metrics.beginCopy( copy );
 			// we copy from host in every gaugecopy step to have a cleaner configuration (concerning numerical errors)
 			// it would be best to keep a completely clean copy on host side
 			if( !options.isSetHot() ) cudaMemcpy( dU, U, arraySize*sizeof(Real), cudaMemcpyHostToDevice );
@@ -204,7 +242,7 @@ int main(int argc, char* argv[])
 
 			// calculate and print the gauge quality
 			printf( "i:\t\tgff:\t\tdA:\n");
-			gaugeStats.generateGaugeQuality();
+			generateGaugeQuality( gaugeStats, metrics );
 			printf( "   \t\t%1.10f\t\t%e\n", gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
 
 
@@ -238,11 +276,12 @@ int main(int argc, char* argv[])
 				if( i % options.getReproject() == 0 )
 				{
 					CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+					metrics.add( PhaseMetrics::REPROJECT, 0, 0, 1 );
 				}
 
 				if( i % options.getCheckPrecision() == 0 )
 				{
-					gaugeStats.generateGaugeQuality();
+					generateGaugeQuality( gaugeStats, metrics );
 					printf( "%d\t\t%1.10f\t\t%e\n", i, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
 					// output<<temperature<<","<<gaugeStats.getCurrentGff()<<endl;
 				}
@@ -253,9 +292,11 @@ int main(int argc, char* argv[])
 			kernelTimer.stop();
 			cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
 			saTotalKernelTime += kernelTimer.getTime();
+			metrics.add( PhaseMetrics::SA, 0, kernelTimer.getTime(), i, saFlops*s.getLatticeSize()*i, saBytes*s.getLatticeSize()*i );
 
 			// OVERRELAXATION
 			if( options.getOrMaxIter() > 0 ) printf( "OVERRELAXATION\n" );
+			long orSteps = 0;
 			kernelTimer.reset();
 			kernelTimer.start();
 			for( int i = 0; i < options.getOrMaxIter(); i++ )
@@ -266,26 +307,38 @@ int main(int argc, char* argv[])
 				if( i % options.getReproject() == 0 )
 				{
 					CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+					metrics.add( PhaseMetrics::REPROJECT, 0, 0, 1 );
 				}
 
 				if( i % options.getCheckPrecision() == 0 )
 				{
-					gaugeStats.generateGaugeQuality();
+					generateGaugeQuality( gaugeStats, metrics );
 					printf( "%d\t\t%1.10f\t\t%e\n", i, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
 					if( gaugeStats.getCurrentA() < options.getPrecision() ) break;
 				}
 
 				orTotalStepnumber++;
+				orSteps++;
 			}
 
 			cudaDeviceSynchronize();
 			kernelTimer.stop();
 			cout << "kernel time: " << kernelTimer.getTime() << " s"<< endl;
 			orTotalKernelTime += kernelTimer.getTime();
+			if( options.getOrMaxIter() > 0 )
+			{
+				metrics.add( PhaseMetrics::OR, 0, kernelTimer.getTime(), orSteps, orFlops*s.getLatticeSize()*orSteps, orBytes*s.getLatticeSize()*orSteps );
+			}
 
 
 			// reconstruct third line
+			kernelTimer.reset();
+			kernelTimer.start();
 			CommonKernelsSU3::projectSU3( s.getLatticeSize()/32,32, dU, HOST_CONSTANTS::getPtrToDeviceSize() );
+			if( metrics.isEnabled() ) cudaDeviceSynchronize();
+			kernelTimer.stop();
+			metrics.add( PhaseMetrics::REPROJECT, 0, kernelTimer.getTime(), 1 );
+			metrics.setResult( 0, gaugeStats.getCurrentGff(), gaugeStats.getCurrentA() );
 
 			// check for best copy
 			if( gaugeStats.getCurrentGff() > bestGff )
@@ -305,6 +358,9 @@ int main(int argc, char* argv[])
 		//saving file
 		if( !options.isSetHot() )
 		{
+			Chronotimer saveTimer;
+			saveTimer.reset();
+			saveTimer.start();
 			cout << "saving " << fi.getOutputFilename() << " as " << options.getFType() << endl;
 			switch( options.getFType() )
 			{
@@ -328,19 +384,19 @@ int main(int argc, char* argv[])
 				cout << "Filetype not set to a known value. Exiting";
 				exit(1);
 			}
+			saveTimer.stop();
+			metrics.addConfig( PhaseMetrics::SAVE, saveTimer.getTime(), 0, 0, (double)arraySize*sizeof(Real) );
 		}
 	}
+	metrics.flush();
 
 	allTimer.stop();
 	cout << "total time: " << allTimer.getTime() << " s" << endl;
 
-	long hbFlops = 2252+86;
-	long microFlops = 2252+14;
-	cout << "Simulated Annealing (HB+Micro): " << (double)((long)(hbFlops+microFlops*options.getSaMicroupdates())*(long)s.getLatticeSize()*(long)options.getSaSteps()*(long)options.getGaugeCopies())/saTotalKernelTime/1.0e9 << " GFlops at "
-					<< (double)((long)192*(long)s.getLatticeSize()*options.getSaSteps()*(options.getSaMicroupdates()+1)*(long)sizeof(Real))/saTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	cout << "Simulated Annealing (HB+Micro): " << saFlops*(double)s.getLatticeSize()*(double)options.getSaSteps()*(double)options.getGaugeCopies()/saTotalKernelTime/1.0e9 << " GFlops at "
+					<< saBytes*(double)s.getLatticeSize()*(double)options.getSaSteps()/saTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
 
-	long orFlops = 2252+22;
-	cout << "Overrelaxation: " << (double)((long)orFlops*(long)s.getLatticeSize()*(long)orTotalStepnumber)/orTotalKernelTime/1.0e9 << " GFlops at "
-				<< (double)((long)192*(long)s.getLatticeSize()*(long)(orTotalStepnumber)*(long)sizeof(Real))/orTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
+	cout << "Overrelaxation: " << orFlops*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << " GFlops at "
+				<< orBytes*(double)s.getLatticeSize()*(double)orTotalStepnumber/orTotalKernelTime/1.0e9 << "GB/s memory throughput." << endl;
 
 }
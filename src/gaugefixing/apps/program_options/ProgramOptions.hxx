@@ -28,6 +28,7 @@
 #include <boost/program_options/options_description.hpp>
 
 #include "../../../lattice/filetypes/filetype_typedefs.h"
+#include "../../../util/log/Logger.hxx"
 
 #include <fstream>
 #include <string>
@@ -75,6 +76,58 @@ public:
 		return gaugeCopies;
 	}
 
+	int getConcurrentCopies() const {
+		return concurrentCopies;
+	}
+
+	int getBatchSize() const {
+		return batchSize;
+	}
+
+	std::string getHostLayout() const {
+		return hostLayout;
+	}
+
+	std::string getTuningFile() const {
+		return tuningFile;
+	}
+
+	int getTuneSweeps() const {
+		return tuneSweeps;
+	}
+
+	bool isEarlyStop() const {
+		return earlyStop;
+	}
+
+	float getEarlyStopMargin() const {
+		return earlyStopMargin;
+	}
+
+	int getReplicas() const {
+		return replicas;
+	}
+
+	int getReSweeps() const {
+		return reSweeps;
+	}
+
+	int getReRounds() const {
+		return reRounds;
+	}
+
+	std::string getCheckpointFile() const {
+		return checkpointFile;
+	}
+
+	int getCheckpointInterval() const {
+		return checkpointInterval;
+	}
+
+	bool isRestart() const {
+		return restart;
+	}
+
 	bool isSetHot() const {
 		return setHot;
 	}
@@ -111,6 +164,14 @@ public:
 		return precision;
 	}
 
+	float getSpPrecision() const {
+		return spPrecision;
+	}
+
+	std::string getRealType() const {
+		return realType;
+	}
+
 	ReinterpretReal getReinterpret() const {
 		return reinterpret;
 	}
@@ -159,6 +220,54 @@ public:
 		return doSA;
 	}
 
+	std::string getMetricsFile() const {
+		return metricsFile;
+	}
+
+	std::string getMetricsFormat() const {
+		return metricsFormat;
+	}
+
+	bool isProfile() const {
+		return profile;
+	}
+
+	std::string getTraceFile() const {
+		return traceFile;
+	}
+
+	std::string getTraceCsv() const {
+		return traceCsv;
+	}
+
+	util::LOGLEVEL getLogLevel() const {
+		if( logLevel == "debug" ) return util::DEBUG;
+		else if( logLevel == "warn" ) return util::WARN;
+		else if( logLevel == "error" ) return util::ERROR;
+		else if( logLevel == "fatal" ) return util::FATAL;
+		else return util::INFO;
+	}
+
+	std::string getBenchmarkFile() const {
+		return benchmarkFile;
+	}
+
+	std::string getBenchmarkReference() const {
+		return benchmarkReference;
+	}
+
+	std::string getPipelines() const {
+		return pipelines;
+	}
+
+	std::string getMpiGrid() const {
+		return mpiGrid;
+	}
+
+	int getLinks() const {
+		return links;
+	}
+
 private:
 	boost::program_options::variables_map options_vm;
 	boost::program_options::options_description options_desc;
@@ -173,6 +282,17 @@ private:
 	std::string outputEnding;
 	bool saveEach;
 	bool doSA;
+	std::string metricsFile;
+	std::string metricsFormat;
+	bool profile;
+	std::string logLevel;
+	std::string traceFile;
+	std::string traceCsv;
+	std::string benchmarkFile;
+	std::string benchmarkReference;
+	std::string pipelines;
+	std::string mpiGrid;
+	int links;
 
 	int deviceNumber;
 
@@ -192,6 +312,20 @@ private:
 	long seed;
 
 	int gaugeCopies;
+	int concurrentCopies;
+	int batchSize;
+	std::string hostLayout;
+	std::string tuningFile;
+	int tuneSweeps;
+	bool earlyStop;
+	float earlyStopMargin;
+	int replicas;
+	int reSweeps;
+	int reRounds;
+
+	std::string checkpointFile;
+	int checkpointInterval;
+	bool restart;
 	bool randomTrafo;
 	int reproject;
 
@@ -208,6 +342,8 @@ private:
 
 
 	float precision;
+	float spPrecision;
+	std::string realType;
 	int checkPrecision;
 
 
@@ -229,8 +365,22 @@ int ProgramOptions::init( int argc, char* argv[] )
 			("output_ending", boost::program_options::value<std::string>(&outputEnding)->default_value(""), "file ending to append to output_conf (default: "")")
 			("save_each", boost::program_options::value<bool>(&saveEach)->default_value(false), "true - save each gauge copy, false - not (default: false)")
 			("doSA", boost::program_options::value<bool>(&doSA)->default_value(true), "true - do simulated annealing, false - don't do (default: true)")
+			("metrics", boost::program_options::value<std::string>(&metricsFile)->default_value(""), "file for the per phase performance metrics (default: no metrics)")
+			("metricsformat", boost::program_options::value<std::string>(&metricsFormat)->default_value("json"), "format of the metrics file: json (JSON lines) or csv")
+			("profile", boost::program_options::value<bool>(&profile)->default_value(false), "print a profile of the timed regions (flat and call tree) at exit")
+			("loglevel", boost::program_options::value<std::string>(&logLevel)->default_value("info"), "messages of the gauge fixing loops: debug, info (progress), warn, error or fatal")
+			("trace", boost::program_options::value<std::string>(&traceFile)->default_value(""), "binary file for the gff, dA and temperature of every measurement (default: no trace)")
+			("tracecsv", boost::program_options::value<std::string>(&traceCsv)->default_value(""), "ConvergenceTraceReader: write the records of --trace to this CSV file")
+			("benchmarkfile", boost::program_options::value<std::string>(&benchmarkFile)->default_value(""), "file for the results of MathBenchmarkSU3 and TimeToSolutionLandauSU3_4D (CSV)")
+			("benchmarkreference", boost::program_options::value<std::string>(&benchmarkReference)->default_value(""), "results of an earlier MathBenchmarkSU3 run to compare with")
+			("pipelines", boost::program_options::value<std::string>(&pipelines)->default_value("or;sa+or;sa+sr200+or"), "gauge fixing pipelines of TimeToSolutionLandauSU3_4D, e.g. \"or;or@1.8;sa1000+or;sa1000+sr200+or\"")
+
+			("checkpoint", boost::program_options::value<std::string>(&checkpointFile)->default_value(""), "file for periodic checkpoints (default: no checkpoints)")
+			("checkpointinterval", boost::program_options::value<int>(&checkpointInterval)->default_value(100), "write a checkpoint every arg-th SA step")
+			("restart", boost::program_options::value<bool>(&restart)->default_value(false), "continue from the checkpoint file")
 
 			("devicenumber,D", boost::program_options::value<int>(&deviceNumber)->default_value(-1), "number of the CUDA device (or -1 for auto selection)")
+			("mpigrid", boost::program_options::value<std::string>(&mpiGrid)->default_value(""), "process grid TxXxYxZ of MultiGPU_MPI_LandauGaugeFixingSU3_4D, e.g. 4x2x1x1 (default: split the time direction)")
 
 			("ftype", boost::program_options::value<FileType>(&fType), "type of configuration (PLAIN, HEADERONLY, VOGT, ILDG, QCDSTAG)")
 			("fbasename", boost::program_options::value<std::string>(&fBasename), "file basename (part before numbering starts)")
@@ -248,6 +398,17 @@ int ProgramOptions::init( int argc, char* argv[] )
 			("seed", boost::program_options::value<long>(&seed)->default_value(1), "RNG seed")
 
 			("gaugecopies", boost::program_options::value<int>(&gaugeCopies)->default_value(1), "Number of gauge copies")
+			("links", boost::program_options::value<int>(&links)->default_value(18), "reals per link on the device: 18, 12 (two rows) or 8 (hot configurations only) (LandauGaugeFixingSU3_4D)")
+			("hostlayout", boost::program_options::value<std::string>(&hostLayout)->default_value("aosoa"), "memory layout of the host backend: aosoa, morton, morton4 or auto (HostLandauGaugeFixingSU3_4D)")
+			("tuningfile", boost::program_options::value<std::string>(&tuningFile)->default_value("culgt_tuning.dat"), "cache file for the layout chosen by --hostlayout auto (empty: always tune)")
+			("tunesweeps", boost::program_options::value<int>(&tuneSweeps)->default_value(10), "timed sweeps per layout for --hostlayout auto")
+			("batchsize", boost::program_options::value<int>(&batchSize)->default_value(16), "Number of configurations that are gauge fixed at once (BatchLandauGaugeFixingSU3_4D)")
+			("concurrentcopies", boost::program_options::value<int>(&concurrentCopies)->default_value(1), "Number of gauge copies that are processed concurrently (each needs its own device memory for the configuration)")
+			("earlystop", boost::program_options::value<bool>(&earlyStop)->default_value(false), "abandon a gauge copy in OR when its predicted functional is below the best copy")
+			("earlystopmargin", boost::program_options::value<float>(&earlyStopMargin)->default_value(1E-4), "a copy is abandoned if predicted functional + margin < best functional")
+			("replicas", boost::program_options::value<int>(&replicas)->default_value(0), "number of replicas for replica exchange instead of SA (0 or 1: no replica exchange)")
+			("resweeps", boost::program_options::value<int>(&reSweeps)->default_value(10), "heatbath sweeps between two replica exchange attempts")
+			("rerounds", boost::program_options::value<int>(&reRounds)->default_value(100), "number of replica exchange rounds")
 			("randomtrafo", boost::program_options::value<bool>(&randomTrafo)->default_value(true), "do a random trafo before each gf run" )
 			("reproject", boost::program_options::value<int>(&reproject)->default_value(100), "reproject every arg-th step")
 
@@ -263,6 +424,8 @@ int ProgramOptions::init( int argc, char* argv[] )
 			("srparameter", boost::program_options::value<float>(&srParameter)->default_value(1.7), "SR parameter")
 
 			("precision", boost::program_options::value<float>(&precision)->default_value(1E-7), "OR precision (dmuAmu)")
+			("spprecision", boost::program_options::value<float>(&spPrecision)->default_value(1E-6), "mixed precision: OR precision (dmuAmu) at which the field is promoted to double precision")
+			("realtype", boost::program_options::value<std::string>(&realType)->default_value("mixed"), "precision of the gauge fixing: sp, dp or mixed (MixedPrecisionLandauGaugeFixingSU3_4D)")
 			("checkprecision", boost::program_options::value<int>(&checkPrecision)->default_value(100), "how often to check the gauge precision")
 			;
 
@@ -277,6 +440,12 @@ int ProgramOptions::init( int argc, char* argv[] )
 	boost::program_options::store(boost::program_options::parse_config_file( cfg, options_desc), options_vm);
 	boost::program_options::notify(options_vm);
 
+	if( concurrentCopies < 1 ) concurrentCopies = 1;
+	if( batchSize < 1 ) batchSize = 1;
+	if( tuneSweeps < 1 ) tuneSweeps = 1;
+	if( checkpointInterval < 1 ) checkpointInterval = 1;
+	if( links != 12 && links != 8 ) links = 18;
+
 	if (options_vm.count("help")) {
 		std::cout << "Usage: " << argv[0] << " [options] [config-file]" << std::endl;
 		std::cout << options_desc << "\n";
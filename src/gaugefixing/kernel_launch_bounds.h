@@ -73,5 +73,33 @@
 #endif
 	
 #endif
+
+/*
+ * Launch bounds of the kernels that are templated on the precision (LandauKernelsSU3, MAGKernelsSU3, U1xU1KernelsSU3,
+ * CoulombKernelsSU3): the float instantiations (SP build or the SP stage of MixedPrecisionLandauGaugeFixingSU3_4D in a
+ * DP build) use the SP values, the double instantiations the DP values, independent of DOUBLEPRECISION.
+ * The counting instantiations (CountingReal, see LandauKernelCounter.hxx) use the values of the wrapped type.
+ */
+template<class T> class CountingReal;
+
+template<class T_Real> struct LaunchBounds
+{
+	static const int OR_MINBLOCKS = 128/NSB;
+	static const int MS_MINBLOCKS = 128/NSB;
+	static const int SA_MINBLOCKS = 128/NSB;
+	static const int SR_MINBLOCKS = 128/NSB;
+};
+
+template<> struct LaunchBounds<double>
+{
+	static const int OR_MINBLOCKS = 1;
+	static const int MS_MINBLOCKS = 1;
+	static const int SA_MINBLOCKS = 1;
+	static const int SR_MINBLOCKS = 1;
+};
+
+template<class T> struct LaunchBounds<CountingReal<T> > : LaunchBounds<T>
+{
+};
 	
 #endif /* KERNEL_LAUNCH_BOUNDS_H_ */
@@ -0,0 +1,71 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Memory policy for gauge fields that live in device memory.
+ * Copies between two device buffers are enqueued to the given stream and do not block the host.
+ */
+
+#ifndef DEVICEMEMORY_HXX_
+#define DEVICEMEMORY_HXX_
+
+#include "../../lattice/datatype/datatypes.h"
+
+#include <cuda_runtime.h>
+
+class DeviceMemory
+{
+public:
+	typedef cudaStream_t Stream;
+
+	static Real* allocate( int arraySize )
+	{
+		Real* U;
+		cudaMalloc( &U, arraySize*sizeof(Real) );
+		return U;
+	}
+
+	static void release( Real* U )
+	{
+		cudaFree( U );
+	}
+
+	static void copy( Real* dest, const Real* src, int arraySize, Stream stream = 0 )
+	{
+		cudaMemcpyAsync( dest, src, arraySize*sizeof(Real), cudaMemcpyDeviceToDevice, stream );
+	}
+
+	static void fromHost( Real* dest, const Real* hostSrc, int arraySize )
+	{
+		cudaMemcpy( dest, hostSrc, arraySize*sizeof(Real), cudaMemcpyHostToDevice );
+	}
+
+	static void toHost( Real* hostDest, const Real* src, int arraySize )
+	{
+		cudaMemcpy( hostDest, src, arraySize*sizeof(Real), cudaMemcpyDeviceToHost );
+	}
+
+	static void synchronize( Stream stream = 0 )
+	{
+		cudaStreamSynchronize( stream );
+	}
+};
+
+#endif /* DEVICEMEMORY_HXX_ */
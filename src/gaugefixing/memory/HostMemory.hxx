@@ -0,0 +1,69 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Memory policy for gauge fields that live in host memory (host backend).
+ * Stream arguments are accepted for interface compatibility with DeviceMemory and ignored.
+ */
+
+#ifndef HOSTMEMORY_HXX_
+#define HOSTMEMORY_HXX_
+
+#include "../../lattice/datatype/datatypes.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+class HostMemory
+{
+public:
+	typedef int Stream;
+
+	static Real* allocate( int arraySize )
+	{
+		return (Real*)malloc( arraySize*sizeof(Real) );
+	}
+
+	static void release( Real* U )
+	{
+		free( U );
+	}
+
+	static void copy( Real* dest, const Real* src, int arraySize, Stream stream = 0 )
+	{
+		memcpy( dest, src, arraySize*sizeof(Real) );
+	}
+
+	static void fromHost( Real* dest, const Real* hostSrc, int arraySize )
+	{
+		memcpy( dest, hostSrc, arraySize*sizeof(Real) );
+	}
+
+	static void toHost( Real* hostDest, const Real* src, int arraySize )
+	{
+		memcpy( hostDest, src, arraySize*sizeof(Real) );
+	}
+
+	static void synchronize( Stream stream = 0 )
+	{
+	}
+};
+
+#endif /* HOSTMEMORY_HXX_ */
@@ -34,6 +34,7 @@ public:
 //	CUDA_HOST_DEVICE inline Complex( const float x );
 //	CUDA_HOST_DEVICE inline Complex( const double x );
 	CUDA_HOST_DEVICE inline Complex( const Complex<datatype>* a);
+	template<class datatype2> CUDA_HOST_DEVICE inline Complex( const Complex<datatype2> a );
 	CUDA_HOST_DEVICE inline Complex();
 	CUDA_HOST_DEVICE inline virtual ~Complex();
 	CUDA_HOST_DEVICE inline datatype abs();
@@ -89,6 +90,15 @@ template<class datatype> Complex<datatype>::Complex(const Complex<datatype>* a )
 	this->y = a->y;
 }
 
+/**
+ * Conversion between precisions.
+ */
+template<class datatype> template<class datatype2> Complex<datatype>::Complex(const Complex<datatype2> a )
+{
+	this->x = (datatype)a.x;
+	this->y = (datatype)a.y;
+}
+
 template<class datatype> Complex<datatype>::Complex()
 {
 	this->x = 0;
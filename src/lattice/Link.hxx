@@ -38,53 +38,60 @@
 #include "datatype/datatypes.h"
 #include "Complex.hxx"
 
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> class Link
+/**
+ * Hook for the counting of the link array accesses, a no-op except for CountingReal (see CountingReal.hxx).
+ */
+template<class T_Real> CUDA_HOST_DEVICE inline void countLinkAccess( T_Real*, int loads, int stores )
+{
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real = Real> class Link
 {
 public:
-	CUDA_HOST_DEVICE inline Link( Real* data, TheSite site, int mu );
+	CUDA_HOST_DEVICE inline Link( T_Real* data, TheSite site, int mu );
 	CUDA_HOST_DEVICE inline virtual ~Link();
-	CUDA_HOST_DEVICE inline Complex<Real> get(int i, int j);
+	CUDA_HOST_DEVICE inline Complex<T_Real> get(int i, int j);
 //	CUDA_HOST_DEVICE inline float4 getFloat4(int i, int j);
-	CUDA_HOST_DEVICE inline void set(int i, int j, Complex<Real> c);
+	CUDA_HOST_DEVICE inline void set(int i, int j, Complex<T_Real> c);
 //	CUDA_HOST_DEVICE inline void setFloat4(int i, int j, float4 f);
-	CUDA_HOST_DEVICE inline Complex<Real> trace();
-	CUDA_HOST_DEVICE inline Link<Pattern, TheSite, T_Ndim, T_Nc>& operator+=( Link<Pattern, TheSite, T_Ndim, T_Nc> );
+	CUDA_HOST_DEVICE inline Complex<T_Real> trace();
+	CUDA_HOST_DEVICE inline Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>& operator+=( Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real> );
 
 	CUDA_HOST_DEVICE inline TheSite& getSite();
 	CUDA_HOST_DEVICE inline void setMu( int mu );
-	CUDA_HOST_DEVICE inline void setPointer( Real* pointer );
-	CUDA_HOST_DEVICE inline Real* getPointer();
+	CUDA_HOST_DEVICE inline void setPointer( T_Real* pointer );
+	CUDA_HOST_DEVICE inline T_Real* getPointer();
 
 private:
-	Real* data; // pointer to the link array
+	T_Real* data; // pointer to the link array
 	TheSite site; // current lattice site
 	int mu; // direction of the link
 };
 
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> Link<Pattern, TheSite, T_Ndim, T_Nc>::Link( Real* data, TheSite site, int mu ) : data(data), site( site ), mu(mu)
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::Link( T_Real* data, TheSite site, int mu ) : data(data), site( site ), mu(mu)
 {
 }
 
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> Link<Pattern, TheSite, T_Ndim, T_Nc>::~Link()
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::~Link()
 {
 }
 
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> TheSite& Link<Pattern, TheSite, T_Ndim, T_Nc>::getSite()
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> TheSite& Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::getSite()
 {
 	return site;
 }
 
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> void Link<Pattern, TheSite, T_Ndim, T_Nc>::setMu( int mu )
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::setMu( int mu )
 {
 	this->mu = mu;
 }
 
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> void Link<Pattern, TheSite, T_Ndim, T_Nc>::setPointer( Real* pointer )
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::setPointer( T_Real* pointer )
 {
 	this->data = pointer;
 }
 
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> Real* Link<Pattern, TheSite, T_Ndim, T_Nc>::getPointer()
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> T_Real* Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::getPointer()
 {
 	return this->data;
 }
@@ -108,9 +115,10 @@ template<class Pattern, class TheSite, int T_Ndim, int T_Nc> Real* Link<Pattern,
  * @parameter col index j
  * @return element (i,j)
  */
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> Complex<Real> Link<Pattern, TheSite, T_Ndim, T_Nc>::get( int i, int j )
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Complex<T_Real> Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::get( int i, int j )
 {
-	return Complex<Real>( data[Pattern::getIndex( site, mu, i, j, 0 )], data[Pattern::getIndex( site, mu, i, j, 1 )] );
+	countLinkAccess( data, 2, 0 );
+	return Complex<T_Real>( data[Pattern::getIndex( site, mu, i, j, 0 )], data[Pattern::getIndex( site, mu, i, j, 1 )] );
 
 }
 
@@ -120,8 +128,9 @@ template<class Pattern, class TheSite, int T_Ndim, int T_Nc> Complex<Real> Link<
  * @parameter col index j
  * @parameter element to set
  */
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> void Link<Pattern, TheSite, T_Ndim, T_Nc>::set( int i, int j, Complex<Real> c )
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::set( int i, int j, Complex<T_Real> c )
 {
+	countLinkAccess( data, 0, 2 );
 	data[Pattern::getIndex( site, mu, i, j, 0 )] = c.x;
 	data[Pattern::getIndex( site, mu, i, j, 1 )] = c.y;
 }
@@ -130,9 +139,9 @@ template<class Pattern, class TheSite, int T_Ndim, int T_Nc> void Link<Pattern,
  * Trace.
  * TODO do it here or in frontend class SU3? Maybe we want to use Link without frontend class?
  */
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> Complex<Real> Link<Pattern, TheSite, T_Ndim, T_Nc>::trace()
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Complex<T_Real> Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::trace()
 {
-	Complex<Real> c;
+	Complex<T_Real> c;
 	for( int i = 0; i < T_Nc; i++ )
 	{
 		c += get(i,i);
@@ -143,12 +152,13 @@ template<class Pattern, class TheSite, int T_Ndim, int T_Nc> Complex<Real> Link<
 /**
  * Add and assign...
  */
-template<class Pattern, class TheSite, int T_Ndim, int T_Nc> Link<Pattern, TheSite, T_Ndim, T_Nc>& Link<Pattern, TheSite, T_Ndim, T_Nc>::operator+=( Link<Pattern, TheSite, T_Ndim, T_Nc> a )
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>& Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::operator+=( Link<Pattern, TheSite, T_Ndim, T_Nc, T_Real> a )
 {
 	for(int i = 0; i < T_Nc; i++ )
 	{
 		for( int j = 0; j < T_Nc; j++ )
 		{
+			countLinkAccess( data, 2, 2 );
 			data[Pattern::getIndex( site, mu, i, j, 0 )] += a.get(i,j).x;
 			data[Pattern::getIndex( site, mu, i, j, 1 )] += a.get(i,j).y;
 		}
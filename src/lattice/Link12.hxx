@@ -0,0 +1,131 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Storage class for a SU(3) link of which only the first two rows (12 reals) are kept in memory.
+ * The third row is reconstructed on access: row 2 = (row 0 x row 1)^*. Setting elements of the third row has no effect.
+ *
+ * SU3<Link12> replaces SU3<Link> in the kernels that read the links with assignWithoutThirdLine(): projectSU3() and
+ * reconstructThirdLine() work as before. Use a Pattern with 12 reals per link (GpuPatternCompressed<...,12>).
+ * The halo buffers of the spatial directions in MultiGPU_MPI are fields in this layout (packHalo(), unpackHalo()).
+ */
+
+#ifndef LINK12_HXX_
+#define LINK12_HXX_
+
+#include "datatype/datatypes.h"
+#include "Complex.hxx"
+#include "Link.hxx"
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real = Real> class Link12
+{
+public:
+	CUDA_HOST_DEVICE inline Link12( T_Real* data, TheSite site, int mu );
+	CUDA_HOST_DEVICE inline Complex<T_Real> get(int i, int j);
+	CUDA_HOST_DEVICE inline void set(int i, int j, Complex<T_Real> c);
+	CUDA_HOST_DEVICE inline Complex<T_Real> trace();
+
+	CUDA_HOST_DEVICE inline TheSite& getSite();
+	CUDA_HOST_DEVICE inline void setMu( int mu );
+	CUDA_HOST_DEVICE inline void setPointer( T_Real* pointer );
+	CUDA_HOST_DEVICE inline T_Real* getPointer();
+
+	static const int Reals = 12;
+
+private:
+	CUDA_HOST_DEVICE inline Complex<T_Real> getStored(int i, int j);
+
+	T_Real* data; // pointer to the link array
+	TheSite site; // current lattice site
+	int mu; // direction of the link
+};
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Link12<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::Link12( T_Real* data, TheSite site, int mu ) : data(data), site( site ), mu(mu)
+{
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> TheSite& Link12<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::getSite()
+{
+	return site;
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link12<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::setMu( int mu )
+{
+	this->mu = mu;
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link12<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::setPointer( T_Real* pointer )
+{
+	this->data = pointer;
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> T_Real* Link12<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::getPointer()
+{
+	return this->data;
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Complex<T_Real> Link12<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::getStored( int i, int j )
+{
+	countLinkAccess( data, 2, 0 );
+	return Complex<T_Real>( data[Pattern::getIndex( site, mu, i, j, 0 )], data[Pattern::getIndex( site, mu, i, j, 1 )] );
+}
+
+/**
+ * Returns the matrix element (i,j), elements of the third row are reconstructed from the first two rows.
+ * @parameter row index i
+ * @parameter col index j
+ * @return element (i,j)
+ */
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Complex<T_Real> Link12<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::get( int i, int j )
+{
+	if( i < 2 ) return getStored( i, j );
+
+	int j1 = (j+1)%3;
+	int j2 = (j+2)%3;
+	return getStored(0,j1).conj() * getStored(1,j2).conj() - getStored(0,j2).conj() * getStored(1,j1).conj();
+}
+
+/**
+ * Sets the matrix element (i,j), the third row is not stored.
+ * @parameter row index i
+ * @parameter col index j
+ * @parameter element to set
+ */
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link12<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::set( int i, int j, Complex<T_Real> c )
+{
+	if( i < 2 )
+	{
+		countLinkAccess( data, 0, 2 );
+		data[Pattern::getIndex( site, mu, i, j, 0 )] = c.x;
+		data[Pattern::getIndex( site, mu, i, j, 1 )] = c.y;
+	}
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Complex<T_Real> Link12<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::trace()
+{
+	Complex<T_Real> c;
+	for( int i = 0; i < T_Nc; i++ )
+	{
+		c += get(i,i);
+	}
+	return c;
+}
+
+#endif /* LINK12_HXX_ */
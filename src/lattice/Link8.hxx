@@ -0,0 +1,254 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Storage class for a SU(3) link in the 8 real parametrization: a01, a02, a10 (6 reals) and the phases of a00 and a20.
+ * The remaining elements are reconstructed with unitarity and det = 1:
+ * 	|a00|^2 = 1 - |a01|^2 - |a02|^2,  |a20|^2 = 1 - |a00|^2 - |a10|^2
+ * 	a11 = -( a00^* a01 a10 + a02^* a20^* )/N,  a12 = ( a01^* a20^* - a00^* a02 a10 )/N,  N = |a01|^2 + |a02|^2
+ * 	a21 = a02^* a10^* - a00^* a12^*,  a22 = a00^* a11^* - a01^* a10^*
+ * Setting a00 or a20 stores the phase only, setting one of the other reconstructed elements has no effect.
+ * The reconstructed elements are calculated once per link (on the first access after construction or a change of the
+ * link, see reconstruct()), i.e. assignWithoutThirdLine() takes one sqrt and one sin/cos pair for a00 and for a20.
+ *
+ * The reconstruction is ill conditioned for |a00| -> 1 (N -> 0), i.e. for links close to the identity. For N below
+ * LINK8_MIN_NORM the lower right 2x2 block is not determined by the stored reals at all, it is replaced by diag(a00^*, 1)
+ * (a valid SU(3) matrix, but not the original link). Link8 is therefore restricted to hot configurations (setHot(),
+ * CompressedLinkBenchmarkSU3_4D), use Link12 for gauge fixed or cold configurations.
+ *
+ * SU3<Link8> replaces SU3<Link> in the kernels that read and write the links with assignWithoutThirdLine(): the phase of
+ * a20 is taken from the third row of the assigned matrix by the assignThirdLineInfo() overload below.
+ * The stored elements are always a point on SU(3), projectSU3() is not needed (and not meaningful) for Link8.
+ * Use a Pattern with 8 reals per link (GpuPatternCompressed<...,8>), k = 0..5: a01, a02, a10 (re, im), k = 6, 7: phases.
+ */
+
+#ifndef LINK8_HXX_
+#define LINK8_HXX_
+
+#include <math.h>
+#include "datatype/datatypes.h"
+#include "Complex.hxx"
+#include "Link.hxx"
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real = Real> class Link8
+{
+public:
+	CUDA_HOST_DEVICE inline Link8( T_Real* data, TheSite site, int mu );
+	CUDA_HOST_DEVICE inline Complex<T_Real> get(int i, int j);
+	CUDA_HOST_DEVICE inline void set(int i, int j, Complex<T_Real> c);
+	CUDA_HOST_DEVICE inline Complex<T_Real> trace();
+
+	CUDA_HOST_DEVICE inline TheSite& getSite();
+	CUDA_HOST_DEVICE inline void setMu( int mu );
+	CUDA_HOST_DEVICE inline void setPointer( T_Real* pointer );
+	CUDA_HOST_DEVICE inline T_Real* getPointer();
+
+	static const int Reals = 8;
+
+private:
+	CUDA_HOST_DEVICE inline Complex<T_Real> getStored( int k );
+	CUDA_HOST_DEVICE inline void setStored( int k, Complex<T_Real> c );
+	CUDA_HOST_DEVICE inline void reconstruct();
+
+	T_Real* data; // pointer to the link array
+	TheSite site; // current lattice site
+	int mu; // direction of the link
+
+	bool reconstructed; // a00, a20, a11 and a12 are valid for the stored reals
+	Complex<T_Real> a00;
+	Complex<T_Real> a20;
+	Complex<T_Real> a11;
+	Complex<T_Real> a12;
+};
+
+// below this |a01|^2+|a02|^2 the lower right 2x2 block is not reconstructed (see above)
+#define LINK8_MIN_NORM 1e-12
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::Link8( T_Real* data, TheSite site, int mu ) : data(data), site( site ), mu(mu), reconstructed(false)
+{
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> TheSite& Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::getSite()
+{
+	reconstructed = false; // the site may be changed by the caller
+	return site;
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::setMu( int mu )
+{
+	this->mu = mu;
+	reconstructed = false;
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::setPointer( T_Real* pointer )
+{
+	this->data = pointer;
+	reconstructed = false;
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> T_Real* Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::getPointer()
+{
+	return this->data;
+}
+
+/**
+ * Stored complex number k: 0 = a01, 1 = a02, 2 = a10, 3 = (phase of a00, phase of a20).
+ */
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Complex<T_Real> Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::getStored( int k )
+{
+	countLinkAccess( data, 2, 0 );
+	return Complex<T_Real>( data[Pattern::getCompressedIndex( site, mu, 2*k )], data[Pattern::getCompressedIndex( site, mu, 2*k+1 )] );
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::setStored( int k, Complex<T_Real> c )
+{
+	countLinkAccess( data, 0, 2 );
+	data[Pattern::getCompressedIndex( site, mu, 2*k )] = c.x;
+	data[Pattern::getCompressedIndex( site, mu, 2*k+1 )] = c.y;
+	reconstructed = false;
+}
+
+/**
+ * Calculates a00, a20, a11 and a12 from the stored reals.
+ */
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::reconstruct()
+{
+	Complex<T_Real> a01 = getStored(0);
+	Complex<T_Real> a02 = getStored(1);
+	Complex<T_Real> a10 = getStored(2);
+	T_Real norm = a01.abs_squared() + a02.abs_squared();
+
+	T_Real abs2 = 1. - norm;
+	T_Real r = (abs2 > 0)?sqrt(abs2):0;
+	countLinkAccess( data, 1, 0 );
+	T_Real phase = data[Pattern::getCompressedIndex( site, mu, 6 )];
+	a00 = Complex<T_Real>( r*cos(phase), r*sin(phase) );
+
+	abs2 = norm - a10.abs_squared();
+	r = (abs2 > 0)?sqrt(abs2):0;
+	countLinkAccess( data, 1, 0 );
+	phase = data[Pattern::getCompressedIndex( site, mu, 7 )];
+	a20 = Complex<T_Real>( r*cos(phase), r*sin(phase) );
+
+	if( norm > LINK8_MIN_NORM )
+	{
+		a11 = ( a02.conj()*a20.conj() + a00.conj()*a01*a10 ) / (-norm);
+		a12 = ( a01.conj()*a20.conj() - a00.conj()*a02*a10 ) / norm;
+	}
+	else
+	{
+		// a01 = a02 = a10 = a20 = 0: complete to diag(a00, a00^*, 1)
+		a11 = a00.conj();
+		a12 = Complex<T_Real>( 0, 0 );
+	}
+	reconstructed = true;
+}
+
+/**
+ * Returns the matrix element (i,j), reconstructed if it is not stored.
+ * @parameter row index i
+ * @parameter col index j
+ * @return element (i,j)
+ */
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Complex<T_Real> Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::get( int i, int j )
+{
+	switch( 3*i+j )
+	{
+	case 1:
+		return getStored(0);
+	case 2:
+		return getStored(1);
+	case 3:
+		return getStored(2);
+	default:
+		break;
+	}
+
+	if( !reconstructed ) reconstruct();
+	switch( 3*i+j )
+	{
+	case 0:
+		return a00;
+	case 4:
+		return a11;
+	case 5:
+		return a12;
+	case 6:
+		return a20;
+	case 7:
+		return getStored(1).conj()*getStored(2).conj() - a00.conj()*a12.conj();
+	default:
+		return a00.conj()*a11.conj() - getStored(0).conj()*getStored(2).conj();
+	}
+}
+
+/**
+ * Sets the matrix element (i,j): a01, a02 and a10 are stored, of a00 and a20 only the phase is stored.
+ * @parameter row index i
+ * @parameter col index j
+ * @parameter element to set
+ */
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> void Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::set( int i, int j, Complex<T_Real> c )
+{
+	switch( 3*i+j )
+	{
+	case 0:
+		countLinkAccess( data, 0, 1 );
+		data[Pattern::getCompressedIndex( site, mu, 6 )] = atan2( c.y, c.x );
+		reconstructed = false;
+		break;
+	case 1:
+		setStored( 0, c );
+		break;
+	case 2:
+		setStored( 1, c );
+		break;
+	case 3:
+		setStored( 2, c );
+		break;
+	case 6:
+		countLinkAccess( data, 0, 1 );
+		data[Pattern::getCompressedIndex( site, mu, 7 )] = atan2( c.y, c.x );
+		reconstructed = false;
+		break;
+	default:
+		break;
+	}
+}
+
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real> Complex<T_Real> Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>::trace()
+{
+	Complex<T_Real> c;
+	for( int i = 0; i < T_Nc; i++ )
+	{
+		c += get(i,i);
+	}
+	return c;
+}
+
+/**
+ * Called by SU3::assignWithoutThirdLine(): Link8 needs the phase of a20 from the third row.
+ */
+template<class Pattern, class TheSite, int T_Ndim, int T_Nc, class T_Real, class Type2> CUDA_HOST_DEVICE inline void assignThirdLineInfo( Link8<Pattern, TheSite, T_Ndim, T_Nc, T_Real>& mat, Type2& c )
+{
+	mat.set( 2, 0, c.get(2,0) );
+}
+
+#endif /* LINK8_HXX_ */
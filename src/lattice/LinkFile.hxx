@@ -63,6 +63,8 @@ public:
 	virtual ~LinkFile();
 	bool load( TheSite site, std::string filename, Real *U );
 	bool save( TheSite site, std::string filename, Real *U );
+	template<class SourcePattern> static void convertFrom( TheSite site, const Real *source, Real *U );
+	template<class TargetPattern> static void convertTo( TheSite site, const Real *U, Real *target );
 	FileType filetype;
 private:
 	ReinterpretReal reinterpret; // defined in "filetypes/filetype_typedefs.h"
@@ -265,6 +267,43 @@ template <class FileType, class FilePattern, class MemoryPattern, class TheSite>
 	return true;
 }
 
+/**
+ * Converts a configuration in SourcePattern (e.g. the GpuPattern of a device configuration) to MemoryPattern.
+ * Both patterns have to provide getIndexByUnique().
+ */
+template <class FileType, class FilePattern, class MemoryPattern, class TheSite> template<class SourcePattern> void LinkFile<FileType, FilePattern, MemoryPattern, TheSite>::convertFrom( TheSite site, const Real *source, Real *U )
+{
+	int configSize = 1;
+	for( int i = 0; i < site.Ndim; i++ )
+	{
+		configSize *= site.size[i];
+	}
+	configSize *= MemoryPattern::Ndim * MemoryPattern::Nc * MemoryPattern::Nc * 2;
+
+	for( int i = 0; i < configSize; i++ )
+	{
+		U[MemoryPattern::getIndexByUnique( i, site.size )] = source[SourcePattern::getIndexByUnique( i, site.size )];
+	}
+}
+
+/**
+ * Converts a configuration in MemoryPattern to TargetPattern.
+ */
+template <class FileType, class FilePattern, class MemoryPattern, class TheSite> template<class TargetPattern> void LinkFile<FileType, FilePattern, MemoryPattern, TheSite>::convertTo( TheSite site, const Real *U, Real *target )
+{
+	int configSize = 1;
+	for( int i = 0; i < site.Ndim; i++ )
+	{
+		configSize *= site.size[i];
+	}
+	configSize *= MemoryPattern::Ndim * MemoryPattern::Nc * MemoryPattern::Nc * 2;
+
+	for( int i = 0; i < configSize; i++ )
+	{
+		target[TargetPattern::getIndexByUnique( i, site.size )] = U[MemoryPattern::getIndexByUnique( i, site.size )];
+	}
+}
+
 // TODO place somewhere else
 template <class FileType, class FilePattern, class MemoryPattern, class TheSite> int LinkFile<FileType, FilePattern, MemoryPattern, TheSite>::getLengthOfReal( ReinterpretReal reinterpret )
 {
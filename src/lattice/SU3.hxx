@@ -30,11 +30,14 @@
  * See for example the implementation of operator=().
  * All storage techniques have to implement a basic set of functions.
  *
+ * T_Real is the floating point type of the operations (default: the global Real), it has to match the storage class,
+ * i.e. SU3<Matrix<Complex<float>,3>,float> or SU3<Link<...,float>,float>. operator=() and assignWithoutThirdLine() accept
+ * an SU3 of the other precision and convert the elements (used to promote a single precision field to double).
+ *
  * TODO:
  *  - Implement all mathematical operations: like operator*
  *  - We have to introduce a compatible and clear way to switch between full 18 parameter matrices
  *    and 12 parameter (third-line-reconstruction) techniques.
- *  - At present we use the hardcodeed "Complex<Real>". This is no good style... Introduce a template parameter or something...
  */
 
 #ifndef SU3_HXX_
@@ -49,58 +52,68 @@
 #include "Quaternion.hxx"
 #include <math.h>
 
-template<class Type> class SU3
+/**
+ * Hook for storage classes that need information of the third line when only the first two lines are assigned
+ * (see Link8). The default does nothing.
+ */
+template<class Type, class Type2> CUDA_HOST_DEVICE inline void assignThirdLineInfo( Type& mat, Type2& c )
+{
+}
+
+template<class Type, class T_Real = Real> class SU3
 {
 public:
+	typedef T_Real RealType;
+
 	CUDA_HOST_DEVICE SU3( Type mat );
 	CUDA_HOST_DEVICE SU3();
 	Type mat;
 
 	CUDA_HOST_DEVICE inline Type& getMat();
 
-	CUDA_HOST_DEVICE inline Complex<Real> get( lat_group_dim_t i, lat_group_dim_t j );
-	CUDA_HOST_DEVICE inline Complex<Real> get(lat_group_dim_t iSub, lat_group_dim_t jSub, lat_group_dim_t i, lat_group_dim_t j);
-	CUDA_HOST_DEVICE inline Quaternion<Real> getSubgroupQuaternion( lat_group_dim_t iSub, lat_group_dim_t jSub ); // TODO binding this class to class Quaternion is not good style -> make this a static function elsewhere
-	CUDA_HOST_DEVICE inline Matrix<Complex<Real>, 2> getSubgroupMatrix( lat_group_dim_t iSub, lat_group_dim_t jSub );
-	CUDA_HOST_DEVICE inline Matrix<Complex<Real>, 2> getSubgroupMatrixHermitian( lat_group_dim_t iSub, lat_group_dim_t jSub );
-	CUDA_HOST_DEVICE inline void set( lat_group_dim_t i, lat_group_dim_t j, Complex<Real> c);
-	CUDA_HOST_DEVICE inline void set(lat_group_dim_t iSub, lat_group_dim_t jSub, lat_group_dim_t i, lat_group_dim_t j, Complex<Real> c);
-	CUDA_HOST_DEVICE inline SU3<Type>& operator+=( SU3<Type> ); // TODO overload for types like SU3<Link>::operator+=( SU3<Matrix> )
-	CUDA_HOST_DEVICE inline SU3<Type>& operator-=( SU3<Type> ); // TODO overload for types like SU3<Link>::operator+=( SU3<Matrix> )
-	CUDA_HOST_DEVICE inline SU3<Type>& operator*=( SU3<Type> );  // TODO can we overload this for arbitrary Type2 (we need some temporary matrix but we don't know of which type we want it!
+	CUDA_HOST_DEVICE inline Complex<T_Real> get( lat_group_dim_t i, lat_group_dim_t j );
+	CUDA_HOST_DEVICE inline Complex<T_Real> get(lat_group_dim_t iSub, lat_group_dim_t jSub, lat_group_dim_t i, lat_group_dim_t j);
+	CUDA_HOST_DEVICE inline Quaternion<T_Real> getSubgroupQuaternion( lat_group_dim_t iSub, lat_group_dim_t jSub ); // TODO binding this class to class Quaternion is not good style -> make this a static function elsewhere
+	CUDA_HOST_DEVICE inline Matrix<Complex<T_Real>, 2> getSubgroupMatrix( lat_group_dim_t iSub, lat_group_dim_t jSub );
+	CUDA_HOST_DEVICE inline Matrix<Complex<T_Real>, 2> getSubgroupMatrixHermitian( lat_group_dim_t iSub, lat_group_dim_t jSub );
+	CUDA_HOST_DEVICE inline void set( lat_group_dim_t i, lat_group_dim_t j, Complex<T_Real> c);
+	CUDA_HOST_DEVICE inline void set(lat_group_dim_t iSub, lat_group_dim_t jSub, lat_group_dim_t i, lat_group_dim_t j, Complex<T_Real> c);
+	CUDA_HOST_DEVICE inline SU3<Type,T_Real>& operator+=( SU3<Type,T_Real> ); // TODO overload for types like SU3<Link>::operator+=( SU3<Matrix> )
+	CUDA_HOST_DEVICE inline SU3<Type,T_Real>& operator-=( SU3<Type,T_Real> ); // TODO overload for types like SU3<Link>::operator+=( SU3<Matrix> )
+	CUDA_HOST_DEVICE inline SU3<Type,T_Real>& operator*=( SU3<Type,T_Real> );  // TODO can we overload this for arbitrary Type2 (we need some temporary matrix but we don't know of which type we want it!
 																	// The problem boils down to that we can't do SU3<Link>*SU3<Link> because we don't know where to store the data...
 																	// Maybe the SU3 wrapper is not as good as it looked in the first place.
 
-	CUDA_HOST_DEVICE inline SU3<Type>& operator/=( Complex<Real> );
-	CUDA_HOST_DEVICE inline SU3<Type>& operator-=( Complex<Real> );
+	CUDA_HOST_DEVICE inline SU3<Type,T_Real>& operator/=( Complex<T_Real> );
+	CUDA_HOST_DEVICE inline SU3<Type,T_Real>& operator-=( Complex<T_Real> );
 
-	template<class Type2> CUDA_HOST_DEVICE inline SU3<Type>& operator+=( SU3<Type2> );
-	template<class Type2> CUDA_HOST_DEVICE inline SU3<Type>& operator=( SU3<Type2> );
+	template<class Type2, class T_Real2> CUDA_HOST_DEVICE inline SU3<Type,T_Real>& operator+=( SU3<Type2,T_Real2> );
+	template<class Type2, class T_Real2> CUDA_HOST_DEVICE inline SU3<Type,T_Real>& operator=( SU3<Type2,T_Real2> );
 //	template<class Type2> CUDA_HOST_DEVICE inline SU3<Matrix<Complex<Real>,3> > operator*( SU3<Type2> );
-	template<class Type2> CUDA_HOST_DEVICE inline SU3<Type>& assignWithoutThirdLine( SU3<Type2> );
+	template<class Type2, class T_Real2> CUDA_HOST_DEVICE inline SU3<Type,T_Real>& assignWithoutThirdLine( SU3<Type2,T_Real2> );
 //	template<class Type2> CUDA_HOST_DEVICE inline SU3<Type>& assignWithoutThirdLineFloat4ToMat( SU3<Type2> ); // TODO uebelster HACK
 //	template<class Type2> CUDA_HOST_DEVICE inline SU3<Type>& assignWithoutThirdLineFloat4FromMat( SU3<Type2> );// TODO uebelster HACK
 
-	CUDA_HOST_DEVICE inline Complex<Real> det();
-	CUDA_HOST_DEVICE inline Complex<Real> trace();
+	CUDA_HOST_DEVICE inline Complex<T_Real> det();
+	CUDA_HOST_DEVICE inline Complex<T_Real> trace();
 	CUDA_HOST_DEVICE inline void identity();
 	CUDA_HOST_DEVICE inline void zero();
 	CUDA_HOST_DEVICE inline void projectSU3();
 	CUDA_HOST_DEVICE inline void projectSU3withoutThirdRow();
-	CUDA_HOST_DEVICE inline SU3<Type>& hermitian();
+	CUDA_HOST_DEVICE inline SU3<Type,T_Real>& hermitian();
 
 	CUDA_HOST_DEVICE inline void reconstructThirdLine();
 
 //	CUDA_HOST_DEVICE inline void leftSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Real q[4] );
 //	CUDA_HOST_DEVICE inline void rightSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Real q[4] );
 
-	CUDA_HOST_DEVICE inline void leftSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Quaternion<Real> *q );
-	CUDA_HOST_DEVICE inline void rightSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Quaternion<Real> *q );
+	CUDA_HOST_DEVICE inline void leftSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Quaternion<T_Real> *q );
+	CUDA_HOST_DEVICE inline void rightSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Quaternion<T_Real> *q );
 
 	CUDA_HOST_DEVICE inline void print();
 
-	template<class Type2> CUDA_HOST_DEVICE inline SU3<Type> operator*( SU3<Type2> b  );
-	template<class Type2> CUDA_HOST_DEVICE inline SU3<Type> operator+( SU3<Type2> b  );
+	template<class Type2, class T_Real2> CUDA_HOST_DEVICE inline SU3<Type,T_Real> operator*( SU3<Type2,T_Real2> b  );
+	template<class Type2, class T_Real2> CUDA_HOST_DEVICE inline SU3<Type,T_Real> operator+( SU3<Type2,T_Real2> b  );
 
 
 	//TODO what if we compile on g++? We can't have a __device__ function!!!
@@ -113,18 +126,18 @@ public:
  * Creates a new SU3 object with from the given background storage object 'mat'.
  * @parameter Object that holds the information of the SU3-matrix.
  */
-template<class Type> SU3<Type>::SU3( Type mat ) : mat(mat)
+template<class Type, class T_Real> SU3<Type,T_Real>::SU3( Type mat ) : mat(mat)
 {
 }
 
 /**
  * TODO check if we need this.
  */
-template<class Type> SU3<Type>::SU3()
+template<class Type, class T_Real> SU3<Type,T_Real>::SU3()
 {
 }
 
-template<class Type> Type& SU3<Type>::getMat()
+template<class Type, class T_Real> Type& SU3<Type,T_Real>::getMat()
 {
 	return mat;
 }
@@ -135,7 +148,7 @@ template<class Type> Type& SU3<Type>::getMat()
  * @parameter col index j
  * @return matrix element (i,j)
  */
-template<class Type> Complex<Real> SU3<Type>::get( lat_group_dim_t i, lat_group_dim_t j )
+template<class Type, class T_Real> Complex<T_Real> SU3<Type,T_Real>::get( lat_group_dim_t i, lat_group_dim_t j )
 {
 	return mat.get(i,j);
 }
@@ -146,7 +159,7 @@ template<class Type> Complex<Real> SU3<Type>::get( lat_group_dim_t i, lat_group_
  * @parameter col index j
  * @parameter element to set
  */
-template<class Type> void SU3<Type>::set( lat_group_dim_t i, lat_group_dim_t j, Complex<Real> c )
+template<class Type, class T_Real> void SU3<Type,T_Real>::set( lat_group_dim_t i, lat_group_dim_t j, Complex<T_Real> c )
 {
 	return mat.set(i,j,c);
 }
@@ -160,7 +173,7 @@ template<class Type> void SU3<Type>::set( lat_group_dim_t i, lat_group_dim_t j,
  * @parameter col of 2x2-subgroup, i.e. j = 0 or 1
  * @return matrix element in 2x2-submatrix.
  */
-template<class Type> Complex<Real> SU3<Type>::get( lat_group_dim_t iSub, lat_group_dim_t jSub, lat_group_dim_t i, lat_group_dim_t j )
+template<class Type, class T_Real> Complex<T_Real> SU3<Type,T_Real>::get( lat_group_dim_t iSub, lat_group_dim_t jSub, lat_group_dim_t i, lat_group_dim_t j )
 {
 	return mat.get( (i==0)?(iSub):(jSub), (j==1)?(iSub):(jSub) );
 }
@@ -173,7 +186,7 @@ template<class Type> Complex<Real> SU3<Type>::get( lat_group_dim_t iSub, lat_gro
  * @parameter col of 2x2-subgroup, i.e. j = 0 or 1
  * @parameter element to set.
  */
-template<class Type> void SU3<Type>::set( lat_group_dim_t iSub, lat_group_dim_t jSub, lat_group_dim_t i, lat_group_dim_t j, Complex<Real> c )
+template<class Type, class T_Real> void SU3<Type,T_Real>::set( lat_group_dim_t iSub, lat_group_dim_t jSub, lat_group_dim_t i, lat_group_dim_t j, Complex<T_Real> c )
 {
 	return mat.set((i==0)?(iSub):(jSub), (j==1)?(iSub):(jSub) ,c);
 }
@@ -190,10 +203,10 @@ template<class Type> void SU3<Type>::set( lat_group_dim_t iSub, lat_group_dim_t
  * @parameter first subgroup index
  * @parameter second subgroup index
  */
-template<class Type> Quaternion<Real> SU3<Type>::getSubgroupQuaternion( lat_group_dim_t iSub, lat_group_dim_t jSub )
+template<class Type, class T_Real> Quaternion<T_Real> SU3<Type,T_Real>::getSubgroupQuaternion( lat_group_dim_t iSub, lat_group_dim_t jSub )
 {
-	Quaternion<Real> q;
-	Complex<Real> temp;
+	Quaternion<T_Real> q;
+	Complex<T_Real> temp;
 	temp = mat.get(iSub,iSub);
 	q[0] = temp.x;
 	q[3] = temp.y;
@@ -216,9 +229,9 @@ template<class Type> Quaternion<Real> SU3<Type>::getSubgroupQuaternion( lat_grou
 	return q;
 }
 
-template<class Type> Matrix<Complex<Real>, 2 > SU3<Type>::getSubgroupMatrix( lat_group_dim_t iSub, lat_group_dim_t jSub )
+template<class Type, class T_Real> Matrix<Complex<T_Real>, 2 > SU3<Type,T_Real>::getSubgroupMatrix( lat_group_dim_t iSub, lat_group_dim_t jSub )
 {
-	Matrix<Complex<Real>, 2 > subMatrix;
+	Matrix<Complex<T_Real>, 2 > subMatrix;
 
 	subMatrix.set( 0, 0, mat.get(iSub, iSub) );
 	subMatrix.set( 0, 1, mat.get(iSub, jSub) );
@@ -228,9 +241,9 @@ template<class Type> Matrix<Complex<Real>, 2 > SU3<Type>::getSubgroupMatrix( lat
 	return subMatrix;
 }
 
-template<class Type> Matrix<Complex<Real>, 2 > SU3<Type>::getSubgroupMatrixHermitian( lat_group_dim_t iSub, lat_group_dim_t jSub )
+template<class Type, class T_Real> Matrix<Complex<T_Real>, 2 > SU3<Type,T_Real>::getSubgroupMatrixHermitian( lat_group_dim_t iSub, lat_group_dim_t jSub )
 {
-	Matrix<Complex<Real>, 2 > subMatrix;
+	Matrix<Complex<T_Real>, 2 > subMatrix;
 
 	subMatrix.set( 0, 0, mat.get(iSub, iSub).conj() );
 	subMatrix.set( 0, 1, mat.get(jSub, iSub).conj() );
@@ -243,7 +256,7 @@ template<class Type> Matrix<Complex<Real>, 2 > SU3<Type>::getSubgroupMatrixHermi
 /**
  * Delegate operation to underlying storage class.
  */
-template<class Type> SU3<Type>& SU3<Type>::operator+=( SU3<Type> c )
+template<class Type, class T_Real> SU3<Type,T_Real>& SU3<Type,T_Real>::operator+=( SU3<Type,T_Real> c )
 {
 	mat += c.mat;
 	return *this;
@@ -252,12 +265,12 @@ template<class Type> SU3<Type>& SU3<Type>::operator+=( SU3<Type> c )
 /**
  *
  */
-template<class Type> template<class Type2> SU3<Type>& SU3<Type>::operator+=( SU3<Type2> c )
+template<class Type, class T_Real> template<class Type2, class T_Real2> SU3<Type,T_Real>& SU3<Type,T_Real>::operator+=( SU3<Type2,T_Real2> c )
 {
 	for( lat_group_dim_t i = 0; i < 3; i++ )
 		for( lat_group_dim_t j = 0; j < 3; j++ )
 		{
-			mat.set(i,j,mat.get(i,j) + c.mat.get(i,j));
+			mat.set(i,j,mat.get(i,j) + Complex<T_Real>( c.mat.get(i,j) ));
 		}
 	return *this;
 }
@@ -265,7 +278,7 @@ template<class Type> template<class Type2> SU3<Type>& SU3<Type>::operator+=( SU3
 /**
  * Delegate operation to underlying storage class.
  */
-template<class Type> SU3<Type>& SU3<Type>::operator-=( SU3<Type> c )
+template<class Type, class T_Real> SU3<Type,T_Real>& SU3<Type,T_Real>::operator-=( SU3<Type,T_Real> c )
 {
 	mat -= c.mat;
 	return *this;
@@ -274,19 +287,19 @@ template<class Type> SU3<Type>& SU3<Type>::operator-=( SU3<Type> c )
 /**
  * Delegate operation to underlying storage class.
  */
-template<class Type> SU3<Type>& SU3<Type>::operator*=( SU3<Type> c )
+template<class Type, class T_Real> SU3<Type,T_Real>& SU3<Type,T_Real>::operator*=( SU3<Type,T_Real> c )
 {
 	mat *= c.mat;
 	return *this;
 }
 
-template<class Type> SU3<Type>& SU3<Type>::operator/=( Complex<Real> c )
+template<class Type, class T_Real> SU3<Type,T_Real>& SU3<Type,T_Real>::operator/=( Complex<T_Real> c )
 {
 	mat /= c;
 	return *this;
 }
 
-template<class Type> SU3<Type>& SU3<Type>::operator-=( Complex<Real> c )
+template<class Type, class T_Real> SU3<Type,T_Real>& SU3<Type,T_Real>::operator-=( Complex<T_Real> c )
 {
 	mat -= c;
 	return *this;
@@ -295,12 +308,12 @@ template<class Type> SU3<Type>& SU3<Type>::operator-=( Complex<Real> c )
 /**
  * Assignment operator allowing different storage class at right and left side of the assignement.
  */
-template<class Type> template<class Type2> SU3<Type>& SU3<Type>::operator=( SU3<Type2> c )
+template<class Type, class T_Real> template<class Type2, class T_Real2> SU3<Type,T_Real>& SU3<Type,T_Real>::operator=( SU3<Type2,T_Real2> c )
 {
 	for( lat_group_dim_t i = 0; i < 3; i++ )
 		for( lat_group_dim_t j = 0; j < 3; j++ )
 		{
-			mat.set(i,j,c.mat.get(i,j));
+			mat.set(i,j,Complex<T_Real>( c.mat.get(i,j) ));
 		}
 	return *this;
 }
@@ -317,13 +330,14 @@ template<class Type> template<class Type2> SU3<Type>& SU3<Type>::operator=( SU3<
 /**
  * Assignement like operator=, but does not copy the third line.
  */
-template<class Type> template<class Type2> SU3<Type>& SU3<Type>::assignWithoutThirdLine( SU3<Type2> c )
+template<class Type, class T_Real> template<class Type2, class T_Real2> SU3<Type,T_Real>& SU3<Type,T_Real>::assignWithoutThirdLine( SU3<Type2,T_Real2> c )
 {
 	for( lat_group_dim_t i = 0; i < 2; i++ )
 		for( lat_group_dim_t j = 0; j < 3; j++ )
 		{
-			mat.set(i,j,c.mat.get(i,j));
+			mat.set(i,j,Complex<T_Real>( c.mat.get(i,j) ));
 		}
+	assignThirdLineInfo( mat, c.mat );
 	return *this;
 }
 
@@ -388,15 +402,15 @@ template<class Type> template<class Type2> SU3<Type>& SU3<Type>::assignWithoutTh
 /**
  * Multiplication of SU3 matrices.
  */
-template<class Type> template<class Type2> SU3<Type> SU3<Type>::operator*( SU3<Type2> b )
+template<class Type, class T_Real> template<class Type2, class T_Real2> SU3<Type,T_Real> SU3<Type,T_Real>::operator*( SU3<Type2,T_Real2> b )
 {
-	SU3<Type> c;
+	SU3<Type,T_Real> c;
 	c.zero();
 	for( lat_group_dim_t i = 0; i < 3; i++ )
 	{
 		for( lat_group_dim_t j = 0; j < 3; j++ )
 		{
-			Complex<Real> temp(0,0);
+			Complex<T_Real> temp(0,0);
 			for( lat_group_dim_t k = 0; k < 3; k++ )
 			{
 				temp += get(i,k)*b.get(k,j);
@@ -410,9 +424,9 @@ template<class Type> template<class Type2> SU3<Type> SU3<Type>::operator*( SU3<T
 /**
  * Summation of SU3 matrices.
  */
-template<class Type> template<class Type2> SU3<Type> SU3<Type>::operator+( SU3<Type2> b )
+template<class Type, class T_Real> template<class Type2, class T_Real2> SU3<Type,T_Real> SU3<Type,T_Real>::operator+( SU3<Type2,T_Real2> b )
 {
-	SU3<Type> c(*this);
+	SU3<Type,T_Real> c(*this);
 	return c+=b;
 }
 
@@ -420,10 +434,10 @@ template<class Type> template<class Type2> SU3<Type> SU3<Type>::operator+( SU3<T
  * Determinant.
  * TODO Check for faster implementations...
  */
-template<class Type> Complex<Real> SU3<Type>::det()
+template<class Type, class T_Real> Complex<T_Real> SU3<Type,T_Real>::det()
 {
-	Complex<Real> c( 0, 0 );
-	Complex<Real> temp = get(0,0);
+	Complex<T_Real> c( 0, 0 );
+	Complex<T_Real> temp = get(0,0);
 	temp *= get(1,1);
 	temp *= get(2,2);
 	c += temp;
@@ -461,7 +475,7 @@ template<class Type> Complex<Real> SU3<Type>::det()
 /**
  * Delegate trace() to underlying storage class.
  */
-template<class Type> Complex<Real> SU3<Type>::trace()
+template<class Type, class T_Real> Complex<T_Real> SU3<Type,T_Real>::trace()
 {
 	return mat.trace();
 }
@@ -469,7 +483,7 @@ template<class Type> Complex<Real> SU3<Type>::trace()
 /**
  * Set matrix to identity.
  */
-template<class Type> void SU3<Type>::identity()
+template<class Type, class T_Real> void SU3<Type,T_Real>::identity()
 {
 	for( lat_group_dim_t i = 0; i < 3; i++ )
 	{
@@ -477,11 +491,11 @@ template<class Type> void SU3<Type>::identity()
 		{
 			if( i == j )
 			{
-				set( i,j, Complex<Real>( 1, 0 ) );
+				set( i,j, Complex<T_Real>( 1, 0 ) );
 			}
 			else
 			{
-				set( i,j, Complex<Real>( 0, 0 ) );
+				set( i,j, Complex<T_Real>( 0, 0 ) );
 			}
 		}
 	}
@@ -490,9 +504,9 @@ template<class Type> void SU3<Type>::identity()
 /**
  * Set matrix to its hermitian. TODO this is a straight forward implementation, do it in a fast way!!!
  */
-template<class Type> SU3<Type>& SU3<Type>::hermitian()
+template<class Type, class T_Real> SU3<Type,T_Real>& SU3<Type,T_Real>::hermitian()
 {
-	Matrix<Complex<Real>,3> temp;
+	Matrix<Complex<T_Real>,3> temp;
 	for( lat_group_dim_t i = 0; i < 3; i++ )
 	{
 		for( lat_group_dim_t j = 0; j < 3; j++ )
@@ -513,13 +527,13 @@ template<class Type> SU3<Type>& SU3<Type>::hermitian()
 /**
  * Set matrix to zero.
  */
-template<class Type> void SU3<Type>::zero()
+template<class Type, class T_Real> void SU3<Type,T_Real>::zero()
 {
 	for( lat_group_dim_t i = 0; i < 3; i++ )
 	{
 		for(lat_group_dim_t j = 0; j < 3; j++ )
 		{
-			set( i,j, Complex<Real>(0, 0 ) );
+			set( i,j, Complex<T_Real>(0, 0 ) );
 		}
 	}
 }
@@ -533,10 +547,10 @@ template<class Type> void SU3<Type>::zero()
  * - Normalize second row
  * - Reconstruct the third row from the first two rows (cross-product).
  */
-template<class Type> void SU3<Type>::projectSU3()
+template<class Type, class T_Real> void SU3<Type,T_Real>::projectSU3()
 {
-	Real abs_u = 0, abs_v = 0;
-	Complex<Real> sp(0.,0.);
+	T_Real abs_u = 0, abs_v = 0;
+	Complex<T_Real> sp(0.,0.);
 
 	// normalize first row
 	for( lat_group_dim_t i = 0; i < 3; i++ )
@@ -592,10 +606,10 @@ template<class Type> void SU3<Type>::projectSU3()
  * - Normalize second row
  * - Reconstruct the third row from the first two rows (cross-product).
  */
-template<class Type> void SU3<Type>::projectSU3withoutThirdRow()
+template<class Type, class T_Real> void SU3<Type,T_Real>::projectSU3withoutThirdRow()
 {
-	Real abs_u = 0, abs_v = 0;
-	Complex<Real> sp(0.,0.);
+	T_Real abs_u = 0, abs_v = 0;
+	Complex<T_Real> sp(0.,0.);
 
 	// normalize first row
 	for( lat_group_dim_t i = 0; i < 3; i++ )
@@ -636,7 +650,7 @@ template<class Type> void SU3<Type>::projectSU3withoutThirdRow()
  * Reconstructs the third line of the 3x3 matrix from the first two rows. This is needed when we load only the first two rows
  * from memory to save memory bandwidth in CUDA applications.
  */
-template<class Type> void SU3<Type>::reconstructThirdLine()
+template<class Type, class T_Real> void SU3<Type,T_Real>::reconstructThirdLine()
 {
 //	Complex<Real> a00 = get(0,0);
 //	Complex<Real> a01 = get(0,1);
@@ -652,11 +666,11 @@ template<class Type> void SU3<Type>::reconstructThirdLine()
 
 
 
-	Complex<Real> a = get(0,1).conj() * get(1,2).conj() - get(0,2).conj() * get(1,1).conj();
-	Complex<Real> b = get(0,2).conj() * get(1,0).conj() - get(0,0).conj() * get(1,2).conj();
-	Complex<Real> c = get(0,0).conj() * get(1,1).conj() - get(0,1).conj() * get(1,0).conj();
+	Complex<T_Real> a = get(0,1).conj() * get(1,2).conj() - get(0,2).conj() * get(1,1).conj();
+	Complex<T_Real> b = get(0,2).conj() * get(1,0).conj() - get(0,0).conj() * get(1,2).conj();
+	Complex<T_Real> c = get(0,0).conj() * get(1,1).conj() - get(0,1).conj() * get(1,0).conj();
 
-	Real norm = a.abs_squared() + b.abs_squared() + c.abs_squared();
+	T_Real norm = a.abs_squared() + b.abs_squared() + c.abs_squared();
 	norm = 1./sqrt( norm );
 
 	set( 2, 0, a*norm );
@@ -679,15 +693,15 @@ template<class Type> void SU3<Type>::reconstructThirdLine()
  * Muliplication of the SU3 matrix by a SU2-subgroup element in Quaternion representation from the right.
  * TODO Be a bit more precise in the commentary...
  */
-template<class Type> void SU3<Type>::rightSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Quaternion<Real> *q )
+template<class Type, class T_Real> void SU3<Type,T_Real>::rightSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Quaternion<T_Real> *q )
 {
 	for( lat_group_dim_t k = 0; k < 3; k++ )
 	{
 //		ki = k*3+iSub;
-		Complex<Real> KI = q->get( 0, 0 ) * get(k,i);
+		Complex<T_Real> KI = q->get( 0, 0 ) * get(k,i);
 		KI += q->get( 1, 0 ) * get(k,j);
 
-		Complex<Real> KJ = q->get( 0, 1 ) * get(k,i);
+		Complex<T_Real> KJ = q->get( 0, 1 ) * get(k,i);
 		KJ += q->get(1,1) * get(k,j);
 
 		set( k, i , KI);
@@ -698,14 +712,14 @@ template<class Type> void SU3<Type>::rightSubgroupMult( lat_group_dim_t i, lat_g
 /**
  * Muliplication of the SU3 matrix by a SU2-subgroup element in Quaternion representation from the left.
  */
-template<class Type> void SU3<Type>::leftSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Quaternion<Real> *q )
+template<class Type, class T_Real> void SU3<Type,T_Real>::leftSubgroupMult( lat_group_dim_t i, lat_group_dim_t j, Quaternion<T_Real> *q )
 {
 	for( lat_group_dim_t k = 0; k < 3; k++ )
 	{
-		Complex<Real> IK = q->get( 0, 0 ) * get(i,k);
+		Complex<T_Real> IK = q->get( 0, 0 ) * get(i,k);
 		IK += q->get( 0, 1 ) * get(j,k);
 
-		Complex<Real> JK = q->get( 1, 0 ) * get(i,k);
+		Complex<T_Real> JK = q->get( 1, 0 ) * get(i,k);
 		JK += q->get(1,1) * get(j,k);
 
 		set( i, k , IK );
@@ -713,7 +727,7 @@ template<class Type> void SU3<Type>::leftSubgroupMult( lat_group_dim_t i, lat_gr
 	}
 }
 
-template<class Type> void SU3<Type>::print()
+template<class Type, class T_Real> void SU3<Type,T_Real>::print()
 {
 	printf( "[%f+i*%f\t %f+i*%f\t %f+i*%f\n", get(0,0).x, get(0,0).y, get(0,1).x, get(0,1).y, get(0,2).x, get(0,2).y );
 	printf( "%f+i*%f\t %f+i*%f\t %f+i*%f\n", get(1,0).x, get(1,0).y, get(1,1).x, get(1,1).y, get(1,2).x, get(1,2).y );
@@ -759,7 +773,7 @@ template<class Type> void SU3<Type>::print()
  * Performs an operation defined in the SubgroupOperationClass by calling its subgroup() function for 3 SU3 subgroups.
  * Check an example application, like the Coulomb-gaugefixing routine.
  */
-template<class Type> template<class SubgroupOperationClass> __device__ void SU3<Type>::perSubgroup( SubgroupOperationClass t )
+template<class Type, class T_Real> template<class SubgroupOperationClass> __device__ void SU3<Type,T_Real>::perSubgroup( SubgroupOperationClass t )
 {
 //	t.subgroup(0,1);
 //	t.subgroup(0,2);
@@ -243,6 +243,8 @@ template<lat_dim_t Nd, ParityType par> lat_coord_t SiteIndex<Nd, par>::getLattic
 /**
  * Sets the index to the neighbour given by mu = 0..(Nd-1) and direction "up": positive direction (up==true), negative direction (up==false)
  * using a neighbour table stored in memory. On the fly calculation reduces memory traffic but probably needs more registers.
+ * Alternatives with the same interface: SiteIndexOnTheFly (no table) and SiteIndexCompressed (16 bit offsets),
+ * see apps/NeighbourBenchmarkSU3_4D.cu for a comparison.
  */
 template<lat_dim_t Nd, ParityType par> void SiteIndex<Nd, par>::setNeighbour( lat_dim_t mu, bool up )
 {
@@ -0,0 +1,184 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Lattice Site using a 1 dimensional index and a compressed neighbour table.
+ *
+ * Same interface as "SiteIndex" but the neighbour table stores 16 bit offsets (lat_offset_t) instead of full indices,
+ * this halves the memory traffic and the size of the table.
+ * The neighbour in direction mu is (nearly) a constant step away from the site: +-stride[mu] in the lexicographic index,
+ * or -+(size[mu]-1)*stride[mu] across the periodic boundary. For the parity split index the step is halved and the
+ * neighbour lies in the other half of the lattice (for TIMESLICE_SPLIT: of the timeslice, except in time direction). Each entry
+ * of the table holds
+ * 	2*correction + wrap
+ * where "wrap" marks the boundary exceptions (use the step across the boundary) and "correction" (usually -1, 0 or 1)
+ * corrects the rounding of the halved step.
+ */
+
+#ifndef SITEINDEXCOMPRESSED_HXX_
+#define SITEINDEXCOMPRESSED_HXX_
+
+#include "cuda/cuda_host_device.h"
+#include "datatype/lattice_typedefs.h"
+#include "SiteIndex.hxx"
+#include <assert.h>
+
+template<lat_dim_t Nd, ParityType par> class SiteIndexCompressed
+{
+public:
+	CUDA_HOST_DEVICE inline SiteIndexCompressed( const lat_coord_t size[Nd] );
+	CUDA_HOST_DEVICE inline lat_index_t getLatticeIndex();
+	CUDA_HOST_DEVICE inline void setLatticeIndex( lat_index_t latticeIndex );
+	CUDA_HOST_DEVICE inline lat_index_t getLatticeSize();
+	CUDA_HOST_DEVICE inline lat_coord_t getLatticeSizeDirection( lat_dim_t i );
+	CUDA_HOST_DEVICE inline void setNeighbour( lat_dim_t direction, bool up );
+
+	inline void calculateNeighbourTable( lat_offset_t* nn );
+
+	static const lat_dim_t Ndim = Nd;
+	lat_offset_t* nn;
+
+	lat_coord_t size[Nd];
+private:
+	lat_index_t index;
+	lat_index_t latticeSize;
+	lat_index_t stride[Nd]; // strides of the lexicographic (NO_SPLIT) index
+
+	CUDA_HOST_DEVICE inline lat_index_t getOffset( lat_dim_t mu, bool up, bool wrap );
+};
+
+template <lat_dim_t Nd, ParityType par> SiteIndexCompressed<Nd, par>::SiteIndexCompressed( const lat_coord_t size[Nd] )
+{
+	latticeSize = 1;
+	for( lat_dim_t i = Nd-1; i >= 0; i-- )
+	{
+		this->size[i] = size[i];
+		stride[i] = latticeSize;
+		latticeSize *= size[i];
+	}
+}
+
+template<lat_dim_t Nd, ParityType par> lat_index_t SiteIndexCompressed<Nd, par>::getLatticeIndex()
+{
+	return index;
+}
+
+template<lat_dim_t Nd, ParityType par> void SiteIndexCompressed<Nd, par>::setLatticeIndex( lat_index_t latticeIndex )
+{
+	index = latticeIndex;
+}
+
+template<lat_dim_t Nd, ParityType par> lat_index_t SiteIndexCompressed<Nd, par>::getLatticeSize()
+{
+	return latticeSize;
+}
+
+template<lat_dim_t Nd, ParityType par> lat_coord_t SiteIndexCompressed<Nd, par>::getLatticeSizeDirection( lat_dim_t i )
+{
+	return size[i];
+}
+
+/**
+ * The offset of the neighbour without the correction from the table.
+ */
+template<lat_dim_t Nd, ParityType par> lat_index_t SiteIndexCompressed<Nd, par>::getOffset( lat_dim_t mu, bool up, bool wrap )
+{
+	lat_index_t step = (wrap)?( -(size[mu]-1)*stride[mu] ):( stride[mu] );
+	if( !up ) step = -step;
+
+	if( par == FULL_SPLIT )
+	{
+		return step/2 + ( (index >= latticeSize/2)?( -latticeSize/2 ):( latticeSize/2 ) );
+	}
+	else if( par == TIMESLICE_SPLIT && mu != 0 )
+	{
+		return step/2 + ( (index % stride[0] >= stride[0]/2)?( -stride[0]/2 ):( stride[0]/2 ) );
+	}
+	else
+	{
+		return step;
+	}
+}
+
+/**
+ * Sets the index to the neighbour given by mu = 0..(Nd-1) and direction "up": positive direction (up==true), negative direction (up==false)
+ * using the compressed neighbour table.
+ */
+template<lat_dim_t Nd, ParityType par> void SiteIndexCompressed<Nd, par>::setNeighbour( lat_dim_t mu, bool up )
+{
+	lat_offset_t entry = nn[(2*mu+up)*getLatticeSize()+index];
+	index += getOffset( mu, up, entry & 1 ) + (entry >> 1);
+}
+
+/**
+ * Calculates the compressed table from the neighbours of SiteIndex. Invoked only once, on the host.
+ */
+template<lat_dim_t Nd, ParityType par> void SiteIndexCompressed<Nd, par>::calculateNeighbourTable( lat_offset_t* nn )
+{
+	SiteIndex<Nd,par> full( size );
+
+	for( lat_index_t i = 0; i < getLatticeSize(); i++ )
+	{
+		lat_coord_t site[Nd];
+		lat_index_t latticeIndex = i;
+		for( lat_dim_t j = Nd-1; j >= 0; j-- ) // calculate site vector
+		{
+			site[j] = latticeIndex % size[j];
+			latticeIndex /= size[j];
+		}
+		setLatticeIndex( full.getLatticeIndex( site ) );
+
+		for( lat_dim_t j = 0; j < Nd; j++ )
+		{
+			for( int up = 0; up < 2; up++ )
+			{
+				lat_coord_t copySite[Nd];
+				for( int k = 0; k < Nd; k++ )
+					copySite[k] = site[k];
+
+				bool wrap = false;
+				if( up )
+				{
+					copySite[j]++;
+					if( copySite[j] >= size[j] )
+					{
+						copySite[j] -= size[j];
+						wrap = true;
+					}
+				}
+				else
+				{
+					copySite[j]--;
+					if( copySite[j] < 0 )
+					{
+						copySite[j] += size[j];
+						wrap = true;
+					}
+				}
+
+				lat_index_t correction = full.getLatticeIndex( copySite ) - index - getOffset( j, up, wrap );
+				assert( correction >= -16384 && correction < 16384 );
+				nn[(2*j+up)*getLatticeSize()+index] = (lat_offset_t)( 2*correction + wrap );
+			}
+		}
+	}
+}
+
+#endif /* SITEINDEXCOMPRESSED_HXX_ */
@@ -0,0 +1,160 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Lattice Site using a 1 dimensional index and on the fly neighbour calculation.
+ *
+ * Same interface as "SiteIndex" but setNeighbour() does not read a neighbour table: the neighbour is calculated from
+ * the lexicographic strides that are precomputed in the constructor. This saves the memory traffic for the table
+ * (and the table itself, latticeSize*2*Nd indices) at the cost of a few integer divisions.
+ * The member "nn" is kept for compatibility with SiteIndex and is not used.
+ *
+ * For the parity split index (FULL_SPLIT) all lattice extents have to be even, for TIMESLICE_SPLIT (each timeslice
+ * split by the parity of the spatial coordinates) all spatial extents.
+ */
+
+#ifndef SITEINDEXONTHEFLY_HXX_
+#define SITEINDEXONTHEFLY_HXX_
+
+#include "cuda/cuda_host_device.h"
+#include "datatype/lattice_typedefs.h"
+
+template<lat_dim_t Nd, ParityType par> class SiteIndexOnTheFly
+{
+public:
+	CUDA_HOST_DEVICE inline SiteIndexOnTheFly( const lat_coord_t size[Nd] );
+	CUDA_HOST_DEVICE inline lat_index_t getLatticeIndex();
+	CUDA_HOST_DEVICE inline void setLatticeIndex( lat_index_t latticeIndex );
+	CUDA_HOST_DEVICE inline lat_index_t getLatticeSize();
+	CUDA_HOST_DEVICE inline lat_coord_t getLatticeSizeDirection( lat_dim_t i );
+	CUDA_HOST_DEVICE inline void setNeighbour( lat_dim_t direction, bool up );
+
+	static const lat_dim_t Ndim = Nd;
+	lat_index_t* nn; // not used
+
+	lat_coord_t size[Nd];
+private:
+	lat_index_t index;
+	lat_index_t latticeSize;
+	lat_index_t stride[Nd]; // strides of the lexicographic (NO_SPLIT) index
+};
+
+template <lat_dim_t Nd, ParityType par> SiteIndexOnTheFly<Nd, par>::SiteIndexOnTheFly( const lat_coord_t size[Nd] )
+{
+	latticeSize = 1;
+	for( lat_dim_t i = Nd-1; i >= 0; i-- )
+	{
+		this->size[i] = size[i];
+		stride[i] = latticeSize;
+		latticeSize *= size[i];
+	}
+}
+
+template<lat_dim_t Nd, ParityType par> lat_index_t SiteIndexOnTheFly<Nd, par>::getLatticeIndex()
+{
+	return index;
+}
+
+template<lat_dim_t Nd, ParityType par> void SiteIndexOnTheFly<Nd, par>::setLatticeIndex( lat_index_t latticeIndex )
+{
+	index = latticeIndex;
+}
+
+template<lat_dim_t Nd, ParityType par> lat_index_t SiteIndexOnTheFly<Nd, par>::getLatticeSize()
+{
+	return latticeSize;
+}
+
+template<lat_dim_t Nd, ParityType par> lat_coord_t SiteIndexOnTheFly<Nd, par>::getLatticeSizeDirection( lat_dim_t i )
+{
+	return size[i];
+}
+
+/**
+ * Sets the index to the neighbour given by mu = 0..(Nd-1) and direction "up": positive direction (up==true), negative direction (up==false).
+ *
+ * FULL_SPLIT: the lexicographic index of a site with parity p and split index i is L = 2*(i-p*V/2) or L+1. Since all extents are
+ * even, the parity of coordinate j is the parity of L/stride[j], this decides between L and L+1. The neighbour has the opposite parity.
+ * TIMESLICE_SPLIT: the same within the timeslice t = i/stride[0] with the spatial coordinates only. The neighbour in time direction
+ * has the same (spatial) parity.
+ */
+template<lat_dim_t Nd, ParityType par> void SiteIndexOnTheFly<Nd, par>::setNeighbour( lat_dim_t mu, bool up )
+{
+	lat_index_t lexIndex;
+	bool parity = false;
+
+	if( par == FULL_SPLIT )
+	{
+		parity = ( index >= latticeSize/2 );
+		lexIndex = 2*( index - parity*(latticeSize/2) );
+
+		lat_index_t coordSum = 0;
+		for( lat_dim_t j = 0; j < Nd; j++ )
+		{
+			coordSum += lexIndex/stride[j];
+		}
+		if( (coordSum & 1) != parity ) lexIndex++;
+	}
+	else if( par == TIMESLICE_SPLIT )
+	{
+		lat_index_t timesliceIndex = index % stride[0];
+		parity = ( timesliceIndex >= stride[0]/2 );
+		lexIndex = 2*( timesliceIndex - parity*(stride[0]/2) );
+
+		lat_index_t coordSum = 0;
+		for( lat_dim_t j = 1; j < Nd; j++ )
+		{
+			coordSum += lexIndex/stride[j];
+		}
+		if( (coordSum & 1) != parity ) lexIndex++;
+		lexIndex += index - timesliceIndex;
+	}
+	else // NO_SPLIT
+	{
+		lexIndex = index;
+	}
+
+	lat_coord_t coord = (lexIndex/stride[mu]) % size[mu];
+	if( up )
+	{
+		lexIndex += ( coord == size[mu]-1 )?( -(size[mu]-1)*stride[mu] ):( stride[mu] );
+	}
+	else
+	{
+		lexIndex -= ( coord == 0 )?( -(size[mu]-1)*stride[mu] ):( stride[mu] );
+	}
+
+	if( par == FULL_SPLIT )
+	{
+		index = lexIndex/2 + (!parity)*(latticeSize/2);
+	}
+	else if( par == TIMESLICE_SPLIT )
+	{
+		lat_index_t timesliceIndex = lexIndex % stride[0];
+		if( mu != 0 ) parity = !parity;
+		index = lexIndex - timesliceIndex + timesliceIndex/2 + parity*(stride[0]/2);
+	}
+	else
+	{
+		index = lexIndex;
+	}
+}
+
+#endif /* SITEINDEXONTHEFLY_HXX_ */
@@ -0,0 +1,43 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Array of structures of arrays for SIMD host code.
+ *
+ * Tiles of T_Tile sites of the same parity (neighbours in z-direction: z, z+2, ...) are stored one after another,
+ * all Ndim*Nc*Nc*2 components of a tile are contiguous and the site within the tile runs fastest:
+ * 	index = ( ( tile*Ndim + mu )*Nc*Nc*2 + c+2*(j+Nc*i) )*T_Tile + lane
+ * Thus the T_Tile values of one matrix element are a single SIMD load (T_Tile = SIMD width), while the 18 components of
+ * a link are only T_Tile Reals apart (GpuPattern: a full lattice size, StandardPattern: not vectorizable).
+ * The tiles are ordered lexicographically, first all even then all odd tiles.
+ *
+ * This is MortonPattern with blocks of a single tile. Requirement: size[Ndim-1] is a multiple of 2*T_Tile.
+ */
+
+#ifndef AOSOAPATTERN_HXX_
+#define AOSOAPATTERN_HXX_
+
+#include "MortonPattern.hxx"
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile = 4> class AoSoAPattern : public MortonPattern<Site, T_Ndim, T_Nc, T_Tile, 1>
+{
+};
+
+#endif /* AOSOAPATTERN_HXX_ */
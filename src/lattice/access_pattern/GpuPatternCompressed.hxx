@@ -0,0 +1,71 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * GpuPattern for compressed link storage (Link12, Link8): only T_Reals instead of 2*Nc*Nc reals per link are stored.
+ *
+ * index = latticeIndex + latticeSize*( k + T_Reals*mu ), k = 0..T_Reals-1
+ *
+ * For T_Reals = 12 (the first two rows) k = c + 2*(j + Nc*i) is the same component order as in GpuPattern, getIndex()
+ * is valid for i < 2. The meaning of k for other T_Reals is defined by the storage class (see Link8).
+ * A field needs T_Reals*Ndim*latticeSize reals. The spatial halo buffers of MultiGPU_MPI use T_Reals = 12 with
+ * a single direction (mu = 0).
+ */
+
+#ifndef GPUPATTERNCOMPRESSED_HXX_
+#define GPUPATTERNCOMPRESSED_HXX_
+
+#include <assert.h>
+#include "../cuda/cuda_host_device.h"
+#include "../datatype/lattice_typedefs.h"
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Reals> class GpuPatternCompressed
+{
+public:
+	static const lat_group_dim_t Nc = T_Nc;
+	static const lat_index_t Ndim = T_Ndim;
+	static const int Reals = T_Reals;
+	CUDA_HOST_DEVICE static inline lat_index_t getSiteIndex( Site s );
+	CUDA_HOST_DEVICE static inline lat_array_index_t getLinkIndex( Site s, lat_dim_t mu );
+	CUDA_HOST_DEVICE static inline lat_array_index_t getIndex( Site s, lat_dim_t mu, lat_group_dim_t i, lat_group_dim_t j, bool c );
+	CUDA_HOST_DEVICE static inline lat_array_index_t getCompressedIndex( Site s, lat_dim_t mu, int k );
+};
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Reals> lat_index_t GpuPatternCompressed<Site, T_Ndim, T_Nc, T_Reals>::getSiteIndex( Site s )
+{
+	return s.getLatticeIndex();
+}
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Reals> lat_array_index_t GpuPatternCompressed<Site, T_Ndim, T_Nc, T_Reals>::getLinkIndex( Site s, lat_dim_t mu )
+{
+	return s.getLatticeIndex()+mu*T_Reals*s.getLatticeSize();
+}
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Reals> lat_array_index_t GpuPatternCompressed<Site, T_Ndim, T_Nc, T_Reals>::getIndex( Site s, lat_dim_t mu, lat_group_dim_t i, lat_group_dim_t j, bool c )
+{
+	return getCompressedIndex( s, mu, c + 2 * ( j + T_Nc * i ) );
+}
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Reals> lat_array_index_t GpuPatternCompressed<Site, T_Ndim, T_Nc, T_Reals>::getCompressedIndex( Site s, lat_dim_t mu, int k )
+{
+	return s.getLatticeIndex() + s.getLatticeSize()*( k + T_Reals * mu );
+}
+
+#endif /* GPUPATTERNCOMPRESSED_HXX_ */
@@ -0,0 +1,193 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Cache friendly pattern for host (CPU) sweeps.
+ *
+ * The sites of one parity are grouped in tiles of T_Tile sites that are neighbours in z-direction (z, z+2, ...).
+ * Within a tile the site index runs fastest, i.e. the same matrix element of the T_Tile links of a tile is contiguous
+ * and can be loaded into one SIMD register (T_Tile = 4 for AVX in double, 8 for AVX in single precision).
+ * The tiles are ordered along a Morton (Z-order) curve within blocks of T_Block^Ndim tiles, the blocks are
+ * ordered lexicographically. All neighbours of a site lie in the same or in adjacent blocks, which keeps the
+ * neighbour links in L2 during a sweep (the lexicographic order of GpuPattern jumps by a timeslice in t-direction).
+ * To profit from this, a sweep has to visit the tiles in storage order, see getTileCoordinates() and HostLandauKernelsSU3.
+ *
+ * index = ( ( tile*Ndim + mu )*Nc*Nc*2 + c+2*(j+Nc*i) )*T_Tile + lane
+ * tile = ( parity*blocks + block )*T_Block^Ndim + morton( tile coordinates within block )
+ *
+ * Requirements (see isCompatible()): T_Block is a power of 2, size[i] is a multiple of T_Block (i < Ndim-1) and
+ * size[Ndim-1] is a multiple of 2*T_Tile*T_Block.
+ * The Site class has to provide access to the coordinates (operator[]) and the lattice extents (size), like SiteCoord.
+ */
+
+#ifndef MORTONPATTERN_HXX_
+#define MORTONPATTERN_HXX_
+
+#include <assert.h>
+#include "../cuda/cuda_host_device.h"
+#include "../datatype/lattice_typedefs.h"
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile = 4, int T_Block = 4> class MortonPattern
+{
+public:
+	static const lat_group_dim_t Nc = T_Nc;
+	static const lat_index_t Ndim = T_Ndim;
+	static const int Tile = T_Tile;
+	static const int Block = T_Block;
+	CUDA_HOST_DEVICE static inline lat_index_t getSiteIndex( Site s );
+	CUDA_HOST_DEVICE static inline lat_array_index_t getLinkIndex( Site s, lat_dim_t mu );
+	CUDA_HOST_DEVICE static inline lat_array_index_t getIndex( Site s, lat_dim_t mu, lat_group_dim_t i, lat_group_dim_t j, bool c );
+	CUDA_HOST_DEVICE static inline lat_array_index_t getIndexByUnique( lat_array_index_t uniqueIndex, lat_coord_t size[T_Ndim] );
+
+	CUDA_HOST_DEVICE static inline lat_index_t getTile( Site s );
+	CUDA_HOST_DEVICE static inline int getLane( Site s );
+	CUDA_HOST_DEVICE static inline void getTileCoordinates( lat_index_t tile, const lat_coord_t size[T_Ndim], lat_coord_t coord[T_Ndim] );
+	static inline bool isCompatible( const lat_coord_t size[T_Ndim] );
+private:
+	CUDA_HOST_DEVICE static inline lat_index_t morton( const lat_coord_t inner[T_Ndim] );
+};
+
+/**
+ * Interleaves the bits of the coordinates within a block: bit b of coordinate i goes to bit b*Ndim+(Ndim-1-i).
+ */
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile, int T_Block> lat_index_t MortonPattern<Site, T_Ndim, T_Nc, T_Tile, T_Block>::morton( const lat_coord_t inner[T_Ndim] )
+{
+	lat_index_t code = 0;
+	for( int b = 0; (1<<b) < T_Block; b++ )
+	{
+		for( lat_dim_t i = 0; i < T_Ndim; i++ )
+		{
+			code |= ( (inner[i] >> b) & 1 ) << ( b*T_Ndim + (T_Ndim-1-i) );
+		}
+	}
+	return code;
+}
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile, int T_Block> lat_index_t MortonPattern<Site, T_Ndim, T_Nc, T_Tile, T_Block>::getTile( Site s )
+{
+	lat_index_t parity = 0;
+	for( lat_dim_t i = 0; i < T_Ndim; i++ )
+	{
+		parity += s[i];
+	}
+	parity %= 2;
+
+	// tile coordinates: the last direction is counted in tiles of same parity sites
+	lat_coord_t inner[T_Ndim];
+	lat_index_t block = 0;
+	lat_index_t blocks = 1;
+	lat_index_t blockVolume = 1;
+	for( lat_dim_t i = 0; i < T_Ndim; i++ )
+	{
+		lat_coord_t coord = s[i];
+		lat_coord_t extent = s.size[i];
+		if( i == T_Ndim-1 )
+		{
+			coord = coord/2/T_Tile;
+			extent = extent/2/T_Tile;
+		}
+		inner[i] = coord % T_Block;
+		block = block*(extent/T_Block) + coord/T_Block;
+		blocks *= extent/T_Block;
+		blockVolume *= T_Block;
+	}
+
+	return ( parity*blocks + block )*blockVolume + morton( inner );
+}
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile, int T_Block> int MortonPattern<Site, T_Ndim, T_Nc, T_Tile, T_Block>::getLane( Site s )
+{
+	return (s[T_Ndim-1]/2) % T_Tile;
+}
+
+/**
+ * Inverse of getTile() within one parity: the coordinates of the tile number "tile" (0..latticeSize/2/T_Tile-1) in storage
+ * order. coord[Ndim-1] is the position of the tile in the last direction (counted in tiles of same parity sites).
+ */
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile, int T_Block> void MortonPattern<Site, T_Ndim, T_Nc, T_Tile, T_Block>::getTileCoordinates( lat_index_t tile, const lat_coord_t size[T_Ndim], lat_coord_t coord[T_Ndim] )
+{
+	lat_index_t blockVolume = 1;
+	for( lat_dim_t i = 0; i < T_Ndim; i++ )
+	{
+		blockVolume *= T_Block;
+	}
+	lat_index_t code = tile % blockVolume;
+	lat_index_t block = tile / blockVolume;
+
+	for( lat_dim_t i = T_Ndim-1; i >= 0; i-- )
+	{
+		lat_coord_t extent = ( i == T_Ndim-1 )?( size[i]/2/T_Tile ):( size[i] );
+		lat_coord_t inner = 0;
+		for( int b = 0; (1<<b) < T_Block; b++ )
+		{
+			inner |= ( (code >> ( b*T_Ndim + (T_Ndim-1-i) )) & 1 ) << b;
+		}
+		coord[i] = ( block % (extent/T_Block) )*T_Block + inner;
+		block /= extent/T_Block;
+	}
+}
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile, int T_Block> lat_index_t MortonPattern<Site, T_Ndim, T_Nc, T_Tile, T_Block>::getSiteIndex( Site s )
+{
+	return getTile( s )*T_Ndim*T_Nc*T_Nc*2*T_Tile + getLane( s );
+}
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile, int T_Block> lat_array_index_t MortonPattern<Site, T_Ndim, T_Nc, T_Tile, T_Block>::getLinkIndex( Site s, lat_dim_t mu )
+{
+	return ( getTile( s )*T_Ndim + mu )*T_Nc*T_Nc*2*T_Tile + getLane( s );
+}
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile, int T_Block> lat_array_index_t MortonPattern<Site, T_Ndim, T_Nc, T_Tile, T_Block>::getIndex( Site s, lat_dim_t mu, lat_group_dim_t i, lat_group_dim_t j, bool c )
+{
+	return ( ( getTile( s )*T_Ndim + mu )*T_Nc*T_Nc*2 + c+2*(j+T_Nc*i) )*T_Tile + getLane( s );
+}
+
+/**
+ * calculate the pattern index from unique index (the index of StandardPattern).
+ */
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile, int T_Block> lat_array_index_t MortonPattern<Site, T_Ndim, T_Nc, T_Tile, T_Block>::getIndexByUnique( lat_array_index_t uniqueIndex, lat_coord_t size[T_Ndim] )
+{
+	bool c = uniqueIndex % 2;
+	uniqueIndex /= 2;
+	lat_group_dim_t j = uniqueIndex % T_Nc;
+	uniqueIndex /= T_Nc;
+	lat_group_dim_t i = uniqueIndex % T_Nc;
+	uniqueIndex /= T_Nc;
+	lat_dim_t mu = uniqueIndex % T_Ndim;
+	uniqueIndex /= T_Ndim;
+	lat_array_index_t latticeIndex = uniqueIndex;
+
+	Site s( size );
+	s.setLatticeIndexFromNonParitySplitOrder( latticeIndex );
+
+	return getIndex( s, mu, i, j, c );
+}
+
+template<class Site, lat_dim_t T_Ndim, lat_group_dim_t T_Nc, int T_Tile, int T_Block> bool MortonPattern<Site, T_Ndim, T_Nc, T_Tile, T_Block>::isCompatible( const lat_coord_t size[T_Ndim] )
+{
+	if( (T_Block & (T_Block-1)) != 0 ) return false;
+	for( lat_dim_t i = 0; i < T_Ndim-1; i++ )
+	{
+		if( size[i] % T_Block != 0 ) return false;
+	}
+	return ( size[T_Ndim-1] % (2*T_Tile*T_Block) == 0 );
+}
+
+#endif /* MORTONPATTERN_HXX_ */
@@ -0,0 +1,180 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Instrumented scalar type for the flop and memory access counting of kernels.
+ *
+ * CountingReal<T> wraps a float or double and counts each arithmetic operation it takes part in (add/sub, mul,
+ * div, sqrt/rsqrt and the transcendental functions). Loads and stores of the link array are counted by the link
+ * storage classes Link, Link12 and Link8 (see countLinkAccess()). A kernel that is templated on the real type is instantiated with CountingReal<Real>
+ * and runs on a field reinterpreted as CountingReal<Real>* (same size and layout as Real), see LandauKernelCounter.hxx.
+ *
+ * In device code the counters are __device__ variables that are incremented atomically, i.e. counting kernels are
+ * slow: run them on a few blocks only. In host code they are plain (not thread safe) variables.
+ *
+ * Conventions: sign changes, comparisons and conversions are not counted, sqrt/rsqrt and the transcendental
+ * functions are counted separately and as one flop each in OperationCounts::getFlops().
+ */
+
+#ifndef COUNTINGREAL_HXX_
+#define COUNTINGREAL_HXX_
+
+#include <math.h>
+#include "../cuda/cuda_host_device.h"
+
+enum CountedOperation { COUNT_ADD, COUNT_MUL, COUNT_DIV, COUNT_SQRT, COUNT_SPECIAL, COUNT_LOAD, COUNT_STORE, COUNTED_OPERATIONS };
+
+struct OperationCounts
+{
+	unsigned long long n[COUNTED_OPERATIONS];
+
+	unsigned long long getFlops() const
+	{
+		return n[COUNT_ADD]+n[COUNT_MUL]+n[COUNT_DIV]+n[COUNT_SQRT]+n[COUNT_SPECIAL];
+	}
+	unsigned long long getAccesses() const
+	{
+		return n[COUNT_LOAD]+n[COUNT_STORE];
+	}
+};
+
+#ifdef __CUDACC__
+__device__ unsigned long long deviceOperationCounts[COUNTED_OPERATIONS];
+#endif
+
+inline unsigned long long* hostOperationCounts()
+{
+	static unsigned long long counts[COUNTED_OPERATIONS];
+	return counts;
+}
+
+CUDA_HOST_DEVICE inline void countOperation( CountedOperation op, unsigned long long n = 1 )
+{
+#ifdef __CUDA_ARCH__
+	atomicAdd( &deviceOperationCounts[op], n );
+#else
+	hostOperationCounts()[op] += n;
+#endif
+}
+
+inline void resetHostOperationCounts()
+{
+	for( int i = 0; i < COUNTED_OPERATIONS; i++ ) hostOperationCounts()[i] = 0;
+}
+
+inline OperationCounts getHostOperationCounts()
+{
+	OperationCounts counts;
+	for( int i = 0; i < COUNTED_OPERATIONS; i++ ) counts.n[i] = hostOperationCounts()[i];
+	return counts;
+}
+
+#ifdef __CUDACC__
+inline void resetDeviceOperationCounts()
+{
+	unsigned long long zero[COUNTED_OPERATIONS] = { 0 };
+	cudaMemcpyToSymbol( deviceOperationCounts, zero, sizeof(zero) );
+}
+
+inline OperationCounts getDeviceOperationCounts()
+{
+	OperationCounts counts;
+	cudaMemcpyFromSymbol( counts.n, deviceOperationCounts, sizeof(counts.n) );
+	return counts;
+}
+#endif
+
+template<class T> class CountingReal
+{
+public:
+	T x;
+
+	// the default constructor is empty: CountingReal may be used for __shared__ arrays
+	CUDA_HOST_DEVICE inline CountingReal() {}
+	CUDA_HOST_DEVICE inline CountingReal( int a ) : x(a) {}
+	CUDA_HOST_DEVICE inline CountingReal( unsigned int a ) : x(a) {}
+	CUDA_HOST_DEVICE inline CountingReal( long a ) : x(a) {}
+	CUDA_HOST_DEVICE inline CountingReal( float a ) : x(a) {}
+	CUDA_HOST_DEVICE inline CountingReal( double a ) : x(a) {}
+	// the update classes work on volatile shared memory
+	CUDA_HOST_DEVICE inline CountingReal( const volatile CountingReal& a ) : x(a.x) {}
+
+	CUDA_HOST_DEVICE inline CountingReal& operator=( CountingReal a ) { x = a.x; return *this; }
+	CUDA_HOST_DEVICE inline volatile CountingReal& operator=( CountingReal a ) volatile { x = a.x; return *this; }
+
+	CUDA_HOST_DEVICE inline CountingReal& operator+=( CountingReal a ) { countOperation( COUNT_ADD ); x += a.x; return *this; }
+	CUDA_HOST_DEVICE inline CountingReal& operator-=( CountingReal a ) { countOperation( COUNT_ADD ); x -= a.x; return *this; }
+	CUDA_HOST_DEVICE inline CountingReal& operator*=( CountingReal a ) { countOperation( COUNT_MUL ); x *= a.x; return *this; }
+	CUDA_HOST_DEVICE inline CountingReal& operator/=( CountingReal a ) { countOperation( COUNT_DIV ); x /= a.x; return *this; }
+	CUDA_HOST_DEVICE inline volatile CountingReal& operator+=( CountingReal a ) volatile { countOperation( COUNT_ADD ); x += a.x; return *this; }
+	CUDA_HOST_DEVICE inline volatile CountingReal& operator-=( CountingReal a ) volatile { countOperation( COUNT_ADD ); x -= a.x; return *this; }
+	CUDA_HOST_DEVICE inline volatile CountingReal& operator*=( CountingReal a ) volatile { countOperation( COUNT_MUL ); x *= a.x; return *this; }
+	CUDA_HOST_DEVICE inline volatile CountingReal& operator/=( CountingReal a ) volatile { countOperation( COUNT_DIV ); x /= a.x; return *this; }
+
+	CUDA_HOST_DEVICE inline CountingReal operator-() const volatile { return CountingReal( -x ); }
+	CUDA_HOST_DEVICE inline CountingReal operator+() const volatile { return CountingReal( x ); }
+
+	// friends are only found by argument dependent lookup, i.e. mixed expressions like 2.*a convert the plain number
+	CUDA_HOST_DEVICE friend inline CountingReal operator+( CountingReal a, CountingReal b ) { countOperation( COUNT_ADD ); return CountingReal( a.x+b.x ); }
+	CUDA_HOST_DEVICE friend inline CountingReal operator-( CountingReal a, CountingReal b ) { countOperation( COUNT_ADD ); return CountingReal( a.x-b.x ); }
+	CUDA_HOST_DEVICE friend inline CountingReal operator*( CountingReal a, CountingReal b ) { countOperation( COUNT_MUL ); return CountingReal( a.x*b.x ); }
+	CUDA_HOST_DEVICE friend inline CountingReal operator/( CountingReal a, CountingReal b ) { countOperation( COUNT_DIV ); return CountingReal( a.x/b.x ); }
+
+	CUDA_HOST_DEVICE friend inline bool operator<( CountingReal a, CountingReal b ) { return a.x < b.x; }
+	CUDA_HOST_DEVICE friend inline bool operator>( CountingReal a, CountingReal b ) { return a.x > b.x; }
+	CUDA_HOST_DEVICE friend inline bool operator<=( CountingReal a, CountingReal b ) { return a.x <= b.x; }
+	CUDA_HOST_DEVICE friend inline bool operator>=( CountingReal a, CountingReal b ) { return a.x >= b.x; }
+	CUDA_HOST_DEVICE friend inline bool operator==( CountingReal a, CountingReal b ) { return a.x == b.x; }
+	CUDA_HOST_DEVICE friend inline bool operator!=( CountingReal a, CountingReal b ) { return a.x != b.x; }
+
+	CUDA_HOST_DEVICE friend inline CountingReal sqrt( CountingReal a ) { countOperation( COUNT_SQRT ); return CountingReal( sqrt( a.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal rsqrt( CountingReal a ) { countOperation( COUNT_SQRT ); return CountingReal( rsqrt( a.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal log( CountingReal a ) { countOperation( COUNT_SPECIAL ); return CountingReal( log( a.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal exp( CountingReal a ) { countOperation( COUNT_SPECIAL ); return CountingReal( exp( a.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal sin( CountingReal a ) { countOperation( COUNT_SPECIAL ); return CountingReal( sin( a.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal cos( CountingReal a ) { countOperation( COUNT_SPECIAL ); return CountingReal( cos( a.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal sinpi( CountingReal a ) { countOperation( COUNT_SPECIAL ); return CountingReal( sinpi( a.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal cospi( CountingReal a ) { countOperation( COUNT_SPECIAL ); return CountingReal( cospi( a.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal atan2( CountingReal a, CountingReal b ) { countOperation( COUNT_SPECIAL ); return CountingReal( atan2( a.x, b.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal fabs( CountingReal a ) { return CountingReal( fabs( a.x ) ); }
+	CUDA_HOST_DEVICE friend inline CountingReal abs( CountingReal a ) { return CountingReal( fabs( a.x ) ); }
+};
+
+/**
+ * Counts the reals of a link that are read from or written to the link array (called by Link).
+ */
+template<class T> CUDA_HOST_DEVICE inline void countLinkAccess( CountingReal<T>*, int loads, int stores )
+{
+	countOperation( COUNT_LOAD, loads );
+	countOperation( COUNT_STORE, stores );
+}
+
+#ifdef __CUDACC__
+/**
+ * The subgroup steps sum up the local functional in shared memory with atomicAdd (single precision).
+ */
+template<class T> __device__ inline CountingReal<T> atomicAdd( CountingReal<T>* address, CountingReal<T> val )
+{
+	countOperation( COUNT_ADD );
+	return CountingReal<T>( atomicAdd( &address->x, val.x ) );
+}
+#endif
+
+#endif /* COUNTINGREAL_HXX_ */
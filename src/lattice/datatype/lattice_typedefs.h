@@ -38,6 +38,9 @@ typedef int lat_index_t;
 // type for index of the global link array
 typedef int lat_array_index_t;
 
+// type for the relative offsets in compressed neighbour tables
+typedef short lat_offset_t;
+
 // TODO define somewhere in "/gaugefixing"
 // enum for the kind of gauge, i.e. Landau, Coulomb, Maximally Abelian, U(1)_3 x U(1)_8, ...
 enum GaugeType {LANDAU, COULOMB, MAG, U1xU1};
@@ -0,0 +1,159 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Host (CPU) version of PhiloxWrapper that runs W generators in lockstep.
+ *
+ * Lane l is the generator of thread id tid[l]: the key is (tid[l], seed), the counter (kernelCounter, globalCounter,
+ * 0x12345678, 0xabcdef09), exactly as in PhiloxWrapper. Hence lane l returns the same sequence as
+ * PhiloxWrapper( tid[l], seed, globalCounter ) on the device, for float and for double.
+ *
+ * The Philox4x32-10 rounds are written as loops over the lanes with 32x32->64 bit multiplications. These loops have
+ * no dependencies between lanes and are vectorized by the compiler (-O3): W=4 fills an SSE2 register, W=8 an AVX2
+ * and W=16 an AVX-512 register (the vendored Random123 has no SIMD philox, only the constants and u01 conversions
+ * are taken from there).
+ *
+ * All lanes draw in lockstep, thus the kernel counter and the cache of unused numbers are shared by the lanes.
+ */
+
+#ifndef HOSTPHILOXWRAPPER_HXX_
+#define HOSTPHILOXWRAPPER_HXX_
+
+#include "../../external/Random123/philox.h"
+#include "../../external/Random123/u01.h"
+
+template<int W> class HostPhiloxWrapper
+{
+public:
+	static const int Lanes = W;
+
+	HostPhiloxWrapper( const int* tid, int seed, unsigned int globalCounter );
+	HostPhiloxWrapper( int firstTid, int seed, unsigned int globalCounter );
+
+	inline void rand( float* r );
+	inline void rand( double* r );
+
+private:
+	uint32_t key0[W];
+	uint32_t key1;
+	uint32_t kernelCounter;
+	uint32_t globalCounter;
+	uint32_t res[4][W];
+	short localCounter; // number of unused 32 bit values per lane
+
+	inline void generate();
+};
+
+template<int W> HostPhiloxWrapper<W>::HostPhiloxWrapper( const int* tid, int seed, unsigned int globalCounter ) : key1(seed), kernelCounter(0), globalCounter(globalCounter), localCounter(0)
+{
+	for( int l = 0; l < W; l++ )
+	{
+		key0[l] = tid[l];
+	}
+}
+
+/**
+ * Lanes firstTid, ..., firstTid+W-1.
+ */
+template<int W> HostPhiloxWrapper<W>::HostPhiloxWrapper( int firstTid, int seed, unsigned int globalCounter ) : key1(seed), kernelCounter(0), globalCounter(globalCounter), localCounter(0)
+{
+	for( int l = 0; l < W; l++ )
+	{
+		key0[l] = firstTid + l;
+	}
+}
+
+/**
+ * Philox4x32-10 for all lanes (see philox4x32round and philox4x32bumpkey in Random123/philox.h).
+ */
+template<int W> void HostPhiloxWrapper<W>::generate()
+{
+	kernelCounter++;
+
+	uint32_t x0[W], x1[W], x2[W], x3[W], k0[W];
+	uint32_t k1 = key1;
+	for( int l = 0; l < W; l++ )
+	{
+		x0[l] = kernelCounter;
+		x1[l] = globalCounter;
+		x2[l] = 0x12345678;
+		x3[l] = 0xabcdef09;
+		k0[l] = key0[l];
+	}
+
+	for( int round = 0; round < 10; round++ )
+	{
+		if( round > 0 )
+		{
+			for( int l = 0; l < W; l++ ) k0[l] += PHILOX_W32_0;
+			k1 += PHILOX_W32_1;
+		}
+
+		for( int l = 0; l < W; l++ )
+		{
+			uint64_t p0 = (uint64_t)PHILOX_M4x32_0 * x0[l];
+			uint64_t p1 = (uint64_t)PHILOX_M4x32_1 * x2[l];
+			uint32_t y0 = (uint32_t)(p1 >> 32) ^ x1[l] ^ k0[l];
+			uint32_t y2 = (uint32_t)(p0 >> 32) ^ x3[l] ^ k1;
+			x1[l] = (uint32_t)p1;
+			x3[l] = (uint32_t)p0;
+			x0[l] = y0;
+			x2[l] = y2;
+		}
+	}
+
+	for( int l = 0; l < W; l++ )
+	{
+		res[0][l] = x0[l];
+		res[1][l] = x1[l];
+		res[2][l] = x2[l];
+		res[3][l] = x3[l];
+	}
+	localCounter = 4;
+}
+
+/**
+ * One float per lane.
+ */
+template<int W> void HostPhiloxWrapper<W>::rand( float* r )
+{
+	if( localCounter == 0 ) generate();
+	localCounter--;
+	for( int l = 0; l < W; l++ )
+	{
+		r[l] = u01_open_open_32_24( res[localCounter][l] );
+	}
+}
+
+/**
+ * One double per lane (two 32 bit values, an odd leftover value is dropped as in PhiloxWrapper).
+ */
+template<int W> void HostPhiloxWrapper<W>::rand( double* r )
+{
+	localCounter -= localCounter % 2;
+	if( localCounter == 0 ) generate();
+	localCounter -= 2;
+	for( int l = 0; l < W; l++ )
+	{
+		r[l] = u01_open_open_64_53( (uint64_t)res[localCounter][l] | ((uint64_t)res[localCounter+1][l] << 32) );
+	}
+}
+
+#endif /* HOSTPHILOXWRAPPER_HXX_ */
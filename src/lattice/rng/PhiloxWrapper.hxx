@@ -33,17 +33,17 @@
  *
  * Each call to philox4x32 calculates 4 32 bit values.
  *
- * We offer a rand() function that
- *  - returns a Real (float or double)
+ * We offer a rand<T>() function that
+ *  - returns a float (24 random bits from one 32 bit value) or a double (53 random bits from two 32 bit values)
  *  - takes care to use already calculated numbers.
  * 	- and increments the kernelCounter.
+ * rand() returns a Real. Single and double precision numbers can be drawn from the same object.
  *
  * The static getNextCounter() function gives a global (runtime-wide) counter which can be given to the constructor.
  * I don't want to do this implicitly to avoid mixing of host and device variables.
+ * setCounter() restores the global counter, e.g. when a run is continued from a checkpoint.
  *
  *
- * TODO: get rid of the preprocessor statements: float/double has to be template argument (in all classes).
- * 		Because now there is no code possible that uses both single and double precision random numbers.
  * TODO: In CUDA5.0 a lot of stack-frame is used when Philox is involved (~ 200 bytes for the single precision SA kernel)
  */
 
@@ -65,9 +65,11 @@ public:
 	__device__ inline PhiloxWrapper( int tid, int seed, unsigned int globalCounter );
 	__device__ inline virtual ~PhiloxWrapper();
 	__device__ inline Real rand();
+	template<class T> __device__ inline T rand();
 
 	static __host__ unsigned int getNextCounter();
 	static __host__ unsigned int getCurrentCounter();
+	static __host__ void setCounter( unsigned int counter );
 
 private:
 	philox4x32_key_t k;
@@ -75,13 +77,10 @@ private:
 	union
 	{
 		philox4x32_ctr_t res;
-#ifdef DOUBLEPRECISION
-		uint64_t i[2];
-#else
-		uint32_t i[4];
-#endif
+		uint64_t i64[2];
+		uint32_t i32[4];
 	} u;
-	short localCounter;
+	short localCounter; // number of unused 32 bit values in u
 //	int localCounter;
 	static unsigned int globalCounter;
 };
@@ -105,35 +104,34 @@ __device__ PhiloxWrapper::~PhiloxWrapper()
 {
 }
 
-__device__ Real PhiloxWrapper::rand()
+template<> __device__ inline float PhiloxWrapper::rand<float>()
 {
-#ifdef DOUBLEPRECISION
-	if( localCounter == 0 )// we have to calculate two new doubles
+	if( localCounter == 0 ) // we have to calculate 4 new floats
 	{
-		localCounter = 1;
+		localCounter = 4;
 		c[0]++; // inkrement the kernel counter
 		u.res = philox4x32(c,k);
-		return u01_open_open_64_53( u.i[localCounter] );
 	}
-	else  // we have another double available.
-	{
-		localCounter--;
-		return u01_open_open_64_53( u.i[localCounter] );
-	}
-#else
-	if( localCounter == 0 ) // we have to calculate 4 new floats
+	localCounter--;
+	return u01_open_open_32_24( u.i32[localCounter] );
+}
+
+template<> __device__ inline double PhiloxWrapper::rand<double>()
+{
+	localCounter -= localCounter % 2; // an odd leftover 32 bit value (after a float) is dropped
+	if( localCounter == 0 ) // we have to calculate two new doubles
 	{
-		localCounter = 3;
+		localCounter = 4;
 		c[0]++; // inkrement the kernel counter
 		u.res = philox4x32(c,k);
-		return u01_open_open_32_24( u.i[localCounter] );
 	}
-	else // we have another float available.
-	{
-		localCounter--;
-		return u01_open_open_32_24( u.i[localCounter] );
-	}
-#endif
+	localCounter -= 2;
+	return u01_open_open_64_53( u.i64[localCounter/2] );
+}
+
+__device__ Real PhiloxWrapper::rand()
+{
+	return rand<Real>();
 }
 
 /**
@@ -149,6 +147,11 @@ __host__ unsigned int PhiloxWrapper::getCurrentCounter()
 	return globalCounter;
 }
 
+__host__ void PhiloxWrapper::setCounter( unsigned int counter )
+{
+	globalCounter = counter;
+}
+
 
 
 #endif /* PHILOXWRAPPER_HXX_ */
@@ -2,6 +2,27 @@
  *
  * @author Hannes Vogt (hannes@havogt.de) Universitaet Tuebingen - Institut fuer Theoretische Physik
  * @date 2012-04-13
+ *
+ * Host messages are written asynchronously: each thread formats its records into its own ring buffer (no lock, the
+ * thread is the only writer of the head, the flusher the only writer of the tail) and a background thread writes
+ * the rings to stdout. The level is checked before anything is formatted, a disabled message costs a comparison.
+ *
+ *	util::Logger::setLevel( util::INFO );
+ *	util::Logger::setConfig( config );
+ *	util::Logger::setCopy( copy );
+ *	util::Logger::logf( util::INFO, "gff: %1.10f dA: %e", gff, dA );
+ *
+ * The structured fields (rank, config, copy, iteration) are per thread and are printed in front of the message
+ * if they are set (>= 0):
+ *
+ *	   12.345678 INFO  conf=3 copy=1 iter=200: gff: 0.8765432101 dA: 1.234567e-09
+ *
+ * If the ring of a thread is full, DEBUG and INFO messages are dropped (the number is reported), WARN and above
+ * are written by the calling thread. FATAL messages are written before logf() returns. The flusher is started
+ * with the first message and stopped at exit, after the remaining records are written. Messages are truncated
+ * to LOG_TEXT_LENGTH-1 characters.
+ *
+ * In device code log() prints via printf if LOGON is defined.
  */
 
 #ifndef LOGGER_H_
@@ -9,28 +30,90 @@
 
 #include <string>
 #include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
 #include "../../lattice/cuda/cuda_host_device.h"
 
 
 namespace util
 {
-enum LOGLEVEL { DEBUG, WARN, ERROR, FATAL };
+enum LOGLEVEL { DEBUG, INFO, WARN, ERROR, FATAL };
+
+CUDA_DEVICE LOGLEVEL curLevel = INFO;
+
+const int LOG_TEXT_LENGTH = 216;
+
+struct LogRecord
+{
+	timespec time;
+	LOGLEVEL level;
+	int rank;
+	int config;
+	int copy;
+	int iteration;
+	char text[LOG_TEXT_LENGTH];
+};
 
-CUDA_DEVICE LOGLEVEL curLevel = DEBUG;
+struct LogFields
+{
+	int rank;
+	int config;
+	int copy;
+	int iteration;
+};
+
+/**
+ * Single producer (the owning thread), single consumer (the thread that holds the flush mutex).
+ */
+struct LogRing
+{
+	static const unsigned int SIZE = 1024; // power of two
+	LogRecord records[SIZE];
+	volatile unsigned int head;
+	volatile unsigned int tail;
+	volatile unsigned int dropped;
+	LogRing* next;
+};
 
 class Logger
 {
 public:
 	CUDA_HOST_DEVICE static void log( LOGLEVEL level, const char* text );
 	CUDA_HOST_DEVICE static void setLevel( LOGLEVEL level );
+	static LOGLEVEL getLevel();
+	static bool isEnabled( LOGLEVEL level );
+	static void logf( LOGLEVEL level, const char* format, ... );
+	static void setRank( int rank );
+	static void setConfig( int config );
+	static void setCopy( int copy );
+	static void setIteration( int iteration );
+	static void setAsync( bool async );
+	static void flush();
 	Logger(){};
 private:
+	static LogFields& fields();
+	static LogRing*& threadRing();
+	static LogRing*& rings();
+	static pthread_mutex_t* ringMutex();
+	static pthread_mutex_t* flushMutex();
+	static bool& async();
+	static volatile bool& stopping();
+	static pthread_t& flusherThread();
+	static timespec& startTime();
+	static void start();
+	static void stop();
+	static void* flusher( void* );
+	static int drain();
+	static void write( const LogRecord& record );
 };
 
 
 /**
  * set log-level
  * DEBUG = All messages
+ * INFO = info, warn, error, fatal messages
  * WARN = warn, error, fatal messages
  * ERROR = error, fatal messages
  * FATAL = fatal messages
@@ -41,17 +124,260 @@ void Logger::setLevel( LOGLEVEL level )
 }
 
 /**
- * prints log via printf (for compatibility reasons to CUDA)
+ * device: prints log via printf (for compatibility reasons to CUDA)
+ * host: see logf()
  */
 void Logger::log( LOGLEVEL level, const char* text )
 {
-
+#ifdef __CUDA_ARCH__
 #ifdef LOGON
 	if( level >= util::curLevel )
 	{
 		printf( "%s\n", text );
 	}
 #endif
+#else
+	if( level >= util::curLevel )
+	{
+		logf( level, "%s", text );
+	}
+#endif
+}
+
+LOGLEVEL Logger::getLevel()
+{
+	return util::curLevel;
+}
+
+bool Logger::isEnabled( LOGLEVEL level )
+{
+	return level >= util::curLevel;
+}
+
+/**
+ * Formats the message (printf format) into the ring of the calling thread.
+ */
+void Logger::logf( LOGLEVEL level, const char* format, ... )
+{
+	if( level < util::curLevel ) return;
+
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once( &once, Logger::start );
+
+	LogRing* ring = threadRing();
+	if( ring->head - ring->tail >= LogRing::SIZE )
+	{
+		if( level < WARN )
+		{
+			__sync_fetch_and_add( &ring->dropped, 1 );
+			return;
+		}
+		while( ring->head - ring->tail >= LogRing::SIZE ) drain();
+	}
+
+	LogRecord& record = ring->records[ring->head & (LogRing::SIZE-1)];
+	clock_gettime( CLOCK_MONOTONIC, &record.time );
+	record.level = level;
+	record.rank = fields().rank;
+	record.config = fields().config;
+	record.copy = fields().copy;
+	record.iteration = fields().iteration;
+
+	va_list args;
+	va_start( args, format );
+	vsnprintf( record.text, LOG_TEXT_LENGTH, format, args );
+	va_end( args );
+
+	// the record has to be complete before the flusher sees the new head
+	__sync_synchronize();
+	ring->head = ring->head + 1;
+
+	if( level == FATAL || !async() ) flush();
+}
+
+void Logger::setRank( int rank )
+{
+	fields().rank = rank;
+}
+
+void Logger::setConfig( int config )
+{
+	fields().config = config;
+}
+
+void Logger::setCopy( int copy )
+{
+	fields().copy = copy;
+}
+
+void Logger::setIteration( int iteration )
+{
+	fields().iteration = iteration;
+}
+
+/**
+ * Without the flusher each message is written before logf() returns (default: asynchronous).
+ */
+void Logger::setAsync( bool async )
+{
+	Logger::async() = async;
+	if( !async ) flush();
+}
+
+/**
+ * Writes all pending records (of all threads).
+ */
+void Logger::flush()
+{
+	drain();
+}
+
+LogFields& Logger::fields()
+{
+	static __thread LogFields fields = { -1, -1, -1, -1 };
+	return fields;
+}
+
+/**
+ * The ring of the calling thread, it is created and registered with the first message of the thread. Rings are
+ * never freed: the flusher may still have to write the records of a thread that has finished.
+ */
+LogRing*& Logger::threadRing()
+{
+	static __thread LogRing* ring = 0;
+	if( ring == 0 )
+	{
+		ring = (LogRing*)malloc( sizeof(LogRing) );
+		ring->head = 0;
+		ring->tail = 0;
+		ring->dropped = 0;
+		pthread_mutex_lock( ringMutex() );
+		ring->next = rings();
+		__sync_synchronize();
+		rings() = ring;
+		pthread_mutex_unlock( ringMutex() );
+	}
+	return ring;
+}
+
+LogRing*& Logger::rings()
+{
+	static LogRing* rings = 0;
+	return rings;
+}
+
+pthread_mutex_t* Logger::ringMutex()
+{
+	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	return &mutex;
+}
+
+pthread_mutex_t* Logger::flushMutex()
+{
+	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	return &mutex;
+}
+
+bool& Logger::async()
+{
+	static bool async = true;
+	return async;
+}
+
+volatile bool& Logger::stopping()
+{
+	static volatile bool stopping = false;
+	return stopping;
+}
+
+pthread_t& Logger::flusherThread()
+{
+	static pthread_t thread;
+	return thread;
+}
+
+timespec& Logger::startTime()
+{
+	static timespec time;
+	return time;
+}
+
+void Logger::start()
+{
+	clock_gettime( CLOCK_MONOTONIC, &startTime() );
+	if( pthread_create( &flusherThread(), NULL, flusher, NULL ) != 0 )
+	{
+		// no thread available: write synchronously
+		async() = false;
+		return;
+	}
+	atexit( Logger::stop );
+}
+
+void Logger::stop()
+{
+	stopping() = true;
+	pthread_join( flusherThread(), NULL );
+	async() = false;
+	flush();
+}
+
+void* Logger::flusher( void* )
+{
+	const timespec interval = { 0, 2000000 };
+	while( true )
+	{
+		bool last = stopping();
+		int n = drain();
+		if( last ) break;
+		if( n == 0 ) nanosleep( &interval, NULL );
+	}
+	return NULL;
+}
+
+/**
+ * Writes the pending records of all rings, returns the number of records.
+ */
+int Logger::drain()
+{
+	int n = 0;
+	pthread_mutex_lock( flushMutex() );
+
+	pthread_mutex_lock( ringMutex() );
+	LogRing* ring = rings();
+	pthread_mutex_unlock( ringMutex() );
+
+	for( ; ring != 0; ring = ring->next )
+	{
+		unsigned int head = ring->head;
+		__sync_synchronize();
+		for( ; ring->tail != head; n++ )
+		{
+			write( ring->records[ring->tail & (LogRing::SIZE-1)] );
+			__sync_synchronize();
+			ring->tail = ring->tail + 1;
+		}
+
+		unsigned int dropped = __sync_lock_test_and_set( &ring->dropped, 0 );
+		if( dropped > 0 ) fprintf( stdout, "(%u log messages dropped)\n", dropped );
+	}
+	if( n > 0 ) fflush( stdout );
+
+	pthread_mutex_unlock( flushMutex() );
+	return n;
+}
+
+void Logger::write( const LogRecord& record )
+{
+	static const char* names[] = { "DEBUG", "INFO ", "WARN ", "ERROR", "FATAL" };
+
+	double seconds = (double)( record.time.tv_sec-startTime().tv_sec ) + 1e-9*(double)( record.time.tv_nsec-startTime().tv_nsec );
+	fprintf( stdout, "%12.6f %s", seconds, names[record.level] );
+	if( record.rank >= 0 ) fprintf( stdout, " rank=%d", record.rank );
+	if( record.config >= 0 ) fprintf( stdout, " conf=%d", record.config );
+	if( record.copy >= 0 ) fprintf( stdout, " copy=%d", record.copy );
+	if( record.iteration >= 0 ) fprintf( stdout, " iter=%d", record.iteration );
+	fprintf( stdout, ": %s\n", record.text );
 }
 
 }
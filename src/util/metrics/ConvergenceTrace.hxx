@@ -0,0 +1,277 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Binary trace of the convergence of the gauge fixing (gff, dA, temperature and wall clock time of every
+ * measurement of every gauge copy and configuration).
+ *
+ * Records are collected in memory. When the buffer is full (or at flush()), it is handed to a writer thread and
+ * the recording continues in a second buffer, i.e. the gauge fixing loops only append a record. Without a file
+ * name the recorder is disabled.
+ *
+ * File format (native byte order): "cuLGTTRC", int version, int record size, then the TraceRecords. The phase is a
+ * ConvergenceTrace::Phase (INITIAL is the measurement before the first update), the temperature is 0 outside SA and the
+ * time is in seconds since the trace was opened. ConvergenceTraceReader prints a summary per gauge copy or writes
+ * the records as CSV.
+ *
+ * With append (a restart from a checkpoint) the records are appended to an existing trace of this version, the
+ * times of the appended records start at 0 again.
+ */
+
+#ifndef CONVERGENCETRACE_HXX_
+#define CONVERGENCETRACE_HXX_
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "PhaseMetrics.hxx"
+
+struct TraceRecord
+{
+	int config;
+	int copy;
+	int phase;
+	int iteration;
+	double temperature;
+	double gff;
+	double dA;
+	double time;
+};
+
+class ConvergenceTrace
+{
+public:
+	enum Phase { INITIAL, SA, SR, OR, PHASES };
+
+	ConvergenceTrace( std::string filename, bool append = false, int bufferSize = 65536 );
+	~ConvergenceTrace();
+	bool isEnabled() const;
+	void setConfig( int config );
+	void add( int copy, Phase phase, int iteration, double gff, double dA, double temperature = 0 );
+	template<class Batch> void addActive( Batch& batch, int slots, Phase phase, int iteration, double temperature = 0 );
+	void flush();
+	static bool read( std::string filename, std::vector<TraceRecord>& records );
+	static const char* getPhaseName( Phase phase );
+
+private:
+	static const int VERSION = 2;
+
+	bool enabled;
+	FILE* file;
+	int config;
+	int bufferSize;
+	timespec start;
+	std::vector<TraceRecord> buffer;
+	std::vector<TraceRecord> writeBuffer;
+	pthread_t thread;
+	bool writing;
+
+	void wait();
+	static void* writer( void* trace );
+	void write();
+	static bool readHeader( FILE* file );
+};
+
+ConvergenceTrace::ConvergenceTrace( std::string filename, bool append, int bufferSize ) : enabled( filename.size() > 0 ), file(0), config(-1), bufferSize(bufferSize), writing(false)
+{
+	if( !enabled ) return;
+
+	bool exists = false;
+	if( append )
+	{
+		FILE* old = fopen( filename.c_str(), "rb" );
+		if( old != NULL )
+		{
+			exists = true;
+			bool compatible = readHeader( old );
+			fclose( old );
+			if( !compatible )
+			{
+				std::cout << filename << " is not a trace file of this version, the trace is disabled." << std::endl;
+				enabled = false;
+				return;
+			}
+		}
+	}
+
+	file = fopen( filename.c_str(), (exists)?("ab"):("wb") );
+	if( file == NULL )
+	{
+		std::cout << "Can not open trace file " << filename << ", the trace is disabled." << std::endl;
+		enabled = false;
+		return;
+	}
+
+	if( !exists )
+	{
+		const char magic[8] = { 'c','u','L','G','T','T','R','C' };
+		int header[2] = { VERSION, (int)sizeof(TraceRecord) };
+		fwrite( magic, sizeof(char), 8, file );
+		fwrite( header, sizeof(int), 2, file );
+	}
+
+	buffer.reserve( bufferSize );
+	writeBuffer.reserve( bufferSize );
+	clock_gettime( CLOCK_MONOTONIC, &start );
+}
+
+ConvergenceTrace::~ConvergenceTrace()
+{
+	if( !enabled ) return;
+	flush();
+	wait();
+	fclose( file );
+}
+
+bool ConvergenceTrace::isEnabled() const
+{
+	return enabled;
+}
+
+void ConvergenceTrace::setConfig( int config )
+{
+	this->config = config;
+}
+
+void ConvergenceTrace::add( int copy, Phase phase, int iteration, double gff, double dA, double temperature )
+{
+	if( !enabled ) return;
+
+	timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	TraceRecord r;
+	r.config = config;
+	r.copy = copy;
+	r.phase = phase;
+	r.iteration = iteration;
+	r.temperature = temperature;
+	r.gff = gff;
+	r.dA = dA;
+	r.time = (double)( now.tv_sec-start.tv_sec ) + 1e-9*(double)( now.tv_nsec-start.tv_nsec );
+	buffer.push_back( r );
+
+	if( (int)buffer.size() >= bufferSize ) flush();
+}
+
+/**
+ * Adds the current gauge quality of the active slots of a GaugeCopyBatch.
+ */
+template<class Batch> void ConvergenceTrace::addActive( Batch& batch, int slots, Phase phase, int iteration, double temperature )
+{
+	if( !enabled ) return;
+	for( int k = 0; k < slots; k++ )
+	{
+		if( batch.isActive(k) ) add( batch.getCopy(k), phase, iteration, batch.getStats(k).getCurrentGff(), batch.getStats(k).getCurrentA(), temperature );
+	}
+}
+
+/**
+ * Starts writing the buffered records (waits for the previous write first).
+ */
+void ConvergenceTrace::flush()
+{
+	if( !enabled || buffer.size() == 0 ) return;
+	wait();
+	writeBuffer.swap( buffer );
+	buffer.clear();
+	writing = true;
+	if( pthread_create( &thread, NULL, writer, this ) != 0 )
+	{
+		// no thread available: write synchronously
+		write();
+		writing = false;
+	}
+}
+
+void ConvergenceTrace::wait()
+{
+	if( writing )
+	{
+		pthread_join( thread, NULL );
+		writing = false;
+	}
+}
+
+void* ConvergenceTrace::writer( void* trace )
+{
+	((ConvergenceTrace*)trace)->write();
+	return NULL;
+}
+
+void ConvergenceTrace::write()
+{
+	if( fwrite( &writeBuffer[0], sizeof(TraceRecord), writeBuffer.size(), file ) != writeBuffer.size() )
+	{
+		std::cout << "Error while writing the trace file." << std::endl;
+	}
+	fflush( file );
+}
+
+/**
+ * Reads all records of a trace file. Returns false if the file is not a (compatible) trace.
+ */
+bool ConvergenceTrace::read( std::string filename, std::vector<TraceRecord>& records )
+{
+	FILE* file = fopen( filename.c_str(), "rb" );
+	if( file == NULL )
+	{
+		std::cout << "Can not open trace file " << filename << std::endl;
+		return false;
+	}
+
+	if( !readHeader( file ) )
+	{
+		std::cout << filename << " is not a trace file of this version." << std::endl;
+		fclose( file );
+		return false;
+	}
+
+	TraceRecord r;
+	while( fread( &r, sizeof(TraceRecord), 1, file ) == 1 )
+	{
+		records.push_back( r );
+	}
+	fclose( file );
+	return true;
+}
+
+/**
+ * Reads the magic and header of a trace file. Returns false if they do not match this version.
+ */
+bool ConvergenceTrace::readHeader( FILE* file )
+{
+	char magic[8];
+	int header[2];
+	bool ok = ( fread( magic, sizeof(char), 8, file ) == 8 ) && ( strncmp( magic, "cuLGTTRC", 8 ) == 0 );
+	return ok && ( fread( header, sizeof(int), 2, file ) == 2 ) && header[0] == VERSION && header[1] == (int)sizeof(TraceRecord);
+}
+
+const char* ConvergenceTrace::getPhaseName( Phase phase )
+{
+	static const char* names[PHASES] = { "initial", "sa", "sr", "or" };
+	return names[phase];
+}
+
+#endif /* CONVERGENCETRACE_HXX_ */
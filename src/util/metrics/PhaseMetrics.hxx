@@ -0,0 +1,277 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Machine readable performance metrics of the phases of a gauge fixing run.
+ *
+ * A record is collected per configuration and gauge copy (copy -1 is the record of the configuration itself, i.e.
+ * of the load and save phases). For each phase the time, the number of sweeps (kernel calls for REPROJECT and
+ * QUALITY), the flops and the bytes are summed up, the final gff and dA of the copy are set at the end. Records
+ * are buffered in memory and written as a whole when the next configuration starts (or in the destructor), thus
+ * the gauge fixing loops only add a few numbers. Without a file name the recorder is disabled.
+ *
+ * Formats:
+ *  - "json": one JSON object per record and line
+ *    {"config":0,"copy":1,"file":"...","slots":2,"gff":...,"dA":...,"phases":{"load":{"time":..,"sweeps":..,"flops":..,"bytes":..},...}}
+ *  - "csv": one line per record and phase, columns config,copy,file,slots,phase,time,sweeps,flops,bytes,gff,dA
+ *
+ * "slots" is the number of gauge copies that ran concurrently with the copy: the times of these copies are the
+ * (shared) wall clock times of their batch. The QUALITY times are device times of the measurements in the stream of
+ * the copy (GaugeFixingStats::setTiming()), the gauge fixing kernels are not synchronized for them.
+ * Applications without a GaugeCopyBatch start the record of each copy with beginCopy(); the Coulomb gauge fixing
+ * writes a record per timeslice and copy (in the order of the timeslices).
+ */
+
+#ifndef PHASEMETRICS_HXX_
+#define PHASEMETRICS_HXX_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+class PhaseMetrics
+{
+public:
+	enum Phase { LOAD, SA, SR, OR, REPROJECT, QUALITY, SAVE, PHASES };
+
+	PhaseMetrics( std::string filename, std::string format );
+	~PhaseMetrics();
+	bool isEnabled() const;
+	void beginConfig( int config, std::string file );
+	template<class Batch> void beginCopies( Batch& batch, int slots );
+	void beginCopy( int copy );
+	template<class Batch> void addQuality( Batch& batch, int slots );
+	void add( Phase phase, int slot, double time, long sweeps = 0, double flops = 0, double bytes = 0 );
+	void addConfig( Phase phase, double time, long sweeps = 0, double flops = 0, double bytes = 0 );
+	void setResult( int slot, double gff, double dA );
+	void flush();
+	static const char* getPhaseName( Phase phase );
+
+private:
+	struct Record
+	{
+		int copy;
+		int slots;
+		double time[PHASES];
+		long sweeps[PHASES];
+		double flops[PHASES];
+		double bytes[PHASES];
+		double gff;
+		double dA;
+	};
+
+	bool enabled;
+	bool json;
+	std::ofstream out;
+	int config;
+	std::string file;
+	std::vector<Record> records; // records[0] is the configuration, then the copies
+	int firstSlotRecord;
+
+	void write( const Record& r );
+	static std::string escape( const std::string& value );
+	Record createRecord( int copy, int slots );
+};
+
+PhaseMetrics::PhaseMetrics( std::string filename, std::string format ) : enabled( filename.size() > 0 ), json( format != "csv" ), config(-1), firstSlotRecord(1)
+{
+	if( !enabled ) return;
+
+	out.open( filename.c_str() );
+	if( !out.good() )
+	{
+		std::cout << "Can not open metrics file " << filename << ", metrics are disabled." << std::endl;
+		enabled = false;
+		return;
+	}
+	if( !json ) out << "config,copy,file,slots,phase,time,sweeps,flops,bytes,gff,dA" << std::endl;
+}
+
+PhaseMetrics::~PhaseMetrics()
+{
+	flush();
+}
+
+bool PhaseMetrics::isEnabled() const
+{
+	return enabled;
+}
+
+/**
+ * Writes the records of the previous configuration and starts the record of the configuration (copy -1).
+ */
+void PhaseMetrics::beginConfig( int config, std::string file )
+{
+	if( !enabled ) return;
+	flush();
+	this->config = config;
+	this->file = file;
+	records.push_back( createRecord( -1, 1 ) );
+}
+
+/**
+ * Starts the records of the slots of a GaugeCopyBatch, slot k is copy batch.getCopy(k) (in replica exchange mode
+ * all slots are replicas of the same copy).
+ */
+template<class Batch> void PhaseMetrics::beginCopies( Batch& batch, int slots )
+{
+	if( !enabled ) return;
+	firstSlotRecord = records.size();
+	for( int k = 0; k < slots; k++ )
+	{
+		records.push_back( createRecord( batch.getCopy(k), slots ) );
+	}
+}
+
+/**
+ * Starts the record of a single gauge copy (slot 0).
+ */
+void PhaseMetrics::beginCopy( int copy )
+{
+	if( !enabled ) return;
+	firstSlotRecord = records.size();
+	records.push_back( createRecord( copy, 1 ) );
+}
+
+/**
+ * Adds the timed gauge quality measurement of the active slots (see GaugeCopyBatch::setTiming()).
+ */
+template<class Batch> void PhaseMetrics::addQuality( Batch& batch, int slots )
+{
+	if( !enabled ) return;
+	for( int k = 0; k < slots; k++ )
+	{
+		if( batch.isActive(k) ) add( QUALITY, k, batch.getStats(k).getQualityTime(), 1 );
+	}
+}
+
+void PhaseMetrics::add( Phase phase, int slot, double time, long sweeps, double flops, double bytes )
+{
+	if( !enabled ) return;
+	Record& r = records[firstSlotRecord+slot];
+	r.time[phase] += time;
+	r.sweeps[phase] += sweeps;
+	r.flops[phase] += flops;
+	r.bytes[phase] += bytes;
+}
+
+void PhaseMetrics::addConfig( Phase phase, double time, long sweeps, double flops, double bytes )
+{
+	if( !enabled || records.size() == 0 ) return;
+	Record& r = records[0];
+	r.time[phase] += time;
+	r.sweeps[phase] += sweeps;
+	r.flops[phase] += flops;
+	r.bytes[phase] += bytes;
+}
+
+void PhaseMetrics::setResult( int slot, double gff, double dA )
+{
+	if( !enabled ) return;
+	records[firstSlotRecord+slot].gff = gff;
+	records[firstSlotRecord+slot].dA = dA;
+}
+
+void PhaseMetrics::flush()
+{
+	if( !enabled ) return;
+	for( unsigned int i = 0; i < records.size(); i++ )
+	{
+		write( records[i] );
+	}
+	records.clear();
+	out.flush();
+}
+
+const char* PhaseMetrics::getPhaseName( Phase phase )
+{
+	static const char* names[PHASES] = { "load", "sa", "sr", "or", "reproject", "quality", "save" };
+	return names[phase];
+}
+
+PhaseMetrics::Record PhaseMetrics::createRecord( int copy, int slots )
+{
+	Record r;
+	r.copy = copy;
+	r.slots = slots;
+	for( int p = 0; p < PHASES; p++ )
+	{
+		r.time[p] = 0;
+		r.sweeps[p] = 0;
+		r.flops[p] = 0;
+		r.bytes[p] = 0;
+	}
+	r.gff = 0;
+	r.dA = 0;
+	return r;
+}
+
+void PhaseMetrics::write( const Record& r )
+{
+	std::ostringstream line;
+	line.precision( 12 );
+	if( json )
+	{
+		line << "{\"config\":" << config << ",\"copy\":" << r.copy << ",\"file\":\"" << escape( file ) << "\",\"slots\":" << r.slots
+				<< ",\"gff\":" << r.gff << ",\"dA\":" << r.dA << ",\"phases\":{";
+		for( int p = 0; p < PHASES; p++ )
+		{
+			if( p > 0 ) line << ",";
+			line << "\"" << getPhaseName( (Phase)p ) << "\":{\"time\":" << r.time[p] << ",\"sweeps\":" << r.sweeps[p]
+					<< ",\"flops\":" << r.flops[p] << ",\"bytes\":" << r.bytes[p] << "}";
+		}
+		line << "}}" << std::endl;
+	}
+	else
+	{
+		for( int p = 0; p < PHASES; p++ )
+		{
+			line << config << "," << r.copy << "," << file << "," << r.slots << "," << getPhaseName( (Phase)p ) << ","
+					<< r.time[p] << "," << r.sweeps[p] << "," << r.flops[p] << "," << r.bytes[p] << "," << r.gff << "," << r.dA << std::endl;
+		}
+	}
+	out << line.str();
+}
+
+/**
+ * Escapes a JSON string value (quotes, backslashes and control characters).
+ */
+std::string PhaseMetrics::escape( const std::string& value )
+{
+	std::ostringstream escaped;
+	for( unsigned int i = 0; i < value.size(); i++ )
+	{
+		char c = value[i];
+		if( c == '"' || c == '\\' ) escaped << '\\' << c;
+		else if( c == '\n' ) escaped << "\\n";
+		else if( c == '\t' ) escaped << "\\t";
+		else if( (unsigned char)c < 0x20 )
+		{
+			const char* hex = "0123456789abcdef";
+			escaped << "\\u00" << hex[(c>>4)&0xf] << hex[c&0xf];
+		}
+		else escaped << c;
+	}
+	return escaped.str();
+}
+
+#endif /* PHASEMETRICS_HXX_ */
@@ -32,35 +32,35 @@ void Chronotimer::start()
 {
 	running = true;
 	if (resetted)
-		gettimeofday(&begin, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &begin);
 	else
 	{
-		__suseconds_t tmp_us = end.tv_usec - begin.tv_usec;
-		__time_t tmp_s = end.tv_sec - begin.tv_sec;
-		if (tmp_us < 0)
+		long tmp_ns = end.tv_nsec - begin.tv_nsec;
+		time_t tmp_s = end.tv_sec - begin.tv_sec;
+		if (tmp_ns < 0)
 		{
-			tmp_us += 1000000;
+			tmp_ns += 1000000000;
 			tmp_s -= 1;
 		}
 
-		gettimeofday(&begin, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &begin);
 
-		if (begin.tv_usec - tmp_us < 0)
+		if (begin.tv_nsec - tmp_ns < 0)
 		{
 			begin.tv_sec += -tmp_s - 1;
-			begin.tv_usec += -tmp_us + 1000000;
+			begin.tv_nsec += -tmp_ns + 1000000000;
 		}
 		else
 		{
 			begin.tv_sec += -tmp_s;
-			begin.tv_usec += -tmp_us;
+			begin.tv_nsec += -tmp_ns;
 		}
 	}
 }
 
 void Chronotimer::stop()
 {
-	gettimeofday(&end, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
 	running = false;
 }
 
@@ -74,9 +74,9 @@ double Chronotimer::getTime()
 {
 	if (running)
 	{
-		gettimeofday(&end, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &end);
 	}
 
 	return (double) (end.tv_sec - begin.tv_sec)
-			+ (double) (end.tv_usec - begin.tv_usec) / (double) 1000000;
+			+ (double) (end.tv_nsec - begin.tv_nsec) / (double) 1000000000;
 }
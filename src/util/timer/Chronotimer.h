@@ -23,9 +23,12 @@
 #ifndef CHRONOTIMER_H_
 #define CHRONOTIMER_H_
 
-#include <sys/time.h>
+#include <time.h>
 #include <string.h>
 
+/**
+ * Stop watch on the monotonic clock. For nested regions and a profile of the run see ScopedTimer.hxx.
+ */
 class Chronotimer {
 	public:
 		Chronotimer();
@@ -36,8 +39,8 @@ class Chronotimer {
 	private:
 		bool running;
 		bool resetted;
-		timeval begin;
-		timeval end;
+		timespec begin;
+		timespec end;
 };
 
 #endif /* CHRONOTIMER_H_ */
@@ -0,0 +1,315 @@
+/************************************************************************
+ *
+ *  Copyright 2012 Mario Schroeck, Hannes Vogt
+ *
+ *  This file is part of cuLGT.
+ *
+ *  cuLGT is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  any later version.
+ *
+ *  cuLGT is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with cuLGT.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ************************************************************************
+ *
+ * Scoped timers on the monotonic clock that build a call tree profile.
+ *
+ *	{
+ *		ScopedTimer timer( "SA" );
+ *		...
+ *		kernelTime = timer.stop(); // optional, otherwise the region ends in the destructor
+ *	}
+ *
+ * A ScopedTimer always measures its own time (getTime(), stop()). If the Profiler is enabled, the region is
+ * additionally entered in the call tree of the calling thread: a region that is opened inside another region
+ * becomes its child, regions with the same name (the pointer or the string) under the same parent are merged
+ * and count the calls and the total, min. and max. time. Each thread builds its own tree, the threads only
+ * synchronize when they open their first region. Disabled, a timer costs two clock reads and a branch.
+ *
+ * Profiler::report() prints a flat profile (all regions of a name, summed over the tree and the threads) and
+ * the tree of each thread. Profiler::enable() prints the report at exit.
+ *
+ * Region names have to outlive the profiler, use string literals.
+ */
+
+#ifndef SCOPEDTIMER_HXX_
+#define SCOPEDTIMER_HXX_
+
+#include <time.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+class ProfileNode
+{
+public:
+	const char* name;
+	ProfileNode* parent;
+	std::vector<ProfileNode*> children;
+	long count;
+	double total;
+	double min;
+	double max;
+
+	ProfileNode( const char* name, ProfileNode* parent ) : name(name), parent(parent), count(0), total(0), min(0), max(0)
+	{
+	}
+
+	ProfileNode* getChild( const char* childName )
+	{
+		for( unsigned int i = 0; i < children.size(); i++ )
+		{
+			if( children[i]->name == childName || strcmp( children[i]->name, childName ) == 0 ) return children[i];
+		}
+		children.push_back( new ProfileNode( childName, this ) );
+		return children.back();
+	}
+
+	void add( double time )
+	{
+		if( count == 0 || time < min ) min = time;
+		if( count == 0 || time > max ) max = time;
+		count++;
+		total += time;
+	}
+};
+
+class Profiler
+{
+public:
+	static void enable( bool reportAtExit = true );
+	static bool isEnabled();
+	static ProfileNode* enter( const char* name );
+	static void leave( ProfileNode* node, double time );
+	static void report( std::ostream& out );
+
+private:
+	static bool& enabled();
+	static ProfileNode*& current();
+	static std::vector<ProfileNode*>& roots();
+	static pthread_mutex_t* mutex();
+	static void reportAtExit();
+	static void collect( ProfileNode* node, std::vector<ProfileNode>& flat );
+	static void printTree( std::ostream& out, ProfileNode* node, int depth );
+	static void printLine( std::ostream& out, const char* name, int depth, long count, double total, double min, double max );
+};
+
+class ScopedTimer
+{
+public:
+	ScopedTimer( const char* name );
+	~ScopedTimer();
+	double stop();
+	double getTime() const;
+
+private:
+	timespec begin;
+	timespec end;
+	bool running;
+	ProfileNode* node;
+
+	static double seconds( const timespec& from, const timespec& to );
+};
+
+
+void Profiler::enable( bool printAtExit )
+{
+	roots(); // constructed before the exit handler is registered, i.e. destroyed after the report
+	if( printAtExit && !enabled() ) atexit( Profiler::reportAtExit );
+	enabled() = true;
+}
+
+bool Profiler::isEnabled()
+{
+	return enabled();
+}
+
+/**
+ * Opens the region name as child of the current region of the calling thread.
+ */
+ProfileNode* Profiler::enter( const char* name )
+{
+	ProfileNode*& cur = current();
+	if( cur == 0 )
+	{
+		cur = new ProfileNode( "thread", 0 );
+		pthread_mutex_lock( mutex() );
+		roots().push_back( cur );
+		pthread_mutex_unlock( mutex() );
+	}
+	cur = cur->getChild( name );
+	return cur;
+}
+
+void Profiler::leave( ProfileNode* node, double time )
+{
+	node->add( time );
+	current() = node->parent;
+}
+
+void Profiler::report( std::ostream& out )
+{
+	pthread_mutex_lock( mutex() );
+
+	std::vector<ProfileNode> flat;
+	for( unsigned int t = 0; t < roots().size(); t++ )
+	{
+		collect( roots()[t], flat );
+	}
+
+	out << "PROFILE (flat)" << std::endl;
+	printLine( out, 0, 0, 0, 0, 0, 0 );
+	for( unsigned int i = 0; i < flat.size(); i++ )
+	{
+		printLine( out, flat[i].name, 0, flat[i].count, flat[i].total, flat[i].min, flat[i].max );
+	}
+
+	for( unsigned int t = 0; t < roots().size(); t++ )
+	{
+		out << "PROFILE (tree of thread " << t << ")" << std::endl;
+		printLine( out, 0, 0, 0, 0, 0, 0 );
+		for( unsigned int i = 0; i < roots()[t]->children.size(); i++ )
+		{
+			printTree( out, roots()[t]->children[i], 0 );
+		}
+	}
+
+	pthread_mutex_unlock( mutex() );
+}
+
+bool& Profiler::enabled()
+{
+	static bool enabled = false;
+	return enabled;
+}
+
+ProfileNode*& Profiler::current()
+{
+	static __thread ProfileNode* current = 0;
+	return current;
+}
+
+std::vector<ProfileNode*>& Profiler::roots()
+{
+	static std::vector<ProfileNode*> roots;
+	return roots;
+}
+
+pthread_mutex_t* Profiler::mutex()
+{
+	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	return &mutex;
+}
+
+void Profiler::reportAtExit()
+{
+	report( std::cout );
+}
+
+/**
+ * Sums up the regions of the tree by name (the list keeps the order of first appearance).
+ */
+void Profiler::collect( ProfileNode* node, std::vector<ProfileNode>& flat )
+{
+	for( unsigned int i = 0; i < node->children.size(); i++ )
+	{
+		ProfileNode* child = node->children[i];
+		unsigned int j = 0;
+		while( j < flat.size() && strcmp( flat[j].name, child->name ) != 0 ) j++;
+		if( j == flat.size() ) flat.push_back( ProfileNode( child->name, 0 ) );
+
+		if( child->count > 0 )
+		{
+			if( flat[j].count == 0 || child->min < flat[j].min ) flat[j].min = child->min;
+			if( flat[j].count == 0 || child->max > flat[j].max ) flat[j].max = child->max;
+		}
+		flat[j].count += child->count;
+		flat[j].total += child->total;
+
+		collect( child, flat );
+	}
+}
+
+void Profiler::printTree( std::ostream& out, ProfileNode* node, int depth )
+{
+	printLine( out, node->name, depth, node->count, node->total, node->min, node->max );
+	for( unsigned int i = 0; i < node->children.size(); i++ )
+	{
+		printTree( out, node->children[i], depth+1 );
+	}
+}
+
+/**
+ * Prints a line of the report (the header for name == 0).
+ */
+void Profiler::printLine( std::ostream& out, const char* name, int depth, long count, double total, double min, double max )
+{
+	if( name == 0 )
+	{
+		out << std::left << std::setw(32) << "region" << std::right << std::setw(10) << "calls" << std::setw(14) << "total [s]"
+				<< std::setw(14) << "mean [s]" << std::setw(14) << "min [s]" << std::setw(14) << "max [s]" << std::endl;
+		return;
+	}
+
+	std::string indented = std::string( 2*depth, ' ' ) + name;
+	out << std::left << std::setw(32) << indented << std::right << std::setw(10) << count << std::setw(14) << total
+			<< std::setw(14) << ((count>0)?(total/(double)count):(0.)) << std::setw(14) << min << std::setw(14) << max << std::endl;
+}
+
+
+ScopedTimer::ScopedTimer( const char* name ) : running(true), node(0)
+{
+	if( Profiler::isEnabled() ) node = Profiler::enter( name );
+	clock_gettime( CLOCK_MONOTONIC, &begin );
+}
+
+ScopedTimer::~ScopedTimer()
+{
+	stop();
+}
+
+/**
+ * Ends the region and returns its time in seconds (further calls return the same time).
+ */
+double ScopedTimer::stop()
+{
+	if( running )
+	{
+		clock_gettime( CLOCK_MONOTONIC, &end );
+		running = false;
+		if( node != 0 ) Profiler::leave( node, seconds( begin, end ) );
+	}
+	return seconds( begin, end );
+}
+
+/**
+ * Time in seconds since the region was opened (or until stop()).
+ */
+double ScopedTimer::getTime() const
+{
+	if( running )
+	{
+		timespec now;
+		clock_gettime( CLOCK_MONOTONIC, &now );
+		return seconds( begin, now );
+	}
+	return seconds( begin, end );
+}
+
+double ScopedTimer::seconds( const timespec& from, const timespec& to )
+{
+	return (double)( to.tv_sec - from.tv_sec ) + 1e-9*(double)( to.tv_nsec - from.tv_nsec );
+}
+
+#endif /* SCOPEDTIMER_HXX_ */